@@ -760,20 +760,47 @@ Tomahawk.PluginManager = {
     },
 
     invoke: function (requestId, objectId, methodName, params) {
-        RSVP.Promise.resolve(this.invokeSync(requestId, objectId, methodName, params))
-            .then(function (result) {
-                var params = {
-                    requestId: requestId,
-                    data: result
-                };
-                Tomahawk.reportScriptJobResults(encodeParamsToNativeFunctions(params));
-            }, function (error) {
-                var params = {
-                    requestId: requestId,
-                    error: error
-                };
-                Tomahawk.reportScriptJobResults(encodeParamsToNativeFunctions(params));
+        var that = this;
+        new RSVP.Promise(function (resolve) {
+            resolve(that.invokeSync(requestId, objectId, methodName, params));
+        }).then(function (result) {
+            that.reportResult({
+                requestId: requestId,
+                data: result
             });
+        }, function (error) {
+            that.reportResult({
+                requestId: requestId,
+                error: error
+            });
+        });
+    },
+
+    // invoked by TomahawkBridge with all jobs queued since the last event loop turn
+    invokeBatch: function (jobs) {
+        for (var i = 0; i < jobs.length; i++) {
+            this.invoke(jobs[i].requestId, jobs[i].objectId, jobs[i].methodName,
+                jobs[i].arguments);
+        }
+    },
+
+    pendingResults: [],
+    reportResult: function (params) {
+        if (!window.TomahawkBridge) {
+            Tomahawk.reportScriptJobResults(encodeParamsToNativeFunctions(params));
+            return;
+        }
+
+        // collect everything that settles in this turn and hand it back in one go
+        this.pendingResults.push(encodeParamsToNativeFunctions(params));
+        if (this.pendingResults.length === 1) {
+            var that = this;
+            window.setTimeout(function () {
+                var results = that.pendingResults;
+                that.pendingResults = [];
+                TomahawkBridge.reportResults(results);
+            }, 0);
+        }
     }
 };
 
@@ -808,9 +835,27 @@ Tomahawk.NativeScriptJobManager = {
         }
         deferred.reject(error);
         delete this.deferreds[requestId];
+    },
+
+    // invoked by TomahawkBridge with all native results queued since the last event loop turn
+    reportNativeScriptJobResults: function (results) {
+        for (var i = 0; i < results.length; i++) {
+            if (results[i].hasOwnProperty('error')) {
+                this.reportNativeScriptJobError(results[i].requestId, results[i].error);
+            } else {
+                this.reportNativeScriptJobResult(results[i].requestId, results[i].result);
+            }
+        }
     }
 };
 
+if (window.TomahawkBridge) {
+    TomahawkBridge.dispatch.connect(Tomahawk.PluginManager,
+        Tomahawk.PluginManager.invokeBatch);
+    TomahawkBridge.nativeResults.connect(Tomahawk.NativeScriptJobManager,
+        Tomahawk.NativeScriptJobManager.reportNativeScriptJobResults);
+}
+
 Tomahawk.UrlType = {
     Any: 0,
     Playlist: 1,
@@ -22,6 +22,7 @@
 #include "database/Database.h"
 #include "database/DatabaseImpl.h"
 #include "database/IdThreadWorker.h"
+#include "utils/CoverCache.h"
 #include "utils/TomahawkUtilsGui.h"
 #include "utils/Logger.h"
 
@@ -32,7 +33,6 @@
 #include "Source.h"
 
 #include <QReadWriteLock>
-#include <QPixmapCache>
 #include <QCoreApplication>
 
 using namespace Tomahawk;
@@ -49,7 +49,9 @@ Album::~Album()
     Q_D( Album );
     d->ownRef.clear();
 
-    delete d->cover;
+    // only what has been asked for its cover can have one
+    if ( !d->uuid.isEmpty() )
+        CoverCache::remove( d->uuid );
 }
 
 
@@ -126,16 +128,12 @@ Album::get( unsigned int id, const QString& name, const Tomahawk::artist_ptr& ar
 Album::Album( unsigned int id, const QString& name, const Tomahawk::artist_ptr& artist )
     : d_ptr( new AlbumPrivate( this, id, name, artist ) )
 {
-    Q_D( Album );
-    d->sortname = DatabaseImpl::sortname( name );
 }
 
 
 Album::Album( const QString& name, const Tomahawk::artist_ptr& artist )
     : d_ptr( new AlbumPrivate( this, name, artist ) )
 {
-    Q_D( Album );
-    d->sortname = DatabaseImpl::sortname( name );
 }
 
 
@@ -239,6 +237,14 @@ Album::sortname() const
 }
 
 
+const QCollatorSortKey&
+Album::sortKey() const
+{
+    Q_D( const Album );
+    return d->sortKey;
+}
+
+
 QString
 Album::purchaseUrl() const
 {
@@ -318,33 +324,11 @@ Album::cover( const QSize& size, bool forceLoad ) const
         d->coverLoading = true;
     }
 
-    if ( !d->cover && !d->coverBuffer.isEmpty() )
-    {
-        QPixmap cover;
-        cover.loadFromData( d->coverBuffer );
-        d->coverBuffer.clear();
-
-        d->cover = new QPixmap( TomahawkUtils::squareCenterPixmap( cover ) );
-    }
-
-    if ( d->cover && !d->cover->isNull() && !size.isEmpty() )
-    {
-        const QString cacheKey = QString( "%1_%2_%3" ).arg( infoid() ).arg( size.width() ).arg( size.height() );
-        QPixmap cover;
-
-        if ( !QPixmapCache::find( cacheKey, &cover ) )
-        {
-            cover = d->cover->scaled( size, Qt::KeepAspectRatio, Qt::SmoothTransformation );
-            QPixmapCache::insert( cacheKey, cover );
-            return cover;
-        }
-        return cover;
-    }
-
-    if ( d->cover )
-        return *d->cover;
-    else
+    // decoding and scaling happens in the background, until it's done this is just a null pixmap
+    if ( !d->coverLoaded )
         return QPixmap();
+
+    return CoverCache::instance()->pixmap( infoid(), size );
 }
 
 
@@ -388,7 +372,8 @@ Album::infoSystemInfo( const Tomahawk::InfoSystem::InfoRequestData& requestData,
         const QByteArray ba = returnedData["imgbytes"].toByteArray();
         if ( !ba.isEmpty() )
         {
-            d->coverBuffer = ba;
+            CoverCache::instance()->decode( infoid(), ba, this, "onCoverDecoded" );
+            return;
         }
 
         d->coverLoaded = true;
@@ -397,6 +382,15 @@ Album::infoSystemInfo( const Tomahawk::InfoSystem::InfoRequestData& requestData,
 }
 
 
+void
+Album::onCoverDecoded()
+{
+    Q_D( Album );
+    d->coverLoaded = true;
+    emit coverChanged();
+}
+
+
 void
 Album::infoSystemFinished( const QString& target )
 {
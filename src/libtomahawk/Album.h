@@ -22,6 +22,7 @@
 #ifndef TOMAHAWKALBUM_H
 #define TOMAHAWKALBUM_H
 
+#include <QCollator>
 #include <QPixmap>
 #include <QFuture>
 
@@ -56,6 +57,7 @@ public:
     unsigned int id() const;
     QString name() const;
     QString sortname() const;
+    const QCollatorSortKey& sortKey() const;
 
     artist_ptr artist() const;
     QPixmap cover( const QSize& size, bool forceLoad = true ) const;
@@ -87,6 +89,7 @@ private slots:
 
     void infoSystemInfo( const Tomahawk::InfoSystem::InfoRequestData& requestData, const QVariant& output );
     void infoSystemFinished( const QString& target );
+    void onCoverDecoded();
 
 private:
     Q_DECLARE_PRIVATE( Album )
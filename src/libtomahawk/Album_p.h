@@ -24,6 +24,9 @@
 
 #include "Album.h"
 
+#include "database/DatabaseImpl.h"
+#include "utils/TomahawkUtils.h"
+
 namespace Tomahawk
 {
 
@@ -35,12 +38,13 @@ public:
         , waitingForId( false )
         , id( _id )
         , name( _name )
+        , sortname( DatabaseImpl::sortname( _name ) )
+        , sortKey( TomahawkUtils::collationKey( sortname ) )
         , artist( _artist )
         , purchaseUrlLoaded( false )
         , purchased( false )
         , coverLoaded( false )
         , coverLoading( false )
-        , cover( 0 )
     {
     }
 
@@ -50,12 +54,13 @@ public:
         , waitingForId( true )
         , id( 0 )
         , name( _name )
+        , sortname( DatabaseImpl::sortname( _name ) )
+        , sortKey( TomahawkUtils::collationKey( sortname ) )
         , artist( _artist )
         , purchaseUrlLoaded( false )
         , purchased( false )
         , coverLoaded( false )
         , coverLoading( false )
-        , cover( 0 )
     {
     }
 
@@ -68,6 +73,7 @@ private:
     mutable unsigned int id;
     QString name;
     QString sortname;
+    QCollatorSortKey sortKey;
 
     artist_ptr artist;
 
@@ -79,9 +85,6 @@ private:
     mutable bool coverLoading;
     mutable QString uuid;
 
-    mutable QByteArray coverBuffer;
-    mutable QPixmap* cover;
-
     QHash< Tomahawk::ModelMode, QHash< Tomahawk::collection_ptr, Tomahawk::playlistinterface_ptr > > playlistInterface;
 
     QWeakPointer< Tomahawk::Album > ownRef;
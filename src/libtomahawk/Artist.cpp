@@ -27,6 +27,8 @@
 #include "database/DatabaseCommand_ArtistStats.h"
 #include "database/DatabaseCommand_TrackStats.h"
 #include "database/IdThreadWorker.h"
+#include "utils/TomahawkUtils.h"
+#include "utils/CoverCache.h"
 #include "utils/TomahawkUtilsGui.h"
 #include "utils/Logger.h"
 
@@ -35,7 +37,6 @@
 #include "Source.h"
 
 #include <QReadWriteLock>
-#include <QPixmapCache>
 #include <QCoreApplication>
 
 using namespace Tomahawk;
@@ -53,7 +54,9 @@ Artist::~Artist()
     FINEGRAINED_MSG( Q_FUNC_INFO << "Deleting artist:" << m_name );
     m_ownRef.clear();
 
-    delete m_cover;
+    // only what has been asked for its cover can have one
+    if ( !m_uuid.isEmpty() )
+        CoverCache::remove( m_uuid );
 }
 
 
@@ -130,6 +133,8 @@ Artist::Artist( unsigned int id, const QString& name )
     , m_waitingForFuture( false )
     , m_id( id )
     , m_name( name )
+    , m_sortname( DatabaseImpl::sortname( name, true ) )
+    , m_sortKey( TomahawkUtils::collationKey( m_sortname ) )
     , m_coverLoaded( false )
     , m_coverLoading( false )
     , m_simArtistsLoaded( false )
@@ -137,10 +142,8 @@ Artist::Artist( unsigned int id, const QString& name )
     , m_infoJobs( 0 )
     , m_chartPosition( 0 )
     , m_chartCount( 0 )
-    , m_cover( 0 )
 {
     FINEGRAINED_MSG( Q_FUNC_INFO << "Creating artist:" << id << name );
-    m_sortname = DatabaseImpl::sortname( name, true );
 }
 
 
@@ -149,6 +152,8 @@ Artist::Artist( const QString& name )
     , m_waitingForFuture( true )
     , m_id( 0 )
     , m_name( name )
+    , m_sortname( DatabaseImpl::sortname( name, true ) )
+    , m_sortKey( TomahawkUtils::collationKey( m_sortname ) )
     , m_coverLoaded( false )
     , m_coverLoading( false )
     , m_simArtistsLoaded( false )
@@ -156,10 +161,8 @@ Artist::Artist( const QString& name )
     , m_infoJobs( 0 )
     , m_chartPosition( 0 )
     , m_chartCount( 0 )
-    , m_cover( 0 )
 {
     FINEGRAINED_MSG( Q_FUNC_INFO << "Creating artist:" << name );
-    m_sortname = DatabaseImpl::sortname( name, true );
 }
 
 
@@ -517,7 +520,8 @@ Artist::infoSystemInfo( Tomahawk::InfoSystem::InfoRequestData requestData, QVari
                 const QByteArray ba = returnedData["imgbytes"].toByteArray();
                 if ( !ba.isEmpty() )
                 {
-                    m_coverBuffer = ba;
+                    CoverCache::instance()->decode( infoid(), ba, this, "onCoverDecoded" );
+                    break;
                 }
 
                 m_coverLoaded = true;
@@ -616,33 +620,19 @@ Artist::cover( const QSize& size, bool forceLoad ) const
         m_coverLoading = true;
     }
 
-    if ( !m_cover && !m_coverBuffer.isEmpty() )
-    {
-        QPixmap cover;
-        cover.loadFromData( m_coverBuffer );
-        m_coverBuffer.clear();
-
-        m_cover = new QPixmap( TomahawkUtils::squareCenterPixmap( cover ) );
-    }
+    // decoding and scaling happens in the background, until it's done this is just a null pixmap
+    if ( !m_coverLoaded )
+        return QPixmap();
 
-    if ( m_cover && !m_cover->isNull() && !size.isEmpty() )
-    {
-        const QString cacheKey = QString( "%1_%2_%3" ).arg( infoid() ).arg( size.width() ).arg( size.height() );
-        QPixmap cover;
+    return CoverCache::instance()->pixmap( infoid(), size );
+}
 
-        if ( !QPixmapCache::find( cacheKey, &cover ) )
-        {
-            cover = m_cover->scaled( size, Qt::KeepAspectRatio, Qt::SmoothTransformation );
-            QPixmapCache::insert( cacheKey, cover );
-            return cover;
-        }
-        return cover;
-    }
 
-    if ( m_cover )
-        return *m_cover;
-    else
-        return QPixmap();
+void
+Artist::onCoverDecoded()
+{
+    m_coverLoaded = true;
+    emit coverChanged();
 }
 
 
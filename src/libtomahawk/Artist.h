@@ -20,6 +20,7 @@
 #ifndef TOMAHAWKARTIST_H
 #define TOMAHAWKARTIST_H
 
+#include <QCollator>
 #include <QFuture>
 #include <QPixmap>
 
@@ -48,6 +49,7 @@ public:
     unsigned int id() const;
     QString name() const { return m_name; }
     QString sortname() const { return m_sortname; }
+    const QCollatorSortKey& sortKey() const { return m_sortKey; }
 
     QList<album_ptr> albums( ModelMode mode = Mixed, const Tomahawk::collection_ptr& collection = Tomahawk::collection_ptr() ) const;
     QList<artist_ptr> similarArtists() const;
@@ -95,6 +97,7 @@ private slots:
 
     void infoSystemInfo( Tomahawk::InfoSystem::InfoRequestData requestData, QVariant output );
     void infoSystemFinished( QString target );
+    void onCoverDecoded();
 
 private:
     Artist();
@@ -108,6 +111,7 @@ private:
 
     QString m_name;
     QString m_sortname;
+    QCollatorSortKey m_sortKey;
 
     bool m_coverLoaded;
     mutable bool m_coverLoading;
@@ -127,9 +131,6 @@ private:
     unsigned int m_chartPosition;
     unsigned int m_chartCount;
 
-    mutable QByteArray m_coverBuffer;
-    mutable QPixmap* m_cover;
-
     QHash< Tomahawk::ModelMode, QHash< Tomahawk::collection_ptr, Tomahawk::playlistinterface_ptr > > m_playlistInterface;
 
     QWeakPointer< Tomahawk::Artist > m_ownRef;
@@ -27,16 +27,18 @@
 #include "utils/ResultUrlChecker.h"
 #include "utils/Logger.h"
 
-#include "FuncTimeout.h"
 #include "Result.h"
 #include "Source.h"
 #include "SourceList.h"
+#include "TomahawkSettings.h"
 
 #define DEFAULT_CONCURRENT_QUERIES 4
 #define MAX_CONCURRENT_QUERIES 16
 #define CLEANUP_TIMEOUT 5 * 60 * 1000
 #define MINSCORE 0.5
 #define DEFAULT_RESOLVER_TIMEOUT 5000 // 5 seconds
+#define MAX_QUERIES_PER_RESOLVER 8 // in parallel dispatch mode
+#define SOLVED_SCORE 0.99 // a result this good lets us stop waiting for lower weighted resolvers
 
 using namespace Tomahawk;
 
@@ -62,6 +64,13 @@ Pipeline::Pipeline( QObject* parent )
 
     d->temporaryQueryTimer.setInterval( CLEANUP_TIMEOUT );
     connect( &d->temporaryQueryTimer, SIGNAL( timeout() ), SLOT( onTemporaryQueryTimer() ) );
+
+    d->timers = new Utils::TimerWheel( 100, this );
+    d->cache = new ResolutionCache( TomahawkSettings::instance()->storageCacheLocation() + "/ResolutionCache", this );
+    d->clock.start();
+
+    connect( TomahawkSettings::instance(), SIGNAL( changed() ), SLOT( onSettingsChanged() ) );
+    onSettingsChanged();
 }
 
 
@@ -80,6 +89,14 @@ Pipeline::~Pipeline()
 }
 
 
+void
+Pipeline::onSettingsChanged()
+{
+    Q_D( Pipeline );
+    d->parallelDispatch = TomahawkSettings::instance()->parallelResolving();
+}
+
+
 bool
 Pipeline::isRunning() const
 {
@@ -100,7 +117,7 @@ unsigned int
 Pipeline::activeQueryCount() const
 {
     Q_D( const Pipeline );
-    return d->qidsState.uniqueKeys().count();
+    return d->activeQueries;
 }
 
 
@@ -117,7 +134,7 @@ Pipeline::start()
 {
     Q_D( Pipeline );
 
-    tDebug() << Q_FUNC_INFO << "Shunting" << d->queries_pending.size() << "queries!";
+    tDebug() << Q_FUNC_INFO << "Shunting" << d->queries_pending.count() << "queries!";
     d->running = true;
     emit running();
 
@@ -142,6 +159,16 @@ Pipeline::removeResolver( Resolver* r )
 
     tDebug() << "Removed resolver:" << r->name();
     d->resolvers.removeAll( r );
+    d->resolverStats.remove( r );
+
+    QHash< QPair< QID, Resolver* >, qint64 >::iterator it = d->dispatchedAt.begin();
+    while ( it != d->dispatchedAt.end() )
+    {
+        if ( it.key().second == r )
+            it = d->dispatchedAt.erase( it );
+        else
+            ++it;
+    }
     if ( d->running ) {
         // Only notify if Pipeline is still active.
         emit resolverRemoved( r );
@@ -265,19 +292,18 @@ Pipeline::resolve( const QList<query_ptr>& qlist, bool prioritized, bool tempora
     {
         QMutexLocker lock( &d->mut );
 
-        int i = 0;
+        // prioritized queries go to the front in the order given, already pending ones included
+        QList< query_ptr > prioritizedQueries;
         foreach ( const query_ptr& q, qlist )
         {
             if ( q->resolvingFinished() )
                 continue;
             if ( d->qidsState.contains( q->id() ) )
                 continue;
-            if ( d->queries_pending.contains( q ) )
+            if ( d->queries_pending.contains( q->id() ) )
             {
                 if ( prioritized )
-                {
-                    d->queries_pending.insert( i++, d->queries_pending.takeAt( d->queries_pending.indexOf( q ) ) );
-                }
+                    prioritizedQueries << q;
                 continue;
             }
 
@@ -285,9 +311,9 @@ Pipeline::resolve( const QList<query_ptr>& qlist, bool prioritized, bool tempora
                 d->qids.insert( q->id(), q );
 
             if ( prioritized )
-                d->queries_pending.insert( i++, q );
+                prioritizedQueries << q;
             else
-                d->queries_pending << q;
+                d->queries_pending.append( q->id(), q );
 
             if ( temporaryQuery )
             {
@@ -298,6 +324,9 @@ Pipeline::resolve( const QList<query_ptr>& qlist, bool prioritized, bool tempora
                 d->temporaryQueryTimer.start();
             }
         }
+
+        for ( int i = prioritizedQueries.count() - 1; i >= 0; i-- )
+            d->queries_pending.prepend( prioritizedQueries.at( i )->id(), prioritizedQueries.at( i ) );
     }
 
     shuntNext();
@@ -313,6 +342,31 @@ Pipeline::isResolving( const query_ptr& q ) const
 }
 
 
+ResolutionCache*
+Pipeline::resolutionCache() const
+{
+    Q_D( const Pipeline );
+    return d->cache;
+}
+
+
+QList< int >
+Pipeline::latencyBuckets()
+{
+    return QList< int >() << 100 << 250 << 500 << 1000 << 2500 << 5000 << 10000 << 25000;
+}
+
+
+Pipeline::ResolverStatistics
+Pipeline::resolverStatistics( Resolver* r ) const
+{
+    Q_D( const Pipeline );
+    QMutexLocker lock( &const_cast< PipelinePrivate* >( d )->mut );
+
+    return d->resolverStats.value( r );
+}
+
+
 void
 Pipeline::resolve( const query_ptr& q, bool prioritized, bool temporaryQuery )
 {
@@ -367,6 +421,8 @@ Pipeline::reportResults( QID qid, Tomahawk::Resolver* r, const QList< result_ptr
     if ( q.isNull() )
         return;
 
+    finishDispatch( q, r, false );
+
     QList< result_ptr > cleanResults;
     QList< result_ptr > httpResults;
     foreach ( const result_ptr& r, results )
@@ -381,13 +437,18 @@ Pipeline::reportResults( QID qid, Tomahawk::Resolver* r, const QList< result_ptr
     }
 
     addResultsToQuery( q, cleanResults );
+    skipLowerResolvers( q, r, cleanResults );
     if ( !httpResults.isEmpty() )
     {
         const ResultUrlChecker* checker = new ResultUrlChecker( q, r, httpResults );
         connect( checker, SIGNAL( done() ), SLOT( onResultUrlCheckerDone() ) );
+
+        // the cache only learns about web results once they passed the check
+        d->uncheckedResults.insert( checker, cleanResults );
     }
     else
     {
+        storeCachedResults( q, r, cleanResults );
         decQIDState( q, r );
     }
 
@@ -432,6 +493,7 @@ Pipeline::addResultsToQuery( const query_ptr& query, const QList< result_ptr >&
 void
 Pipeline::onResultUrlCheckerDone()
 {
+    Q_D( Pipeline );
     ResultUrlChecker* checker = qobject_cast< ResultUrlChecker* >( sender() );
     if ( !checker )
         return;
@@ -440,13 +502,70 @@ Pipeline::onResultUrlCheckerDone()
 
     const query_ptr q = checker->query();
     addResultsToQuery( q, checker->validResults() );
+
+    // cached results don't count towards the resolver's answer, that one is still pending
+    if ( checker->userData() == resolutionCache() )
+        return;
+
+    Resolver* r = reinterpret_cast<Tomahawk::Resolver*>( checker->userData() );
+    storeCachedResults( q, r, d->uncheckedResults.take( checker ) + checker->validResults() );
+    skipLowerResolvers( q, r, checker->validResults() );
 /*    if ( q && !q->isFullTextQuery() )
     {
         checkQIDState( q, 0 );
         return;
     }*/
 
-    decQIDState( q, reinterpret_cast<Tomahawk::Resolver*>( checker->userData() ) );
+    decQIDState( q, r );
+}
+
+
+void
+Pipeline::storeCachedResults( const query_ptr& query, Tomahawk::Resolver* r, const QList< result_ptr >& results )
+{
+    Q_D( Pipeline );
+    if ( query->isFullTextQuery() || !r )
+        return;
+
+    // remember what matched for the next session, an empty answer replaces what we had before
+    QList< result_ptr > matches;
+    foreach ( const result_ptr& result, results )
+    {
+        if ( query->howSimilar( result ) >= MINSCORE )
+            matches << result;
+    }
+
+    d->cache->store( query, r, matches );
+}
+
+
+void
+Pipeline::addCachedResults( const query_ptr& query, Tomahawk::Resolver* r )
+{
+    Q_D( Pipeline );
+
+    const QList< result_ptr > results = d->cache->results( query, r );
+    if ( results.isEmpty() )
+        return;
+
+    tLog( LOGVERBOSE ) << "Using" << results.count() << "cached results of" << r->name() << "for" << query->toString();
+
+    QList< result_ptr > cleanResults;
+    QList< result_ptr > httpResults;
+    foreach ( const result_ptr& result, results )
+    {
+        if ( !result->checked() && ( result->url().startsWith( "http" ) && !result->url().startsWith( "http://localhost" ) ) )
+            httpResults << result;
+        else
+            cleanResults << result;
+    }
+
+    addResultsToQuery( query, cleanResults );
+    if ( !httpResults.isEmpty() )
+    {
+        const ResultUrlChecker* checker = new ResultUrlChecker( query, d->cache, httpResults );
+        connect( checker, SIGNAL( done() ), SLOT( onResultUrlCheckerDone() ) );
+    }
 }
 
 
@@ -560,6 +679,7 @@ Pipeline::timeoutShunt( const query_ptr& q, Tomahawk::Resolver* r )
     if ( !d->running )
         return;
 
+    finishDispatch( q, r, true );
     decQIDState( q, r );
 }
 
@@ -571,26 +691,17 @@ Pipeline::shunt( const query_ptr& q )
     if ( !d->running )
         return;
 
-    Resolver* r = 0;
+    QList< Resolver* > resolvers;
+    bool waiting = false;
     if ( !q->resolvingFinished() )
-        r = nextResolver( q );
-
-    if ( r )
     {
-        tLog( LOGVERBOSE ) << "Dispatching to resolver" << r->name() << r->timeout() << q->toString() << q->solved() << q->id();
-
-        incQIDState( q, r );
-        q->setCurrentResolver( r );
-        r->resolve( q );
-        emit resolving( q );
-
-        auto timeout = r->timeout();
-        if ( timeout == 0 )
-            timeout = DEFAULT_RESOLVER_TIMEOUT;
-
-        new FuncTimeout( timeout, std::bind( &Pipeline::timeoutShunt, this, q, r ), this );
+        if ( d->parallelDispatch )
+            resolvers = availableResolvers( q, &waiting );
+        else if ( Resolver* r = nextResolver( q ) )
+            resolvers << r;
     }
-    else
+
+    if ( resolvers.isEmpty() && !waiting )
     {
         // we get here if we disable a resolver while a query is resolving
         // OR we are just out of resolvers while query is still resolving
@@ -601,10 +712,183 @@ Pipeline::shunt( const query_ptr& q )
         return;
     }
 
+    foreach ( Resolver* r, resolvers )
+        dispatch( q, r );
+
+    if ( d->parallelDispatch )
+    {
+        if ( waiting )
+        {
+            // finishDispatch() gets us back here once one of the busy resolvers is done with another query
+            QMutexLocker lock( &d->mut );
+            if ( !d->queries_waiting.contains( q ) )
+                d->queries_waiting << q;
+        }
+        else
+        {
+            // everyone got asked, from now on we only wait for their answers
+            decQIDState( q, nullptr );
+        }
+    }
+
     shuntNext();
 }
 
 
+void
+Pipeline::dispatch( const query_ptr& q, Tomahawk::Resolver* r )
+{
+    Q_D( Pipeline );
+    tLog( LOGVERBOSE ) << "Dispatching to resolver" << r->name() << r->timeout() << q->toString() << q->solved() << q->id();
+
+    incQIDState( q, r );
+    q->setCurrentResolver( r );
+
+    {
+        QMutexLocker lock( &d->mut );
+        ResolverStatistics& stats = d->resolverStats[ r ];
+        stats.dispatched++;
+        stats.inFlight++;
+        d->dispatchedAt.insert( qMakePair( q->id(), r ), d->clock.elapsed() );
+    }
+
+    // answer from the cache right away, the resolver's own answer refreshes it
+    if ( !q->isFullTextQuery() )
+        addCachedResults( q, r );
+
+    r->resolve( q );
+    emit resolving( q );
+
+    auto timeout = r->timeout();
+    if ( timeout == 0 )
+        timeout = DEFAULT_RESOLVER_TIMEOUT;
+
+    d->timers->schedule( timeout, std::bind( &Pipeline::timeoutShunt, this, q, r ) );
+}
+
+
+void
+Pipeline::finishDispatch( const query_ptr& q, Tomahawk::Resolver* r, bool timedOut, bool skipped )
+{
+    Q_D( Pipeline );
+
+    QList< query_ptr > waiting;
+    {
+        QMutexLocker lock( &d->mut );
+
+        // only the first of answer, timeout or skip counts
+        QHash< QPair< QID, Resolver* >, qint64 >::iterator it = d->dispatchedAt.find( qMakePair( q->id(), r ) );
+        if ( it == d->dispatchedAt.end() )
+            return;
+
+        const qint64 latency = d->clock.elapsed() - it.value();
+        d->dispatchedAt.erase( it );
+
+        ResolverStatistics& stats = d->resolverStats[ r ];
+        stats.inFlight--;
+        if ( skipped )
+        {
+            stats.skipped++;
+        }
+        else if ( timedOut )
+        {
+            stats.timeouts++;
+        }
+        else
+        {
+            static const QList< int > buckets = latencyBuckets();
+            int bucket = 0;
+            while ( bucket < buckets.count() && latency > buckets.at( bucket ) )
+                bucket++;
+
+            if ( stats.histogram.isEmpty() )
+                stats.histogram.fill( 0, buckets.count() + 1 );
+            stats.histogram[ bucket ]++;
+            stats.answered++;
+            stats.totalAnswerMs += latency;
+        }
+
+        // r can take another query now
+        waiting = d->queries_waiting;
+        d->queries_waiting.clear();
+    }
+
+    foreach ( const query_ptr& query, waiting )
+        d->timers->schedule( 0, std::bind( &Pipeline::shunt, this, query ) );
+}
+
+
+void
+Pipeline::skipLowerResolvers( const query_ptr& q, Tomahawk::Resolver* r, const QList< result_ptr >& results )
+{
+    Q_D( Pipeline );
+    if ( !d->parallelDispatch || !r || q->isFullTextQuery() )
+        return;
+
+    bool solved = false;
+    foreach ( const result_ptr& result, results )
+    {
+        if ( result->isOnline() && q->howSimilar( result ) >= SOLVED_SCORE )
+        {
+            solved = true;
+            break;
+        }
+    }
+    if ( !solved )
+        return;
+
+    QList< Resolver* > skipped;
+    {
+        QMutexLocker lock( &d->mut );
+        d->solvedWeight[ q->id() ] = qMax( d->solvedWeight.value( q->id() ), r->weight() );
+
+        foreach ( Resolver* pending, d->qidsState.values( q->id() ) )
+        {
+            if ( pending && pending != r && pending->weight() < r->weight() && !skipped.contains( pending ) )
+                skipped << pending;
+        }
+    }
+
+    // we can't call off a resolver, but we don't have to wait for it anymore.
+    // Whatever it still finds for this query gets added as usual.
+    foreach ( Resolver* pending, skipped )
+    {
+        tLog( LOGVERBOSE ) << "Not waiting for" << pending->name() << "anymore, found by" << r->name() << q->toString();
+        finishDispatch( q, pending, false, true );
+        decQIDState( q, pending );
+    }
+}
+
+
+QList< Tomahawk::Resolver* >
+Pipeline::availableResolvers( const Tomahawk::query_ptr& query, bool* waiting ) const
+{
+    Q_D( const Pipeline );
+    QMutexLocker lock( &const_cast< PipelinePrivate* >( d )->mut );
+
+    const unsigned int solvedWeight = d->solvedWeight.value( query->id() );
+    const QList< QPointer< Resolver > > resolvedBy = query->resolvedBy();
+
+    QList< Resolver* > resolvers;
+    *waiting = false;
+    foreach ( Resolver* r, d->resolvers )
+    {
+        if ( resolvedBy.contains( r ) || r->weight() < solvedWeight )
+            continue;
+
+        if ( d->resolverStats.value( r ).inFlight >= MAX_QUERIES_PER_RESOLVER )
+        {
+            *waiting = true;
+            continue;
+        }
+
+        resolvers << r;
+    }
+
+    return resolvers;
+}
+
+
 Tomahawk::Resolver*
 Pipeline::nextResolver( const Tomahawk::query_ptr& query ) const
 {
@@ -640,16 +924,17 @@ Pipeline::checkQIDState( const Tomahawk::query_ptr& query )
 
     if ( d->qidsState.contains( query->id() ) )
     {
-        new FuncTimeout( 0, std::bind( &Pipeline::shunt, this, query ), this );
+        d->timers->schedule( 0, std::bind( &Pipeline::shunt, this, query ) );
     }
     else
     {
         query->onResolvingFinished();
+        d->solvedWeight.remove( query->id() );
 
         if ( !d->queries_temporary.contains( query ) )
             d->qids.remove( query->id() );
 
-        new FuncTimeout( 0, std::bind( &Pipeline::shuntNext, this ), this );
+        d->timers->schedule( 0, std::bind( &Pipeline::shuntNext, this ) );
     }
 }
 
@@ -660,6 +945,8 @@ Pipeline::incQIDState( const Tomahawk::query_ptr& query, Tomahawk::Resolver* r )
     Q_D( Pipeline );
     QMutexLocker lock( &d->mut );
 
+    if ( !d->qidsState.contains( query->id() ) )
+        d->activeQueries++;
     d->qidsState.insert( query->id(), r );
 }
 
@@ -674,6 +961,8 @@ Pipeline::decQIDState( const Tomahawk::query_ptr& query, Tomahawk::Resolver* r )
         {
             QMutexLocker lock( &d->mut );
             d->qidsState.remove( query->id(), r ); // Removes all matching pairs
+            if ( !d->qidsState.contains( query->id() ) )
+                d->activeQueries--;
         }
 
         checkQIDState( query );
@@ -690,14 +979,13 @@ Pipeline::onTemporaryQueryTimer()
     QMutexLocker lock( &d->mut );
     d->temporaryQueryTimer.stop();
 
-    for ( int i = d->queries_temporary.count() - 1; i >= 0; i-- )
+    foreach ( const query_ptr& q, d->queries_temporary )
     {
-        query_ptr q = d->queries_temporary.takeAt( i );
-
         d->qids.remove( q->id() );
         foreach ( const Tomahawk::result_ptr& r, q->results() )
             d->rids.remove( r->id() );
     }
+    d->queries_temporary.clear();
 }
 
 
@@ -28,6 +28,7 @@
 #include <QObject>
 #include <QList>
 #include <QStringList>
+#include <QVector>
 
 #include <functional>
 
@@ -35,6 +36,7 @@ namespace Tomahawk
 {
 
 class PipelinePrivate;
+class ResolutionCache;
 class Resolver;
 class ExternalResolver;
 typedef std::function<Tomahawk::ExternalResolver*( QString, QString, QStringList )> ResolverFactoryFunc;
@@ -44,8 +46,29 @@ class DLLEXPORT Pipeline : public QObject
 Q_OBJECT
 
 public:
+    /// How fast one resolver answered the queries we sent it
+    struct ResolverStatistics
+    {
+        ResolverStatistics() : dispatched( 0 ), inFlight( 0 ), answered( 0 ), timeouts( 0 ), skipped( 0 ), totalAnswerMs( 0 ) {}
+
+        quint64 dispatched;
+        int inFlight;
+        quint64 answered;
+        quint64 timeouts;
+        /// Not waited for anymore since a higher weighted resolver found the track
+        quint64 skipped;
+        quint64 totalAnswerMs;
+        /// Answers per latencyBuckets() entry, plus one for the slower ones
+        QVector< quint64 > histogram;
+
+        qint64 averageAnswerMs() const { return answered ? totalAnswerMs / answered : 0; }
+    };
+
     static Pipeline* instance();
 
+    /// Upper bounds in milliseconds of the ResolverStatistics histogram buckets
+    static QList< int > latencyBuckets();
+
     explicit Pipeline( QObject* parent = nullptr );
     virtual ~Pipeline();
 
@@ -75,6 +98,9 @@ public:
 
     bool isResolving( const query_ptr& q ) const;
 
+    Tomahawk::ResolutionCache* resolutionCache() const;
+    ResolverStatistics resolverStatistics( Tomahawk::Resolver* r ) const;
+
 public slots:
     void resolve( const query_ptr& q, bool prioritized = true, bool temporaryQuery = false );
     void resolve( const QList<query_ptr>& qlist, bool prioritized = true, bool temporaryQuery = false );
@@ -102,12 +128,19 @@ private slots:
 
     void onTemporaryQueryTimer();
     void onResultUrlCheckerDone( );
+    void onSettingsChanged();
 
 private:
     Q_DECLARE_PRIVATE( Pipeline )
 
     void addResultsToQuery( const query_ptr& query, const QList< result_ptr >& results );
+    void addCachedResults( const query_ptr& query, Tomahawk::Resolver* r );
+    void storeCachedResults( const query_ptr& query, Tomahawk::Resolver* r, const QList< result_ptr >& results );
     Tomahawk::Resolver* nextResolver( const Tomahawk::query_ptr& query ) const;
+    QList< Tomahawk::Resolver* > availableResolvers( const Tomahawk::query_ptr& query, bool* waiting ) const;
+    void dispatch( const Tomahawk::query_ptr& query, Tomahawk::Resolver* r );
+    void finishDispatch( const Tomahawk::query_ptr& query, Tomahawk::Resolver* r, bool timedOut, bool skipped = false );
+    void skipLowerResolvers( const Tomahawk::query_ptr& query, Tomahawk::Resolver* r, const QList< result_ptr >& results );
 
     void checkQIDState( const Tomahawk::query_ptr& query );
     void incQIDState( const Tomahawk::query_ptr& query, Tomahawk::Resolver* );
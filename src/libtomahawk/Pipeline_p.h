@@ -22,8 +22,15 @@
 #define PIPELINE_P_H
 
 #include "Pipeline.h"
+#include "ResolutionCache.h"
+#include "utils/IndexedQueue.h"
+#include "utils/TimerWheel.h"
 
+#include <QElapsedTimer>
+#include <QHash>
 #include <QMutex>
+#include <QPair>
+#include <QSet>
 #include <QTimer>
 
 namespace Tomahawk
@@ -34,7 +41,11 @@ class PipelinePrivate
 public:
     PipelinePrivate( Pipeline* q )
         : q_ptr( q )
+        , activeQueries( 0 )
         , running( false )
+        , timers( 0 )
+        , cache( 0 )
+        , parallelDispatch( true )
     {
     }
 
@@ -46,19 +57,39 @@ private:
     QList< QPointer<Tomahawk::ExternalResolver> > scriptResolvers;
     QList< ResolverFactoryFunc > resolverFactories;
     QMultiMap< QID, Tomahawk::Resolver* > qidsState;
+    // number of distinct QIDs in qidsState
+    unsigned int activeQueries;
     QMap< QID, query_ptr > qids;
     QMap< RID, result_ptr > rids;
 
     QMutex mut; // for m_qids, m_rids
 
     // store queries here until DB index is loaded, then shunt them all
-    QList< query_ptr > queries_pending;
+    Utils::IndexedQueue< QID, query_ptr > queries_pending;
     // store temporary queries here and clean up after timeout threshold
-    QList< query_ptr > queries_temporary;
+    QSet< query_ptr > queries_temporary;
 
     int maxConcurrentQueries;
     bool running;
     QTimer temporaryQueryTimer;
+    // resolver timeouts and deferred shunts
+    Utils::TimerWheel* timers;
+
+    // results of earlier sessions, handed out while the resolvers are still busy
+    ResolutionCache* cache;
+    // results that didn't need checking, they get cached along with the web results that pass the check
+    QHash< const QObject*, QList< result_ptr > > uncheckedResults;
+
+    // ask all resolvers at once instead of one after the other
+    bool parallelDispatch;
+    // queries that still have resolvers to go, which were all busy
+    QList< query_ptr > queries_waiting;
+    // weight of the best resolver that found a query's track, lower ones don't get asked anymore
+    QHash< QID, unsigned int > solvedWeight;
+
+    QElapsedTimer clock;
+    QHash< QPair< QID, Resolver* >, qint64 > dispatchedAt;
+    QHash< Resolver*, Pipeline::ResolverStatistics > resolverStats;
 
     static Pipeline* s_instance;
 };
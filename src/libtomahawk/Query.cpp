@@ -38,6 +38,30 @@
 using namespace Tomahawk;
 
 
+/**
+ * Cleanup symbols for minor naming differences.
+ *
+ * Equivalent to removing a QRegExp character class, but without compiling a
+ * regular expression every time a name is normalized.
+ */
+static QString
+stripSymbols( const QString& name )
+{
+    static const QString symbols = QString::fromUtf8( "-`~!@#$%^&*()_—+=|:;<>«»,.?/{}\'\"[]\\" );
+
+    QString stripped;
+    stripped.reserve( name.length() );
+    for ( int i = 0; i < name.length(); i++ )
+    {
+        const QChar c = name.at( i );
+        if ( !symbols.contains( c ) )
+            stripped.append( c );
+    }
+
+    return stripped;
+}
+
+
 query_ptr
 Query::get( const QString& artist, const QString& track, const QString& album, const QID& qid, bool autoResolve )
 {
@@ -149,6 +173,20 @@ Query::init()
     d->playable = false;
     d->saveResultHint = false;
     d->score = 0.0;
+
+    if ( isFullTextQuery() )
+    {
+        d->normalizedArtist = stripSymbols( DatabaseImpl::sortname( d->fullTextQuery, true ) );
+        d->normalizedAlbum = stripSymbols( DatabaseImpl::sortname( d->fullTextQuery ) );
+        d->normalizedTrack = d->normalizedAlbum;
+        d->normalizedArtistTrack = DatabaseImpl::sortname( d->fullTextQuery );
+    }
+    else if ( d->queryTrack )
+    {
+        d->normalizedArtist = stripSymbols( d->queryTrack->artistSortname() );
+        d->normalizedAlbum = stripSymbols( d->queryTrack->albumSortname() );
+        d->normalizedTrack = stripSymbols( d->queryTrack->trackSortname() );
+    }
 }
 
 
@@ -200,6 +238,7 @@ Query::addResults( const QList< Tomahawk::result_ptr >& newresults )
         foreach( const result_ptr& rp, newresults )
         {
             connect( rp.data(), SIGNAL( statusChanged() ), SLOT( onResultStatusChanged() ) );
+            connect( rp->track().data(), SIGNAL( updated() ), SLOT( onResultTrackUpdated() ), Qt::UniqueConnection );
         }
     }
 
@@ -266,6 +305,19 @@ Query::onResultStatusChanged()
 }
 
 
+void
+Query::onResultTrackUpdated()
+{
+    Q_D( Query );
+    {
+        QMutexLocker lock( &d->similarityMutex );
+        d->similarityCache.clear();
+    }
+
+    onResultStatusChanged();
+}
+
+
 void
 Query::removeResult( const Tomahawk::result_ptr& result )
 {
@@ -274,6 +326,11 @@ Query::removeResult( const Tomahawk::result_ptr& result )
         QMutexLocker lock( &d->mutex );
         d->results.removeAll( result );
     }
+    {
+        Q_D( Query );
+        QMutexLocker lock( &d->similarityMutex );
+        d->similarityCache.remove( result.data() );
+    }
 
     emit resultsRemoved( result );
     checkResults();
@@ -293,6 +350,10 @@ Query::clearResults()
         QMutexLocker lock( &d->mutex );
         d->results.clear();
     }
+    {
+        QMutexLocker lock( &d->similarityMutex );
+        d->similarityCache.clear();
+    }
 
     emit playableStateChanged( false );
     emit solvedStateChanged( false );
@@ -617,36 +678,45 @@ Query::score() const
 }
 
 
-// TODO make clever (ft. featuring live (stuff) etc)
 float
 Query::howSimilar( const Tomahawk::result_ptr& r )
 {
     Q_D( Query );
-    // result values
-    const QString& rArtistname = r->track()->artistSortname();
-    const QString& rAlbumname  = r->track()->albumSortname();
-    const QString& rTrackname  = r->track()->trackSortname();
-    QString qArtistname;
-    QString qAlbumname;
-    QString qTrackname;
+    const track_ptr track = r->track();
 
-    if ( isFullTextQuery() )
-    {
-        qArtistname = DatabaseImpl::sortname( d->fullTextQuery, true );
-        qAlbumname = DatabaseImpl::sortname( d->fullTextQuery );
-        qTrackname = qAlbumname;
-    }
-    else
     {
-        qArtistname = queryTrack()->artistSortname();
-        qAlbumname  = queryTrack()->albumSortname();
-        qTrackname  = queryTrack()->trackSortname();
+        QMutexLocker lock( &d->similarityMutex );
+        QHash< const Result*, QueryPrivate::SimilarityCacheEntry >::const_iterator it = d->similarityCache.constFind( r.data() );
+        if ( it != d->similarityCache.constEnd() && it->track == track.data() && !it->result.isNull() )
+            return it->score;
     }
 
-    //Cleanup symbols for minor naming differences
-    qArtistname.remove(QRegExp(QString::fromUtf8("[-`~!@#$%^&*()_—+=|:;<>«»,.?/{}\'\"\\[\\]\\\\]")));
-    qTrackname.remove(QRegExp(QString::fromUtf8("[-`~!@#$%^&*()_—+=|:;<>«»,.?/{}\'\"\\[\\]\\\\]")));
-    qAlbumname.remove(QRegExp(QString::fromUtf8("[-`~!@#$%^&*()_—+=|:;<>«»,.?/{}\'\"\\[\\]\\\\]")));
+    QueryPrivate::SimilarityCacheEntry entry;
+    entry.result = r.toWeakRef();
+    entry.track = track.data();
+    entry.score = computeSimilarity( track );
+
+    QMutexLocker lock( &d->similarityMutex );
+    d->similarityCache.insert( r.data(), entry );
+
+    return entry.score;
+}
+
+
+// TODO make clever (ft. featuring live (stuff) etc)
+float
+Query::computeSimilarity( const Tomahawk::track_ptr& track ) const
+{
+    Q_D( const Query );
+    // result values
+    const QString& rArtistname = track->artistSortname();
+    const QString& rAlbumname  = track->albumSortname();
+    const QString& rTrackname  = track->trackSortname();
+
+    // query values, with symbols already stripped in init()
+    const QString& qArtistname = d->normalizedArtist;
+    const QString& qAlbumname  = d->normalizedAlbum;
+    const QString& qTrackname  = d->normalizedTrack;
 
     // normal edit distance
     const int artdist = TomahawkUtils::levenshtein( qArtistname, rArtistname );
@@ -671,8 +741,8 @@ Query::howSimilar( const Tomahawk::result_ptr& r )
 
     if ( isFullTextQuery() )
     {
-        const QString artistTrackname = DatabaseImpl::sortname( fullTextQuery() );
-        const QString rArtistTrackname = DatabaseImpl::sortname( r->track()->artist() + " " + r->track()->track() );
+        const QString& artistTrackname = d->normalizedArtistTrack;
+        const QString rArtistTrackname = DatabaseImpl::sortname( track->artist() + " " + track->track() );
 
         const int atrdist = TomahawkUtils::levenshtein( artistTrackname, rArtistTrackname );
         const int mlatr = qMax( artistTrackname.length(), rArtistTrackname.length() );
@@ -141,6 +141,7 @@ protected:
 
 private slots:
     void onResultStatusChanged();
+    void onResultTrackUpdated();
     void refreshResults();
 
 private:
@@ -154,6 +155,7 @@ private:
     Q_DECLARE_PRIVATE( Query )
 
     void init();
+    float computeSimilarity( const Tomahawk::track_ptr& track ) const;
 
     void setCurrentResolver( Tomahawk::Resolver* resolver );
     void clearResults();
@@ -3,6 +3,7 @@
 
 #include "Query.h"
 
+#include <QHash>
 #include <QMutex>
 
 namespace Tomahawk
@@ -56,6 +57,23 @@ private:
 
     track_ptr queryTrack;
 
+    // Query side of howSimilar(), normalized once in Query::init()
+    QString normalizedArtist;
+    QString normalizedAlbum;
+    QString normalizedTrack;
+    QString normalizedArtistTrack;
+
+    struct SimilarityCacheEntry
+    {
+        result_wptr result;
+        const Track* track;
+        float score;
+    };
+
+    // Per-result similarity scores, dropped when a result's track metadata changes
+    QHash< const Result*, SimilarityCacheEntry > similarityCache;
+    QMutex similarityMutex;
+
     mutable QMutex mutex;
     QWeakPointer< Tomahawk::Query > ownRef;
 };
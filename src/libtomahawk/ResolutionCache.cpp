@@ -0,0 +1,373 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ResolutionCache.h"
+
+#include "resolvers/Resolver.h"
+#include "utils/Logger.h"
+
+#include "Query.h"
+#include "Result.h"
+#include "TomahawkSettings.h"
+#include "Track.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+#include <algorithm>
+
+// bump this when changing the file format, old caches get discarded
+#define RESOLUTION_CACHE_VERSION 1
+// cached results are not handed out anymore after a week
+#define RESOLUTION_CACHE_TTL ( 7 * 24 * 60 * 60 * (qint64)1000 )
+// write changes to disk at most once a minute
+#define RESOLUTION_CACHE_SAVE_DELAY 60 * 1000
+
+using namespace Tomahawk;
+
+
+ResolutionCache::ResolutionCache( const QString& path, QObject* parent )
+    : QObject( parent )
+    , m_path( path )
+    , m_maxEntries( TomahawkSettings::instance()->resolutionCacheSize() )
+    , m_dirty( false )
+    , m_hits( 0 )
+    , m_misses( 0 )
+{
+    m_saveTimer.setSingleShot( true );
+    m_saveTimer.setInterval( RESOLUTION_CACHE_SAVE_DELAY );
+    connect( &m_saveTimer, SIGNAL( timeout() ), SLOT( save() ) );
+
+    load();
+}
+
+
+ResolutionCache::~ResolutionCache()
+{
+    save();
+}
+
+
+QString
+ResolutionCache::key( const query_ptr& query, Resolver* resolver )
+{
+    const track_ptr track = query->queryTrack();
+
+    // all at once, a %1 in a name must not get replaced by the next one
+    return QString( "%1\t%2\t%3\t%4" ).arg( track->artist().toLower().simplified(),
+                                           track->track().toLower().simplified(),
+                                           track->album().toLower().simplified(),
+                                           resolver->name() );
+}
+
+
+QVariant
+ResolutionCache::toVariant( const result_ptr& result )
+{
+    const track_ptr track = result->track();
+
+    QVariantMap m;
+    m[ "url" ] = result->url();
+    m[ "artist" ] = track->artist();
+    m[ "track" ] = track->track();
+    m[ "album" ] = track->album();
+    m[ "albumartist" ] = track->albumArtist();
+    m[ "composer" ] = track->composer();
+    m[ "duration" ] = track->duration();
+    m[ "albumpos" ] = track->albumpos();
+    m[ "discnumber" ] = track->discnumber();
+    m[ "bitrate" ] = result->bitrate();
+    m[ "size" ] = result->size();
+    m[ "mimetype" ] = result->mimetype();
+    m[ "source" ] = result->friendlySource();
+    m[ "purchaseUrl" ] = result->purchaseUrl();
+    m[ "linkUrl" ] = result->linkUrl();
+
+    return m;
+}
+
+
+result_ptr
+ResolutionCache::fromVariant( const QVariant& v, Resolver* resolver )
+{
+    const QVariantMap m = v.toMap();
+
+    const track_ptr track = Track::get( m.value( "artist" ).toString(),
+                                        m.value( "track" ).toString(),
+                                        m.value( "album" ).toString(),
+                                        m.value( "albumartist" ).toString(),
+                                        m.value( "duration" ).toInt(),
+                                        m.value( "composer" ).toString(),
+                                        m.value( "albumpos" ).toUInt(),
+                                        m.value( "discnumber" ).toUInt() );
+    if ( !track )
+        return result_ptr();
+
+    result_ptr result = Result::get( m.value( "url" ).toString(), track );
+    if ( !result )
+        return result_ptr();
+
+    result->setBitrate( m.value( "bitrate" ).toUInt() );
+    result->setSize( m.value( "size" ).toUInt() );
+    result->setMimetype( m.value( "mimetype" ).toString() );
+    result->setFriendlySource( m.value( "source" ).toString() );
+    result->setPurchaseUrl( m.value( "purchaseUrl" ).toString() );
+    result->setLinkUrl( m.value( "linkUrl" ).toString() );
+    result->setResolvedByResolver( resolver );
+
+    return result;
+}
+
+
+QList< result_ptr >
+ResolutionCache::results( const query_ptr& query, Resolver* resolver )
+{
+    QMutexLocker lock( &m_mutex );
+
+    QList< result_ptr > results;
+    if ( !m_maxEntries )
+        return results;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QHash< QString, Entry >::iterator it = m_entries.find( key( query, resolver ) );
+    if ( it != m_entries.end() && it->stored + RESOLUTION_CACHE_TTL < now )
+    {
+        m_entries.erase( it );
+        it = m_entries.end();
+        scheduleSave();
+    }
+
+    if ( it == m_entries.end() )
+    {
+        m_misses++;
+        return results;
+    }
+
+    m_hits++;
+    it->used = now;
+    foreach ( const QVariant& v, it->results )
+    {
+        const result_ptr result = fromVariant( v, resolver );
+        if ( result )
+            results << result;
+    }
+
+    return results;
+}
+
+
+void
+ResolutionCache::store( const query_ptr& query, Resolver* resolver, const QList< result_ptr >& results )
+{
+    QMutexLocker lock( &m_mutex );
+    if ( !m_maxEntries )
+        return;
+
+    // only remember what the resolver found itself, collections know their own tracks anyway
+    QVariantList vl;
+    foreach ( const result_ptr& result, results )
+    {
+        if ( result->resolvedByResolver().data() != resolver || !result->resolvedByCollection().isNull() )
+            continue;
+
+        vl << toVariant( result );
+    }
+
+    // the resolver doesn't find these anymore, don't keep handing out the old answer
+    if ( vl.isEmpty() )
+    {
+        if ( m_entries.remove( key( query, resolver ) ) )
+            scheduleSave();
+        return;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    Entry& entry = m_entries[ key( query, resolver ) ];
+    entry.stored = now;
+    entry.used = now;
+    entry.results = vl;
+
+    // don't sort the whole cache on every new entry
+    if ( m_entries.count() > m_maxEntries + m_maxEntries / 10 )
+        prune( m_maxEntries );
+
+    scheduleSave();
+}
+
+
+int
+ResolutionCache::count() const
+{
+    QMutexLocker lock( &m_mutex );
+    return m_entries.count();
+}
+
+
+quint64
+ResolutionCache::hits() const
+{
+    QMutexLocker lock( &m_mutex );
+    return m_hits;
+}
+
+
+quint64
+ResolutionCache::misses() const
+{
+    QMutexLocker lock( &m_mutex );
+    return m_misses;
+}
+
+
+void
+ResolutionCache::setMaxEntries( int entries )
+{
+    QMutexLocker lock( &m_mutex );
+
+    m_maxEntries = qMax( 0, entries );
+    prune( m_maxEntries );
+    scheduleSave();
+}
+
+
+void
+ResolutionCache::prune( int count )
+{
+    if ( m_entries.count() <= count )
+        return;
+
+    QList< qint64 > used;
+    used.reserve( m_entries.count() );
+    for ( QHash< QString, Entry >::const_iterator it = m_entries.constBegin(); it != m_entries.constEnd(); ++it )
+        used << it->used;
+
+    // everything used before the cutoff goes, so does part of what was used at exactly that time
+    std::nth_element( used.begin(), used.begin() + ( used.count() - count ), used.end() );
+    const qint64 cutoff = used.at( used.count() - count );
+    int excess = m_entries.count() - count;
+
+    QHash< QString, Entry >::iterator it = m_entries.begin();
+    while ( it != m_entries.end() && excess > 0 )
+    {
+        if ( it->used <= cutoff )
+        {
+            it = m_entries.erase( it );
+            excess--;
+        }
+        else
+            ++it;
+    }
+}
+
+
+void
+ResolutionCache::scheduleSave()
+{
+    m_dirty = true;
+
+    // we might get called from any thread, the timer lives in ours
+    QMetaObject::invokeMethod( &m_saveTimer, "start", Qt::QueuedConnection );
+}
+
+
+void
+ResolutionCache::load()
+{
+    QMutexLocker lock( &m_mutex );
+
+    QFile file( m_path );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return;
+
+    QDataStream in( &file );
+    in.setVersion( QDataStream::Qt_5_0 );
+
+    quint32 version = 0, count = 0;
+    in >> version;
+    if ( version != RESOLUTION_CACHE_VERSION )
+    {
+        tLog() << Q_FUNC_INFO << "Discarding resolution cache of version" << version;
+        return;
+    }
+
+    const qint64 expired = QDateTime::currentMSecsSinceEpoch() - RESOLUTION_CACHE_TTL;
+    in >> count;
+    m_entries.reserve( count );
+    for ( quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++ )
+    {
+        QString key;
+        Entry entry;
+        in >> key >> entry.stored >> entry.used >> entry.results;
+
+        if ( entry.stored > expired )
+            m_entries.insert( key, entry );
+    }
+
+    if ( in.status() != QDataStream::Ok )
+    {
+        tLog() << Q_FUNC_INFO << "Resolution cache is corrupt, discarding it";
+        m_entries.clear();
+    }
+
+    prune( m_maxEntries );
+    tLog() << Q_FUNC_INFO << "Loaded" << m_entries.count() << "cached resolutions";
+}
+
+
+void
+ResolutionCache::save()
+{
+    QMutexLocker lock( &m_mutex );
+    if ( !m_dirty )
+        return;
+
+    m_dirty = false;
+    QDir().mkpath( QFileInfo( m_path ).absolutePath() );
+
+    // a crash halfway through writing must not leave us with a truncated cache
+    QSaveFile file( m_path );
+    if ( !file.open( QIODevice::WriteOnly ) )
+    {
+        tLog() << Q_FUNC_INFO << "Could not write resolution cache:" << file.errorString();
+        return;
+    }
+
+    QDataStream out( &file );
+    out.setVersion( QDataStream::Qt_5_0 );
+
+    out << (quint32)RESOLUTION_CACHE_VERSION << (quint32)m_entries.count();
+    for ( QHash< QString, Entry >::const_iterator it = m_entries.constBegin(); it != m_entries.constEnd(); ++it )
+        out << it.key() << it->stored << it->used << it->results;
+
+    if ( !file.commit() )
+    {
+        tLog() << Q_FUNC_INFO << "Could not write resolution cache:" << file.errorString();
+        m_dirty = true;
+        return;
+    }
+
+    const quint64 lookups = m_hits + m_misses;
+    tDebug() << Q_FUNC_INFO << "Saved" << m_entries.count() << "cached resolutions,"
+             << m_hits << "hits," << m_misses << "misses"
+             << QString( "(%1% hit rate)" ).arg( lookups ? m_hits * 100 / lookups : 0 );
+}
@@ -0,0 +1,104 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef RESOLUTIONCACHE_H
+#define RESOLUTIONCACHE_H
+
+#include "DllMacro.h"
+#include "Typedefs.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QTimer>
+#include <QVariant>
+
+namespace Tomahawk
+{
+
+class Resolver;
+
+/**
+ * Remembers across restarts which results a resolver found for a query.
+ *
+ * Entries are keyed by the normalized artist, track and album of the query plus
+ * the resolver's name, and expire after a week. The Pipeline hands out cached
+ * results as soon as it dispatches a query to a resolver, while the resolver
+ * itself still gets asked and its answer replaces the entry once its web
+ * results passed the ResultUrlChecker. Cached results
+ * are never marked as checked, so web results go through the ResultUrlChecker
+ * again before they get added to a query.
+ *
+ * The least recently used entries get dropped once there are more than
+ * TomahawkSettings::resolutionCacheSize() of them.
+ */
+class DLLEXPORT ResolutionCache : public QObject
+{
+Q_OBJECT
+
+public:
+    explicit ResolutionCache( const QString& path, QObject* parent = 0 );
+    virtual ~ResolutionCache();
+
+    /// Results @p resolver found for @p query before, empty on a miss
+    QList< Tomahawk::result_ptr > results( const Tomahawk::query_ptr& query, Tomahawk::Resolver* resolver );
+    /// Replaces what we know about @p resolver's results for @p query, an empty list drops the entry
+    void store( const Tomahawk::query_ptr& query, Tomahawk::Resolver* resolver, const QList< Tomahawk::result_ptr >& results );
+
+    int count() const;
+    int maxEntries() const { return m_maxEntries; }
+    void setMaxEntries( int entries );
+
+    quint64 hits() const;
+    quint64 misses() const;
+
+public slots:
+    void save();
+
+private:
+    struct Entry
+    {
+        qint64 stored;
+        qint64 used;
+        QVariantList results;
+    };
+
+    static QString key( const Tomahawk::query_ptr& query, Tomahawk::Resolver* resolver );
+    static QVariant toVariant( const Tomahawk::result_ptr& result );
+    static Tomahawk::result_ptr fromVariant( const QVariant& v, Tomahawk::Resolver* resolver );
+
+    void load();
+    /// Drops the least recently used entries until we are at most @p count, needs m_mutex
+    void prune( int count );
+    void scheduleSave();
+
+    QString m_path;
+    QHash< QString, Entry > m_entries;
+    mutable QMutex m_mutex;
+    QTimer m_saveTimer;
+    int m_maxEntries;
+    bool m_dirty;
+
+    quint64 m_hits;
+    quint64 m_misses;
+};
+
+} // Tomahawk
+
+#endif // RESOLUTIONCACHE_H
@@ -26,6 +26,7 @@
 #include "resolvers/Resolver.h"
 #include "utils/TomahawkUtilsGui.h"
 #include "utils/Logger.h"
+#include "utils/WeakRegistry.h"
 
 #include "Album.h"
 #include "Pipeline.h"
@@ -39,8 +40,7 @@
 
 using namespace Tomahawk;
 
-static QHash< QString, result_wptr > s_results;
-static QMutex s_mutex;
+static Tomahawk::Utils::WeakRegistry< QString, Result > s_results;
 
 typedef QMap< QString, QPixmap > SourceIconCache;
 Q_GLOBAL_STATIC( SourceIconCache, sourceIconCache );
@@ -64,18 +64,13 @@ Result::get( const QString& url, const track_ptr& track )
         return result_ptr();
     }
 
-    QMutexLocker lock( &s_mutex );
-    if ( s_results.contains( url ) )
+    return s_results.valueOrInsert( url, [ &url, &track ]()
     {
-        return s_results.value( url );
-    }
-
-    result_ptr r = result_ptr( new Result( url, track ), &Result::deleteLater );
-    r->moveToThread( QCoreApplication::instance()->thread() );
-    r->setWeakRef( r.toWeakRef() );
-    s_results.insert( url, r );
-
-    return r;
+        result_ptr r = result_ptr( new Result( url, track ), &Result::deleteLater );
+        r->moveToThread( QCoreApplication::instance()->thread() );
+        r->setWeakRef( r.toWeakRef() );
+        return r;
+    } );
 }
 
 
@@ -87,13 +82,7 @@ Result::getCached( const QString& url )
         return result_ptr();
     }
 
-    QMutexLocker lock( &s_mutex );
-    if ( s_results.contains( url ) )
-    {
-        return s_results.value( url );
-    }
-
-    return result_ptr();
+    return s_results.value( url );
 }
 
 
@@ -121,12 +110,7 @@ Result::~Result()
 void
 Result::deleteLater()
 {
-    QMutexLocker lock( &s_mutex );
-
-    if ( s_results.contains( m_url ) )
-    {
-        s_results.remove( m_url );
-    }
+    s_results.remove( m_url );
 
     QObject::deleteLater();
 }
@@ -31,7 +31,6 @@
 #include "database/DatabaseCommand_LoadAllSources.h"
 #include "database/DatabaseCommand_SocialAction.h"
 #include "database/DatabaseCommand_SourceOffline.h"
-#include "database/DatabaseCommand_UpdateSearchIndex.h"
 #include "database/DatabaseImpl.h"
 #include "database/Database.h"
 #include "utils/Logger.h"
@@ -688,6 +687,30 @@ Source::addCommand( const dbcmd_ptr& command )
 }
 
 
+void
+Source::addCommands( const QList< dbcmd_ptr >& commands )
+{
+    Q_D( Source );
+
+    QMutexLocker lock( &d->cmdMutex );
+
+    for ( int i = 0; i < commands.count(); ++i )
+    {
+        const dbcmd_ptr& command = commands.at( i );
+        if ( i > 0 )
+            d->frameContinuations << command.data();
+
+        d->cmds << command;
+        if ( !command->singletonCmd() )
+        {
+            d->lastCmdGuid = command->guid();
+        }
+    }
+
+    d->commandCount = d->cmds.count();
+}
+
+
 void
 Source::executeCommands()
 {
@@ -710,7 +733,20 @@ Source::executeCommands()
         QMutexLocker lock( &d->cmdMutex );
         QList< Tomahawk::dbcmd_ptr > cmdGroup;
         Tomahawk::dbcmd_ptr cmd = d->cmds.takeFirst();
-        while ( cmd->groupable() )
+
+        // a frame of synced ops, applied as a whole in a single transaction
+        bool isFrame = false;
+        while ( !d->cmds.isEmpty() && d->frameContinuations.remove( d->cmds.first().data() ) )
+        {
+            if ( !isFrame )
+                cmdGroup << cmd;
+
+            isFrame = true;
+            cmd = d->cmds.takeFirst();
+            cmdGroup << cmd;
+        }
+
+        while ( !isFrame && cmd->groupable() )
         {
             cmdGroup << cmd;
             if ( !d->cmds.isEmpty() && d->cmds.first()->groupable() && d->cmds.first()->commandname() == cmd->commandname() )
@@ -722,7 +758,11 @@ Source::executeCommands()
         // return here when the last command finished
         connect( cmd.data(), SIGNAL( finished() ), SLOT( executeCommands() ) );
 
-        if ( !cmdGroup.isEmpty() )
+        if ( isFrame )
+        {
+            Database::instance()->enqueue( cmdGroup, true );
+        }
+        else if ( !cmdGroup.isEmpty() )
         {
             Database::instance()->enqueue( cmdGroup );
         }
@@ -778,11 +818,7 @@ Source::reportSocialAttributesChanged( DatabaseCommand_SocialAction* action )
 void
 Source::updateTracks()
 {
-    {
-        DatabaseCommand* cmd = new DatabaseCommand_UpdateSearchIndex();
-        Database::instance()->enqueue( Tomahawk::dbcmd_ptr( cmd ) );
-    }
-
+    // the search index got updated along with the files already, see DatabaseCommand_AddFiles
     {
         // Re-calculate local db stats
         DatabaseCommand_CollectionStats* cmd = new DatabaseCommand_CollectionStats( SourceList::instance()->get( id() ) );
@@ -149,6 +149,8 @@ private slots:
 
     void executeCommands();
     void addCommand( const dbcmd_ptr& command );
+    // adds a frame of commands that get applied in a single transaction
+    void addCommands( const QList< dbcmd_ptr >& commands );
 
 private:
     Q_DECLARE_PRIVATE( Source )
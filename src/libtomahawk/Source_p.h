@@ -23,6 +23,7 @@
 
 #include "Source.h"
 
+#include <QSet>
 #include <QTimer>
 
 namespace Tomahawk
@@ -71,6 +72,8 @@ private:
 
     QPointer<ControlConnection> cc;
     QList< Tomahawk::dbcmd_ptr > cmds;
+    // commands that belong to the same transaction as the one before them in cmds
+    QSet< Tomahawk::DatabaseCommand* > frameContinuations;
     int commandCount;
     QString lastCmdGuid;
     QMutex setControlConnectionMutex;
@@ -730,6 +730,62 @@ TomahawkSettings::genericCacheVersion() const
 }
 
 
+bool
+TomahawkSettings::parallelResolving() const
+{
+    return value( "resolvers/parallel-dispatch", true ).toBool();
+}
+
+
+void
+TomahawkSettings::setParallelResolving( bool enabled )
+{
+    setValue( "resolvers/parallel-dispatch", enabled );
+}
+
+
+int
+TomahawkSettings::resolutionCacheSize() const
+{
+    return value( "resolvers/cache-size", 10000 ).toInt();
+}
+
+
+void
+TomahawkSettings::setResolutionCacheSize( int entries )
+{
+    setValue( "resolvers/cache-size", entries );
+}
+
+
+QString
+TomahawkSettings::fuzzyIndexBackend() const
+{
+    return value( "collection/fuzzy-index-backend", "lucene" ).toString();
+}
+
+
+void
+TomahawkSettings::setFuzzyIndexBackend( const QString& backend )
+{
+    setValue( "collection/fuzzy-index-backend", backend );
+}
+
+
+bool
+TomahawkSettings::databaseWriteAheadLog() const
+{
+    return value( "collection/database-wal", true ).toBool();
+}
+
+
+void
+TomahawkSettings::setDatabaseWriteAheadLog( bool enabled )
+{
+    setValue( "collection/database-wal", enabled );
+}
+
+
 QString
 TomahawkSettings::storageCacheLocation() const
 {
@@ -785,6 +841,20 @@ TomahawkSettings::setScannerTime( uint time )
 }
 
 
+uint
+TomahawkSettings::scannerTagReaders() const
+{
+    return value( "scanner/tagreaders", 0 ).toUInt();
+}
+
+
+void
+TomahawkSettings::setScannerTagReaders( uint threads )
+{
+    setValue( "scanner/tagreaders", threads );
+}
+
+
 bool
 TomahawkSettings::watchForChanges() const
 {
@@ -943,6 +1013,20 @@ TomahawkSettings::setMuted( bool muted )
 }
 
 
+unsigned int
+TomahawkSettings::prefetchTime() const
+{
+    return value( "audio/prefetch-time", 10 ).toUInt();
+}
+
+
+void
+TomahawkSettings::setPrefetchTime( unsigned int seconds )
+{
+    setValue( "audio/prefetch-time", seconds );
+}
+
+
 QString
 TomahawkSettings::proxyHost() const
 {
@@ -1476,6 +1560,34 @@ TomahawkSettings::setExternalPort(int externalPort)
 }
 
 
+int
+TomahawkSettings::streamWindowSize() const
+{
+    return value( "network/stream-window", 256 * 1024 ).toInt();
+}
+
+
+void
+TomahawkSettings::setStreamWindowSize( int bytes )
+{
+    setValue( "network/stream-window", bytes );
+}
+
+
+int
+TomahawkSettings::uploadLimit() const
+{
+    return value( "network/upload-limit", 0 ).toInt();
+}
+
+
+void
+TomahawkSettings::setUploadLimit( int kibPerSecond )
+{
+    setValue( "network/upload-limit", kibPerSecond );
+}
+
+
 QString
 TomahawkSettings::xmppBotServer() const
 {
@@ -56,6 +56,9 @@ public:
     bool hasScannerPaths() const;
     uint scannerTime() const;
     void setScannerTime( uint time );
+    /// Number of threads reading tags while scanning, 0 picks the scanner's default of two
+    uint scannerTagReaders() const;
+    void setScannerTagReaders( uint threads );
 
     QString downloadsPreferredFormat() const;
     void setDownloadsPreferredFormat( const QString& format );
@@ -71,6 +74,22 @@ public:
     uint genericCacheVersion() const;
     void setGenericCacheVersion( uint version );
 
+    /// Whether queries get sent to all resolvers at once, instead of one after the other
+    bool parallelResolving() const;
+    void setParallelResolving( bool enabled );
+
+    /// How many queries' results we remember across restarts, 0 to disable
+    int resolutionCacheSize() const;
+    void setResolutionCacheSize( int entries );
+
+    /// What keeps the collection's fuzzy index, "lucene" or "trigram". Switching rebuilds it on the next start
+    QString fuzzyIndexBackend() const;
+    void setFuzzyIndexBackend( const QString& backend );
+
+    /// Whether the collection database keeps a write-ahead log, so reading never waits for writing. Takes effect on the next start
+    bool databaseWriteAheadLog() const;
+    void setDatabaseWriteAheadLog( bool enabled );
+
     bool watchForChanges() const;
     void setWatchForChanges( bool watch );
 
@@ -110,6 +129,10 @@ public:
     bool muted() const;
     void setMuted( bool muted );
 
+    /// How many seconds before the end of a track we start loading the next one, 0 to disable
+    unsigned int prefetchTime() const;
+    void setPrefetchTime( unsigned int seconds );
+
     /// Playlist stuff
     QByteArray playlistColumnSizes( const QString& playlistid ) const;
     void setPlaylistColumnSizes( const QString& playlistid, const QByteArray& state );
@@ -176,6 +199,14 @@ public:
     int externalPort() const;
     void setExternalPort( int externalPort );
 
+    /// How many bytes of a stream we send to a peer may be waiting to be written to the socket
+    int streamWindowSize() const;
+    void setStreamWindowSize( int bytes );
+
+    /// Total upload rate for streams to peers in KiB/s, 0 for no limit
+    int uploadLimit() const;
+    void setUploadLimit( int kibPerSecond );
+
     QString proxyHost() const;
     void setProxyHost( const QString& host );
     QString proxyNoProxyHosts() const;
@@ -28,6 +28,7 @@
 #include "database/DatabaseCommand_ModifyInboxEntry.h"
 #include "resolvers/Resolver.h"
 #include "utils/Logger.h"
+#include "utils/WeakRegistry.h"
 
 #include "Album.h"
 #include "Pipeline.h"
@@ -42,9 +43,7 @@
 
 using namespace Tomahawk;
 
-QHash< QString, track_wptr > Track::s_tracksByName = QHash< QString, track_wptr >();
-
-static QMutex s_nameCacheMutex;
+static Tomahawk::Utils::WeakRegistry< QString, Track > s_tracksByName;
 
 
 inline QString
@@ -83,41 +82,27 @@ Track::get( const QString& artist, const QString& track, const QString& album, c
         return track_ptr();
     }
 
-    QMutexLocker lock( &s_nameCacheMutex );
     const QString key = cacheKey( artist, track, album, albumArtist, duration, composer, albumpos, discnumber );
-    if ( s_tracksByName.contains( key ) )
+    return s_tracksByName.valueOrInsert( key, [&]()
     {
-        track_wptr track = s_tracksByName.value( key );
-        if ( track )
-            return track.toStrongRef();
-    }
-
-    track_ptr t = track_ptr( new Track( artist, track, album, albumArtist, duration, composer, albumpos, discnumber ), &Track::deleteLater );
-    t->moveToThread( QCoreApplication::instance()->thread() );
-    t->setWeakRef( t.toWeakRef() );
-    s_tracksByName.insert( key, t );
-
-    return t;
+        track_ptr t = track_ptr( new Track( artist, track, album, albumArtist, duration, composer, albumpos, discnumber ), &Track::deleteLater );
+        t->moveToThread( QCoreApplication::instance()->thread() );
+        t->setWeakRef( t.toWeakRef() );
+        return t;
+    } );
 }
 
 
 track_ptr
 Track::get( unsigned int id, const QString& artist, const QString& track, const QString& album, const QString& albumArtist, int duration, const QString& composer, unsigned int albumpos, unsigned int discnumber )
 {
-    QMutexLocker lock( &s_nameCacheMutex );
     const QString key = cacheKey( artist, track, album, albumArtist, duration, composer, albumpos, discnumber );
-    if ( s_tracksByName.contains( key ) )
+    return s_tracksByName.valueOrInsert( key, [&]()
     {
-        track_wptr track = s_tracksByName.value( key );
-        if ( track )
-            return track;
-    }
-
-    track_ptr t = track_ptr( new Track( id, artist, track, album, albumArtist, duration, composer, albumpos, discnumber ), &Track::deleteLater );
-    t->setWeakRef( t.toWeakRef() );
-    s_tracksByName.insert( key, t );
-
-    return t;
+        track_ptr t = track_ptr( new Track( id, artist, track, album, albumArtist, duration, composer, albumpos, discnumber ), &Track::deleteLater );
+        t->setWeakRef( t.toWeakRef() );
+        return t;
+    } );
 }
 
 
@@ -233,13 +218,8 @@ void
 Track::deleteLater()
 {
     Q_D( Track );
-    QMutexLocker lock( &s_nameCacheMutex );
 
-    const QString key = cacheKey( artist(), track(), d->album, d->albumArtist, d->duration, d->composer, d->albumpos, d->discnumber );
-    if ( s_tracksByName.contains( key ) )
-    {
-        s_tracksByName.remove( key );
-    }
+    s_tracksByName.remove( cacheKey( artist(), track(), d->album, d->albumArtist, d->duration, d->composer, d->albumpos, d->discnumber ) );
 
     QObject::deleteLater();
 }
@@ -338,6 +318,8 @@ Track::updateSortNames()
     Q_D( Track );
     d->composerSortname = DatabaseImpl::sortname( d->composer, true );
     d->albumSortname = DatabaseImpl::sortname( d->album );
+    d->composerSortKey = TomahawkUtils::collationKey( d->composerSortname );
+    d->albumSortKey = TomahawkUtils::collationKey( d->albumSortname );
 }
 
 
@@ -799,6 +781,38 @@ Track::share( const Tomahawk::source_ptr& source )
 }
 
 
+const QCollatorSortKey&
+Track::composerSortKey() const
+{
+    Q_D( const Track );
+    return d->composerSortKey;
+}
+
+
+const QCollatorSortKey&
+Track::albumSortKey() const
+{
+    Q_D( const Track );
+    return d->albumSortKey;
+}
+
+
+const QCollatorSortKey&
+Track::artistSortKey() const
+{
+    Q_D( const Track );
+    return d->trackData->artistSortKey();
+}
+
+
+const QCollatorSortKey&
+Track::trackSortKey() const
+{
+    Q_D( const Track );
+    return d->trackData->trackSortKey();
+}
+
+
 const QString&
 Track::artistSortname() const
 {
@@ -27,6 +27,7 @@
 #include "SocialAction.h"
 #include "Typedefs.h"
 
+#include <QCollator>
 #include <QList>
 #include <QVariant>
 
@@ -72,6 +73,11 @@ public:
     const QString& albumSortname() const;
     const QString& artistSortname() const;
     const QString& trackSortname() const;
+    /// Collation keys of the sort names above (and of track()), for cheap locale-aware sorting
+    const QCollatorSortKey& composerSortKey() const;
+    const QCollatorSortKey& albumSortKey() const;
+    const QCollatorSortKey& artistSortKey() const;
+    const QCollatorSortKey& trackSortKey() const;
 
     QString artist() const;
     QString albumArtist() const;
@@ -152,8 +158,6 @@ private:
     void updateSortNames();
 
     void setAllSocialActions( const QList< SocialAction >& socialActions );
-
-    static QHash< QString, track_wptr > s_tracksByName;
 };
 
 } // namespace Tomahawk
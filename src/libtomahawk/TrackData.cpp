@@ -35,6 +35,8 @@
 #include "database/IdThreadWorker.h"
 #include "resolvers/Resolver.h"
 #include "utils/Logger.h"
+#include "utils/TomahawkUtils.h"
+#include "utils/WeakRegistry.h"
 
 #include "Album.h"
 #include "PlaylistEntry.h"
@@ -46,11 +48,11 @@
 
 using namespace Tomahawk;
 
-QHash< QString, trackdata_wptr > TrackData::s_trackDatasByName = QHash< QString, trackdata_wptr >();
-QHash< unsigned int, trackdata_wptr > TrackData::s_trackDatasById = QHash< unsigned int, trackdata_wptr >();
+static Tomahawk::Utils::WeakRegistry< QString, TrackData > s_trackDatasByName;
+static Tomahawk::Utils::WeakRegistry< unsigned int, TrackData > s_trackDatasById;
 
-static QMutex s_datanameCacheMutex;
 static QMutex s_memberMutex;
+// guards m_trackId and m_waitingForId
 static QReadWriteLock s_dataidMutex;
 
 inline QString
@@ -66,47 +68,40 @@ cacheKey( const QString& artist, const QString& track )
 trackdata_ptr
 TrackData::get( unsigned int id, const QString& artist, const QString& track )
 {
-    s_dataidMutex.lockForRead();
-    if ( s_trackDatasById.contains( id ) )
+    if ( id > 0 )
     {
-        trackdata_wptr track = s_trackDatasById.value( id );
-        s_dataidMutex.unlock();
-
-        if ( track )
-            return track;
+        trackdata_ptr t = s_trackDatasById.value( id );
+        if ( t )
+            return t;
     }
-    s_dataidMutex.unlock();
 
-    QMutexLocker lock( &s_datanameCacheMutex );
-    const QString key = cacheKey( artist, track );
-    if ( s_trackDatasByName.contains( key ) )
+    bool created = false;
+    trackdata_ptr data = s_trackDatasByName.valueOrInsert( cacheKey( artist, track ), [&]()
     {
-        trackdata_wptr track = s_trackDatasByName.value( key );
-        if ( track )
-            return track;
-    }
-
-    trackdata_ptr t = trackdata_ptr( new TrackData( id, artist, track ), &TrackData::deleteLater );
-    t->moveToThread( QCoreApplication::instance()->thread() );
-    t->setWeakRef( t.toWeakRef() );
-    s_trackDatasByName.insert( key, t );
-
-    if ( id > 0 )
+        trackdata_ptr t = trackdata_ptr( new TrackData( id, artist, track ), &TrackData::deleteLater );
+        t->moveToThread( QCoreApplication::instance()->thread() );
+        t->setWeakRef( t.toWeakRef() );
+        created = true;
+        return t;
+    } );
+
+    if ( created )
     {
-        s_dataidMutex.lockForWrite();
-        s_trackDatasById.insert( id, t );
-        s_dataidMutex.unlock();
+        if ( id > 0 )
+            s_trackDatasById.insert( id, data );
+        else
+            data->loadId( false );
     }
-    else
-        t->loadId( false );
 
-    return t;
+    return data;
 }
 
 
 TrackData::TrackData( unsigned int id, const QString& artist, const QString& track )
     : m_artist( artist )
     , m_track( track )
+    , m_artistSortKey( TomahawkUtils::collationKey( QString() ) )
+    , m_trackSortKey( TomahawkUtils::collationKey( QString() ) )
     , m_year( 0 )
     , m_attributesLoaded( false )
     , m_socialActionsLoaded( false )
@@ -133,23 +128,14 @@ TrackData::~TrackData()
 void
 TrackData::deleteLater()
 {
-    QMutexLocker lock( &s_datanameCacheMutex );
+    s_trackDatasByName.remove( cacheKey( m_artist, m_track ) );
 
-    const QString key = cacheKey( m_artist, m_track );
-    if ( s_trackDatasByName.contains( key ) )
-    {
-        s_trackDatasByName.remove( key );
-    }
+    s_dataidMutex.lockForRead();
+    const unsigned int id = m_trackId;
+    s_dataidMutex.unlock();
 
-    if ( m_trackId > 0 )
-    {
-        s_dataidMutex.lockForWrite();
-        if ( s_trackDatasById.contains( m_trackId ) )
-        {
-            s_trackDatasById.remove( m_trackId );
-        }
-        s_dataidMutex.unlock();
-    }
+    if ( id > 0 )
+        s_trackDatasById.remove( id );
 
     QObject::deleteLater();
 }
@@ -160,6 +146,8 @@ TrackData::updateSortNames()
 {
     m_artistSortname = DatabaseImpl::sortname( m_artist, true );
     m_trackSortname = DatabaseImpl::sortname( m_track );
+    m_artistSortKey = TomahawkUtils::collationKey( m_artistSortname );
+    m_trackSortKey = TomahawkUtils::collationKey( m_trackSortname );
 }
 
 
@@ -210,13 +198,12 @@ TrackData::trackId() const
         s_dataidMutex.lockForWrite();
         m_trackId = finalId;
         m_waitingForId = false;
-
-        if ( m_trackId > 0 )
-        {
-            s_trackDatasById.insert( m_trackId, m_ownRef.toStrongRef() );
-        }
-
         s_dataidMutex.unlock();
+
+        // don't hold any lock here, dropping the last reference runs deleteLater()
+        trackdata_ptr self = m_ownRef.toStrongRef();
+        if ( finalId > 0 && self )
+            s_trackDatasById.insert( finalId, self );
     }
 
     return finalId;
@@ -19,6 +19,7 @@
 #ifndef TRACKDATA_H
 #define TRACKDATA_H
 
+#include <QCollator>
 #include <QObject>
 #include <QList>
 #include <QFuture>
@@ -57,6 +58,9 @@ public:
 
     const QString& artistSortname() const { return m_artistSortname; }
     const QString& trackSortname() const { return m_trackSortname; }
+    /// Collation keys of artistSortname() and track(), for sorting
+    const QCollatorSortKey& artistSortKey() const { return m_artistSortKey; }
+    const QCollatorSortKey& trackSortKey() const { return m_trackSortKey; }
 
     QWeakPointer< Tomahawk::TrackData > weakRef() { return m_ownRef; }
     void setWeakRef( QWeakPointer< Tomahawk::TrackData > weakRef ) { m_ownRef = weakRef; }
@@ -76,7 +80,7 @@ public:
 
     void loadAttributes();
     QVariantMap attributes() const { return m_attributes; }
-    void setAttributes( const QVariantMap& map ) { m_attributes = map; updateAttributes(); }
+    void setAttributes( const QVariantMap& map ) { m_attributesLoaded = true; m_attributes = map; updateAttributes(); }
 
     void loadSocialActions( bool force = false );
     QList< Tomahawk::SocialAction > allSocialActions() const;
@@ -123,6 +127,8 @@ private:
     QString m_track;
     QString m_artistSortname;
     QString m_trackSortname;
+    QCollatorSortKey m_artistSortKey;
+    QCollatorSortKey m_trackSortKey;
 
     int m_year;
 
@@ -153,9 +159,6 @@ private:
 
     QWeakPointer< Tomahawk::TrackData > m_ownRef;
 
-    static QHash< QString, trackdata_wptr > s_trackDatasByName;
-    static QHash< unsigned int, trackdata_wptr > s_trackDatasById;
-
     friend class IdThreadWorker;
     friend class DatabaseCommand_LogPlayback;
     friend class DatabaseCommand_PlaybackHistory;
@@ -24,6 +24,8 @@
 
 #include "Track.h"
 
+#include "utils/TomahawkUtils.h"
+
 namespace Tomahawk {
 
 class TrackPrivate
@@ -37,6 +39,8 @@ public:
         , duration( _duration )
         , albumpos( _albumpos )
         , discnumber( _discnumber )
+        , composerSortKey( TomahawkUtils::collationKey( QString() ) )
+        , albumSortKey( TomahawkUtils::collationKey( QString() ) )
     {
     }
 
@@ -54,6 +58,9 @@ private:
     uint albumpos;
     uint discnumber;
 
+    QCollatorSortKey composerSortKey;
+    QCollatorSortKey albumSortKey;
+
     mutable Tomahawk::artist_ptr artistPtr;
     mutable Tomahawk::artist_ptr albumArtistPtr;
     mutable Tomahawk::album_ptr albumPtr;
@@ -49,6 +49,8 @@
 using namespace Tomahawk;
 
 #define AUDIO_VOLUME_STEP 5
+// how much of a prefetched network stream we buffer before the track starts
+#define PREFETCH_BUFFER_SIZE ( 2 * 1024 * 1024 )
 
 static const uint_fast8_t UNDERRUNTHRESHOLD = 2;
 
@@ -96,7 +98,16 @@ AudioEnginePrivate::onStateChanged( AudioOutput::AudioState newState, AudioOutpu
         audioRetryCounter = 0;
 
         if ( emitSignal )
+        {
+            if ( loadTimer.isValid() )
+            {
+                tLog() << Q_FUNC_INFO << "Time to first sample:" << loadTimer.elapsed() << "ms"
+                       << ( loadedFromPrefetch ? "(prefetched)" : "" );
+                loadTimer.invalidate();
+            }
+
             emit q_ptr->started( currentTrack );
+        }
     }
     else if ( newState == AudioOutput::Paused )
     {
@@ -293,6 +304,8 @@ AudioEngine::stop( AudioErrorCode errorCode )
         emit timerPercentage( ( (double)d->timeElapsed / (double)d->currentTrack->track()->duration() ) * 100.0 );
 
     setCurrentTrack( Tomahawk::result_ptr() );
+    clearPrefetch();
+    d->prefetchedFor.clear();
 
     if ( d->waitingOnNewTrack )
         sendWaitingNotification();
@@ -598,6 +611,26 @@ AudioEngine::loadTrack( const Tomahawk::result_ptr& result )
 
     setCurrentTrack( result );
 
+    d->loadTimer.start();
+    d->prefetchTime = (qint64)TomahawkSettings::instance()->prefetchTime() * 1000;
+    d->loadedFromPrefetch = ( result == d->prefetchTrack );
+    if ( d->loadedFromPrefetch )
+    {
+        if ( d->prefetchReady )
+        {
+            tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Using prefetched stream for" << result->url();
+            const QString url = d->prefetchUrl;
+            const QSharedPointer< QIODevice > io = d->prefetchInput;
+            clearPrefetch();
+
+            performLoadTrack( result, url, io );
+        }
+
+        // otherwise the prefetch is still under way and loads the track once it's done
+        return;
+    }
+    clearPrefetch();
+
     ScriptJob* job = result->resolvedBy()->getStreamUrl( result );
     connect( job, SIGNAL( done( QVariantMap ) ), SLOT( gotStreamUrl( QVariantMap ) ) );
     job->setProperty( "result", QVariant::fromValue( result ) );
@@ -710,9 +743,28 @@ AudioEngine::performLoadTrack( const Tomahawk::result_ptr result, const QString&
     Q_D( AudioEngine );
     if ( currentTrack() != result )
     {
+        if ( result && result == d->prefetchTrack )
+        {
+            // keep it until the current track ends
+            tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Prefetched:" << url;
+            d->prefetchUrl = url;
+            d->prefetchInput = io;
+            d->prefetchReady = true;
+
+            // don't download the whole track before we even know it will be played
+            QSharedPointer<QNetworkReply> qnr = io.objectCast<QNetworkReply>();
+            if ( !qnr.isNull() )
+                qnr->setReadBufferSize( PREFETCH_BUFFER_SIZE );
+
+            return;
+        }
+
         tLog( LOGVERBOSE ) << Q_FUNC_INFO << "Track loaded too late, skip.";
         return;
     }
+    if ( result == d->prefetchTrack )
+        clearPrefetch();
+
     tDebug( LOGEXTRA ) << Q_FUNC_INFO << ( result.isNull() ? QString() : result->url() );
     QSharedPointer< QIODevice > ioToKeep = io;
 
@@ -738,6 +790,8 @@ AudioEngine::performLoadTrack( const Tomahawk::result_ptr result, const QString&
                 QSharedPointer<QNetworkReply> qnr = io.objectCast<QNetworkReply>();
                 if ( !qnr.isNull() )
                 {
+                    // a prefetched reply was limited to its first few MB
+                    qnr->setReadBufferSize( 0 );
                     d->audioOutput->setCurrentSource( new QNR_IODeviceStream( qnr, this ) );
                     // We keep track of the QNetworkReply in QNR_IODeviceStream
                     // and AudioOutput handles the deletion of the
@@ -902,6 +956,54 @@ AudioEngine::loadNextTrack()
 }
 
 
+void
+AudioEngine::prefetchNextTrack()
+{
+    Q_D( AudioEngine );
+
+    if ( d->currentTrack.isNull() )
+        return;
+    if ( d->stopAfterTrack && d->stopAfterTrack->track()->equals( d->currentTrack->track() ) )
+        return;
+
+    // the same choice loadNextTrack() is going to make, without advancing the playlist
+    Tomahawk::result_ptr result;
+    if ( d->queue && d->queue->trackCount() )
+    {
+        query_ptr query = d->queue->tracks().first();
+        if ( query && query->numResults() )
+            result = query->results().first();
+    }
+    if ( result.isNull() && !d->playlist.isNull() )
+        result = d->playlist.data()->nextResult();
+
+    if ( result.isNull() || result == d->currentTrack || !result->resolvedBy() )
+        return;
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Prefetching next track:" << result->url();
+    clearPrefetch();
+    d->prefetchTrack = result;
+
+    ScriptJob* job = result->resolvedBy()->getStreamUrl( result );
+    connect( job, SIGNAL( done( QVariantMap ) ), SLOT( gotStreamUrl( QVariantMap ) ) );
+    job->setProperty( "result", QVariant::fromValue( result ) );
+    job->start();
+}
+
+
+void
+AudioEngine::clearPrefetch()
+{
+    Q_D( AudioEngine );
+
+    // a pending prefetch finds itself outdated in performLoadTrack()
+    d->prefetchTrack.clear();
+    d->prefetchUrl.clear();
+    d->prefetchInput.clear();
+    d->prefetchReady = false;
+}
+
+
 void
 AudioEngine::play( const QUrl& url )
 {
@@ -1109,6 +1211,16 @@ AudioEngine::timerTriggered( qint64 time )
 
     emit timerMilliSeconds( time );
 
+    if ( d->prefetchTime > 0 && d->currentTrack && d->prefetchedFor != d->currentTrack )
+    {
+        const qint64 total = currentTrackTotalTime();
+        if ( total > 0 && total - time <= d->prefetchTime )
+        {
+            d->prefetchedFor = d->currentTrack;
+            prefetchNextTrack();
+        }
+    }
+
     if ( d->timeElapsed != time / 1000 )
     {
         d->timeElapsed = time / 1000;
@@ -191,6 +191,7 @@ private slots:
     void performLoadTrack( const Tomahawk::result_ptr result, const QString& url, QSharedPointer< QIODevice > io ); //only call from loadTrack or performLoadIODevice kthxbi
     void loadPreviousTrack();
     void loadNextTrack();
+    void prefetchNextTrack();
 
     void onVolumeChanged( qreal volume );
     void timerTriggered( qint64 time );
@@ -206,6 +207,7 @@ private slots:
 private:
     void setState( AudioState state );
     void setCurrentTrackPlaylist( const Tomahawk::playlistinterface_ptr& playlist );
+    void clearPrefetch();
 
 //    void audioDataArrived( QMap< AudioEngine::AudioChannel, QVector< qint16 > >& data );
 
@@ -2,6 +2,7 @@
 
 #include <stdint.h>
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QTimer>
 #include <QQueue>
@@ -17,6 +18,9 @@ public:
         , audioRetryCounter( 0 )
         , underrunCount( 0 )
         , underrunNotified( false )
+        , prefetchReady( false )
+        , prefetchTime( 0 )
+        , loadedFromPrefetch( false )
     {
     }
     AudioEngine* q_ptr;
@@ -50,5 +54,19 @@ private:
 
     QTemporaryFile* coverTempFile;
 
+    // The track we expect to play next, resolved and opened before the current one ends
+    Tomahawk::result_ptr prefetchTrack;
+    QString prefetchUrl;
+    QSharedPointer<QIODevice> prefetchInput;
+    bool prefetchReady;
+    // the track during which we prefetched, so we only do it once per track
+    Tomahawk::result_ptr prefetchedFor;
+    // how many ms before the end of a track we start prefetching, 0 to disable
+    qint64 prefetchTime;
+
+    // measures the time from loading a track until the first sample is played
+    QElapsedTimer loadTimer;
+    bool loadedFromPrefetch;
+
     static AudioEngine* s_instance;
 };
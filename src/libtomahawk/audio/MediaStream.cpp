@@ -21,8 +21,17 @@
 #include "MediaStream.h"
 
 #include "utils/Logger.h"
+#include "utils/RingBuffer.h"
+
+#include <QMutexLocker>
 
 #define BLOCK_SIZE 1048576
+// how much of an IODevice we read ahead of VLC
+#define RING_SIZE ( 4 * BLOCK_SIZE )
+// ask for a refill once the ring is less than half full
+#define RING_LOW_WATERMARK ( RING_SIZE / 2 )
+// how long VLC waits for data on an empty ring before trying again later
+#define UNDERRUN_WAIT_MS 50
 
 MediaStream::MediaStream( QObject* parent )
     : QObject( parent )
@@ -46,16 +55,26 @@ MediaStream::MediaStream( QIODevice* device, bool bufferingFinished )
     , m_type( IODevice )
     , m_ioDevice ( device )
     , m_bufferingFinished( bufferingFinished )
+    , m_ring( new Tomahawk::Utils::RingBuffer( RING_SIZE ) )
 {
     if ( !bufferingFinished )
     {
         QObject::connect( m_ioDevice, SIGNAL( readChannelFinished() ), this, SLOT( bufferingFinished() ) );
     }
+    QObject::connect( m_ioDevice, SIGNAL( readyRead() ), this, SLOT( fillBuffer() ) );
+
+    fillBuffer();
 }
 
 
 MediaStream::~MediaStream()
 {
+    if ( m_type == IODevice )
+    {
+        tLog( LOGVERBOSE ) << Q_FUNC_INFO << "Buffer underruns:" << underruns();
+    }
+
+    delete m_ring;
 }
 
 
@@ -98,6 +117,126 @@ void
 MediaStream::bufferingFinished()
 {
     m_bufferingFinished = true;
+
+    if ( m_type == IODevice )
+    {
+        fillBuffer();
+    }
+}
+
+
+int
+MediaStream::underruns() const
+{
+    return m_underruns.loadAcquire();
+}
+
+
+void
+MediaStream::fillBuffer()
+{
+    m_fillRequested.storeRelease( 0 );
+
+    // VLC asked for a seek, seekDevice() will be next and refill from the new position
+    if ( m_type != IODevice || m_pendingSeeks.loadAcquire() > 0 || m_inputComplete.loadAcquire() )
+        return;
+
+    while ( m_ring->space() > 0 )
+    {
+        int len;
+        char* data = m_ring->writePointer( &len );
+
+        const qint64 read = m_ioDevice->read( data, len );
+        if ( read < 0 || ( read == 0 && m_bufferingFinished && m_ioDevice->atEnd() ) )
+        {
+            m_inputComplete.storeRelease( 1 );
+            break;
+        }
+        if ( read == 0 )
+        {
+            // nothing there yet, readyRead() gets us going again
+            break;
+        }
+
+        m_ring->commitWrite( read );
+    }
+
+    QMutexLocker locker( &m_dataMutex );
+    m_dataAvailable.wakeAll();
+}
+
+
+void
+MediaStream::seekDevice( qint64 pos )
+{
+    // VLC does not read while a seek is pending, so the ring is all ours
+    m_ioDevice->seek( pos );
+    m_ring->clear();
+    m_inputComplete.storeRelease( 0 );
+
+    if ( m_pendingSeeks.deref() )
+    {
+        // another seek is already on its way, don't bother filling for this one
+        return;
+    }
+
+    fillBuffer();
+}
+
+
+void
+MediaStream::requestFill()
+{
+    // one queued request at a time is plenty
+    if ( m_fillRequested.testAndSetOrdered( 0, 1 ) )
+    {
+        QMetaObject::invokeMethod( this, "fillBuffer", Qt::QueuedConnection );
+    }
+}
+
+
+qint64
+MediaStream::readBuffer()
+{
+    qint64 bufsize = 0;
+    if ( m_pendingSeeks.loadAcquire() == 0 )
+    {
+        bufsize = m_ring->read( m_buffer, BLOCK_SIZE );
+        if ( bufsize == 0 && !m_inputComplete.loadAcquire() )
+        {
+            if ( m_started && !m_underrun )
+            {
+                m_underrun = true;
+                m_underruns.ref();
+            }
+
+            QMutexLocker locker( &m_dataMutex );
+            if ( m_ring->available() == 0 && !m_inputComplete.loadAcquire() )
+            {
+                requestFill();
+                m_dataAvailable.wait( &m_dataMutex, UNDERRUN_WAIT_MS );
+            }
+        }
+        if ( bufsize == 0 && m_pendingSeeks.loadAcquire() == 0 )
+        {
+            bufsize = m_ring->read( m_buffer, BLOCK_SIZE );
+        }
+        if ( bufsize == 0 && m_inputComplete.loadAcquire() && m_pendingSeeks.loadAcquire() == 0 )
+        {
+            return -1;
+        }
+    }
+
+    if ( bufsize > 0 )
+    {
+        m_underrun = false;
+    }
+    if ( m_ring->available() < RING_LOW_WATERMARK && !m_inputComplete.loadAcquire() )
+    {
+        requestFill();
+    }
+
+    return bufsize;
 }
 
 
@@ -123,7 +262,7 @@ MediaStream::readCallback ( const char* cookie, int64_t* dts, int64_t* pts, unsi
     }
     else if ( m_type == IODevice )
     {
-        bufsize = m_ioDevice->read( m_buffer, BLOCK_SIZE );
+        bufsize = readBuffer();
         *buffer = m_buffer;
     }
 
@@ -131,11 +270,6 @@ MediaStream::readCallback ( const char* cookie, int64_t* dts, int64_t* pts, unsi
     {
         m_started = true;
     }
-    if ( m_type == IODevice && bufsize == 0 && m_started && m_bufferingFinished == true )
-    {
-        m_eos = true;
-        return -1;
-    }
     if ( bufsize < 0 )
     {
         m_eos = true;
@@ -172,7 +306,9 @@ MediaStream::seekCallback ( void *data, const uint64_t pos )
     that->m_started = false;
     that->m_pos = pos;
     if ( that->m_type == IODevice ) {
-        that->m_ioDevice->seek(pos);
+        // the device belongs to another thread, let it seek and refill the ring there
+        that->m_pendingSeeks.ref();
+        QMetaObject::invokeMethod( that, "seekDevice", Qt::QueuedConnection, Q_ARG( qint64, (qint64)pos ) );
     }
 
     return 0;
@@ -24,8 +24,19 @@
 #include "DllMacro.h"
 #include "Typedefs.h"
 
-#include <QUrl>
+#include <QAtomicInt>
 #include <QIODevice>
+#include <QMutex>
+#include <QUrl>
+#include <QWaitCondition>
+
+namespace Tomahawk
+{
+    namespace Utils
+    {
+        class RingBuffer;
+    }
+}
 
 class DLLEXPORT MediaStream : public QObject
 {
@@ -58,9 +69,17 @@ public:
     int readDoneCallback ( const char *cookie, size_t bufferSize, void *buffer );
     static int seekCallback ( void *data, const uint64_t pos );
 
+    /// How often VLC found the buffer of an IODevice stream empty during playback
+    int underruns() const;
+
 public slots:
     void bufferingFinished();
 
+private slots:
+    /// Reads from the IODevice into the ring buffer, in the thread this stream lives in
+    void fillBuffer();
+    void seekDevice( qint64 pos );
+
 protected:
     void endOfData();
 
@@ -75,7 +94,21 @@ protected:
     qint64 m_streamSize = 0;
 
     char m_buffer[1048576];
+
 private:
+    qint64 readBuffer();
+    void requestFill();
+
+    // IODevice streams are read ahead into this ring in our own thread, VLC only copies from it
+    Tomahawk::Utils::RingBuffer* m_ring = nullptr;
+    QAtomicInt m_inputComplete;
+    QAtomicInt m_pendingSeeks;
+    QAtomicInt m_fillRequested;
+    QAtomicInt m_underruns;
+    bool m_underrun = false;
+    QMutex m_dataMutex;
+    QWaitCondition m_dataAvailable;
+
     Q_DISABLE_COPY( MediaStream )
 };
 
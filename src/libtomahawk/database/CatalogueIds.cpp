@@ -0,0 +1,352 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CatalogueIds.h"
+
+#include "DatabaseImpl.h"
+#include "TomahawkSqlQuery.h"
+#include "utils/Logger.h"
+
+#include <QStringList>
+
+// SQLite's default SQLITE_MAX_VARIABLE_NUMBER
+#define MAX_BOUND_VALUES 999
+// older SQLite builds multi-row VALUES as a compound SELECT, which can't have more than 500 parts
+#define MAX_INSERT_ROWS 400
+
+using namespace Tomahawk;
+
+
+static QString
+placeholders( int count )
+{
+    QStringList marks;
+    for ( int i = 0; i < count; i++ )
+        marks << "?";
+
+    return marks.join( ", " );
+}
+
+
+static QString
+valueRows( int rows, int columns )
+{
+    const QString row = QString( "(%1)" ).arg( placeholders( columns ) );
+
+    QStringList result;
+    for ( int i = 0; i < rows; i++ )
+        result << row;
+
+    return result.join( ", " );
+}
+
+
+CatalogueIds::CatalogueIds( DatabaseImpl* dbi )
+    : m_dbi( dbi )
+    , m_statements( 0 )
+{
+    m_tracks.table = "track";
+    m_albums.table = "album";
+}
+
+
+QString
+CatalogueIds::sortname( const QString& name )
+{
+    QHash< QString, QString >::const_iterator it = m_sortnames.constFind( name );
+    if ( it != m_sortnames.constEnd() )
+        return it.value();
+
+    const QString result = DatabaseImpl::sortname( name );
+    m_sortnames.insert( name, result );
+
+    return result;
+}
+
+
+void
+CatalogueIds::addArtist( const QString& name )
+{
+    if ( name.trimmed().isEmpty() )
+        return;
+
+    const QString key = sortname( name );
+    if ( !m_artists.contains( key ) && !m_pendingArtists.contains( key ) )
+        m_pendingArtists.insert( key, name );
+}
+
+
+void
+CatalogueIds::add( Children& children, const QString& artist, const QString& name )
+{
+    if ( artist.trimmed().isEmpty() )
+        return;
+
+    addArtist( artist );
+
+    const NameKey key( sortname( artist ), sortname( name ) );
+    if ( !children.pending.contains( key ) )
+        children.pending.insert( key, name );
+}
+
+
+void
+CatalogueIds::addTrack( const QString& artist, const QString& track )
+{
+    add( m_tracks, artist, track );
+}
+
+
+void
+CatalogueIds::addAlbum( const QString& artist, const QString& album )
+{
+    if ( album.isEmpty() )
+        return;
+
+    add( m_albums, artist, album );
+}
+
+
+void
+CatalogueIds::resolve()
+{
+    resolveArtists();
+    resolveChildren( m_tracks );
+    resolveChildren( m_albums );
+}
+
+
+void
+CatalogueIds::resolveArtists()
+{
+    QVariantList missing;
+    foreach ( const QString& key, m_pendingArtists.keys() )
+    {
+        if ( !m_artists.contains( key ) )
+            missing << key;
+    }
+
+    const std::function< void( TomahawkSqlQuery& ) > collect = [this]( TomahawkSqlQuery& query )
+    {
+        m_artists.insert( query.value( 1 ).toString(), query.value( 0 ).toInt() );
+    };
+
+    select( "SELECT id, sortname FROM artist WHERE sortname IN (%1)", missing, collect );
+
+    QList< QVariantList > rows;
+    QVariantList created;
+    foreach ( const QVariant& key, missing )
+    {
+        if ( m_artists.contains( key.toString() ) )
+            continue;
+
+        rows << ( QVariantList() << m_pendingArtists.value( key.toString() ) << key );
+        created << key;
+    }
+
+    if ( !rows.isEmpty() )
+    {
+        insert( "INSERT OR IGNORE INTO artist(name, sortname)", rows );
+        select( "SELECT id, sortname FROM artist WHERE sortname IN (%1)", created, collect );
+
+        // they can't have any tracks or albums yet
+        foreach ( const QVariant& key, created )
+        {
+            const int id = m_artists.value( key.toString() );
+            m_tracks.loaded.insert( id );
+            m_albums.loaded.insert( id );
+        }
+    }
+
+    m_pendingArtists.clear();
+}
+
+
+void
+CatalogueIds::resolveChildren( Children& children )
+{
+    QHash< IdKey, QString > wanted;
+    QVariantList unloaded;
+
+    QHash< NameKey, QString >::const_iterator it = children.pending.constBegin();
+    for ( ; it != children.pending.constEnd(); ++it )
+    {
+        const int artistId = m_artists.value( it.key().first );
+        if ( !artistId )
+            continue;
+
+        const IdKey key( artistId, it.key().second );
+        if ( children.ids.contains( key ) )
+            continue;
+
+        wanted.insert( key, it.value() );
+        if ( !children.loaded.contains( artistId ) )
+        {
+            children.loaded.insert( artistId );
+            unloaded << artistId;
+        }
+    }
+    children.pending.clear();
+
+    const QString sql = QString( "SELECT id, artist, sortname FROM %1 WHERE artist IN (%2)" ).arg( children.table ).arg( "%1" );
+    const std::function< void( TomahawkSqlQuery& ) > collect = [&children]( TomahawkSqlQuery& query )
+    {
+        children.ids.insert( IdKey( query.value( 1 ).toInt(), query.value( 2 ).toString() ), query.value( 0 ).toInt() );
+    };
+
+    // everything these artists already have, rather than one name at a time
+    select( sql, unloaded, collect );
+
+    QList< QVariantList > rows;
+    QSet< int > touched;
+    QHash< IdKey, QString >::const_iterator wit = wanted.constBegin();
+    for ( ; wit != wanted.constEnd(); ++wit )
+    {
+        if ( children.ids.contains( wit.key() ) )
+            continue;
+
+        rows << ( QVariantList() << wit.key().first << wit.value() << wit.key().second );
+        touched.insert( wit.key().first );
+    }
+
+    if ( rows.isEmpty() )
+        return;
+
+    insert( QString( "INSERT OR IGNORE INTO %1(artist, name, sortname)" ).arg( children.table ), rows );
+
+    QVariantList artists;
+    foreach ( int id, touched )
+        artists << id;
+    select( sql, artists, collect );
+}
+
+
+int
+CatalogueIds::artistId( const QString& name ) const
+{
+    if ( name.trimmed().isEmpty() )
+        return 0;
+
+    return m_artists.value( m_sortnames.value( name ) );
+}
+
+
+int
+CatalogueIds::childId( const Children& children, const QString& artist, const QString& name ) const
+{
+    const int id = artistId( artist );
+    if ( !id || !m_sortnames.contains( name ) )
+        return 0;
+
+    return children.ids.value( IdKey( id, m_sortnames.value( name ) ) );
+}
+
+
+int
+CatalogueIds::trackId( const QString& artist, const QString& track ) const
+{
+    return childId( m_tracks, artist, track );
+}
+
+
+int
+CatalogueIds::albumId( const QString& artist, const QString& album ) const
+{
+    if ( album.isEmpty() )
+        return 0;
+
+    return childId( m_albums, artist, album );
+}
+
+
+void
+CatalogueIds::select( const QString& sql, const QVariantList& values, const std::function< void( TomahawkSqlQuery& ) >& row )
+{
+    for ( int i = 0; i < values.count(); i += MAX_BOUND_VALUES )
+    {
+        const QVariantList chunk = values.mid( i, MAX_BOUND_VALUES );
+
+        TomahawkSqlQuery query = m_dbi->newquery();
+        query.prepare( sql.arg( placeholders( chunk.count() ) ) );
+        foreach ( const QVariant& value, chunk )
+            query.addBindValue( value );
+
+        query.exec();
+        m_statements++;
+
+        while ( query.next() )
+            row( query );
+    }
+}
+
+
+bool
+CatalogueIds::insert( const QString& into, const QList< QVariantList >& rows, QList< int >* ids )
+{
+    if ( rows.isEmpty() )
+        return true;
+
+    const int columns = rows.first().count();
+    const int perStatement = qBound( 1, MAX_BOUND_VALUES / columns, MAX_INSERT_ROWS );
+
+    bool ok = true;
+    for ( int i = 0; i < rows.count(); i += perStatement )
+    {
+        const QList< QVariantList > chunk = rows.mid( i, perStatement );
+
+        TomahawkSqlQuery query = m_dbi->newquery();
+        query.prepare( QString( "%1 VALUES %2" ).arg( into ).arg( valueRows( chunk.count(), columns ) ) );
+        foreach ( const QVariantList& row, chunk )
+        {
+            foreach ( const QVariant& value, row )
+                query.addBindValue( value );
+        }
+
+        m_statements++;
+        if ( query.exec() )
+        {
+            if ( ids )
+            {
+                // the rows of a single INSERT get consecutive ids, we're the only writer
+                const int last = query.lastInsertId().toInt();
+                for ( int j = 0; j < chunk.count(); j++ )
+                    *ids << last - chunk.count() + 1 + j;
+            }
+
+            continue;
+        }
+
+        // one bad row shouldn't cost the others theirs
+        tDebug() << Q_FUNC_INFO << "Batch insert failed, inserting rows one by one:" << into;
+        ok = false;
+
+        query.prepare( QString( "%1 VALUES %2" ).arg( into ).arg( valueRows( 1, columns ) ) );
+        foreach ( const QVariantList& row, chunk )
+        {
+            for ( int j = 0; j < row.count(); j++ )
+                query.bindValue( j, row.at( j ) );
+
+            m_statements++;
+            const bool inserted = query.exec();
+            if ( ids )
+                *ids << ( inserted ? query.lastInsertId().toInt() : 0 );
+        }
+    }
+
+    return ok;
+}
@@ -0,0 +1,109 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_CATALOGUEIDS_H
+#define TOMAHAWK_CATALOGUEIDS_H
+
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QVariantList>
+
+#include <functional>
+
+#include "DllMacro.h"
+
+class TomahawkSqlQuery;
+
+namespace Tomahawk
+{
+
+class DatabaseImpl;
+
+/**
+ * Artist, album and track ids for a whole batch of files at once, for a
+ * single transaction.
+ *
+ * Instead of DatabaseImpl::artistId(), albumId() and trackId() looking up and
+ * maybe inserting one name at a time, every name gets added first. resolve()
+ * then looks them all up with a handful of "... IN (...)" queries and inserts
+ * whatever is missing with multi-row INSERTs. Each name is only sortname()'d
+ * once. Everything resolved stays known for the lifetime of the object.
+ */
+class DLLEXPORT CatalogueIds
+{
+public:
+    explicit CatalogueIds( DatabaseImpl* dbi );
+
+    void addArtist( const QString& name );
+    void addTrack( const QString& artist, const QString& track );
+    void addAlbum( const QString& artist, const QString& album );
+
+    /// Looks up everything added since the last call, creating what doesn't exist yet
+    void resolve();
+
+    /// Ids of resolved names, 0 for anything unknown
+    int artistId( const QString& name ) const;
+    int trackId( const QString& artist, const QString& track ) const;
+    int albumId( const QString& artist, const QString& album ) const;
+
+    /**
+     * Inserts @p rows with as few statements as SQLite allows, @p into being
+     * e.g. "INSERT INTO file(source, url)". If @p ids is given, it gets the id
+     * of every row, 0 for rows that couldn't be inserted.
+     */
+    bool insert( const QString& into, const QList< QVariantList >& rows, QList< int >* ids = 0 );
+
+    /// How many statements ran so far
+    int statements() const { return m_statements; }
+
+private:
+    typedef QPair< QString, QString > NameKey; // artist sortname, sortname
+    typedef QPair< int, QString > IdKey;       // artist id, sortname
+
+    struct Children
+    {
+        QString table;
+        QHash< NameKey, QString > pending;
+        QHash< IdKey, int > ids;
+        // artists whose existing rows are already in ids
+        QSet< int > loaded;
+    };
+
+    QString sortname( const QString& name );
+    void add( Children& children, const QString& artist, const QString& name );
+    void resolveArtists();
+    void resolveChildren( Children& children );
+    int childId( const Children& children, const QString& artist, const QString& name ) const;
+
+    void select( const QString& sql, const QVariantList& values, const std::function< void( TomahawkSqlQuery& ) >& row );
+
+    DatabaseImpl* m_dbi;
+    int m_statements;
+
+    QHash< QString, QString > m_sortnames;
+    QHash< QString, QString > m_pendingArtists;
+    QHash< QString, int > m_artists;
+    Children m_tracks;
+    Children m_albums;
+};
+
+} // namespace Tomahawk
+
+#endif // TOMAHAWK_CATALOGUEIDS_H
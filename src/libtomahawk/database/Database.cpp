@@ -24,6 +24,7 @@
 
 #include "DatabaseCommand.h"
 #include "DatabaseImpl.h"
+#include "DatabaseScheduler.h"
 #include "DatabaseWorker.h"
 #include "IdThreadWorker.h"
 #include "PlaylistEntry.h"
@@ -88,6 +89,7 @@ Database::Database( const QString& dbname, QObject* parent )
     : QObject( parent )
     , m_ready( false )
     , m_impl( new DatabaseImpl( dbname ) )
+    , m_scheduler( new DatabaseScheduler() )
     , m_workerRW( new DatabaseWorkerThread( this, true ) )
     , m_idWorker( new IdThreadWorker( this ) )
 {
@@ -125,7 +127,7 @@ Database::Database( const QString& dbname, QObject* parent )
 
     while ( m_workerThreads.count() < m_maxConcurrentThreads )
     {
-        QPointer< DatabaseWorkerThread > workerThread( new DatabaseWorkerThread( this, false ) );
+        QPointer< DatabaseWorkerThread > workerThread( new DatabaseWorkerThread( this, false, m_scheduler ) );
         Q_ASSERT( workerThread );
         workerThread.data()->start();
         m_workerThreads << workerThread;
@@ -170,6 +172,7 @@ Database::~Database()
         }
     }
     m_workerThreads.clear();
+    delete m_scheduler;
 
     qDeleteAll( m_implHash.values() );
     qDeleteAll( m_commandFactories.values() );
@@ -187,7 +190,7 @@ Database::loadIndex()
 
 
 void
-Database::enqueue( const QList< Tomahawk::dbcmd_ptr >& lc )
+Database::enqueue( const QList< Tomahawk::dbcmd_ptr >& lc, bool singleTransaction )
 {
     Q_ASSERT( m_ready );
     if ( !m_ready )
@@ -207,7 +210,7 @@ Database::enqueue( const QList< Tomahawk::dbcmd_ptr >& lc )
 
     tDebug( LOGVERBOSE ) << "Enqueueing" << lc.count() << "commands to rw thread";
     if ( m_workerRW && m_workerRW.data()->worker() )
-        m_workerRW.data()->worker().data()->enqueue( lc );
+        m_workerRW.data()->worker().data()->enqueue( lc, singleTransaction );
 }
 
 
@@ -235,50 +238,9 @@ Database::enqueue( const Tomahawk::dbcmd_ptr& lc )
     }
     else
     {
-        // find thread for commandname with lowest amount of outstanding jobs and enqueue job
-        int busyThreads = 0;
-        QPointer< DatabaseWorkerThread > workerThread;
-        QPointer< DatabaseWorker > happyWorker;
-        for ( int i = 0; i < m_workerThreads.count(); i++ )
-        {
-            workerThread = m_workerThreads.at( i );
-
-            if ( !workerThread || !workerThread->worker() )
-            {
-                // We have no valid worker for the current thread so skip it.
-                continue;
-            }
-
-            if ( !workerThread->worker()->busy() )
-            {
-                // Case 1: We have a workerThread with no outstanding jobs.
-                // As this is the optimal situation we do not need to look at
-                // the other workers.
-                happyWorker = workerThread->worker();
-                break;
-            }
-            else
-            {
-                busyThreads++;
-
-                if ( !happyWorker )
-                {
-                    // Case 2: We have not yet got a happyWorker but the current
-                    // workerThread has a worker so use it as a fallback.
-                    happyWorker = workerThread->worker();
-                }
-                else if ( workerThread->worker()->outstandingJobs() < happyWorker->outstandingJobs() )
-                {
-                    // Case 3: We have a worker and the current worker is less busy
-                    // than the previous minimum.
-                    happyWorker = workerThread->worker();
-                }
-            }
-        }
-
-        tDebug( LOGVERBOSE ) << "Enqueueing command to thread:" << happyWorker << busyThreads << lc->commandname();
-        Q_ASSERT( happyWorker );
-        happyWorker->enqueue( lc );
+        // all read-only workers share one queue, whichever is free first picks it up
+        tDebug( LOGVERBOSE ) << "Enqueueing command to read workers:" << lc->commandname() << lc->priority();
+        m_scheduler->enqueue( lc );
     }
 }
 
@@ -300,6 +262,19 @@ Database::impl()
 }
 
 
+DatabaseStatementStatistics
+Database::statementStatistics()
+{
+    QMutexLocker lock( &m_mutex );
+
+    DatabaseStatementStatistics stats = m_impl->statementStatistics();
+    foreach ( DatabaseImpl* impl, m_implHash )
+        stats.add( impl->statementStatistics() );
+
+    return stats;
+}
+
+
 void
 Database::markAsReady()
 {
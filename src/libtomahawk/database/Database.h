@@ -32,7 +32,9 @@ namespace Tomahawk
 {
 
 class DatabaseImpl;
+struct DatabaseStatementStatistics;
 class DatabaseCommand;
+class DatabaseScheduler;
 class DatabaseWorkerThread;
 class DatabaseWorker;
 class IdThreadWorker;
@@ -87,6 +89,15 @@ public:
 
     DatabaseImpl* impl();
 
+    /**
+     * The scheduler shared by all read-only worker threads, for queue depth
+     * and wait time statistics.
+     */
+    DatabaseScheduler* scheduler() const { return m_scheduler; }
+
+    /// Prepared statement cache statistics, summed up over all connections
+    DatabaseStatementStatistics statementStatistics();
+
     dbcmd_ptr createCommandInstance( const QVariant& op, const Tomahawk::source_ptr& source );
 
     // Template implementations need to stay in header!
@@ -113,7 +124,11 @@ signals:
 
 public slots:
     void enqueue( const Tomahawk::dbcmd_ptr& lc );
-    void enqueue( const QList< Tomahawk::dbcmd_ptr >& lc );
+    /**
+     * Enqueues a list of mutating commands. With @p singleTransaction all of
+     * them are run inside one transaction, not just consecutive groupable ones.
+     */
+    void enqueue( const QList< Tomahawk::dbcmd_ptr >& lc, bool singleTransaction = false );
 
 private slots:
     void markAsReady();
@@ -127,6 +142,7 @@ private:
     bool m_ready;
 
     DatabaseImpl* m_impl;
+    DatabaseScheduler* m_scheduler;
     QPointer< DatabaseWorkerThread > m_workerRW;
     QList< QPointer< DatabaseWorkerThread > > m_workerThreads;
     IdThreadWorker* m_idWorker;
@@ -45,6 +45,16 @@ public:
         FINISHED = 2
     };
 
+    /**
+     * Scheduling class of read-only commands. Queued commands of a lower value
+     * are always handed to a free read worker first.
+     */
+    enum Priority {
+        InteractivePriority = 0, // resolving, things the user is waiting for
+        ModelPriority = 1,       // loading views and models
+        BackgroundPriority = 2   // stats, charts and other bulk work
+    };
+
     explicit DatabaseCommand( QObject* parent = nullptr );
     explicit DatabaseCommand( const Tomahawk::source_ptr& src, QObject* parent = nullptr );
 
@@ -54,6 +64,7 @@ public:
 
     virtual QString commandname() const { return "DatabaseCommand"; }
     virtual bool doesMutates() const { return true; }
+    virtual Priority priority() const { return ModelPriority; }
     State state() const;
 
     // if i make this pure virtual, i get compile errors in qmetatype.h.
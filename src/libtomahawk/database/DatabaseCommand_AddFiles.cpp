@@ -26,7 +26,9 @@
 
 #include "Album.h"
 #include "Artist.h"
+#include "CatalogueIds.h"
 #include "DatabaseImpl.h"
+#include "fuzzyindex/DatabaseFuzzyIndex.h"
 #include "PlaylistEntry.h"
 #include "SourceList.h"
 
@@ -56,6 +58,10 @@ DatabaseCommand_AddFiles::files() const
 void
 DatabaseCommand_AddFiles::postCommitHook()
 {
+    // only index what actually made it into the database
+    if ( !m_indexData.isEmpty() )
+        Database::instance()->impl()->m_fuzzyIndex->updateFields( m_indexData );
+
     // make the collection object emit its tracksAdded signal, so the
     // collection browser will update/fade in etc.
     Collection* coll = source()->dbCollection().data();
@@ -76,103 +82,115 @@ DatabaseCommand_AddFiles::exec( DatabaseImpl* dbi )
     qDebug() << Q_FUNC_INFO;
     Q_ASSERT( !source().isNull() );
 
-    TomahawkSqlQuery query_file = dbi->newquery();
-    TomahawkSqlQuery query_filejoin = dbi->newquery();
-    TomahawkSqlQuery query_trackattr = dbi->newquery();
-
-    query_file.prepare( "INSERT INTO file(source, url, size, mtime, md5, mimetype, duration, bitrate) VALUES (?, ?, ?, ?, ?, ?, ?, ?)" );
-    query_filejoin.prepare( "INSERT INTO file_join(file, artist, album, track, albumpos, composer, discnumber) VALUES (?, ?, ?, ?, ?, ?, ?)" );
-    query_trackattr.prepare( "INSERT INTO track_attributes(id, k, v) VALUES (?, ?, ?)" );
-
     int added = 0;
     QVariant srcid = source()->isLocal() ? QVariant( QVariant::Int ) : source()->id();
     qDebug() << "Adding" << m_files.length() << "files to db for source" << srcid;
 
-    QList<QVariant>::iterator it;
-    for ( it = m_files.begin(); it != m_files.end(); ++it )
+    // look up or create the ids of every artist, album and track in one go, instead of file by file
+    CatalogueIds ids( dbi );
+    QList< QVariantList > fileRows;
+    foreach ( const QVariant& v, m_files )
     {
-        QVariant& v = *it;
-        QVariantMap m = v.toMap();
+        const QVariantMap m = v.toMap();
+        const QString artist      = m.value( "artist" ).toString();
+        const QString albumartist = m.value( "albumartist" ).toString();
+
+        ids.addArtist( albumartist );
+        ids.addArtist( m.value( "composer" ).toString() );
+        ids.addTrack( artist, m.value( "track" ).toString() );
+        // If there's an album artist, use it. Otherwise use the track artist
+        ids.addAlbum( albumartist.trimmed().isEmpty() ? artist : albumartist, m.value( "album" ).toString() );
+
+        fileRows << ( QVariantList() << srcid
+                                     << m.value( "url" ).toString()
+                                     << m.value( "size" ).toUInt()
+                                     << m.value( "mtime" ).toInt()
+                                     << m.value( "hash" ).toString()
+                                     << m.value( "mimetype" ).toString()
+                                     << m.value( "duration" ).toUInt()
+                                     << m.value( "bitrate" ).toUInt() );
+    }
+
+    ids.resolve();
+
+    QList< int > fileIds;
+    ids.insert( "INSERT INTO file(source, url, size, mtime, md5, mimetype, duration, bitrate)", fileRows, &fileIds );
+    fileRows.clear();
+
+    // only what's new gets added to the search index, instead of rebuilding it from scratch
+    QHash< unsigned int, IndexData > indexTracks;
+    QHash< unsigned int, IndexData > indexAlbums;
+
+    QList< QVariantList > joinRows;
+    QList< QVariantList > attributeRows;
+
+    for ( int i = 0; i < m_files.count(); i++ )
+    {
+        const int fileid = fileIds.value( i );
+        if ( fileid < 1 )
+            continue;
 
-        int fileid = 0, artistid = 0, albumartistid = 0, albumid = 0, trackid = 0, composerid = 0;
+        QVariantMap m = m_files.at( i ).toMap();
+        m.insert( "id", fileid );
+        // this is the qvariant(map) the remote will get
+        m_files[ i ] = m;
 
-        const QString url         = m.value( "url" ).toString();
-        const int mtime           = m.value( "mtime" ).toInt();
-        const uint size           = m.value( "size" ).toUInt();
-        const QString hash        = m.value( "hash" ).toString();
-        const QString mimetype    = m.value( "mimetype" ).toString();
-        const uint duration       = m.value( "duration" ).toUInt();
-        const uint bitrate        = m.value( "bitrate" ).toUInt();
         const QString artist      = m.value( "artist" ).toString();
         const QString albumartist = m.value( "albumartist" ).toString();
         const QString album       = m.value( "album" ).toString();
         const QString track       = m.value( "track" ).toString();
-        const uint albumpos       = m.value( "albumpos" ).toUInt();
-        const QString composer    = m.value( "composer" ).toString();
-        const uint discnumber     = m.value( "discnumber" ).toUInt();
-        const int year            = m.value( "year" ).toInt();
-
-        query_file.bindValue( 0, srcid );
-        query_file.bindValue( 1, url );
-        query_file.bindValue( 2, size );
-        query_file.bindValue( 3, mtime );
-        query_file.bindValue( 4, hash );
-        query_file.bindValue( 5, mimetype );
-        query_file.bindValue( 6, duration );
-        query_file.bindValue( 7, bitrate );
-        query_file.exec();
-
-        if ( added % 1000 == 0 )
-            qDebug() << "Inserted" << added;
-
-        // get internal IDs for art/alb/trk
-        fileid = query_file.lastInsertId().toInt();
-        m.insert( "id", fileid );
-        // this is the qvariant(map) the remote will get
-        v = m;
-
-        // add the album artist to the artist database.
-        if ( !albumartist.trimmed().isEmpty() )
-            albumartistid = dbi->artistId( albumartist, true );
-        
-        if ( !artist.trimmed().isEmpty() )
-            artistid = dbi->artistId( artist, true );
+
+        const int artistid = ids.artistId( artist );
         if ( artistid < 1 )
             continue;
-        trackid = dbi->trackId( artistid, track, true );
+        const int trackid = ids.trackId( artist, track );
         if ( trackid < 1 )
             continue;
-        // If there's an album artist, use it. Otherwise use the track artist
-        albumid = dbi->albumId( albumartistid > 0 ? albumartistid : artistid, album, true );
-
-        if ( !composer.trimmed().isEmpty() )
-            composerid = dbi->artistId( composer, true );
+        const int albumid = ids.albumId( ids.artistId( albumartist ) > 0 ? albumartist : artist, album );
+        const int composerid = ids.artistId( m.value( "composer" ).toString() );
 
         // Now add the association
-        query_filejoin.bindValue( 0, fileid );
-        query_filejoin.bindValue( 1, artistid );
-        query_filejoin.bindValue( 2, albumid > 0 ? albumid : QVariant( QVariant::Int ) );
-        query_filejoin.bindValue( 3, trackid );
-        query_filejoin.bindValue( 4, albumpos );
-        query_filejoin.bindValue( 5, composerid > 0 ? composerid : QVariant( QVariant::Int ) );
-        query_filejoin.bindValue( 6, discnumber );
-        if ( !query_filejoin.exec() )
+        joinRows << ( QVariantList() << fileid
+                                     << artistid
+                                     << ( albumid > 0 ? albumid : QVariant( QVariant::Int ) )
+                                     << trackid
+                                     << m.value( "albumpos" ).toUInt()
+                                     << ( composerid > 0 ? composerid : QVariant( QVariant::Int ) )
+                                     << m.value( "discnumber" ).toUInt() );
+
+        attributeRows << ( QVariantList() << trackid << "releaseyear" << m.value( "year" ).toInt() );
+
+        if ( !indexTracks.contains( trackid ) )
         {
-            qDebug() << "Error inserting into file_join table";
-            continue;
+            IndexData ida;
+            ida.id = trackid;
+            ida.artistId = artistid;
+            ida.artist = artist;
+            ida.track = track;
+            indexTracks.insert( trackid, ida );
+        }
+        if ( albumid > 0 && !indexAlbums.contains( albumid ) )
+        {
+            IndexData ida;
+            ida.id = albumid;
+            ida.artistId = 0;
+            ida.album = album;
+            indexAlbums.insert( albumid, ida );
         }
-
-        query_trackattr.bindValue( 0, trackid );
-        query_trackattr.bindValue( 1, "releaseyear" );
-        query_trackattr.bindValue( 2, year );
-        query_trackattr.exec();
 
         m_ids << fileid;
         added++;
     }
 
+    if ( !ids.insert( "INSERT INTO file_join(file, artist, album, track, albumpos, composer, discnumber)", joinRows ) )
+        qDebug() << "Error inserting into file_join table";
+    ids.insert( "INSERT INTO track_attributes(id, k, v)", attributeRows );
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Ran" << ids.statements() << "statements for" << m_files.count() << "files";
     qDebug() << "Inserted" << added << "tracks to database";
     tDebug() << "Committing" << added << "tracks...";
 
+    m_indexData = indexTracks.values() + indexAlbums.values();
+
     emit done( m_files, source()->dbCollection() );
 }
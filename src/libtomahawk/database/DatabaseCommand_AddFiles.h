@@ -23,6 +23,7 @@
 #include <QVariantMap>
 
 #include "database/DatabaseCommandLoggable.h"
+#include "database/DatabaseCommand_UpdateSearchIndex.h"
 #include "Typedefs.h"
 #include "Query.h"
 
@@ -63,6 +64,7 @@ signals:
 private:
     QVariantList m_files;
     QList<unsigned int> m_ids;
+    QList<IndexData> m_indexData;
 };
 
 }
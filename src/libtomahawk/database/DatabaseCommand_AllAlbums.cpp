@@ -59,10 +59,13 @@ DatabaseCommand_AllAlbums::setArtist( const Tomahawk::artist_ptr& artist )
 void
 DatabaseCommand_AllAlbums::execForArtist( DatabaseImpl* dbi )
 {
-    TomahawkSqlQuery query = dbi->newquery();
     QList<Tomahawk::album_ptr> al;
     QString orderToken, sourceToken, filterToken, timeToken, tables;
 
+    // values get bound in the order their tokens show up in the statement
+    QVariantList values;
+    values << m_artist->id();
+
     switch ( m_sortOrder )
     {
         case 0:
@@ -70,11 +73,22 @@ DatabaseCommand_AllAlbums::execForArtist( DatabaseImpl* dbi )
 
         case ModificationTime:
             orderToken = "file.mtime";
-            timeToken = QString( "AND file.mtime <= %1" ).arg( QDateTime::currentDateTimeUtc().toTime_t() );
+            timeToken = "AND file.mtime <= ?";
     }
 
     if ( !m_collection.isNull() )
-        sourceToken = QString( "AND file.source %1" ).arg( m_collection->isLocal() ? "IS NULL" : QString( "= %1" ).arg( m_collection->source()->id() ) );
+    {
+        if ( m_collection->isLocal() )
+            sourceToken = "AND file.source IS NULL";
+        else
+        {
+            sourceToken = "AND file.source = ?";
+            values << m_collection->source()->id();
+        }
+    }
+
+    if ( !timeToken.isEmpty() )
+        values << QDateTime::currentDateTimeUtc().toTime_t();
 
     if ( !m_filter.isEmpty() )
     {
@@ -82,7 +96,9 @@ DatabaseCommand_AllAlbums::execForArtist( DatabaseImpl* dbi )
         QStringList sl = m_filter.split( " ", QString::SkipEmptyParts );
         foreach( QString s, sl )
         {
-            filtersql += QString( " AND ( artist.name LIKE '%%1%' OR album.name LIKE '%%1%' OR track.name LIKE '%%1%' )" ).arg( TomahawkSqlQuery::escape( s ) );
+            filtersql += " AND ( artist.name LIKE ? OR album.name LIKE ? OR track.name LIKE ? )";
+            const QString pattern = QString( "%%1%" ).arg( s );
+            values << pattern << pattern << pattern;
         }
 
         filterToken = QString( "AND artist.id = file_join.artist AND file_join.track = track.id %1" ).arg( filtersql );
@@ -96,18 +112,22 @@ DatabaseCommand_AllAlbums::execForArtist( DatabaseImpl* dbi )
         "FROM %1 "
         "LEFT OUTER JOIN album ON file_join.album = album.id "
         "WHERE file.id = file_join.file "
-        "AND file_join.artist = %2 "
-        "%3 %4 %5 %6 %7 %8"
+        "AND file_join.artist = ? "
+        "%2 %3 %4 %5 %6 %7"
         ).arg( tables )
-         .arg( m_artist->id() )
          .arg( sourceToken )
          .arg( timeToken )
          .arg( filterToken )
          .arg( m_sortOrder > 0 ? QString( "ORDER BY %1" ).arg( orderToken ) : QString() )
          .arg( m_sortDescending ? "DESC" : QString() )
-         .arg( m_amount > 0 ? QString( "LIMIT 0, %1" ).arg( m_amount ) : QString() );
+         .arg( m_amount > 0 ? QString( "LIMIT 0, ?" ) : QString() );
 
-    query.prepare( sql );
+    if ( m_amount > 0 )
+        values << m_amount;
+
+    TomahawkSqlQuery query = dbi->preparedQuery( sql );
+    for ( int i = 0; i < values.count(); i++ )
+        query.bindValue( i, values.at( i ) );
     query.exec();
 
     while( query.next() )
@@ -132,9 +152,9 @@ DatabaseCommand_AllAlbums::execForArtist( DatabaseImpl* dbi )
 void
 DatabaseCommand_AllAlbums::execForCollection( DatabaseImpl* dbi )
 {
-    TomahawkSqlQuery query = dbi->newquery();
     QList<Tomahawk::album_ptr> al;
     QString orderToken, sourceToken;
+    QVariantList values;
 
     switch ( m_sortOrder )
     {
@@ -146,7 +166,15 @@ DatabaseCommand_AllAlbums::execForCollection( DatabaseImpl* dbi )
     }
 
     if ( !m_collection.isNull() )
-        sourceToken = QString( "AND file.source %1 " ).arg( m_collection->source()->isLocal() ? "IS NULL" : QString( "= %1" ).arg( m_collection->source()->id() ) );
+    {
+        if ( m_collection->source()->isLocal() )
+            sourceToken = "AND file.source IS NULL";
+        else
+        {
+            sourceToken = "AND file.source = ?";
+            values << m_collection->source()->id();
+        }
+    }
 
     QString sql = QString(
         "SELECT DISTINCT album.id, album.name, album.artist, artist.name "
@@ -159,9 +187,14 @@ DatabaseCommand_AllAlbums::execForCollection( DatabaseImpl* dbi )
         ).arg( sourceToken )
          .arg( m_sortOrder > 0 ? QString( "ORDER BY %1" ).arg( orderToken ) : QString() )
          .arg( m_sortDescending ? "DESC" : QString() )
-         .arg( m_amount > 0 ? QString( "LIMIT 0, %1" ).arg( m_amount ) : QString() );
+         .arg( m_amount > 0 ? QString( "LIMIT 0, ?" ) : QString() );
+
+    if ( m_amount > 0 )
+        values << m_amount;
 
-    query.prepare( sql );
+    TomahawkSqlQuery query = dbi->preparedQuery( sql );
+    for ( int i = 0; i < values.count(); i++ )
+        query.bindValue( i, values.at( i ) );
     query.exec();
 
     while( query.next() )
@@ -38,7 +38,6 @@ namespace Tomahawk
 void
 DatabaseCommand_AllTracks::exec( DatabaseImpl* dbi )
 {
-    TomahawkSqlQuery query = dbi->newquery();
     QList<Tomahawk::query_ptr> ql;
 
     QString m_orderToken, sourceToken;
@@ -60,8 +59,18 @@ DatabaseCommand_AllTracks::exec( DatabaseImpl* dbi )
             break;
     }
 
+    // values get bound in the order their tokens show up in the statement
+    QVariantList values;
     if ( !m_collection.isNull() )
-        sourceToken = QString( "AND file.source %1" ).arg( m_collection->source()->isLocal() ? "IS NULL" : QString( "= %1" ).arg( m_collection->source()->id() ) );
+    {
+        if ( m_collection->source()->isLocal() )
+            sourceToken = "AND file.source IS NULL";
+        else
+        {
+            sourceToken = "AND file.source = ?";
+            values << m_collection->source()->id();
+        }
+    }
 
     QString albumToken;
     if ( m_album )
@@ -69,12 +78,19 @@ DatabaseCommand_AllTracks::exec( DatabaseImpl* dbi )
         if ( m_album->id() == 0 )
         {
             m_artist = m_album->artist();
-            albumToken = QString( "AND album.id IS NULL" );
+            albumToken = "AND album.id IS NULL";
         }
         else
-            albumToken = QString( "AND album.id = %1" ).arg( m_album->id() );
+            albumToken = "AND album.id = ?";
     }
 
+    if ( m_artist )
+        values << m_artist->id();
+    if ( m_album && m_album->id() != 0 )
+        values << m_album->id();
+    if ( m_amount > 0 )
+        values << m_amount;
+
     QString sql = QString(
             "SELECT file.id, artist.name, album.name, track.name, composer.name, file.size, "             //0
                    "file.duration, file.bitrate, file.url, file.source, file.mtime, "                     //6
@@ -93,13 +109,15 @@ DatabaseCommand_AllTracks::exec( DatabaseImpl* dbi )
             "%2 %3 "
             "%4 %5 %6"
             ).arg( sourceToken )
-             .arg( !m_artist ? QString() : QString( "AND artist.id = %1" ).arg( m_artist->id() ) )
+             .arg( !m_artist ? QString() : QString( "AND artist.id = ?" ) )
              .arg( !m_album ? QString() : albumToken )
              .arg( m_sortOrder > 0 ? QString( "ORDER BY %1" ).arg( m_orderToken ) : QString() )
              .arg( m_sortDescending ? "DESC" : QString() )
-             .arg( m_amount > 0 ? QString( "LIMIT 0, %1" ).arg( m_amount ) : QString() );
+             .arg( m_amount > 0 ? QString( "LIMIT 0, ?" ) : QString() );
 
-    query.prepare( sql );
+    TomahawkSqlQuery query = dbi->preparedQuery( sql );
+    for ( int i = 0; i < values.count(); i++ )
+        query.bindValue( i, values.at( i ) );
     query.exec();
 
     // Small cache to keep already created source objects.
@@ -38,6 +38,7 @@ public:
 
     virtual void exec( DatabaseImpl* lib );
     virtual bool doesMutates() const { return false; }
+    virtual Priority priority() const { return BackgroundPriority; }
     virtual QString commandname() const { return "artiststats"; }
 
 signals:
@@ -90,47 +90,47 @@ DatabaseCommand_CalculatePlaytime::exec( DatabaseImpl *dbi )
 {
     Q_D( DatabaseCommand_CalculatePlaytime );
 
-    QString sql;
-
+    // one cached statement per id, a playlist can have more entries than sqlite takes bound values
+    uint playtime = 0;
     if ( d->plEntryIds.isEmpty() )
     {
-        sql = QString(
+        TomahawkSqlQuery query = dbi->preparedQuery(
                     " SELECT SUM(pl.secs_played) "
                     " FROM playback_log pl "
-                    " WHERE track in ( %1 ) AND playtime >= %2 AND playtime <= %3 "
-                    ).arg( d->trackIds.join(", ") ).arg( d->from.toTime_t() ).arg( d->to.toTime_t() );
+                    " WHERE track = ? AND playtime >= ? AND playtime <= ? " );
+
+        foreach ( const QString& trackId, d->trackIds.toSet() )
+        {
+            query.bindValue( 0, trackId.toUInt() );
+            query.bindValue( 1, d->from.toTime_t() );
+            query.bindValue( 2, d->to.toTime_t() );
+            query.exec();
+
+            if ( query.next() )
+                playtime += query.value( 0 ).toUInt();
+        }
     }
     else
     {
-        // Escape all GUIDs
-        QMutableStringListIterator iter( d->plEntryIds );
-        while ( iter.hasNext() )
-        {
-            iter.setValue( QString( "'%1'" ).arg( iter.next() ) );
-        }
-        sql = QString(
+        TomahawkSqlQuery query = dbi->preparedQuery(
                     " SELECT SUM(pl.secs_played) "
                     " FROM playlist_item pi "
                     " JOIN track t ON pi.trackname = t.name "
                     " JOIN artist a ON a.name = pi.artistname AND t.artist = a.id "
                     " JOIN playback_log pl ON pl.track = t.id "
-                    " WHERE pi.guid IN (%1) "
-                    " AND pl.playtime >= %2 AND pl.playtime <= %3 "
-                    )
-                .arg( d->plEntryIds.join(", ") )
-                .arg( d->from.toTime_t() )
-                .arg( d->to.toTime_t() );
-
-    }
+                    " WHERE pi.guid = ? "
+                    " AND pl.playtime >= ? AND pl.playtime <= ? " );
 
-    TomahawkSqlQuery query = dbi->newquery();
-    query.prepare( sql );
-    query.exec();
+        foreach ( const QString& guid, d->plEntryIds.toSet() )
+        {
+            query.bindValue( 0, guid );
+            query.bindValue( 1, d->from.toTime_t() );
+            query.bindValue( 2, d->to.toTime_t() );
+            query.exec();
 
-    uint playtime = 0;
-    while ( query.next() )
-    {
-        playtime = query.value( 0 ).toUInt();
+            if ( query.next() )
+                playtime += query.value( 0 ).toUInt();
+        }
     }
     emit done( playtime );
 
@@ -41,6 +41,7 @@ public:
     virtual void exec( DatabaseImpl* dbi );
 
     virtual bool doesMutates() const { return false; }
+    virtual Priority priority() const { return BackgroundPriority; }
     virtual QString commandname() const { return "calculateplaytime"; }
 
 
@@ -32,7 +32,7 @@ DatabaseCommand_CollectionAttributes::DatabaseCommand_CollectionAttributes( Data
 void
 DatabaseCommand_CollectionAttributes::exec( DatabaseImpl *lib )
 {
-    TomahawkSqlQuery query = lib->newquery();
+    TomahawkSqlQuery query = lib->preparedQuery( "SELECT id, v FROM collection_attributes WHERE k = ?" );
 
 //    QString sourceStr;
 //    if ( source().isNull() )
@@ -46,9 +46,8 @@ DatabaseCommand_CollectionAttributes::exec( DatabaseImpl *lib )
     else if ( m_type == DatabaseCommand_SetCollectionAttributes::EchonestArtistCatalog )
         typeStr = "echonest_artist";
 
-    QString queryStr = QString( "SELECT id, v FROM collection_attributes WHERE k = \"%1\"" ).arg( typeStr );
-    qDebug() << "Doing queryL" << queryStr;
-    query.exec( queryStr );
+    query.bindValue( 0, typeStr );
+    query.exec();
     PairList data;
     while ( query.next() )
     {
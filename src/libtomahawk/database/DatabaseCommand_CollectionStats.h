@@ -37,6 +37,7 @@ public:
     explicit DatabaseCommand_CollectionStats( const source_ptr& source, QObject* parent = 0 );
     virtual void exec( DatabaseImpl* lib );
     virtual bool doesMutates() const { return false; }
+    virtual Priority priority() const { return BackgroundPriority; }
     virtual QString commandname() const { return "collectionstats"; }
 
 signals:
@@ -24,6 +24,7 @@
 #include "collection/Collection.h"
 #include "database/Database.h"
 #include "database/DatabaseImpl.h"
+#include "database/fuzzyindex/DatabaseFuzzyIndex.h"
 #include "network/Servent.h"
 #include "utils/Logger.h"
 #include "utils/TomahawkUtils.h"
@@ -40,6 +41,10 @@ using namespace Tomahawk;
 void
 DatabaseCommand_DeleteFiles::postCommitHook()
 {
+    // the files are gone for good now, so their tracks and albums can leave the search index
+    if ( !m_orphanedTracks.isEmpty() || !m_orphanedAlbums.isEmpty() )
+        Database::instance()->impl()->m_fuzzyIndex->deleteFields( m_orphanedTracks, m_orphanedAlbums );
+
     if ( m_idList.isEmpty() )
         return;
 
@@ -99,6 +104,28 @@ DatabaseCommand_DeleteFiles::exec( DatabaseImpl* dbi )
                 m_idList << id.toUInt();
         }
     }
+    else if ( !m_ids.isEmpty() )
+    {
+        // remote sources refer to their files by their own ids, which we keep as the url
+        QString urlstring;
+        foreach ( const QVariant& id, m_ids )
+            urlstring.append( id.toString() + ", " );
+        urlstring.chop( 2 ); //remove the trailing ", "
+
+        delquery.prepare( QString( "SELECT id FROM file WHERE source = %1 AND url IN ( %2 )" )
+                    .arg( source()->id() )
+                    .arg( urlstring ) );
+        delquery.exec();
+
+        while ( delquery.next() )
+            m_idList << delquery.value( 0 ).toUInt();
+    }
+
+    // the file_join rows cascade away with the files, so look up what they point at first
+    QSet< unsigned int > tracks;
+    QSet< unsigned int > albums;
+    if ( !m_idList.isEmpty() )
+        indexedIds( dbi, tracks, albums );
 
     if ( m_deleteAll )
     {
@@ -106,29 +133,13 @@ DatabaseCommand_DeleteFiles::exec( DatabaseImpl* dbi )
                     .arg( source()->isLocal() ? "IS NULL" : QString( "= %1" ).arg( source()->id() ) ) );
         delquery.exec();
     }
-    else if ( !m_ids.isEmpty() )
+    else if ( !m_idList.isEmpty() )
     {
         QString idstring;
-        foreach ( const QVariant& id, m_ids )
-            idstring.append( id.toString() + ", " );
+        foreach ( unsigned int id, m_idList )
+            idstring.append( QString::number( id ) + ", " );
         idstring.chop( 2 ); //remove the trailing ", "
 
-        if ( !source()->isLocal() )
-        {
-            delquery.prepare( QString( "SELECT id FROM file WHERE source = %1 AND url IN ( %2 )" )
-                        .arg( source()->id() )
-                        .arg( idstring ) );
-            delquery.exec();
-            
-            idstring = QString();
-            while ( delquery.next() )
-            {
-                idstring.append( delquery.value( 0 ).toString() + ", " );
-                m_idList << delquery.value( 0 ).toUInt();
-            }
-            idstring.chop( 2 ); //remove the trailing ", "
-        }
-
         delquery.prepare( QString( "DELETE FROM file WHERE source %1 AND id IN ( %2 )" )
                              .arg( source()->isLocal() ? "IS NULL" : QString( "= %1" ).arg( source()->id() ) )
                              .arg( idstring ) );
@@ -136,7 +147,54 @@ DatabaseCommand_DeleteFiles::exec( DatabaseImpl* dbi )
     }
 
     if ( !m_idList.isEmpty() )
+    {
+        findOrphans( dbi, tracks, albums );
         source()->updateIndexWhenSynced();
+    }
 
     emit done( m_idList, source()->dbCollection() );
 }
+
+
+void
+DatabaseCommand_DeleteFiles::indexedIds( DatabaseImpl* dbi, QSet< unsigned int >& tracks, QSet< unsigned int >& albums ) const
+{
+    QStringList fileIds;
+    foreach ( unsigned int id, m_idList )
+        fileIds << QString::number( id );
+
+    TomahawkSqlQuery query = dbi->newquery();
+    query.exec( QString( "SELECT DISTINCT track, album FROM file_join WHERE file IN ( %1 )" ).arg( fileIds.join( ", " ) ) );
+    while ( query.next() )
+    {
+        tracks << query.value( 0 ).toUInt();
+        if ( !query.value( 1 ).isNull() )
+            albums << query.value( 1 ).toUInt();
+    }
+}
+
+
+void
+DatabaseCommand_DeleteFiles::findOrphans( DatabaseImpl* dbi, const QSet< unsigned int >& tracks, const QSet< unsigned int >& albums )
+{
+    // the deleted files' file_join rows are already gone, whatever isn't referenced anymore has no files left
+    TomahawkSqlQuery trackquery = dbi->newquery();
+    trackquery.prepare( "SELECT 1 FROM file_join WHERE track = ? LIMIT 1" );
+    foreach ( unsigned int id, tracks )
+    {
+        trackquery.bindValue( 0, id );
+        trackquery.exec();
+        if ( !trackquery.next() )
+            m_orphanedTracks << id;
+    }
+
+    TomahawkSqlQuery albumquery = dbi->newquery();
+    albumquery.prepare( "SELECT 1 FROM file_join WHERE album = ? LIMIT 1" );
+    foreach ( unsigned int id, albums )
+    {
+        albumquery.bindValue( 0, id );
+        albumquery.exec();
+        if ( !albumquery.next() )
+            m_orphanedAlbums << id;
+    }
+}
@@ -22,6 +22,7 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QDir>
+#include <QtCore/QSet>
 #include <QtCore/QVariantMap>
 
 #include "database/DatabaseCommandLoggable.h"
@@ -81,9 +82,14 @@ signals:
     void notify( const QList<unsigned int>& ids );
 
 private:
+    void indexedIds( DatabaseImpl* dbi, QSet< unsigned int >& tracks, QSet< unsigned int >& albums ) const;
+    void findOrphans( DatabaseImpl* dbi, const QSet< unsigned int >& tracks, const QSet< unsigned int >& albums );
+
     QDir m_dir;
     QVariantList m_ids;
     QList<unsigned int> m_idList;
+    QList<unsigned int> m_orphanedTracks;
+    QList<unsigned int> m_orphanedAlbums;
     bool m_deleteAll;
 };
 
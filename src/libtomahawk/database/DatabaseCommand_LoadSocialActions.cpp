@@ -39,23 +39,16 @@ DatabaseCommand_LoadSocialActions::exec( DatabaseImpl* dbi )
     qDebug() << Q_FUNC_INFO;
     Q_ASSERT( !source().isNull() );
 
-    TomahawkSqlQuery query = dbi->newquery();
-
     if ( m_actionOnly.isNull() )
     {
         // Load for just specified track
         if ( m_track->trackId() == 0 )
             return;
 
-        QString whereToken;
-        whereToken = QString( "WHERE id IS %1" ).arg( m_track->trackId() );
-
-        QString sql = QString(
-                "SELECT k, v, timestamp, source "
-                "FROM social_attributes %1 "
-                "ORDER BY timestamp ASC" ).arg( whereToken );
-
-        query.prepare( sql );
+        TomahawkSqlQuery query = dbi->preparedQuery( "SELECT k, v, timestamp, source "
+                                                     "FROM social_attributes WHERE id IS ? "
+                                                     "ORDER BY timestamp ASC" );
+        query.bindValue( 0, m_track->trackId() );
         query.exec();
 
         QList< Tomahawk::SocialAction > allSocialActions;
@@ -76,9 +69,11 @@ DatabaseCommand_LoadSocialActions::exec( DatabaseImpl* dbi )
     else
     {
         // Load all tracks with this social action
-        const QString srcStr = source()->isLocal() ? "IS NULL" : QString( "=%1" ).arg( source()->id() );
+        const QString srcStr = source()->isLocal() ? "IS NULL" : "= ?";
 
-        query.prepare( QString( "SELECT id, v, timestamp FROM social_attributes WHERE source %1 AND k = ? " ).arg( srcStr ) );
+        TomahawkSqlQuery query = dbi->preparedQuery( QString( "SELECT id, v, timestamp FROM social_attributes WHERE source %1 AND k = ? " ).arg( srcStr ) );
+        if ( !source()->isLocal() )
+            query.addBindValue( source()->id() );
         query.addBindValue( m_actionOnly );
 
         query.exec();
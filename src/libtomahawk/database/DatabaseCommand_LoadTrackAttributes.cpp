@@ -40,9 +40,7 @@ DatabaseCommand_LoadTrackAttributes::exec( DatabaseImpl* dbi )
     if ( m_track->trackId() == 0 )
         return;
 
-    TomahawkSqlQuery query = dbi->newquery();
-
-    query.prepare( "SELECT k, v FROM track_attributes WHERE id = ?" );
+    TomahawkSqlQuery query = dbi->preparedQuery( "SELECT k, v FROM track_attributes WHERE id = ?" );
     query.bindValue( 0, m_track->trackId() );
     query.exec();
 
@@ -88,13 +88,13 @@ DatabaseCommand_LogPlayback::exec( DatabaseImpl* dbi )
         return;
 
     QVariant srcid = source()->isLocal() ? QVariant( QVariant::Int ) : source()->id();
-    TomahawkSqlQuery query = dbi->newquery();
 
     if ( pt > 0 && source()->isLocal() )
     {
-        query.prepare( QString( "SELECT * FROM playback_log WHERE source %1 AND playtime = %2" ).arg( srcid.isNull() ? "IS NULL" : srcid.toString() ).arg( m_playtime ) );
-        query.exec();
-        if ( query.next() )
+        TomahawkSqlQuery dupe = dbi->preparedQuery( "SELECT * FROM playback_log WHERE source IS NULL AND playtime = ?" );
+        dupe.bindValue( 0, m_playtime );
+        dupe.exec();
+        if ( dupe.next() )
         {
             tDebug() << "Ignoring dupe playback log for source" << srcid << "with timestamp" << m_playtime;
             return;
@@ -103,7 +103,7 @@ DatabaseCommand_LogPlayback::exec( DatabaseImpl* dbi )
 
 //    tDebug() << "Logging playback of" << m_artist << "-" << m_track << "for source" << srcid << "- timestamp:" << m_playtime;
 
-    query.prepare( "INSERT INTO playback_log(source, track, playtime, secs_played) VALUES (?, ?, ?, ?)" );
+    TomahawkSqlQuery query = dbi->preparedQuery( "INSERT INTO playback_log(source, track, playtime, secs_played) VALUES (?, ?, ?, ?)" );
     query.bindValue( 0, srcid );
 
     // If there's no artist, because it's a resolver result with bad metadata for example, don't save it
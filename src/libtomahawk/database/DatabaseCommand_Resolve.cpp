@@ -27,6 +27,11 @@
 #include "SourceList.h"
 #include "Track.h"
 
+#include <QStringList>
+
+// track id lists are padded up to a multiple of this, so their statements can be reused
+#define TRACK_ID_SLOTS 16
+
 using namespace Tomahawk;
 
 
@@ -44,6 +49,33 @@ DatabaseCommand_Resolve::~DatabaseCommand_Resolve()
 }
 
 
+static int
+trackIdSlots( const QList< QPair<int, float> >& tracks )
+{
+    return ( ( tracks.count() + TRACK_ID_SLOTS - 1 ) / TRACK_ID_SLOTS ) * TRACK_ID_SLOTS;
+}
+
+
+static QString
+trackIdPlaceholders( int slots )
+{
+    QStringList marks;
+    for ( int k = 0; k < slots; k++ )
+        marks << "?";
+
+    return marks.join( "," );
+}
+
+
+static void
+bindTrackIds( TomahawkSqlQuery& query, const QList< QPair<int, float> >& tracks, int slots )
+{
+    // there's no track 0, so the padding doesn't match anything
+    for ( int k = 0; k < slots; k++ )
+        query.bindValue( k, k < tracks.count() ? tracks.at( k ).first : 0 );
+}
+
+
 void
 DatabaseCommand_Resolve::exec( DatabaseImpl* lib )
 {
@@ -91,13 +123,7 @@ DatabaseCommand_Resolve::resolve( DatabaseImpl* lib )
     }
 
     // STEP 2
-    TomahawkSqlQuery files_query = lib->newquery();
-
-    QStringList trksl;
-    for ( int k = 0; k < tracks.count(); k++ )
-        trksl.append( QString::number( tracks.at( k ).first ) );
-
-    QString trksToken = QString( "file_join.track IN (%1)" ).arg( trksl.join( "," ) );
+    QString trksToken = QString( "file_join.track IN (%1)" ).arg( trackIdPlaceholders( trackIdSlots( tracks ) ) );
 
     QString sql = QString( "SELECT "
                             "url, mtime, size, md5, mimetype, duration, bitrate, "  //0
@@ -125,7 +151,8 @@ DatabaseCommand_Resolve::resolve( DatabaseImpl* lib )
                             "(%1)" )
          .arg( trksToken );
 
-    files_query.prepare( sql );
+    TomahawkSqlQuery files_query = lib->preparedQuery( sql );
+    bindTrackIds( files_query, tracks, trackIdSlots( tracks ) );
     files_query.exec();
 
     while ( files_query.next() )
@@ -183,8 +210,7 @@ DatabaseCommand_Resolve::fullTextResolve( DatabaseImpl* lib )
     QList< QPair<int, float> > trackPairs = lib->search( m_query );
     QList< QPair<int, float> > albumPairs = lib->searchAlbum( m_query, 20 );
 
-    TomahawkSqlQuery query = lib->newquery();
-    query.prepare( "SELECT album.name, artist.id, artist.name FROM album, artist WHERE artist.id = album.artist AND album.id = ?" );
+    TomahawkSqlQuery query = lib->preparedQuery( "SELECT album.name, artist.id, artist.name FROM album, artist WHERE artist.id = album.artist AND album.id = ?" );
 
     foreach ( const scorepair_t& albumPair, albumPairs )
     {
@@ -210,13 +236,7 @@ DatabaseCommand_Resolve::fullTextResolve( DatabaseImpl* lib )
     }
 
     // STEP 2
-    TomahawkSqlQuery files_query = lib->newquery();
-
-    QStringList trksl;
-    for ( int k = 0; k < trackPairs.count(); k++ )
-        trksl.append( QString::number( trackPairs.at( k ).first ) );
-
-    QString trksToken = QString( "file_join.track IN (%1)" ).arg( trksl.join( "," ) );
+    QString trksToken = QString( "file_join.track IN (%1)" ).arg( trackIdPlaceholders( trackIdSlots( trackPairs ) ) );
     QString sql = QString( "SELECT "
                             "url, mtime, size, md5, mimetype, duration, bitrate, "  //0
                             "file_join.artist, file_join.album, file_join.track, "  //7
@@ -241,9 +261,10 @@ DatabaseCommand_Resolve::fullTextResolve( DatabaseImpl* lib )
                             "track.id = file_join.track AND "
                             "file.id = file_join.file AND "
                             "%1" )
-                        .arg( !trksl.isEmpty() ? trksToken : QString( "0" ) );
+                        .arg( trksToken );
 
-    files_query.prepare( sql );
+    TomahawkSqlQuery files_query = lib->preparedQuery( sql );
+    bindTrackIds( files_query, trackPairs, trackIdSlots( trackPairs ) );
     files_query.exec();
 
     while ( files_query.next() )
@@ -41,6 +41,7 @@ public:
 
     QString commandname() const override { return "dbresolve"; }
     bool doesMutates() const override { return false; }
+    Priority priority() const override { return InteractivePriority; }
 
     void exec( DatabaseImpl *lib ) override;
 
@@ -0,0 +1,254 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2011, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DatabaseCommand_ResolveBatch.h"
+
+#include "collection/Collection.h"
+#include "utils/Logger.h"
+
+#include "PlaylistEntry.h"
+#include "SourceList.h"
+#include "Track.h"
+
+#include <QSet>
+
+// Upper bound for the number of ids inlined into a single IN (...) clause
+#define MAX_IDS_PER_STATEMENT 500
+
+using namespace Tomahawk;
+
+
+static QList< QStringList >
+chunkedIds( const QList< int >& ids )
+{
+    QList< QStringList > chunks;
+    QStringList chunk;
+    foreach ( int id, ids )
+    {
+        chunk << QString::number( id );
+        if ( chunk.count() == MAX_IDS_PER_STATEMENT )
+        {
+            chunks << chunk;
+            chunk.clear();
+        }
+    }
+    if ( !chunk.isEmpty() )
+        chunks << chunk;
+
+    return chunks;
+}
+
+
+DatabaseCommand_ResolveBatch::DatabaseCommand_ResolveBatch( const QList< query_ptr >& queries )
+    : DatabaseCommand()
+    , m_queries( queries )
+{
+}
+
+
+DatabaseCommand_ResolveBatch::~DatabaseCommand_ResolveBatch()
+{
+}
+
+
+void
+DatabaseCommand_ResolveBatch::exec( DatabaseImpl* lib )
+{
+    /*
+     *        Same 2 stage process as DatabaseCommand_Resolve, but for all queries at once:
+     *        1) find list of trk IDs that are reasonable matches for every query
+     *        2) fetch the files of all candidate tracks in one go and hand each
+     *           query the results belonging to its own candidates
+     */
+
+    QList< query_ptr > queries;
+    foreach ( const query_ptr& query, m_queries )
+    {
+        Q_ASSERT( !query->isFullTextQuery() );
+
+        if ( !query->resultHint().isEmpty() )
+        {
+            Tomahawk::result_ptr result = lib->resultFromHint( query );
+            if ( result && ( !result->resolvedByCollection() || result->resolvedByCollection()->isOnline() ) )
+            {
+                QList<Tomahawk::result_ptr> res;
+                res << result;
+                emit results( query->id(), res );
+                continue;
+            }
+        }
+
+        queries << query;
+    }
+
+    if ( queries.isEmpty() )
+        return;
+
+    // STEP 1
+    const QList< QList< QPair<int, float> > > candidates = lib->search( queries );
+
+    QList< int > trackIds;
+    QSet< int > seenTrackIds;
+    for ( int i = 0; i < candidates.count(); i++ )
+    {
+        for ( int k = 0; k < candidates.at( i ).count(); k++ )
+        {
+            const int trackId = candidates.at( i ).at( k ).first;
+            if ( seenTrackIds.contains( trackId ) )
+                continue;
+
+            seenTrackIds.insert( trackId );
+            trackIds << trackId;
+        }
+    }
+
+    // STEP 2
+    QHash< int, QList< Tomahawk::result_ptr > > resultsByTrack;
+    QHash< int, Tomahawk::track_ptr > newTracks;
+    if ( !trackIds.isEmpty() )
+    {
+        loadResults( lib, trackIds, resultsByTrack, newTracks );
+        loadAttributes( lib, newTracks );
+    }
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Resolved" << queries.count() << "queries against" << trackIds.count() << "candidate tracks";
+
+    for ( int i = 0; i < queries.count(); i++ )
+    {
+        const query_ptr& query = queries.at( i );
+
+        QList<Tomahawk::result_ptr> res;
+        for ( int k = 0; k < candidates.at( i ).count(); k++ )
+            res << resultsByTrack.value( candidates.at( i ).at( k ).first );
+
+        if ( candidates.at( i ).isEmpty() )
+            qDebug() << "No candidates found in first pass, aborting resolve" << query->queryTrack()->toString();
+
+        emit results( query->id(), res );
+    }
+}
+
+
+void
+DatabaseCommand_ResolveBatch::loadResults( DatabaseImpl* lib, const QList< int >& trackIds,
+                                           QHash< int, QList< Tomahawk::result_ptr > >& resultsByTrack,
+                                           QHash< int, Tomahawk::track_ptr >& newTracks )
+{
+    foreach ( const QStringList& trksl, chunkedIds( trackIds ) )
+    {
+        TomahawkSqlQuery files_query = lib->newquery();
+
+        QString sql = QString( "SELECT "
+                                "url, mtime, size, md5, mimetype, duration, bitrate, "  //0
+                                "file_join.artist, file_join.album, file_join.track, "  //7
+                                "file_join.composer, file_join.discnumber, "            //10
+                                "artist.name as artname, "                              //12
+                                "album.name as albname, "                               //13
+                                "track.name as trkname, "                               //14
+                                "composer.name as cmpname, "                            //15
+                                "file.source, "                                         //16
+                                "file_join.albumpos, "                                  //17
+                                "artist.id as artid, "                                  //18
+                                "album.id as albid, "                                   //19
+                                "composer.id as cmpid, "                                //20
+                                "albumArtist.id as albumartistid, "                     //21
+                                "albumArtist.name as albumartistname "                  //22
+                                "FROM file, file_join, artist, track "
+                                "LEFT JOIN album ON album.id = file_join.album "
+                                "LEFT JOIN artist AS composer ON composer.id = file_join.composer "
+                                "LEFT JOIN artist AS albumArtist ON albumArtist.id = album.artist "
+                                "WHERE "
+                                "artist.id = file_join.artist AND "
+                                "track.id = file_join.track AND "
+                                "file.id = file_join.file AND "
+                                "file_join.track IN (%1)" )
+             .arg( trksl.join( "," ) );
+
+        files_query.prepare( sql );
+        files_query.exec();
+
+        while ( files_query.next() )
+        {
+            const int trackId = files_query.value( 9 ).toInt();
+            QString url = files_query.value( 0 ).toString();
+            source_ptr s = SourceList::instance()->get( files_query.value( 16 ).toUInt() );
+            if ( !s )
+            {
+                tDebug() << "Could not find source" << files_query.value( 16 ).toUInt();
+                continue;
+            }
+            if ( !s->isLocal() )
+                url = QString( "servent://%1\t%2" ).arg( s->nodeId() ).arg( url );
+
+            Tomahawk::result_ptr result = Tomahawk::Result::getCached( url );
+            if ( result )
+            {
+                tDebug( LOGVERBOSE ) << "Result already cached:" << result->toString();
+                resultsByTrack[ trackId ] << result;
+                continue;
+            }
+
+            track_ptr track = Track::get( files_query.value( 9 ).toUInt(), files_query.value( 12 ).toString(), files_query.value( 14 ).toString(),
+                                          files_query.value( 13 ).toString(), files_query.value( 22 ).toString(), files_query.value( 5 ).toUInt(),
+                                          files_query.value( 15 ).toString(), files_query.value( 17 ).toUInt(), files_query.value( 11 ).toUInt() );
+            if ( !track )
+                continue;
+
+            result = Result::get( url, track );
+            if ( !result )
+                continue;
+
+            result->setModificationTime( files_query.value( 1 ).toUInt() );
+            result->setSize( files_query.value( 2 ).toUInt() );
+            result->setMimetype( files_query.value( 4 ).toString() );
+            result->setBitrate( files_query.value( 6 ).toUInt() );
+            result->setRID( uuid() );
+            result->setResolvedByCollection( s->dbCollection() );
+
+            newTracks.insert( trackId, track );
+            resultsByTrack[ trackId ] << result;
+        }
+    }
+}
+
+
+void
+DatabaseCommand_ResolveBatch::loadAttributes( DatabaseImpl* lib, const QHash< int, Tomahawk::track_ptr >& tracks )
+{
+    if ( tracks.isEmpty() )
+        return;
+
+    // Replaces one DatabaseCommand_LoadTrackAttributes per track with one SELECT per chunk
+    QHash< int, QVariantMap > attributes;
+    foreach ( const QStringList& trksl, chunkedIds( tracks.keys() ) )
+    {
+        TomahawkSqlQuery query = lib->newquery();
+        query.prepare( QString( "SELECT id, k, v FROM track_attributes WHERE id IN (%1)" ).arg( trksl.join( "," ) ) );
+        query.exec();
+
+        while ( query.next() )
+        {
+            attributes[ query.value( 0 ).toInt() ][ query.value( 1 ).toString() ] = query.value( 2 ).toString();
+        }
+    }
+
+    for ( QHash< int, Tomahawk::track_ptr >::const_iterator it = tracks.constBegin(); it != tracks.constEnd(); ++it )
+    {
+        it.value()->setAttributes( attributes.value( it.key() ) );
+    }
+}
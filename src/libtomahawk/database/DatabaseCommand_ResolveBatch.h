@@ -0,0 +1,73 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2011, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASECOMMAND_RESOLVEBATCH_H
+#define DATABASECOMMAND_RESOLVEBATCH_H
+
+#include "DatabaseCommand.h"
+#include "DatabaseImpl.h"
+#include "Result.h"
+
+#include <QVariant>
+
+#include "DllMacro.h"
+
+namespace Tomahawk
+{
+
+/**
+ * \class DatabaseCommand_ResolveBatch
+ * \brief Resolves a list of (non full-text) queries against the local database in one go.
+ *
+ * All queries are looked up in the fuzzy index together, the files for the
+ * union of all candidate tracks are fetched with a single joined SELECT and
+ * the track attributes of all new tracks are loaded in bulk. Results are
+ * reported per query, exactly like DatabaseCommand_Resolve does.
+ */
+class DLLEXPORT DatabaseCommand_ResolveBatch : public DatabaseCommand
+{
+Q_OBJECT
+public:
+    explicit DatabaseCommand_ResolveBatch( const QList< Tomahawk::query_ptr >& queries );
+    virtual ~DatabaseCommand_ResolveBatch();
+
+    QString commandname() const override { return "dbresolvebatch"; }
+    bool doesMutates() const override { return false; }
+    Priority priority() const override { return InteractivePriority; }
+
+    void exec( DatabaseImpl* lib ) override;
+
+    QList< Tomahawk::query_ptr > queries() const { return m_queries; }
+
+signals:
+    void results( Tomahawk::QID qid, QList<Tomahawk::result_ptr> results );
+
+private:
+    DatabaseCommand_ResolveBatch();
+
+    void loadResults( DatabaseImpl* lib, const QList< int >& trackIds,
+                      QHash< int, QList< Tomahawk::result_ptr > >& resultsByTrack,
+                      QHash< int, Tomahawk::track_ptr >& newTracks );
+    void loadAttributes( DatabaseImpl* lib, const QHash< int, Tomahawk::track_ptr >& tracks );
+
+    QList< Tomahawk::query_ptr > m_queries;
+};
+
+}
+
+#endif // DATABASECOMMAND_RESOLVEBATCH_H
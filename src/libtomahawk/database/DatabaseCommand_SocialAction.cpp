@@ -54,8 +54,6 @@ DatabaseCommand_SocialAction::exec( DatabaseImpl* dbi )
     qDebug() << Q_FUNC_INFO;
     Q_ASSERT( !source().isNull() );
 
-    TomahawkSqlQuery query = dbi->newquery();
-
     QVariant srcid = source()->isLocal() ? QVariant( QVariant::Int ) : source()->id();
 
     if ( m_artist.isNull() || m_title.isEmpty() || m_action.isEmpty() )
@@ -68,25 +66,31 @@ DatabaseCommand_SocialAction::exec( DatabaseImpl* dbi )
     if ( trkid < 1 )
         return;
 
+    const QString srcToken = source()->isLocal() ? "IS NULL" : "= ?";
+
     // update if it already exists
-    TomahawkSqlQuery find = dbi->newquery();
-    find.prepare( QString( "SELECT id, k, v FROM social_attributes WHERE social_attributes.id = ? AND social_attributes.source %1 AND social_attributes.k = ?" ).arg( source()->isLocal() ? "IS NULL" : QString( "=%1" ).arg( source()->id() ) ) );
+    TomahawkSqlQuery find = dbi->preparedQuery( QString( "SELECT id, k, v FROM social_attributes WHERE social_attributes.id = ? AND social_attributes.source %1 AND social_attributes.k = ?" ).arg( srcToken ) );
     find.addBindValue( trkid );
+    if ( !source()->isLocal() )
+        find.addBindValue( srcid );
     find.addBindValue( m_action );
+
+    TomahawkSqlQuery query;
     if ( find.exec() && find.next() )
     {
         // update
-        query.prepare( QString( "UPDATE social_attributes SET v = '%1', timestamp = %2 WHERE social_attributes.id = %3 AND social_attributes.source %4 AND social_attributes.k = '%5'" )
-                               .arg( m_comment )
-                               .arg( m_timestamp )
-                               .arg( trkid )
-                               .arg( source()->isLocal() ? "IS NULL" : QString( "=%1" ).arg( source()->id() ) )
-                               .arg( m_action ) );
+        query = dbi->preparedQuery( QString( "UPDATE social_attributes SET v = ?, timestamp = ? WHERE social_attributes.id = ? AND social_attributes.source %1 AND social_attributes.k = ?" ).arg( srcToken ) );
+        query.addBindValue( m_comment );
+        query.addBindValue( m_timestamp );
+        query.addBindValue( trkid );
+        if ( !source()->isLocal() )
+            query.addBindValue( srcid );
+        query.addBindValue( m_action );
     }
     else
     {
-        query.prepare( "INSERT INTO social_attributes(id, source, k, v, timestamp) "
-                       "VALUES (?, ?, ?, ?, ?)" );
+        query = dbi->preparedQuery( "INSERT INTO social_attributes(id, source, k, v, timestamp) "
+                                    "VALUES (?, ?, ?, ?, ?)" );
 
         query.bindValue( 0, trkid );
         query.bindValue( 1, srcid );
@@ -37,8 +37,6 @@ DatabaseCommand_TrackAttributes::DatabaseCommand_TrackAttributes( DatabaseComman
 
 void DatabaseCommand_TrackAttributes::exec( DatabaseImpl* lib )
 {
-    TomahawkSqlQuery query = lib->newquery();
-
     QString k;
     switch ( m_type )
     {
@@ -50,9 +48,9 @@ void DatabaseCommand_TrackAttributes::exec( DatabaseImpl* lib )
     PairList results;
     if ( !m_ids.isEmpty() )
     {
+        TomahawkSqlQuery query = lib->preparedQuery( "SELECT v FROM track_attributes WHERE id = ? AND k = ?" );
         foreach ( const QID id, m_ids )
         {
-            query.prepare( "SELECT v FROM track_attributes WHERE id = ? AND k = ?" );
             query.bindValue( 0, id );
             query.bindValue( 1, k );
             if ( query.exec() )
@@ -61,7 +59,7 @@ void DatabaseCommand_TrackAttributes::exec( DatabaseImpl* lib )
     }
     else
     {
-        query.prepare( "SELECT id, v FROM track_attributes WHERE k = ?" );
+        TomahawkSqlQuery query = lib->preparedQuery( "SELECT id, v FROM track_attributes WHERE k = ?" );
         query.bindValue( 0, k );
         query.exec();
         while ( query.next() )
@@ -39,6 +39,7 @@ public:
 
     virtual void exec( DatabaseImpl* lib );
     virtual bool doesMutates() const { return false; }
+    virtual Priority priority() const { return BackgroundPriority; }
     virtual QString commandname() const { return "trackstats"; }
 
 signals:
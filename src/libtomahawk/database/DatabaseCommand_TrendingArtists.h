@@ -37,6 +37,7 @@ public:
     virtual void exec( DatabaseImpl* );
 
     virtual bool doesMutates() const { return false; }
+    virtual Priority priority() const { return BackgroundPriority; }
     virtual QString commandname() const { return "trendingartists"; }
 
     void setLimit( unsigned int amount );
@@ -50,7 +50,8 @@ DatabaseCommand_UpdateSearchIndex::exec( DatabaseImpl* db )
     db->m_fuzzyIndex->beginIndexing();
 
     TomahawkSqlQuery q = db->newquery();
-    q.exec( "SELECT track.id, track.name, artist.name, artist.id FROM track, artist WHERE artist.id = track.artist" );
+    // tracks and albums without any files can't be resolved, DatabaseCommand_DeleteFiles drops them from the index as well
+    q.exec( "SELECT track.id, track.name, artist.name, artist.id FROM track, artist WHERE artist.id = track.artist AND track.id IN ( SELECT track FROM file_join )" );
     while ( q.next() )
     {
         IndexData ida;
@@ -62,7 +63,7 @@ DatabaseCommand_UpdateSearchIndex::exec( DatabaseImpl* db )
         db->m_fuzzyIndex->appendFields( ida );
     }
 
-    q.exec( "SELECT album.id, album.name FROM album" );
+    q.exec( "SELECT album.id, album.name FROM album WHERE album.id IN ( SELECT album FROM file_join )" );
     while ( q.next() )
     {
         IndexData ida;
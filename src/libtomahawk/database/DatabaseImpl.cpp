@@ -32,10 +32,12 @@
 #include "PlaylistEntry.h"
 #include "Result.h"
 #include "SourceList.h"
+#include "TomahawkSettings.h"
 #include "Track.h"
 
 #include <QtAlgorithms>
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QRegExp>
 #include <QStringList>
@@ -49,8 +51,33 @@
 #include "Schema.sql.h"
 
 #define CURRENT_SCHEMA_VERSION 31
+#define MAX_CACHED_STATEMENTS 128
+#define MMAP_SIZE 268435456
+#define WAL_AUTOCHECKPOINT_PAGES 10000
+#define INCREMENTAL_VACUUM_PAGES 2000
+
+
+void
+Tomahawk::DatabaseStatementStatistics::add( const DatabaseStatementStatistics& other )
+{
+    hits += other.hits;
+    misses += other.misses;
+    totalPrepareUs += other.totalPrepareUs;
+    maxPrepareUs = qMax( maxPrepareUs, other.maxPrepareUs );
+    cached += other.cached;
+}
+
+
+static bool
+configuredWriteAheadLog()
+{
+    // the write-ahead log is the default, also for the command line tools that run without TomahawkSettings
+    return !TomahawkSettings::instance() || TomahawkSettings::instance()->databaseWriteAheadLog();
+}
+
 
 Tomahawk::DatabaseImpl::DatabaseImpl( const QString& dbname )
+    : m_writeAheadLog( configuredWriteAheadLog() )
 {
     QTime t;
     t.start();
@@ -79,9 +106,9 @@ Tomahawk::DatabaseImpl::DatabaseImpl( const QString& dbname )
     }
 
     tLog() << "Database ID:" << m_dbid;
+    query.finish();
+    setupStorage();
     init();
-    query.exec( "PRAGMA auto_vacuum = FULL" );
-    query.exec( "PRAGMA synchronous = NORMAL" );
 
     tDebug( LOGVERBOSE ) << "Tweaked db pragmas:" << t.elapsed();
 
@@ -100,9 +127,9 @@ Tomahawk::DatabaseImpl::DatabaseImpl( const QString& dbname )
 }
 
 
-Tomahawk::DatabaseImpl::DatabaseImpl( const QString& dbname, bool internal )
+Tomahawk::DatabaseImpl::DatabaseImpl( const QString& dbname, bool writeAheadLog )
+    : m_writeAheadLog( writeAheadLog )
 {
-    Q_UNUSED( internal );
     openDatabase( dbname, false );
     init();
 }
@@ -112,11 +139,97 @@ void
 Tomahawk::DatabaseImpl::init()
 {
     m_lastartid = m_lastalbid = m_lasttrkid = 0;
+    m_statements.setMaxCost( MAX_CACHED_STATEMENTS );
 
     TomahawkSqlQuery query = newquery();
 
      // make sqlite behave how we want:
     query.exec( "PRAGMA foreign_keys = ON" );
+    query.exec( "PRAGMA synchronous = NORMAL" );
+
+    if ( m_writeAheadLog )
+    {
+        query.exec( QString( "PRAGMA mmap_size = %1" ).arg( MMAP_SIZE ) );
+
+        // checkpointing is up to runIdleMaintenance(), this only keeps the log from growing forever during long syncs
+        query.exec( QString( "PRAGMA wal_autocheckpoint = %1" ).arg( WAL_AUTOCHECKPOINT_PAGES ) );
+    }
+}
+
+
+void
+Tomahawk::DatabaseImpl::setupStorage()
+{
+    TomahawkSqlQuery query = newquery();
+
+    query.exec( QString( "PRAGMA journal_mode = %1" ).arg( m_writeAheadLog ? "WAL" : "DELETE" ) );
+    const QString mode = query.next() ? query.value( 0 ).toString().toLower() : QString();
+    if ( m_writeAheadLog && mode != "wal" )
+    {
+        tLog() << "Database can't use a write-ahead log, journal mode is" << mode;
+        m_writeAheadLog = false;
+    }
+
+    tLog() << "Database journal mode:" << mode;
+}
+
+
+void
+Tomahawk::DatabaseImpl::runIdleMaintenance()
+{
+    enableIncrementalVacuum();
+
+    TomahawkSqlQuery query = newquery();
+
+    query.exec( "PRAGMA freelist_count" );
+    if ( query.next() && query.value( 0 ).toInt() > 0 )
+    {
+        tDebug( LOGVERBOSE ) << "Freeing unused database pages:" << qMin( query.value( 0 ).toInt(), INCREMENTAL_VACUUM_PAGES );
+
+        // every step frees another page
+        query.exec( QString( "PRAGMA incremental_vacuum(%1)" ).arg( INCREMENTAL_VACUUM_PAGES ) );
+        while ( query.next() ) {}
+    }
+
+    if ( m_writeAheadLog )
+    {
+        // doesn't wait for readers, whatever they still look at gets its turn next time
+        query.exec( "PRAGMA wal_checkpoint(PASSIVE)" );
+        if ( query.next() )
+            tDebug( LOGVERBOSE ) << "Checkpointed" << query.value( 2 ).toInt() << "of" << query.value( 1 ).toInt() << "write-ahead log pages";
+    }
+
+    query.finish();
+}
+
+
+void
+Tomahawk::DatabaseImpl::enableIncrementalVacuum()
+{
+    TomahawkSqlQuery query = newquery();
+
+    // a database that already had tables when it got created only starts freeing pages once it got rebuilt
+    query.exec( "PRAGMA auto_vacuum" );
+    if ( !query.next() || query.value( 0 ).toInt() == 2 /* INCREMENTAL */ )
+        return;
+
+    // rebuilding can fail, e.g. for lack of disk space, so only ever try it once
+    query.exec( "SELECT v FROM settings WHERE k='incremental_vacuum'" );
+    if ( query.next() )
+        return;
+    query.exec( "INSERT INTO settings(k,v) VALUES('incremental_vacuum','tried')" );
+
+    tLog() << "Switching database to incremental vacuum, this rebuilds it once";
+    QTime t;
+    t.start();
+
+    query.exec( "PRAGMA auto_vacuum = INCREMENTAL" );
+    if ( query.exec( "VACUUM" ) )
+        tLog() << "Rebuilt database for incremental vacuum in" << t.elapsed() << "ms";
+    else
+        tLog() << "Failed rebuilding database for incremental vacuum:" << query.lastError().text();
+
+    query.finish();
 }
 
 
@@ -124,6 +237,9 @@ Tomahawk::DatabaseImpl::~DatabaseImpl()
 {
     tDebug() << "Shutting down database connection.";
 
+    // finalize the cached statements while the connection is still there
+    m_statements.clear();
+
 /*
 #ifdef TOMAHAWK_QUERY_ANALYZE
     TomahawkSqlQuery q = newquery();
@@ -156,12 +272,75 @@ Tomahawk::DatabaseImpl::database()
 }
 
 
+TomahawkSqlQuery
+Tomahawk::DatabaseImpl::preparedQuery( const QString& sql )
+{
+    QMutexLocker lock( &m_mutex );
+
+    m_usedStatements.insert( sql );
+    if ( TomahawkSqlQuery* query = m_statements.object( sql ) )
+    {
+        m_statementStatistics.hits++;
+        return *query;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    TomahawkSqlQuery* query = new TomahawkSqlQuery( m_db );
+    if ( !query->prepare( sql ) )
+    {
+        // exec() will re-prepare and report it, don't keep it around
+        tDebug() << Q_FUNC_INFO << "Failed to prepare statement:" << sql << query->lastError().text();
+        TomahawkSqlQuery result = *query;
+        delete query;
+        return result;
+    }
+
+    const qint64 us = timer.nsecsElapsed() / 1000;
+    m_statementStatistics.misses++;
+    m_statementStatistics.totalPrepareUs += us;
+    m_statementStatistics.maxPrepareUs = qMax( m_statementStatistics.maxPrepareUs, us );
+
+    m_statements.insert( sql, query );
+    return *query;
+}
+
+
+void
+Tomahawk::DatabaseImpl::finishPreparedQueries()
+{
+    QMutexLocker lock( &m_mutex );
+
+    // evicted ones got finalized already
+    foreach ( const QString& sql, m_usedStatements )
+    {
+        TomahawkSqlQuery* query = m_statements.object( sql );
+        if ( query && query->isActive() )
+            query->finish();
+    }
+
+    m_usedStatements.clear();
+}
+
+
+Tomahawk::DatabaseStatementStatistics
+Tomahawk::DatabaseImpl::statementStatistics() const
+{
+    QMutexLocker lock( &m_mutex );
+
+    DatabaseStatementStatistics stats = m_statementStatistics;
+    stats.cached = m_statements.count();
+    return stats;
+}
+
+
 Tomahawk::DatabaseImpl*
 Tomahawk::DatabaseImpl::clone() const
 {
     QMutexLocker lock( &m_mutex );
 
-    DatabaseImpl* impl = new DatabaseImpl( m_db.databaseName(), true );
+    DatabaseImpl* impl = new DatabaseImpl( m_db.databaseName(), m_writeAheadLog );
     impl->setDatabaseID( m_dbid );
     impl->setFuzzyIndex( m_fuzzyIndex );
     return impl;
@@ -287,18 +466,18 @@ Tomahawk::result_ptr
 Tomahawk::DatabaseImpl::file( int fid )
 {
     Tomahawk::result_ptr r;
-    TomahawkSqlQuery query = newquery();
-    query.exec( QString( "SELECT url, mtime, size, md5, mimetype, duration, bitrate, "
-                         "file_join.artist, file_join.album, file_join.track, file_join.composer, "
-                         "(SELECT name FROM artist WHERE id = file_join.artist) AS artname, "
-                         "(SELECT name FROM album  WHERE id = file_join.album)  AS albname, "
-                         "(SELECT name FROM track  WHERE id = file_join.track)  AS trkname, "
-                         "(SELECT name FROM artist WHERE id = file_join.composer) AS cmpname, "
-                         "source, "
-                         "(SELECT artist.name FROM artist, album WHERE artist.id = album.artist AND album.id = file_join.album) AS albumartname "
-                         "FROM file, file_join "
-                         "WHERE file.id = file_join.file AND file.id = %1" )
-                .arg( fid ) );
+    TomahawkSqlQuery query = preparedQuery( "SELECT url, mtime, size, md5, mimetype, duration, bitrate, "
+                                            "file_join.artist, file_join.album, file_join.track, file_join.composer, "
+                                            "(SELECT name FROM artist WHERE id = file_join.artist) AS artname, "
+                                            "(SELECT name FROM album  WHERE id = file_join.album)  AS albname, "
+                                            "(SELECT name FROM track  WHERE id = file_join.track)  AS trkname, "
+                                            "(SELECT name FROM artist WHERE id = file_join.composer) AS cmpname, "
+                                            "source, "
+                                            "(SELECT artist.name FROM artist, album WHERE artist.id = album.artist AND album.id = file_join.album) AS albumartname "
+                                            "FROM file, file_join "
+                                            "WHERE file.id = file_join.file AND file.id = ?" );
+    query.bindValue( 0, fid );
+    query.exec();
 
     if ( query.next() )
     {
@@ -339,8 +518,7 @@ Tomahawk::DatabaseImpl::artistId( const QString& name_orig, bool autoCreate )
     int id = 0;
     QString sortname = Tomahawk::DatabaseImpl::sortname( name_orig );
 
-    TomahawkSqlQuery query = newquery();
-    query.prepare( "SELECT id FROM artist WHERE sortname = ?" );
+    TomahawkSqlQuery query = preparedQuery( "SELECT id FROM artist WHERE sortname = ?" );
     query.addBindValue( sortname );
     query.exec();
     if ( query.next() )
@@ -357,16 +535,16 @@ Tomahawk::DatabaseImpl::artistId( const QString& name_orig, bool autoCreate )
     if ( autoCreate )
     {
         // not found, insert it.
-        query.prepare( "INSERT INTO artist(id,name,sortname) VALUES(NULL,?,?)" );
-        query.addBindValue( name_orig );
-        query.addBindValue( sortname );
-        if ( !query.exec() )
+        TomahawkSqlQuery insert = preparedQuery( "INSERT INTO artist(id,name,sortname) VALUES(NULL,?,?)" );
+        insert.addBindValue( name_orig );
+        insert.addBindValue( sortname );
+        if ( !insert.exec() )
         {
             tDebug() << "Failed to insert artist:" << name_orig;
             return 0;
         }
 
-        id = query.lastInsertId().toInt();
+        id = insert.lastInsertId().toInt();
         m_lastart = name_orig;
         m_lastartid = id;
     }
@@ -382,8 +560,7 @@ Tomahawk::DatabaseImpl::trackId( int artistid, const QString& name_orig, bool au
     QString sortname = Tomahawk::DatabaseImpl::sortname( name_orig );
     //if( ( id = m_artistcache[sortname] ) ) return id;
 
-    TomahawkSqlQuery query = newquery();
-    query.prepare( "SELECT id FROM track WHERE artist = ? AND sortname = ?" );
+    TomahawkSqlQuery query = preparedQuery( "SELECT id FROM track WHERE artist = ? AND sortname = ?" );
     query.addBindValue( artistid );
     query.addBindValue( sortname );
     query.exec();
@@ -401,17 +578,17 @@ Tomahawk::DatabaseImpl::trackId( int artistid, const QString& name_orig, bool au
     if ( autoCreate )
     {
         // not found, insert it.
-        query.prepare( "INSERT INTO track(id,artist,name,sortname) VALUES(NULL,?,?,?)" );
-        query.addBindValue( artistid );
-        query.addBindValue( name_orig );
-        query.addBindValue( sortname );
-        if ( !query.exec() )
+        TomahawkSqlQuery insert = preparedQuery( "INSERT INTO track(id,artist,name,sortname) VALUES(NULL,?,?,?)" );
+        insert.addBindValue( artistid );
+        insert.addBindValue( name_orig );
+        insert.addBindValue( sortname );
+        if ( !insert.exec() )
         {
             tDebug() << "Failed to insert track:" << name_orig;
             return 0;
         }
 
-        id = query.lastInsertId().toInt();
+        id = insert.lastInsertId().toInt();
     }
 
     return id;
@@ -434,8 +611,7 @@ Tomahawk::DatabaseImpl::albumId( int artistid, const QString& name_orig, bool au
     QString sortname = Tomahawk::DatabaseImpl::sortname( name_orig );
     //if( ( id = m_albumcache[sortname] ) ) return id;
 
-    TomahawkSqlQuery query = newquery();
-    query.prepare( "SELECT id FROM album WHERE artist = ? AND sortname = ?" );
+    TomahawkSqlQuery query = preparedQuery( "SELECT id FROM album WHERE artist = ? AND sortname = ?" );
     query.addBindValue( artistid );
     query.addBindValue( sortname );
     query.exec();
@@ -453,17 +629,17 @@ Tomahawk::DatabaseImpl::albumId( int artistid, const QString& name_orig, bool au
     if ( autoCreate )
     {
         // not found, insert it.
-        query.prepare( "INSERT INTO album(id,artist,name,sortname) VALUES(NULL,?,?,?)" );
-        query.addBindValue( artistid );
-        query.addBindValue( name_orig );
-        query.addBindValue( sortname );
-        if( !query.exec() )
+        TomahawkSqlQuery insert = preparedQuery( "INSERT INTO album(id,artist,name,sortname) VALUES(NULL,?,?,?)" );
+        insert.addBindValue( artistid );
+        insert.addBindValue( name_orig );
+        insert.addBindValue( sortname );
+        if( !insert.exec() )
         {
             tDebug() << "Failed to insert album:" << name_orig;
             return 0;
         }
 
-        id = query.lastInsertId().toInt();
+        id = insert.lastInsertId().toInt();
         m_lastalb = name_orig;
         m_lastalbid = id;
     }
@@ -472,12 +648,10 @@ Tomahawk::DatabaseImpl::albumId( int artistid, const QString& name_orig, bool au
 }
 
 
-QList< QPair<int, float> >
-Tomahawk::DatabaseImpl::search( const Tomahawk::query_ptr& query, uint limit )
+static QList< QPair<int, float> >
+sortedScorePairs( const QMap< int, float >& resultsmap, uint limit )
 {
     QList< QPair<int, float> > resultslist;
-
-    QMap< int, float > resultsmap = m_fuzzyIndex->search( query );
     foreach ( int i, resultsmap.keys() )
     {
         resultslist << QPair<int, float>( i, (float)resultsmap.value( i ) );
@@ -497,6 +671,28 @@ Tomahawk::DatabaseImpl::search( const Tomahawk::query_ptr& query, uint limit )
 }
 
 
+QList< QPair<int, float> >
+Tomahawk::DatabaseImpl::search( const Tomahawk::query_ptr& query, uint limit )
+{
+    return sortedScorePairs( m_fuzzyIndex->search( query ), limit );
+}
+
+
+QList< QList< QPair<int, float> > >
+Tomahawk::DatabaseImpl::search( const QList< Tomahawk::query_ptr >& queries, uint limit )
+{
+    QList< QList< QPair<int, float> > > resultslists;
+
+    const QList< QMap< int, float > > resultsmaps = m_fuzzyIndex->search( queries );
+    foreach ( const QMap< int, float >& resultsmap, resultsmaps )
+    {
+        resultslists << sortedScorePairs( resultsmap, limit );
+    }
+
+    return resultslists;
+}
+
+
 QList< QPair<int, float> >
 Tomahawk::DatabaseImpl::searchAlbum( const Tomahawk::query_ptr& query, uint limit )
 {
@@ -527,10 +723,10 @@ Tomahawk::DatabaseImpl::getTrackFids( int tid )
 {
     QList< int > ret;
 
-    TomahawkSqlQuery query = newquery();
-    query.exec( QString( "SELECT file.id FROM file, file_join "
-                         "WHERE file_join.file=file.id "
-                         "AND file_join.track = %1 ").arg( tid ) );
+    TomahawkSqlQuery query = preparedQuery( "SELECT file.id FROM file, file_join "
+                                            "WHERE file_join.file=file.id "
+                                            "AND file_join.track = ?" );
+    query.bindValue( 0, tid );
     query.exec();
 
     while( query.next() )
@@ -557,8 +753,9 @@ Tomahawk::DatabaseImpl::sortname( const QString& str, bool replaceArticle )
 QVariantMap
 Tomahawk::DatabaseImpl::artist( int id )
 {
-    TomahawkSqlQuery query = newquery();
-    query.exec( QString( "SELECT id, name, sortname FROM artist WHERE id = %1" ).arg( id ) );
+    TomahawkSqlQuery query = preparedQuery( "SELECT id, name, sortname FROM artist WHERE id = ?" );
+    query.bindValue( 0, id );
+    query.exec();
 
     QVariantMap m;
     if( !query.next() )
@@ -574,8 +771,9 @@ Tomahawk::DatabaseImpl::artist( int id )
 QVariantMap
 Tomahawk::DatabaseImpl::track( int id )
 {
-    TomahawkSqlQuery query = newquery();
-    query.exec( QString( "SELECT id, artist, name, sortname FROM track WHERE id = %1" ).arg( id ) );
+    TomahawkSqlQuery query = preparedQuery( "SELECT id, artist, name, sortname FROM track WHERE id = ?" );
+    query.bindValue( 0, id );
+    query.exec();
 
     QVariantMap m;
     if( !query.next() )
@@ -592,8 +790,9 @@ Tomahawk::DatabaseImpl::track( int id )
 QVariantMap
 Tomahawk::DatabaseImpl::album( int id )
 {
-    TomahawkSqlQuery query = newquery();
-    query.exec( QString( "SELECT id, artist, name, sortname FROM album WHERE id = %1" ).arg( id ) );
+    TomahawkSqlQuery query = preparedQuery( "SELECT id, artist, name, sortname FROM album WHERE id = ?" );
+    query.bindValue( 0, id );
+    query.exec();
 
     QVariantMap m;
     if( !query.next() )
@@ -611,7 +810,6 @@ Tomahawk::result_ptr
 Tomahawk::DatabaseImpl::resultFromHint( const Tomahawk::query_ptr& origquery )
 {
     QString url = origquery->resultHint();
-    TomahawkSqlQuery query = newquery();
     Tomahawk::source_ptr s;
     Tomahawk::result_ptr res;
     QString fileUrl;
@@ -689,10 +887,12 @@ Tomahawk::DatabaseImpl::resultFromHint( const Tomahawk::query_ptr& origquery )
                             "file.source %1 AND "
                             "file_join.file = file.id AND "
                             "file.url = ?"
-        ).arg( searchlocal ? "IS NULL" : QString( "= %1" ).arg( s->id() ) );
+        ).arg( searchlocal ? "IS NULL" : "= ?" );
 
-    query.prepare( sql );
-    query.bindValue( 0, fileUrl );
+    TomahawkSqlQuery query = preparedQuery( sql );
+    if ( !searchlocal )
+        query.addBindValue( s->id() );
+    query.addBindValue( fileUrl );
     query.exec();
 
     if ( query.next() )
@@ -757,7 +957,9 @@ Tomahawk::DatabaseImpl::openDatabase( const QString& dbname, bool checkSchema )
 
         QSqlDatabase db = QSqlDatabase::addDatabase( sqlDriver, connName );
         db.setDatabaseName( dbname );
-        db.setConnectOptions( "QSQLITE_ENABLE_SHARED_CACHE=1" );
+        // a shared cache would make connections wait for each other's table locks again
+        if ( !m_writeAheadLog )
+            db.setConnectOptions( "QSQLITE_ENABLE_SHARED_CACHE=1" );
         if ( !db.open() )
         {
             tLog() << "Failed to open database" << dbname << "with driver" << sqlDriver;
@@ -809,6 +1011,8 @@ Tomahawk::DatabaseImpl::openDatabase( const QString& dbname, bool checkSchema )
     }
     else if ( version < 0 )
     {
+        // only takes effect before the first table is created, saves rebuilding the database later on
+        QSqlQuery( m_db ).exec( "PRAGMA auto_vacuum = INCREMENTAL" );
         schemaUpdated = updateSchema( 0 );
     }
 
@@ -22,9 +22,11 @@
 #define DATABASEIMPL_H
 
 #include <QObject>
+#include <QCache>
 #include <QList>
 #include <QMutex>
 #include <QPair>
+#include <QSet>
 #include <QVariant>
 #include <QVariantMap>
 #include <QSqlDatabase>
@@ -44,11 +46,28 @@ namespace Tomahawk
 class Database;
 class DatabaseFuzzyIndex;
 
+/// How well DatabaseImpl::preparedQuery() does, for one connection or all of them
+struct DLLEXPORT DatabaseStatementStatistics
+{
+    DatabaseStatementStatistics() : hits( 0 ), misses( 0 ), totalPrepareUs( 0 ), maxPrepareUs( 0 ), cached( 0 ) {}
+
+    quint64 hits;
+    quint64 misses;
+    quint64 totalPrepareUs;
+    qint64 maxPrepareUs;
+    int cached;
+
+    qint64 averagePrepareUs() const { return misses ? totalPrepareUs / misses : 0; }
+    void add( const DatabaseStatementStatistics& other );
+};
+
 class DLLEXPORT DatabaseImpl : public QObject
 {
 Q_OBJECT
 
 friend class DatabaseFuzzyIndex;
+friend class DatabaseCommand_AddFiles;
+friend class DatabaseCommand_DeleteFiles;
 friend class DatabaseCommand_UpdateSearchIndex;
 
 public:
@@ -60,11 +79,41 @@ public:
     TomahawkSqlQuery newquery();
     QSqlDatabase& database();
 
+    /**
+     * Returns @p sql prepared on this connection, ready to have its values
+     * bound and be exec()'d. Statements are kept around per connection (and
+     * so per thread), the least recently used ones get dropped.
+     *
+     * The returned query shares its statement with the cached one: bind all
+     * of its values every time, don't prepare() something else on it and
+     * don't ask for the same SQL again while still reading its results.
+     */
+    TomahawkSqlQuery preparedQuery( const QString& sql );
+
+    /// Resets all cached statements, so none of them keeps a read lock open
+    void finishPreparedQueries();
+
+    /// Can be called from any thread
+    DatabaseStatementStatistics statementStatistics() const;
+
+    /// Whether the database keeps a write-ahead log, in which case reads see a snapshot and don't wait for writes
+    bool writeAheadLog() const { return m_writeAheadLog; }
+
+    /**
+     * Housekeeping for when nothing else is going on: gives pages that are no
+     * longer used back to the file system and checkpoints the write-ahead log.
+     * Databases created without incremental vacuum get rebuilt once, here
+     * rather than on startup.
+     * Writes, so only call it from the thread that does the writing.
+     */
+    void runIdleMaintenance();
+
     int artistId( const QString& name_orig, bool autoCreate ); //also for composers!
     int trackId( int artistid, const QString& name_orig, bool autoCreate );
     int albumId( int artistid, const QString& name_orig, bool autoCreate );
 
     QList< QPair<int, float> > search( const Tomahawk::query_ptr& query, uint limit = 0 );
+    QList< QList< QPair<int, float> > > search( const QList< Tomahawk::query_ptr >& queries, uint limit = 0 );
     QList< QPair<int, float> > searchAlbum( const Tomahawk::query_ptr& query, uint limit = 0 );
     QList< int > getTrackFids( int tid );
 
@@ -94,17 +143,20 @@ signals:
     void schemaUpdateDone();
 
 private:
-    DatabaseImpl( const QString& dbname, bool internal );
+    DatabaseImpl( const QString& dbname, bool writeAheadLog );
     void setFuzzyIndex( DatabaseFuzzyIndex* fi ) { m_fuzzyIndex = fi; }
     void setDatabaseID( const QString& dbid ) { m_dbid = dbid; }
 
     void init();
+    void setupStorage();
+    void enableIncrementalVacuum();
     bool openDatabase( const QString& dbname, bool checkSchema = true );
     bool updateSchema( int oldVersion );
     void dumpDatabase();
     QString cleanSql( const QString& sql );
 
     bool m_ready;
+    bool m_writeAheadLog;
     QSqlDatabase m_db;
 
     QString m_lastart, m_lastalb, m_lasttrk;
@@ -113,6 +165,10 @@ private:
     QString m_dbid;
     Tomahawk::DatabaseFuzzyIndex* m_fuzzyIndex;
     mutable QMutex m_mutex;
+
+    QCache< QString, TomahawkSqlQuery > m_statements;
+    QSet< QString > m_usedStatements;
+    DatabaseStatementStatistics m_statementStatistics;
 };
 
 }
@@ -20,6 +20,7 @@
 
 #include "database/Database.h"
 #include "database/DatabaseCommand_Resolve.h"
+#include "database/DatabaseCommand_ResolveBatch.h"
 #include "network/Servent.h"
 #include "utils/Logger.h"
 
@@ -27,6 +28,11 @@
 #include "PlaylistEntry.h"
 #include "Source.h"
 
+#include <QTimer>
+
+// Queries handed to a single DatabaseCommand_ResolveBatch at most
+#define MAX_BATCH_SIZE 100
+
 
 DatabaseResolver::DatabaseResolver( int weight )
     : Resolver()
@@ -38,6 +44,19 @@ DatabaseResolver::DatabaseResolver( int weight )
 void
 DatabaseResolver::resolve( const Tomahawk::query_ptr& query )
 {
+    if ( !query->isFullTextQuery() )
+    {
+        // Pipeline hands us queries one by one, collect all of them dispatched
+        // in this event loop turn and resolve them with a single command.
+        m_pendingQueries << query;
+        if ( m_pendingQueries.count() >= MAX_BATCH_SIZE )
+            resolvePendingQueries();
+        else if ( m_pendingQueries.count() == 1 )
+            QTimer::singleShot( 0, this, SLOT( resolvePendingQueries() ) );
+
+        return;
+    }
+
     Tomahawk::DatabaseCommand_Resolve* cmd = new Tomahawk::DatabaseCommand_Resolve( query );
 
     connect( cmd, SIGNAL( results( Tomahawk::QID, QList< Tomahawk::result_ptr > ) ),
@@ -51,6 +70,22 @@ DatabaseResolver::resolve( const Tomahawk::query_ptr& query )
 }
 
 
+void
+DatabaseResolver::resolvePendingQueries()
+{
+    if ( m_pendingQueries.isEmpty() )
+        return;
+
+    Tomahawk::DatabaseCommand_ResolveBatch* cmd = new Tomahawk::DatabaseCommand_ResolveBatch( m_pendingQueries );
+    m_pendingQueries.clear();
+
+    connect( cmd, SIGNAL( results( Tomahawk::QID, QList< Tomahawk::result_ptr > ) ),
+                    SLOT( gotResults( Tomahawk::QID, QList< Tomahawk::result_ptr > ) ), Qt::QueuedConnection );
+
+    Tomahawk::Database::instance()->enqueue( Tomahawk::dbcmd_ptr( cmd ) );
+}
+
+
 void
 DatabaseResolver::gotResults( const Tomahawk::QID qid, QList< Tomahawk::result_ptr> results )
 {
@@ -41,12 +41,17 @@ public slots:
     virtual void resolve( const Tomahawk::query_ptr& query ) override;
 
 private slots:
+    void resolvePendingQueries();
+
     void gotResults( const Tomahawk::QID qid, QList< Tomahawk::result_ptr> results );
     void gotAlbums( const Tomahawk::QID qid, QList< Tomahawk::album_ptr> albums );
     void gotArtists( const Tomahawk::QID qid, QList< Tomahawk::artist_ptr> artists );
 
 private:
     int m_weight;
+
+    // queries collected during the current event loop turn, resolved as one batch
+    QList< Tomahawk::query_ptr > m_pendingQueries;
 };
 
 #endif // DATABASERESOLVER_H
@@ -0,0 +1,176 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2011, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DatabaseScheduler.h"
+
+#include "utils/Logger.h"
+
+#include "DatabaseWorker.h"
+
+#include <QMetaObject>
+
+// Commands waiting longer than this are served before anything else
+#define MAX_WAIT_MS 5000
+
+namespace Tomahawk
+{
+
+DatabaseScheduler::DatabaseScheduler()
+{
+    m_clock.start();
+}
+
+
+DatabaseScheduler::~DatabaseScheduler()
+{
+}
+
+
+void
+DatabaseScheduler::enqueue( const Tomahawk::dbcmd_ptr& cmd )
+{
+    QMutexLocker lock( &m_mutex );
+
+    const int priority = qBound( 0, (int)cmd->priority(), PriorityCount - 1 );
+
+    Job job;
+    job.cmd = cmd;
+    job.enqueuedAt = m_clock.elapsed();
+    m_queues[ priority ].enqueue( job );
+
+    Statistics& stats = m_statistics[ priority ];
+    stats.queued = m_queues[ priority ].count();
+    stats.maxQueued = qMax( stats.maxQueued, stats.queued );
+
+    wakeWorker();
+}
+
+
+Tomahawk::dbcmd_ptr
+DatabaseScheduler::takeNext( DatabaseWorker* worker )
+{
+    QMutexLocker lock( &m_mutex );
+
+    const qint64 now = m_clock.elapsed();
+
+    int priority = -1;
+    qint64 oldest = now;
+    for ( int i = 0; i < PriorityCount; i++ )
+    {
+        if ( m_queues[ i ].isEmpty() )
+            continue;
+
+        // Strict priority order, unless some lower class has been starving
+        const qint64 enqueuedAt = m_queues[ i ].head().enqueuedAt;
+        if ( priority < 0 )
+        {
+            priority = i;
+            oldest = enqueuedAt;
+        }
+        else if ( now - enqueuedAt > MAX_WAIT_MS && enqueuedAt < oldest )
+        {
+            priority = i;
+            oldest = enqueuedAt;
+        }
+    }
+
+    if ( priority < 0 )
+    {
+        if ( !m_idleWorkers.contains( worker ) )
+            m_idleWorkers << worker;
+
+        return Tomahawk::dbcmd_ptr();
+    }
+
+    const Job job = m_queues[ priority ].dequeue();
+    const qint64 waited = now - job.enqueuedAt;
+
+    Statistics& stats = m_statistics[ priority ];
+    stats.queued = m_queues[ priority ].count();
+    stats.dispatched++;
+    stats.totalWaitMs += waited;
+    stats.maxWaitMs = qMax( stats.maxWaitMs, waited );
+
+    if ( waited > MAX_WAIT_MS )
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Command waited" << waited << "ms before running:" << job.cmd->commandname();
+
+    return job.cmd;
+}
+
+
+void
+DatabaseScheduler::addWorker( DatabaseWorker* worker )
+{
+    QMutexLocker lock( &m_mutex );
+
+    m_idleWorkers << worker;
+
+    for ( int i = 0; i < PriorityCount; i++ )
+    {
+        if ( !m_queues[ i ].isEmpty() )
+        {
+            wakeWorker();
+            break;
+        }
+    }
+}
+
+
+void
+DatabaseScheduler::removeWorker( DatabaseWorker* worker )
+{
+    QMutexLocker lock( &m_mutex );
+
+    m_idleWorkers.removeAll( worker );
+}
+
+
+DatabaseScheduler::Statistics
+DatabaseScheduler::statistics( DatabaseCommand::Priority priority ) const
+{
+    QMutexLocker lock( &m_mutex );
+
+    return m_statistics[ qBound( 0, (int)priority, PriorityCount - 1 ) ];
+}
+
+
+int
+DatabaseScheduler::idleWorkers() const
+{
+    QMutexLocker lock( &m_mutex );
+
+    return m_idleWorkers.count();
+}
+
+
+void
+DatabaseScheduler::wakeWorker()
+{
+    // m_mutex is held by the caller
+    while ( !m_idleWorkers.isEmpty() )
+    {
+        QPointer< DatabaseWorker > worker = m_idleWorkers.takeFirst();
+        if ( worker.isNull() )
+            continue;
+
+        QMetaObject::invokeMethod( worker.data(), "doWork", Qt::QueuedConnection );
+        return;
+    }
+}
+
+}
@@ -0,0 +1,100 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2011, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASESCHEDULER_H
+#define DATABASESCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QPointer>
+#include <QQueue>
+
+#include "DatabaseCommand.h"
+#include "DllMacro.h"
+
+namespace Tomahawk
+{
+
+class DatabaseWorker;
+
+/**
+ * Shared run queue for all read-only DatabaseWorkers.
+ *
+ * Commands are not bound to a worker when they are enqueued. Instead every
+ * read worker pulls the next command from here as soon as it is done with
+ * its current one, so a long running command can never hold up commands
+ * queued behind it while other workers are idle. Queued commands are handed
+ * out by DatabaseCommand::priority(), commands that waited for longer than
+ * a few seconds are served first so background work can not starve.
+ */
+class DLLEXPORT DatabaseScheduler
+{
+public:
+    struct Statistics
+    {
+        Statistics() : queued( 0 ), maxQueued( 0 ), dispatched( 0 ), totalWaitMs( 0 ), maxWaitMs( 0 ) {}
+
+        int queued;
+        int maxQueued;
+        quint64 dispatched;
+        quint64 totalWaitMs;
+        qint64 maxWaitMs;
+
+        qint64 averageWaitMs() const { return dispatched ? totalWaitMs / dispatched : 0; }
+    };
+
+    DatabaseScheduler();
+    ~DatabaseScheduler();
+
+    void enqueue( const Tomahawk::dbcmd_ptr& cmd );
+
+    /**
+     * Returns the next command for @p worker. If there is none, the worker is
+     * put to sleep and will get its doWork() slot invoked once a new command
+     * has been enqueued.
+     */
+    Tomahawk::dbcmd_ptr takeNext( DatabaseWorker* worker );
+
+    void addWorker( DatabaseWorker* worker );
+    void removeWorker( DatabaseWorker* worker );
+
+    Statistics statistics( DatabaseCommand::Priority priority ) const;
+    int idleWorkers() const;
+
+private:
+    struct Job
+    {
+        Tomahawk::dbcmd_ptr cmd;
+        qint64 enqueuedAt;
+    };
+
+    static const int PriorityCount = DatabaseCommand::BackgroundPriority + 1;
+
+    void wakeWorker();
+
+    mutable QMutex m_mutex;
+    QElapsedTimer m_clock;
+    QQueue< Job > m_queues[ PriorityCount ];
+    Statistics m_statistics[ PriorityCount ];
+    QList< QPointer< DatabaseWorker > > m_idleWorkers;
+};
+
+}
+
+#endif // DATABASESCHEDULER_H
@@ -25,6 +25,7 @@
 #include "Database.h"
 #include "DatabaseImpl.h"
 #include "DatabaseCommandLoggable.h"
+#include "DatabaseScheduler.h"
 #include "PlaylistEntry.h"
 #include "Source.h"
 #include "TomahawkSqlQuery.h"
@@ -37,13 +38,16 @@
     //#define DEBUG_TIMING TRUE
 #endif
 
+#define IDLE_MAINTENANCE_DELAY 5000
+
 
 namespace Tomahawk
 {
 
-DatabaseWorkerThread::DatabaseWorkerThread( Database* db, bool mutates )
+DatabaseWorkerThread::DatabaseWorkerThread( Database* db, bool mutates, DatabaseScheduler* scheduler )
     : QThread()
     , m_db( db )
+    , m_scheduler( scheduler )
     , m_mutates( mutates )
 {
     m_startupMutex.lock();
@@ -54,7 +58,7 @@ void
 DatabaseWorkerThread::run()
 {
     tDebug() << Q_FUNC_INFO << "DatabaseWorkerThread starting...";
-    m_worker = QPointer< DatabaseWorker >( new DatabaseWorker( m_db, m_mutates ) );
+    m_worker = QPointer< DatabaseWorker >( new DatabaseWorker( m_db, m_mutates, m_scheduler ) );
     m_startupMutex.unlock();
     exec();
     tDebug() << Q_FUNC_INFO << "DatabaseWorkerThread finishing...";
@@ -84,13 +88,24 @@ DatabaseWorkerThread::waitForEventLoopStart()
 }
 
 
-DatabaseWorker::DatabaseWorker( Database* db, bool mutates )
+DatabaseWorker::DatabaseWorker( Database* db, bool mutates, DatabaseScheduler* scheduler )
     : QObject()
     , m_db( db )
+    , m_scheduler( scheduler )
+    , m_mutates( mutates )
     , m_outstanding( 0 )
 {
-    Q_UNUSED( mutates );
     tDebug() << Q_FUNC_INFO << "New db connection with name:" << Database::instance()->impl()->database().connectionName() << "on thread" << this->thread();
+
+    if ( m_scheduler )
+        m_scheduler->addWorker( this );
+
+    if ( m_mutates )
+    {
+        m_idleTimer.setSingleShot( true );
+        m_idleTimer.setInterval( IDLE_MAINTENANCE_DELAY );
+        connect( &m_idleTimer, SIGNAL( timeout() ), SLOT( runIdleMaintenance() ) );
+    }
 }
 
 
@@ -98,6 +113,9 @@ DatabaseWorker::~DatabaseWorker()
 {
     tDebug() << Q_FUNC_INFO << m_outstanding;
 
+    if ( m_scheduler )
+        m_scheduler->removeWorker( this );
+
     if ( m_outstanding )
     {
         foreach ( const Tomahawk::dbcmd_ptr& cmd, m_commands )
@@ -109,12 +127,18 @@ DatabaseWorker::~DatabaseWorker()
 
 
 void
-DatabaseWorker::enqueue( const QList< Tomahawk::dbcmd_ptr >& cmds )
+DatabaseWorker::enqueue( const QList< Tomahawk::dbcmd_ptr >& cmds, bool singleTransaction )
 {
     QMutexLocker lock( &m_mut );
     m_outstanding += cmds.count();
     m_commands << cmds;
 
+    if ( singleTransaction )
+    {
+        for ( int i = 1; i < cmds.count(); ++i )
+            m_transactionContinuations << cmds.at( i ).data();
+    }
+
     if ( m_outstanding == cmds.count() )
         QTimer::singleShot( 0, this, SLOT( doWork() ) );
 }
@@ -150,13 +174,24 @@ DatabaseWorker::doWork()
 
     QList< Tomahawk::dbcmd_ptr > cmdGroup;
     Tomahawk::dbcmd_ptr cmd;
+    if ( m_scheduler )
+    {
+        // Returns nothing (and remembers us as idle) when there's no work left
+        cmd = m_scheduler->takeNext( this );
+        if ( !cmd )
+            return;
+    }
+    else
     {
         QMutexLocker lock( &m_mut );
         cmd = m_commands.takeFirst();
     }
 
     DatabaseImpl* impl = Database::instance()->impl();
-    if ( cmd->doesMutates() )
+
+    // with a write-ahead log, reading in a transaction gets the whole command one snapshot and never waits for the writer
+    const bool transaction = cmd->doesMutates() || impl->writeAheadLog();
+    if ( transaction )
     {
         bool transok = impl->database().transaction();
         Q_ASSERT( transok );
@@ -194,8 +229,7 @@ DatabaseWorker::doWork()
                         //
                         if ( !cmd->singletonCmd() )
                         {
-                            TomahawkSqlQuery query = impl->newquery();
-                            query.prepare( "UPDATE source SET lastop = ? WHERE id = ?" );
+                            TomahawkSqlQuery query = impl->preparedQuery( "UPDATE source SET lastop = ? WHERE id = ?" );
                             query.addBindValue( cmd->guid() );
                             query.addBindValue( cmd->source()->id() );
 
@@ -208,10 +242,11 @@ DatabaseWorker::doWork()
                 }
 
                 cmdGroup << cmd;
-                if ( cmd->groupable() && !m_commands.isEmpty() )
                 {
                     QMutexLocker lock( &m_mut );
-                    if ( m_commands.first()->groupable() )
+                    if ( !m_commands.isEmpty() &&
+                         ( m_transactionContinuations.remove( m_commands.first().data() ) ||
+                           ( cmd->groupable() && m_commands.first()->groupable() ) ) )
                     {
                         cmd = m_commands.takeFirst();
                     }
@@ -220,13 +255,16 @@ DatabaseWorker::doWork()
                         finished = true;
                     }
                 }
-                else
-                    finished = true;
             }
 
-            if ( cmd->doesMutates() )
+            // cached statements that weren't read to the end would keep holding a read lock
+            impl->finishPreparedQueries();
+
+            if ( transaction )
             {
-                qDebug() << "Committing" << cmd->commandname() << cmd->guid();
+                if ( cmd->doesMutates() )
+                    qDebug() << "Committing" << cmd->commandname() << cmd->guid();
+
                 if ( !impl->newquery().commitTransaction() )
                 {
                     tDebug() << "FAILED TO COMMIT TRANSACTION*";
@@ -257,7 +295,8 @@ DatabaseWorker::doWork()
                  << impl->database().lastError().driverText()
                  << endl;
 
-        if ( cmd->doesMutates() )
+        impl->finishPreparedQueries();
+        if ( transaction )
             impl->database().rollback();
 
         Q_ASSERT( false );
@@ -265,7 +304,8 @@ DatabaseWorker::doWork()
     catch (...)
     {
         qDebug() << "Uncaught exception processing dbcmd";
-        if ( cmd->doesMutates() )
+        impl->finishPreparedQueries();
+        if ( transaction )
             impl->database().rollback();
 
         Q_ASSERT( false );
@@ -275,10 +315,33 @@ DatabaseWorker::doWork()
     foreach ( Tomahawk::dbcmd_ptr c, cmdGroup )
         c->emitFinished();
 
+    if ( m_scheduler )
+    {
+        QTimer::singleShot( 0, this, SLOT( doWork() ) );
+        return;
+    }
+
     QMutexLocker lock( &m_mut );
     m_outstanding -= completed;
     if ( m_outstanding > 0 )
         QTimer::singleShot( 0, this, SLOT( doWork() ) );
+    else if ( m_mutates )
+        m_idleTimer.start();
+}
+
+
+void
+DatabaseWorker::runIdleMaintenance()
+{
+    {
+        QMutexLocker lock( &m_mut );
+
+        // we'll be back once the new work is done
+        if ( m_outstanding > 0 )
+            return;
+    }
+
+    Database::instance()->impl()->runIdleMaintenance();
 }
 
 
@@ -286,10 +349,10 @@ DatabaseWorker::doWork()
 void
 DatabaseWorker::logOp( DatabaseCommandLoggable* command )
 {
-    TomahawkSqlQuery oplogquery = Database::instance()->impl()->newquery();
+    DatabaseImpl* impl = Database::instance()->impl();
     tLog( LOGVERBOSE ) << "INSERTING INTO OPLOG:" << command->source()->id() << command->guid() << command->commandname();
-    oplogquery.prepare( "INSERT INTO oplog(source, guid, command, singleton, compressed, json) "
-                        "VALUES(?, ?, ?, ?, ?, ?)" );
+    TomahawkSqlQuery oplogquery = impl->preparedQuery( "INSERT INTO oplog(source, guid, command, singleton, compressed, json) "
+                                                       "VALUES(?, ?, ?, ?, ?, ?)" );
 
     QVariantMap variant = TomahawkUtils::qobject2qvariant( command );
     QByteArray ba = TomahawkUtils::toJson( variant );
@@ -308,14 +371,15 @@ DatabaseWorker::logOp( DatabaseCommandLoggable* command )
     {
         tLog( LOGVERBOSE ) << "Singleton command, deleting previous oplog commands";
 
-        TomahawkSqlQuery oplogdelquery = Database::instance()->impl()->newquery();
-        oplogdelquery.prepare( QString( "DELETE FROM oplog WHERE "
-                                        "source %1 "
-                                        "AND (singleton = 'true' or singleton = 1) "
-                                        "AND command = ?" )
-                                  .arg( command->source()->isLocal() ? "IS NULL" : QString( "= %1" ).arg( command->source()->id() ) ) );
+        TomahawkSqlQuery oplogdelquery = impl->preparedQuery( QString( "DELETE FROM oplog WHERE "
+                                                                       "source %1 "
+                                                                       "AND (singleton = 'true' or singleton = 1) "
+                                                                       "AND command = ?" )
+                                                                 .arg( command->source()->isLocal() ? "IS NULL" : "= ?" ) );
 
-        oplogdelquery.bindValue( 0, command->commandname() );
+        if ( !command->source()->isLocal() )
+            oplogdelquery.addBindValue( command->source()->id() );
+        oplogdelquery.addBindValue( command->commandname() );
         oplogdelquery.exec();
     }
 
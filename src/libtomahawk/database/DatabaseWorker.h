@@ -24,6 +24,8 @@
 #include <QMutex>
 #include <QList>
 #include <QPointer>
+#include <QSet>
+#include <QTimer>
 
 #include "DatabaseCommand.h"
 
@@ -32,13 +34,18 @@ namespace Tomahawk
 
 class Database;
 class DatabaseCommandLoggable;
+class DatabaseScheduler;
 
 class DatabaseWorker : public QObject
 {
 Q_OBJECT
 
 public:
-    DatabaseWorker( Database* db, bool mutates );
+    /**
+     * Creates a worker. If @p scheduler is given, the worker pulls its commands
+     * from that shared scheduler instead of its own queue.
+     */
+    DatabaseWorker( Database* db, bool mutates, DatabaseScheduler* scheduler = nullptr );
     ~DatabaseWorker();
 
     bool busy() const { return m_outstanding > 0; }
@@ -46,17 +53,24 @@ public:
 
 public slots:
     void enqueue( const Tomahawk::dbcmd_ptr& );
-    void enqueue( const QList< Tomahawk::dbcmd_ptr >& );
+    void enqueue( const QList< Tomahawk::dbcmd_ptr >&, bool singleTransaction = false );
 
 private slots:
     void doWork();
+    void runIdleMaintenance();
 
 private:
     void logOp( DatabaseCommandLoggable* command );
 
     QMutex m_mut;
     Database* m_db;
+    DatabaseScheduler* m_scheduler;
+    bool m_mutates;
+    // checkpoints and vacuums once the writer had nothing to do for a while
+    QTimer m_idleTimer;
     QList< Tomahawk::dbcmd_ptr > m_commands;
+    // commands that have to run in the same transaction as their predecessor
+    QSet< Tomahawk::DatabaseCommand* > m_transactionContinuations;
     int m_outstanding;
 };
 
@@ -65,7 +79,7 @@ class DatabaseWorkerThread : public QThread
 Q_OBJECT
 
 public:
-    DatabaseWorkerThread( Database* db, bool mutates );
+    DatabaseWorkerThread( Database* db, bool mutates, DatabaseScheduler* scheduler = nullptr );
     ~DatabaseWorkerThread();
 
     QPointer< DatabaseWorker > worker() const;
@@ -83,6 +97,7 @@ protected:
 private:
     QPointer< DatabaseWorker > m_worker;
     Database* m_db;
+    DatabaseScheduler* m_scheduler;
     bool m_mutates;
 
     /**
@@ -229,5 +229,8 @@ IdThreadWorker::run()
         }
 
         s_mutex.unlock();
+
+        // don't hold on to a read lock or snapshot while waiting for more work
+        m_impl->finishPreparedQueries();
     }
 }
@@ -26,6 +26,8 @@
 #include "Source.h"
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMutex>
 #include <QSqlError>
 #include <QTime>
 #include <QThread>
@@ -33,6 +35,21 @@
 
 #define QUERY_THRESHOLD 60
 
+static QMutex s_lockStatisticsMutex;
+static TomahawkSqlQuery::LockStatistics s_lockStatistics;
+
+
+static void
+recordLockWait( unsigned int busyRetries, qint64 ms )
+{
+    QMutexLocker lock( &s_lockStatisticsMutex );
+
+    s_lockStatistics.waits++;
+    s_lockStatistics.busyRetries += busyRetries;
+    s_lockStatistics.totalWaitMs += ms;
+    s_lockStatistics.maxWaitMs = qMax( s_lockStatistics.maxWaitMs, ms );
+}
+
 
 TomahawkSqlQuery::TomahawkSqlQuery()
     : QSqlQuery()
@@ -86,6 +103,8 @@ TomahawkSqlQuery::exec()
     t.start();
 
     unsigned int retries = 0;
+    unsigned int busyRetries = 0;
+    QElapsedTimer lockWait;
     while ( !QSqlQuery::exec() && ++retries < 10 )
     {
         if ( lastError().text() == QCoreApplication::translate( "QSQLiteResult", "No query" ) ||
@@ -104,12 +123,19 @@ TomahawkSqlQuery::exec()
         }
 
         if ( isBusyError( lastError() ) )
+        {
+            if ( !busyRetries++ )
+                lockWait.start();
             retries = 0;
+        }
 
         tDebug() << "INFO: Retrying failed query:" << lastQuery() << lastError().text();
         TomahawkUtils::msleep( 10 );
     }
 
+    if ( busyRetries )
+        recordLockWait( busyRetries, lockWait.elapsed() );
+
     bool ret = ( retries < 10 );
     if ( !ret )
         showError();
@@ -133,19 +159,37 @@ TomahawkSqlQuery::commitTransaction()
         tLog( LOGSQL ) << "TomahawkSqlQuery::commitTransaction running in thread" << QThread::currentThread();
 
     unsigned int retries = 0;
+    unsigned int busyRetries = 0;
+    QElapsedTimer lockWait;
     while ( !m_db.commit() && ++retries < 10 )
     {
-        if ( isBusyError( lastError() ) )
+        // the failed commit's error is the connection's, not ours
+        if ( isBusyError( m_db.lastError() ) )
+        {
+            if ( !busyRetries++ )
+                lockWait.start();
             retries = 0;
+        }
 
-        tDebug() << "INFO: Retrying failed commit:" << retries << lastError().text();
+        tDebug() << "INFO: Retrying failed commit:" << retries << m_db.lastError().text();
         TomahawkUtils::msleep( 10 );
     }
 
+    if ( busyRetries )
+        recordLockWait( busyRetries, lockWait.elapsed() );
+
     return ( retries < 10 );
 }
 
 
+TomahawkSqlQuery::LockStatistics
+TomahawkSqlQuery::lockStatistics()
+{
+    QMutexLocker lock( &s_lockStatisticsMutex );
+    return s_lockStatistics;
+}
+
+
 void
 TomahawkSqlQuery::showError()
 {
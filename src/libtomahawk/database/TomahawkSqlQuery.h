@@ -32,6 +32,19 @@ class DLLEXPORT TomahawkSqlQuery : public QSqlQuery
 {
 
 public:
+    /// How often and how long queries had to wait for another connection's lock, over all connections
+    struct LockStatistics
+    {
+        LockStatistics() : waits( 0 ), busyRetries( 0 ), totalWaitMs( 0 ), maxWaitMs( 0 ) {}
+
+        quint64 waits;
+        quint64 busyRetries;
+        quint64 totalWaitMs;
+        qint64 maxWaitMs;
+
+        qint64 averageWaitMs() const { return waits ? totalWaitMs / waits : 0; }
+    };
+
     TomahawkSqlQuery();
     TomahawkSqlQuery( const QSqlDatabase& db );
 
@@ -43,6 +56,9 @@ public:
 
     bool commitTransaction();
 
+    /// Can be called from any thread
+    static LockStatistics lockStatistics();
+
 private:
     bool isBusyError( const QSqlError& error ) const;
 
@@ -20,18 +20,37 @@
 
 #include "database/DatabaseImpl.h"
 #include "database/Database.h"
+#include "utils/Logger.h"
 #include "utils/TomahawkUtils.h"
+#include "TomahawkSettings.h"
 
 #include <QDir>
+#include <QTimer>
 
 
 namespace Tomahawk {
 
 static QString s_indexPathName = "tomahawk.lucene";
 
+static FuzzyIndex::Backend
+configuredBackend()
+{
+    // tools open the database without any settings
+    if ( TomahawkSettings::instance() && TomahawkSettings::instance()->fuzzyIndexBackend() == "trigram" )
+        return FuzzyIndex::TrigramBackend;
+
+    return FuzzyIndex::LuceneBackend;
+}
+
+
 DatabaseFuzzyIndex::DatabaseFuzzyIndex( QObject* parent, bool wipe )
-    : FuzzyIndex( parent, s_indexPathName, wipe )
+    : FuzzyIndex( parent, s_indexPathName, wipe, configuredBackend() )
 {
+    if ( !supportsUpdates() )
+    {
+        tLog() << "Fuzzy index can't be updated incrementally, rebuilding it";
+        QTimer::singleShot( 0, this, SLOT( updateIndexSlot() ) );
+    }
 }
 
 
@@ -19,6 +19,7 @@
 #include "FuzzyIndex.h"
 
 #include "utils/Logger.h"
+#include "TrigramIndex.h"
 
 #include "database/DatabaseImpl.h"
 #include "PlaylistEntry.h"
@@ -26,20 +27,47 @@
 #include "Track.h"
 
 #include <QDir>
+#include <QFile>
 #include <QTime>
 #include <QTimer>
 
+#include <lucene++/ConcurrentMergeScheduler.h>
 #include <lucene++/FuzzyQuery.h>
 
+#define MERGE_FACTOR 10
+#define TRIGRAM_FILE "trigrams"
+
 using namespace Lucene;
 
 
-FuzzyIndex::FuzzyIndex( QObject* parent, const QString& filename, bool wipe )
+FuzzyIndex::FuzzyIndex( QObject* parent, const QString& filename, bool wipe, Backend backend )
     : QObject( parent )
+    , m_backend( backend )
+    , m_supportsUpdates( true )
 {
     m_lucenePath = TomahawkUtils::appDataDir().absoluteFilePath( filename );
+    const QString trigramPath = QDir( m_lucenePath ).filePath( TRIGRAM_FILE );
+
+    if ( m_backend == TrigramBackend )
+    {
+        // whatever Lucene left in here is outdated once we stop updating it
+        if ( !QFile::exists( trigramPath ) )
+            TomahawkUtils::removeDirectory( m_lucenePath );
+        QDir().mkpath( m_lucenePath );
+
+        tDebug() << "Opening trigram index:" << trigramPath;
+        m_trigrams.reset( new Tomahawk::TrigramIndex( trigramPath ) );
+
+        // nothing to update before it has been built once
+        m_supportsUpdates = m_trigrams->load();
+
+        if ( wipe )
+            wipeIndex();
+        return;
+    }
 
-    bool failed = false;
+    // and the other way around
+    bool failed = QFile::exists( trigramPath );
     tDebug() << "Opening Lucene directory:" << m_lucenePath;
     try
     {
@@ -47,6 +75,12 @@ FuzzyIndex::FuzzyIndex( QObject* parent, const QString& filename, bool wipe )
         m_luceneDir = FSDirectory::open( m_lucenePath.toStdWString() );
         m_luceneReader = IndexReader::open( m_luceneDir );
         m_luceneSearcher = newLucene<IndexSearcher>( m_luceneReader );
+
+        if ( m_luceneReader->numDocs() > 0 )
+        {
+            HashSet< String > fields = m_luceneReader->getFieldNames( IndexReader::FIELD_OPTION_INDEXED );
+            m_supportsUpdates = fields.contains( L"trackid" ) || fields.contains( L"albumid" );
+        }
     }
     catch ( LuceneException& error )
     {
@@ -68,6 +102,9 @@ FuzzyIndex::FuzzyIndex( QObject* parent, const QString& filename, bool wipe )
 FuzzyIndex::~FuzzyIndex()
 {
     tLog( LOGVERBOSE ) << Q_FUNC_INFO;
+
+    QMutexLocker lock( &m_mutex );
+    closeWriter();
 }
 
 
@@ -97,10 +134,22 @@ FuzzyIndex::beginIndexing()
     emit indexStarted();
     m_mutex.lock();
 
+    if ( m_trigrams )
+    {
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Starting indexing:" << m_lucenePath;
+        m_trigrams->beginBuild();
+        m_supportsUpdates = true;
+        return;
+    }
+
+    // an incremental writer might still hold the lock on the index
+    closeWriter();
+
     try
     {
         tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Starting indexing:" << m_lucenePath;
         m_luceneWriter = newLucene<IndexWriter>( m_luceneDir, m_analyzer, true, IndexWriter::MaxFieldLengthLIMITED );
+        m_supportsUpdates = true;
     }
     catch( LuceneException& error )
     {
@@ -114,75 +163,308 @@ void
 FuzzyIndex::endIndexing()
 {
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Finishing indexing:" << m_lucenePath;
-    m_luceneWriter->optimize();
-    m_luceneWriter->close();
-    m_luceneWriter.reset();
+    if ( m_trigrams )
+    {
+        m_supportsUpdates = m_trigrams->endBuild();
 
-    m_luceneReader = IndexReader::open( m_luceneDir );
-    m_luceneSearcher = newLucene<IndexSearcher>( m_luceneReader );
+        m_mutex.unlock();
+        emit indexReady();
+        return;
+    }
+
+    try
+    {
+        m_luceneWriter->optimize();
+        m_luceneWriter->close();
+        m_luceneWriter.reset();
+
+        setReader( IndexReader::open( m_luceneDir ) );
+    }
+    catch( LuceneException& error )
+    {
+        tDebug() << "Caught Lucene error:" << QString::fromWCharArray( error.getError().c_str() );
+        m_luceneWriter.reset();
+    }
 
     m_mutex.unlock();
     emit indexReady();
 }
 
 
+DocumentPtr
+FuzzyIndex::document( const Tomahawk::IndexData& data )
+{
+    DocumentPtr doc = newLucene<Document>();
+
+    // ids are indexed, so updateFields() and deleteFields() can find the entries again
+    if ( !data.track.isEmpty() )
+    {
+        doc->add(newLucene<Field>( L"fulltext", Tomahawk::DatabaseImpl::sortname( QString( "%1 %2" ).arg( data.artist ).arg( data.track ) ).toStdWString(),
+                                   Field::STORE_NO, Field::INDEX_NOT_ANALYZED_NO_NORMS ) );
+
+        doc->add(newLucene<Field>( L"track", Tomahawk::DatabaseImpl::sortname( data.track ).toStdWString(),
+                                   Field::STORE_NO, Field::INDEX_NOT_ANALYZED_NO_NORMS ) );
+
+        doc->add(newLucene<Field>( L"artist", Tomahawk::DatabaseImpl::sortname( data.artist ).toStdWString(),
+                                   Field::STORE_NO, Field::INDEX_NOT_ANALYZED_NO_NORMS ) );
+
+        doc->add(newLucene<Field>( L"artistid", QString::number( data.artistId ).toStdWString(),
+                                   Field::STORE_YES, Field::INDEX_NO ) );
+
+        doc->add(newLucene<Field>( L"trackid", QString::number( data.id ).toStdWString(),
+                                   Field::STORE_YES, Field::INDEX_NOT_ANALYZED_NO_NORMS ) );
+    }
+    else if ( !data.album.isEmpty() )
+    {
+        doc->add(newLucene<Field>( L"album", Tomahawk::DatabaseImpl::sortname( data.album ).toStdWString(),
+                                   Field::STORE_NO, Field::INDEX_NOT_ANALYZED_NO_NORMS ) );
+
+        doc->add(newLucene<Field>( L"albumid", QString::number( data.id ).toStdWString(),
+                                   Field::STORE_YES, Field::INDEX_NOT_ANALYZED_NO_NORMS ) );
+    }
+    else
+        return DocumentPtr();
+
+    return doc;
+}
+
+
+Tomahawk::IndexData
+FuzzyIndex::normalized( const Tomahawk::IndexData& data )
+{
+    // the trigram index takes names the way Lucene gets them in document()
+    Tomahawk::IndexData result = data;
+    result.artist = Tomahawk::DatabaseImpl::sortname( data.artist );
+    result.album = Tomahawk::DatabaseImpl::sortname( data.album );
+    result.track = Tomahawk::DatabaseImpl::sortname( data.track );
+
+    return result;
+}
+
+
 void
 FuzzyIndex::appendFields( const Tomahawk::IndexData& data )
 {
+    if ( m_trigrams )
+    {
+        m_trigrams->add( normalized( data ) );
+        return;
+    }
+
     try
     {
-        DocumentPtr doc = newLucene<Document>();
+        DocumentPtr doc = document( data );
+        if ( !doc )
+            return;
 
-        if ( !data.track.isEmpty() )
-        {
-            doc->add(newLucene<Field>( L"fulltext", Tomahawk::DatabaseImpl::sortname( QString( "%1 %2" ).arg( data.artist ).arg( data.track ) ).toStdWString(),
-                                       Field::STORE_NO, Field::INDEX_NOT_ANALYZED_NO_NORMS ) );
+        m_luceneWriter->addDocument( doc );
+    }
+    catch( LuceneException& error )
+    {
+        tDebug() << "Caught Lucene error:" << QString::fromWCharArray( error.getError().c_str() );
 
-            doc->add(newLucene<Field>( L"track", Tomahawk::DatabaseImpl::sortname( data.track ).toStdWString(),
-                                       Field::STORE_NO, Field::INDEX_NOT_ANALYZED_NO_NORMS ) );
+        QTimer::singleShot( 0, this, SLOT( wipeIndex() ) );
+    }
+}
 
-            doc->add(newLucene<Field>( L"artist", Tomahawk::DatabaseImpl::sortname( data.artist ).toStdWString(),
-                                       Field::STORE_NO, Field::INDEX_NOT_ANALYZED_NO_NORMS ) );
 
-            doc->add(newLucene<Field>( L"artistid", QString::number( data.artistId ).toStdWString(),
-                                       Field::STORE_YES, Field::INDEX_NO ) );
+bool
+FuzzyIndex::openWriter()
+{
+    // m_mutex must be held
+    if ( m_luceneWriter )
+        return true;
 
-            doc->add(newLucene<Field>( L"trackid", QString::number( data.id ).toStdWString(),
-                                       Field::STORE_YES, Field::INDEX_NO ) );
+    try
+    {
+        // stays open between updates, so segments get merged in the background instead of optimizing the whole index every time
+        m_luceneWriter = newLucene<IndexWriter>( m_luceneDir, m_analyzer, IndexWriter::MaxFieldLengthLIMITED );
+        m_luceneWriter->setMergeScheduler( newLucene<ConcurrentMergeScheduler>() );
+        m_luceneWriter->setMergeFactor( MERGE_FACTOR );
+    }
+    catch( LuceneException& error )
+    {
+        tDebug() << "Caught Lucene error:" << QString::fromWCharArray( error.getError().c_str() );
+        m_luceneWriter.reset();
+    }
+
+    return m_luceneWriter.get() != 0;
+}
+
+
+void
+FuzzyIndex::commitWriter()
+{
+    // m_mutex must be held
+    try
+    {
+        m_luceneWriter->commit();
+
+        if ( m_luceneReader )
+            setReader( m_luceneReader->reopen() );
+        else
+            setReader( IndexReader::open( m_luceneDir ) );
+    }
+    catch( LuceneException& error )
+    {
+        tDebug() << "Caught Lucene error:" << QString::fromWCharArray( error.getError().c_str() );
+    }
+}
+
+
+void
+FuzzyIndex::closeWriter()
+{
+    // m_mutex must be held
+    if ( !m_luceneWriter )
+        return;
+
+    try
+    {
+        m_luceneWriter->close();
+    }
+    catch( LuceneException& error )
+    {
+        tDebug() << "Caught Lucene error:" << QString::fromWCharArray( error.getError().c_str() );
+    }
+
+    m_luceneWriter.reset();
+}
+
+
+void
+FuzzyIndex::setReader( const IndexReaderPtr& reader )
+{
+    if ( reader == m_luceneReader )
+        return;
+
+    QMutexLocker lock( &m_searcherMutex );
+
+    // searches might still be running on the current reader, only close the one before it
+    if ( m_retiredReader )
+    {
+        try
+        {
+            m_retiredReader->close();
         }
-        else if ( !data.album.isEmpty() )
+        catch( LuceneException& error )
         {
-            doc->add(newLucene<Field>( L"album", Tomahawk::DatabaseImpl::sortname( data.album ).toStdWString(),
-                                       Field::STORE_NO, Field::INDEX_NOT_ANALYZED_NO_NORMS ) );
-
-            doc->add(newLucene<Field>( L"albumid", QString::number( data.id ).toStdWString(),
-                                       Field::STORE_YES, Field::INDEX_NO ) );
+            tDebug() << "Caught Lucene error:" << QString::fromWCharArray( error.getError().c_str() );
         }
-        else
-            return;
+    }
 
-        m_luceneWriter->addDocument( doc );
+    m_retiredReader = m_luceneReader;
+    m_luceneReader = reader;
+    m_luceneSearcher = newLucene<IndexSearcher>( m_luceneReader );
+}
+
+
+IndexSearcherPtr
+FuzzyIndex::searcher()
+{
+    QMutexLocker lock( &m_searcherMutex );
+    return m_luceneSearcher;
+}
+
+
+void
+FuzzyIndex::updateFields( const QList< Tomahawk::IndexData >& data )
+{
+    if ( data.isEmpty() )
+        return;
+
+    QMutexLocker lock( &m_mutex );
+    if ( m_trigrams )
+    {
+        QList< Tomahawk::IndexData > entries;
+        foreach ( const Tomahawk::IndexData& entry, data )
+            entries << normalized( entry );
+
+        m_trigrams->update( entries );
+        return;
+    }
+
+    if ( !openWriter() )
+        return;
+
+    try
+    {
+        foreach ( const Tomahawk::IndexData& entry, data )
+        {
+            DocumentPtr doc = document( entry );
+            if ( !doc )
+                continue;
+
+            const String field = entry.track.isEmpty() ? L"albumid" : L"trackid";
+            m_luceneWriter->updateDocument( newLucene<Term>( field, QString::number( entry.id ).toStdWString() ), doc );
+        }
     }
     catch( LuceneException& error )
     {
         tDebug() << "Caught Lucene error:" << QString::fromWCharArray( error.getError().c_str() );
+    }
 
-        QTimer::singleShot( 0, this, SLOT( wipeIndex() ) );
+    commitWriter();
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Updated" << data.count() << "entries in" << m_lucenePath;
+}
+
+
+void
+FuzzyIndex::deleteFields( const QList< unsigned int >& trackIds, const QList< unsigned int >& albumIds )
+{
+    if ( trackIds.isEmpty() && albumIds.isEmpty() )
+        return;
+
+    QMutexLocker lock( &m_mutex );
+    if ( m_trigrams )
+    {
+        m_trigrams->remove( trackIds, albumIds );
+        return;
+    }
+
+    if ( !openWriter() )
+        return;
+
+    try
+    {
+        foreach ( unsigned int id, trackIds )
+            m_luceneWriter->deleteDocuments( newLucene<Term>( L"trackid", QString::number( id ).toStdWString() ) );
+        foreach ( unsigned int id, albumIds )
+            m_luceneWriter->deleteDocuments( newLucene<Term>( L"albumid", QString::number( id ).toStdWString() ) );
     }
+    catch( LuceneException& error )
+    {
+        tDebug() << "Caught Lucene error:" << QString::fromWCharArray( error.getError().c_str() );
+    }
+
+    commitWriter();
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Removed" << trackIds.count() << "tracks and" << albumIds.count() << "albums from" << m_lucenePath;
 }
 
 
 void
 FuzzyIndex::deleteIndex()
 {
+    {
+        QMutexLocker lock( &m_mutex );
+        closeWriter();
+
+        if ( m_trigrams )
+            m_trigrams->deleteIndex();
+    }
+
     if ( m_luceneReader )
     {
         tDebug( LOGVERBOSE ) << "Deleting old lucene stuff.";
 
+        QMutexLocker lock( &m_searcherMutex );
         m_luceneSearcher->close();
         m_luceneReader->close();
         m_luceneSearcher.reset();
         m_luceneReader.reset();
+        if ( m_retiredReader )
+            m_retiredReader->close();
+        m_retiredReader.reset();
     }
 
     TomahawkUtils::removeDirectory( m_lucenePath );
@@ -208,7 +490,17 @@ FuzzyIndex::search( const Tomahawk::query_ptr& query )
 {
 //    QMutexLocker lock( &m_mutex );
     QMap< int, float > resultsmap;
-    if ( !m_luceneReader || !m_luceneSearcher )
+    if ( m_trigrams )
+    {
+        if ( query->isFullTextQuery() )
+            return m_trigrams->searchFullText( Tomahawk::DatabaseImpl::sortname( query->fullTextQuery() ), 20 );
+
+        return m_trigrams->searchTracks( Tomahawk::DatabaseImpl::sortname( query->queryTrack()->artist() ),
+                                         Tomahawk::DatabaseImpl::sortname( query->queryTrack()->track() ), 20 );
+    }
+
+    const IndexSearcherPtr luceneSearcher = searcher();
+    if ( !luceneSearcher )
         return resultsmap;
 
     try
@@ -244,12 +536,12 @@ FuzzyIndex::search( const Tomahawk::query_ptr& query )
         }
 
         TopScoreDocCollectorPtr collector = TopScoreDocCollector::create( 20, true );
-        m_luceneSearcher->search( qry, collector );
+        luceneSearcher->search( qry, collector );
         Collection<ScoreDocPtr> hits = collector->topDocs()->scoreDocs;
 
         for ( int i = 0; i < collector->getTotalHits() && i < 20; i++ )
         {
-            DocumentPtr d = m_luceneSearcher->doc( hits[i]->doc );
+            DocumentPtr d = luceneSearcher->doc( hits[i]->doc );
             const float score = hits[i]->score;
             const int id = QString::fromStdWString( d->get( L"trackid" ) ).toInt();
 
@@ -269,6 +561,35 @@ FuzzyIndex::search( const Tomahawk::query_ptr& query )
 }
 
 
+QList< QMap< int, float > >
+FuzzyIndex::search( const QList< Tomahawk::query_ptr >& queries )
+{
+    QList< QMap< int, float > > resultsmaps;
+    QHash< QString, int > lookedUp;
+
+    foreach ( const Tomahawk::query_ptr& query, queries )
+    {
+        QString key;
+        if ( query->isFullTextQuery() )
+            key = QString( "fulltext\t%1" ).arg( Tomahawk::DatabaseImpl::sortname( query->fullTextQuery() ) );
+        else
+            key = QString( "%1\t%2" ).arg( Tomahawk::DatabaseImpl::sortname( query->queryTrack()->artist() ) )
+                                      .arg( Tomahawk::DatabaseImpl::sortname( query->queryTrack()->track() ) );
+
+        if ( lookedUp.contains( key ) )
+        {
+            resultsmaps << resultsmaps.at( lookedUp.value( key ) );
+            continue;
+        }
+
+        lookedUp.insert( key, resultsmaps.count() );
+        resultsmaps << search( query );
+    }
+
+    return resultsmaps;
+}
+
+
 QMap< int, float >
 FuzzyIndex::searchAlbum( const Tomahawk::query_ptr& query )
 {
@@ -276,7 +597,11 @@ FuzzyIndex::searchAlbum( const Tomahawk::query_ptr& query )
 
 //    QMutexLocker lock( &m_mutex );
     QMap< int, float > resultsmap;
-    if ( !m_luceneReader || !m_luceneSearcher )
+    if ( m_trigrams )
+        return m_trigrams->searchAlbums( Tomahawk::DatabaseImpl::sortname( query->fullTextQuery() ) );
+
+    const IndexSearcherPtr luceneSearcher = searcher();
+    if ( !luceneSearcher )
         return resultsmap;
 
     try
@@ -286,12 +611,12 @@ FuzzyIndex::searchAlbum( const Tomahawk::query_ptr& query )
 
         FuzzyQueryPtr qry = newLucene<FuzzyQuery>( newLucene<Term>( L"album", q.toStdWString() ) );
         TopScoreDocCollectorPtr collector = TopScoreDocCollector::create( 99999, false );
-        m_luceneSearcher->search( boost::dynamic_pointer_cast<Query>( qry ), collector );
+        luceneSearcher->search( boost::dynamic_pointer_cast<Query>( qry ), collector );
         Collection<ScoreDocPtr> hits = collector->topDocs()->scoreDocs;
 
         for ( int i = 0; i < collector->getTotalHits(); i++ )
         {
-            DocumentPtr d = m_luceneSearcher->doc( hits[i]->doc );
+            DocumentPtr d = luceneSearcher->doc( hits[i]->doc );
             float score = hits[i]->score;
             int id = QString::fromStdWString( d->get( L"albumid" ) ).toInt();
 
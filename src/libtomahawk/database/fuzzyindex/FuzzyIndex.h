@@ -24,24 +24,55 @@
 #include <QHash>
 #include <QString>
 #include <QMutex>
+#include <QScopedPointer>
 
 #include <lucene++/LuceneHeaders.h>
 
 #include "Query.h"
 #include "database/DatabaseCommand_UpdateSearchIndex.h"
+#include "DllMacro.h"
 
-class FuzzyIndex : public QObject
+namespace Tomahawk
+{
+    class TrigramIndex;
+}
+
+class DLLEXPORT FuzzyIndex : public QObject
 {
 Q_OBJECT
 
 public:
-    explicit FuzzyIndex( QObject* parent, const QString& filename, bool wipe = false );
+    /**
+     * What keeps the index: Lucene++, or a TrigramIndex that is mapped into
+     * memory and scores with edit distances itself. Both live in the same
+     * directory and answer the same searches.
+     */
+    enum Backend
+    {
+        LuceneBackend,
+        TrigramBackend
+    };
+
+    explicit FuzzyIndex( QObject* parent, const QString& filename, bool wipe = false, Backend backend = LuceneBackend );
     virtual ~FuzzyIndex();
 
+    /**
+     * Rebuild the whole index: beginIndexing() starts over with an empty one,
+     * appendFields() adds to it and endIndexing() makes it searchable.
+     */
     void beginIndexing();
     void endIndexing();
     void appendFields( const Tomahawk::IndexData& data );
 
+    /**
+     * Adds the given tracks and albums to the index, replacing any entries they
+     * already had, keyed by their ids. Doesn't block searches, which see the
+     * changes once they're committed.
+     */
+    void updateFields( const QList< Tomahawk::IndexData >& data );
+    /// Removes the tracks and albums with the given ids from the index
+    void deleteFields( const QList< unsigned int >& trackIds, const QList< unsigned int >& albumIds );
+
     /**
      * Delete the index from the harddrive.
      *
@@ -51,6 +82,8 @@ public:
 
     virtual void updateIndex();
 
+    Backend backend() const { return m_backend; }
+
 signals:
     void indexStarted();
     void indexReady();
@@ -60,20 +93,44 @@ public slots:
     bool wipeIndex();
 
     QMap< int, float > search( const Tomahawk::query_ptr& query );
+    /**
+     * Search the index for a batch of queries. Queries that normalize to the
+     * same artist / track pair are only looked up once. The returned list has
+     * one entry per query, in the same order.
+     */
+    QList< QMap< int, float > > search( const QList< Tomahawk::query_ptr >& queries );
     QMap< int, float > searchAlbum( const Tomahawk::query_ptr& query );
 
-private slots:
+protected:
+    /// False for indexes written before entries could be looked up by id, they need a rebuild first
+    bool supportsUpdates() const { return m_supportsUpdates; }
+
+protected slots:
     void updateIndexSlot();
 
 private:
+    static Lucene::DocumentPtr document( const Tomahawk::IndexData& data );
+    static Tomahawk::IndexData normalized( const Tomahawk::IndexData& data );
+
+    bool openWriter();
+    void commitWriter();
+    void closeWriter();
+    void setReader( const Lucene::IndexReaderPtr& reader );
+    Lucene::IndexSearcherPtr searcher();
+
     QMutex m_mutex;
+    QMutex m_searcherMutex;
     QString m_lucenePath;
+    Backend m_backend;
+    QScopedPointer< Tomahawk::TrigramIndex > m_trigrams;
 
     boost::shared_ptr<Lucene::SimpleAnalyzer> m_analyzer;
     Lucene::IndexWriterPtr m_luceneWriter;
     Lucene::IndexReaderPtr m_luceneReader;
     Lucene::FSDirectoryPtr m_luceneDir;
     Lucene::IndexSearcherPtr m_luceneSearcher;
+    Lucene::IndexReaderPtr m_retiredReader;
+    bool m_supportsUpdates;
 };
 
 #endif // FUZZYINDEX_H
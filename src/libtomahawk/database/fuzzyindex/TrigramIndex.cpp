@@ -0,0 +1,877 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TrigramIndex.h"
+
+#include "database/DatabaseCommand_UpdateSearchIndex.h"
+#include "utils/Logger.h"
+
+#include <QThreadStorage>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <functional>
+
+#define TRIGRAM_MAGIC 0x49525454 // "TTRI"
+#define TRIGRAM_VERSION 1
+
+#define MIN_SIMILARITY 0.5f
+#define TRACK_PREFIX_LENGTH 3
+#define MAX_CANDIDATES 2000
+#define MAX_CHANGES 10000
+
+using namespace Tomahawk;
+
+
+// Everything in the file is in host byte order, it never leaves the machine.
+// Sections start 8-byte aligned, names are offsets and lengths in QChars into
+// the string section, postings are byte offsets into the postings section.
+
+struct TrigramIndex::Header
+{
+    quint32 magic;
+    quint32 version;
+
+    quint32 artistCount;
+    quint32 trackCount;
+    quint32 albumCount;
+    quint32 trackGramCount;
+    quint32 albumGramCount;
+
+    quint32 artists;
+    quint32 tracks;
+    quint32 albums;
+    quint32 trackGrams;
+    quint32 albumGrams;
+    quint32 postings;
+    quint32 postingsSize;
+    quint32 strings;
+    quint32 stringsSize;
+};
+
+struct TrigramIndex::ArtistRecord
+{
+    quint32 id;
+    quint32 name;
+    quint32 length;
+};
+
+struct TrigramIndex::TrackRecord
+{
+    quint32 id;
+    quint32 artist; // index into the artists
+    quint32 name;
+    quint32 length;
+};
+
+struct TrigramIndex::AlbumRecord
+{
+    quint32 id;
+    quint32 name;
+    quint32 length;
+};
+
+/// Which records contain a trigram, as ascending indexes delta- and varint-encoded
+struct TrigramIndex::GramRecord
+{
+    quint64 gram;
+    quint32 postings;
+    quint32 count;
+};
+
+
+static quint32
+appendString( QVector< QChar >& strings, const QString& text )
+{
+    const quint32 offset = strings.count();
+    strings.resize( offset + text.length() );
+    memcpy( strings.data() + offset, text.constData(), text.length() * sizeof( QChar ) );
+
+    return offset;
+}
+
+
+static void
+appendVarint( QByteArray& out, quint32 value )
+{
+    while ( value >= 0x80 )
+    {
+        out.append( char( ( value & 0x7f ) | 0x80 ) );
+        value >>= 7;
+    }
+    out.append( char( value ) );
+}
+
+
+static quint32
+readVarint( const uchar*& p )
+{
+    quint32 value = 0;
+    int shift = 0;
+    while ( *p & 0x80 )
+    {
+        value |= quint32( *p++ & 0x7f ) << shift;
+        shift += 7;
+    }
+    value |= quint32( *p++ ) << shift;
+
+    return value;
+}
+
+
+static bool
+alignFile( QFile& file )
+{
+    static const char zeros[ 8 ] = { 0 };
+    const int padding = ( 8 - file.pos() % 8 ) % 8;
+
+    return file.write( zeros, padding ) == padding;
+}
+
+
+template< typename T >
+static bool
+writeSection( QFile& file, const QVector< T >& records, quint32& offset )
+{
+    if ( !alignFile( file ) )
+        return false;
+
+    offset = file.pos();
+    const qint64 size = records.count() * sizeof( T );
+
+    return file.write( reinterpret_cast< const char* >( records.constData() ), size ) == size;
+}
+
+
+static QMap< int, float >
+best( QList< QPair< float, quint32 > >& scored, int limit )
+{
+    std::sort( scored.begin(), scored.end(), std::greater< QPair< float, quint32 > >() );
+
+    QMap< int, float > resultsmap;
+    for ( int i = 0; i < scored.count() && ( limit <= 0 || i < limit ); i++ )
+        resultsmap.insert( scored.at( i ).second, scored.at( i ).first );
+
+    return resultsmap;
+}
+
+
+TrigramIndex::TrigramIndex( const QString& path )
+    : m_path( path )
+    , m_data( 0 )
+    , m_header( 0 )
+{
+}
+
+
+TrigramIndex::~TrigramIndex()
+{
+    unmap();
+}
+
+
+bool
+TrigramIndex::load()
+{
+    QWriteLocker lock( &m_lock );
+    unmap();
+
+    m_addedTracks.clear();
+    m_addedAlbums.clear();
+    m_hiddenTracks.clear();
+    m_hiddenAlbums.clear();
+
+    return map();
+}
+
+
+void
+TrigramIndex::deleteIndex()
+{
+    QWriteLocker lock( &m_lock );
+    unmap();
+
+    m_addedTracks.clear();
+    m_addedAlbums.clear();
+    m_hiddenTracks.clear();
+    m_hiddenAlbums.clear();
+
+    QFile::remove( m_path );
+}
+
+
+bool
+TrigramIndex::map()
+{
+    // m_lock must be held for writing
+    m_file.setFileName( m_path );
+    if ( !m_file.exists() )
+        return false;
+
+    if ( !m_file.open( QIODevice::ReadOnly ) || m_file.size() < qint64( sizeof( Header ) ) )
+    {
+        tLog() << Q_FUNC_INFO << "Can't open trigram index:" << m_path;
+        m_file.close();
+        return false;
+    }
+
+    const qint64 size = m_file.size();
+    m_data = m_file.map( 0, size );
+    if ( !m_data )
+    {
+        tLog() << Q_FUNC_INFO << "Can't map trigram index:" << m_path << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    const Header* header = reinterpret_cast< const Header* >( m_data );
+    const bool valid = header->magic == TRIGRAM_MAGIC && header->version == TRIGRAM_VERSION &&
+                       header->artists + qint64( header->artistCount ) * sizeof( ArtistRecord ) <= size &&
+                       header->tracks + qint64( header->trackCount ) * sizeof( TrackRecord ) <= size &&
+                       header->albums + qint64( header->albumCount ) * sizeof( AlbumRecord ) <= size &&
+                       header->trackGrams + qint64( header->trackGramCount ) * sizeof( GramRecord ) <= size &&
+                       header->albumGrams + qint64( header->albumGramCount ) * sizeof( GramRecord ) <= size &&
+                       header->postings + qint64( header->postingsSize ) <= size &&
+                       header->strings + qint64( header->stringsSize ) * sizeof( QChar ) <= size;
+    if ( !valid )
+    {
+        tLog() << Q_FUNC_INFO << "Trigram index is broken or outdated:" << m_path;
+        unmap();
+        return false;
+    }
+
+    m_header = header;
+    tDebug() << Q_FUNC_INFO << "Mapped trigram index:" << m_path << m_header->trackCount << "tracks," << m_header->albumCount << "albums";
+
+    return true;
+}
+
+
+void
+TrigramIndex::unmap()
+{
+    // m_lock must be held for writing
+    if ( m_data )
+        m_file.unmap( const_cast< uchar* >( m_data ) );
+
+    m_file.close();
+    m_data = 0;
+    m_header = 0;
+}
+
+
+bool
+TrigramIndex::replaceWith( const QString& path )
+{
+    QWriteLocker lock( &m_lock );
+    unmap();
+
+    m_addedTracks.clear();
+    m_addedAlbums.clear();
+    m_hiddenTracks.clear();
+    m_hiddenAlbums.clear();
+
+    QFile::remove( m_path );
+    if ( !QFile::rename( path, m_path ) )
+    {
+        tLog() << Q_FUNC_INFO << "Can't replace trigram index:" << m_path;
+        return false;
+    }
+
+    return map();
+}
+
+
+QVector< quint64 >
+TrigramIndex::grams( const QString& text )
+{
+    QVector< quint64 > result;
+    if ( text.isEmpty() )
+        return result;
+
+    // padded, so the start and end of a name count for more than its middle
+    const QString padded = QString( "  %1 " ).arg( text );
+    const ushort* c = padded.utf16();
+
+    result.reserve( padded.length() - 2 );
+    for ( int i = 0; i + 2 < padded.length(); i++ )
+        result << ( ( quint64( c[ i ] ) << 32 ) | ( quint64( c[ i + 1 ] ) << 16 ) | quint64( c[ i + 2 ] ) );
+
+    std::sort( result.begin(), result.end() );
+    result.erase( std::unique( result.begin(), result.end() ), result.end() );
+
+    return result;
+}
+
+
+bool
+TrigramIndex::write( const QString& path, const QVector< Track >& tracks, const QVector< Album >& albums )
+{
+    QVector< QChar > strings;
+    QVector< ArtistRecord > artistRecords;
+    QVector< TrackRecord > trackRecords;
+    QVector< AlbumRecord > albumRecords;
+    QHash< quint32, quint32 > artistIndex;
+    QHash< quint64, QVector< quint32 > > trackPostings;
+    QHash< quint64, QVector< quint32 > > albumPostings;
+
+    trackRecords.reserve( tracks.count() );
+    foreach ( const Track& t, tracks )
+    {
+        if ( !artistIndex.contains( t.artistId ) )
+        {
+            ArtistRecord artist;
+            artist.id = t.artistId;
+            artist.name = appendString( strings, t.artist );
+            artist.length = t.artist.length();
+
+            artistIndex.insert( t.artistId, artistRecords.count() );
+            artistRecords << artist;
+        }
+
+        TrackRecord record;
+        record.id = t.id;
+        record.artist = artistIndex.value( t.artistId );
+        record.name = appendString( strings, t.track );
+        record.length = t.track.length();
+
+        foreach ( quint64 gram, grams( QString( "%1 %2" ).arg( t.artist ).arg( t.track ) ) )
+            trackPostings[ gram ] << trackRecords.count();
+
+        trackRecords << record;
+    }
+
+    albumRecords.reserve( albums.count() );
+    foreach ( const Album& a, albums )
+    {
+        AlbumRecord record;
+        record.id = a.id;
+        record.name = appendString( strings, a.album );
+        record.length = a.album.length();
+
+        foreach ( quint64 gram, grams( a.album ) )
+            albumPostings[ gram ] << albumRecords.count();
+
+        albumRecords << record;
+    }
+
+    QByteArray postings;
+    QVector< GramRecord > trackGrams;
+    QVector< GramRecord > albumGrams;
+    for ( int i = 0; i < 2; i++ )
+    {
+        const QHash< quint64, QVector< quint32 > >& source = ( i == 0 ? trackPostings : albumPostings );
+        QVector< GramRecord >& table = ( i == 0 ? trackGrams : albumGrams );
+
+        QList< quint64 > keys = source.keys();
+        std::sort( keys.begin(), keys.end() );
+
+        table.reserve( keys.count() );
+        foreach ( quint64 gram, keys )
+        {
+            const QVector< quint32 >& indexes = source[ gram ];
+
+            GramRecord record;
+            record.gram = gram;
+            record.postings = postings.size();
+            record.count = indexes.count();
+            table << record;
+
+            quint32 previous = 0;
+            foreach ( quint32 index, indexes )
+            {
+                appendVarint( postings, index - previous );
+                previous = index;
+            }
+        }
+    }
+
+    QFile file( path );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        tLog() << Q_FUNC_INFO << "Can't write trigram index:" << path << file.errorString();
+        return false;
+    }
+
+    Header header;
+    memset( &header, 0, sizeof( Header ) );
+    header.magic = TRIGRAM_MAGIC;
+    header.version = TRIGRAM_VERSION;
+    header.artistCount = artistRecords.count();
+    header.trackCount = trackRecords.count();
+    header.albumCount = albumRecords.count();
+    header.trackGramCount = trackGrams.count();
+    header.albumGramCount = albumGrams.count();
+    header.postingsSize = postings.size();
+    header.stringsSize = strings.count();
+
+    bool ok = file.write( reinterpret_cast< const char* >( &header ), sizeof( Header ) ) == sizeof( Header ) &&
+              writeSection( file, artistRecords, header.artists ) &&
+              writeSection( file, trackRecords, header.tracks ) &&
+              writeSection( file, albumRecords, header.albums ) &&
+              writeSection( file, trackGrams, header.trackGrams ) &&
+              writeSection( file, albumGrams, header.albumGrams ) &&
+              alignFile( file );
+
+    header.postings = file.pos();
+    ok = ok && file.write( postings ) == postings.size() &&
+         writeSection( file, strings, header.strings );
+
+    // now that all offsets are known
+    ok = ok && file.seek( 0 ) &&
+         file.write( reinterpret_cast< const char* >( &header ), sizeof( Header ) ) == sizeof( Header );
+
+    file.close();
+    if ( !ok )
+    {
+        tLog() << Q_FUNC_INFO << "Can't write trigram index:" << path << file.errorString();
+        QFile::remove( path );
+        return false;
+    }
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Wrote trigram index:" << path << header.trackCount << "tracks," << header.albumCount << "albums," << file.size() << "bytes";
+    return true;
+}
+
+
+void
+TrigramIndex::beginBuild()
+{
+    m_buildTracks.clear();
+    m_buildAlbums.clear();
+}
+
+
+void
+TrigramIndex::add( const IndexData& data )
+{
+    if ( !data.track.isEmpty() )
+    {
+        Track t;
+        t.id = data.id;
+        t.artistId = data.artistId;
+        t.artist = data.artist;
+        t.track = data.track;
+        m_buildTracks << t;
+    }
+    else if ( !data.album.isEmpty() )
+    {
+        Album a;
+        a.id = data.id;
+        a.album = data.album;
+        m_buildAlbums << a;
+    }
+}
+
+
+bool
+TrigramIndex::endBuild()
+{
+    const QString path = m_path + ".new";
+    const bool written = write( path, m_buildTracks, m_buildAlbums );
+
+    m_buildTracks = QVector< Track >();
+    m_buildAlbums = QVector< Album >();
+
+    return written && replaceWith( path );
+}
+
+
+bool
+TrigramIndex::compact()
+{
+    QVector< Track > tracks;
+    QVector< Album > albums;
+    {
+        QReadLocker lock( &m_lock );
+        if ( m_header )
+        {
+            tracks.reserve( m_header->trackCount );
+            for ( quint32 i = 0; i < m_header->trackCount; i++ )
+            {
+                Track t = track( i );
+                if ( m_hiddenTracks.contains( t.id ) )
+                    continue;
+
+                // detach from the mapping, it's about to go away
+                t.artist = QString( t.artist.unicode(), t.artist.length() );
+                t.track = QString( t.track.unicode(), t.track.length() );
+                tracks << t;
+            }
+
+            albums.reserve( m_header->albumCount );
+            for ( quint32 i = 0; i < m_header->albumCount; i++ )
+            {
+                Album a = album( i );
+                if ( m_hiddenAlbums.contains( a.id ) )
+                    continue;
+
+                a.album = QString( a.album.unicode(), a.album.length() );
+                albums << a;
+            }
+        }
+
+        foreach ( const Track& t, m_addedTracks )
+            tracks << t;
+        foreach ( const Album& a, m_addedAlbums )
+            albums << a;
+    }
+
+    // searches keep going on the old file while the new one gets written
+    const QString path = m_path + ".new";
+    return write( path, tracks, albums ) && replaceWith( path );
+}
+
+
+void
+TrigramIndex::update( const QList< IndexData >& data )
+{
+    int changes = 0;
+    {
+        QWriteLocker lock( &m_lock );
+        foreach ( const IndexData& entry, data )
+        {
+            if ( !entry.track.isEmpty() )
+            {
+                Track t;
+                t.id = entry.id;
+                t.artistId = entry.artistId;
+                t.artist = entry.artist;
+                t.track = entry.track;
+
+                m_hiddenTracks.insert( t.id );
+                m_addedTracks.insert( t.id, t );
+            }
+            else if ( !entry.album.isEmpty() )
+            {
+                Album a;
+                a.id = entry.id;
+                a.album = entry.album;
+
+                m_hiddenAlbums.insert( a.id );
+                m_addedAlbums.insert( a.id, a );
+            }
+        }
+
+        changes = m_hiddenTracks.count() + m_hiddenAlbums.count();
+    }
+
+    if ( changes > MAX_CHANGES )
+        compact();
+}
+
+
+void
+TrigramIndex::remove( const QList< unsigned int >& trackIds, const QList< unsigned int >& albumIds )
+{
+    int changes = 0;
+    {
+        QWriteLocker lock( &m_lock );
+        foreach ( unsigned int id, trackIds )
+        {
+            m_hiddenTracks.insert( id );
+            m_addedTracks.remove( id );
+        }
+        foreach ( unsigned int id, albumIds )
+        {
+            m_hiddenAlbums.insert( id );
+            m_addedAlbums.remove( id );
+        }
+
+        changes = m_hiddenTracks.count() + m_hiddenAlbums.count();
+    }
+
+    if ( changes > MAX_CHANGES )
+        compact();
+}
+
+
+QString
+TrigramIndex::string( quint32 offset, quint32 length ) const
+{
+    // no copy, only valid while the file stays mapped
+    const QChar* strings = reinterpret_cast< const QChar* >( m_data + m_header->strings );
+    return QString::fromRawData( strings + offset, length );
+}
+
+
+TrigramIndex::Track
+TrigramIndex::track( quint32 index ) const
+{
+    const TrackRecord& record = reinterpret_cast< const TrackRecord* >( m_data + m_header->tracks )[ index ];
+    const ArtistRecord& artist = reinterpret_cast< const ArtistRecord* >( m_data + m_header->artists )[ record.artist ];
+
+    Track t;
+    t.id = record.id;
+    t.artistId = artist.id;
+    t.artist = string( artist.name, artist.length );
+    t.track = string( record.name, record.length );
+
+    return t;
+}
+
+
+TrigramIndex::Album
+TrigramIndex::album( quint32 index ) const
+{
+    const AlbumRecord& record = reinterpret_cast< const AlbumRecord* >( m_data + m_header->albums )[ index ];
+
+    Album a;
+    a.id = record.id;
+    a.album = string( record.name, record.length );
+
+    return a;
+}
+
+
+QVector< quint32 >
+TrigramIndex::candidates( const QString& text, const GramRecord* table, quint32 tableCount, quint32 recordCount ) const
+{
+    QVector< quint32 > touched;
+    const QVector< quint64 > query = grams( text );
+    if ( query.isEmpty() || !recordCount )
+        return touched;
+
+    // kept per thread and only the touched slots get reset, a search shouldn't have to clear a counter for every record
+    static QThreadStorage< QVector< quint16 > > hitBuffers;
+    QVector< quint16 >& hits = hitBuffers.localData();
+    if ( quint32( hits.count() ) < recordCount )
+        hits.resize( recordCount );
+
+    const GramRecord* end = table + tableCount;
+    const uchar* postings = m_data + m_header->postings;
+
+    foreach ( quint64 gram, query )
+    {
+        const GramRecord* record = std::lower_bound( table, end, gram,
+                                                     []( const GramRecord& r, quint64 g ) { return r.gram < g; } );
+        if ( record == end || record->gram != gram )
+            continue;
+
+        const uchar* p = postings + record->postings;
+        quint32 index = 0;
+        for ( quint32 i = 0; i < record->count; i++ )
+        {
+            index += readVarint( p );
+            if ( hits[ index ]++ == 0 )
+                touched << index;
+        }
+    }
+
+    // whatever is similar enough shares a good part of the query's trigrams, the rest isn't worth an edit distance
+    const int minHits = qMax( 1, query.count() / 3 );
+    QVector< quint32 > result;
+    foreach ( quint32 index, touched )
+    {
+        if ( hits[ index ] >= minHits )
+            result << index;
+    }
+
+    if ( result.count() > MAX_CANDIDATES )
+    {
+        std::nth_element( result.begin(), result.begin() + MAX_CANDIDATES, result.end(),
+                          [&hits]( quint32 a, quint32 b ) { return hits[ a ] > hits[ b ]; } );
+        result.resize( MAX_CANDIDATES );
+    }
+
+    foreach ( quint32 index, touched )
+        hits[ index ] = 0;
+
+    return result;
+}
+
+
+float
+TrigramIndex::scoreTrack( const Track& entry, const QString& artist, const QString& track )
+{
+    // like Lucene's FuzzyQuery with a prefix length, the start has to match exactly
+    if ( !entry.track.startsWith( track.left( TRACK_PREFIX_LENGTH ) ) || !entry.artist.startsWith( artist.left( TRACK_PREFIX_LENGTH ) ) )
+        return 0.0;
+
+    const float trackSimilarity = similarity( entry.track, track, MIN_SIMILARITY );
+    if ( trackSimilarity <= 0.0 )
+        return 0.0;
+
+    const float artistSimilarity = similarity( entry.artist, artist, MIN_SIMILARITY );
+    if ( artistSimilarity <= 0.0 )
+        return 0.0;
+
+    return ( trackSimilarity + artistSimilarity ) / 2.0;
+}
+
+
+float
+TrigramIndex::scoreFullText( const Track& entry, const QString& text )
+{
+    float score = qMax( similarity( entry.track, text, MIN_SIMILARITY ), similarity( entry.artist, text, MIN_SIMILARITY ) );
+    if ( score < 1.0 )
+        score = qMax( score, similarity( QString( "%1 %2" ).arg( entry.artist ).arg( entry.track ), text, MIN_SIMILARITY ) );
+
+    return score;
+}
+
+
+QMap< int, float >
+TrigramIndex::searchTracks( const QString& artist, const QString& track, int limit ) const
+{
+    QList< QPair< float, quint32 > > scored;
+
+    QReadLocker lock( &m_lock );
+    if ( m_header )
+    {
+        const GramRecord* table = reinterpret_cast< const GramRecord* >( m_data + m_header->trackGrams );
+        foreach ( quint32 index, candidates( QString( "%1 %2" ).arg( artist ).arg( track ), table, m_header->trackGramCount, m_header->trackCount ) )
+        {
+            const Track entry = this->track( index );
+            if ( m_hiddenTracks.contains( entry.id ) )
+                continue;
+
+            const float score = scoreTrack( entry, artist, track );
+            if ( score > 0.0 )
+                scored << qMakePair( score, entry.id );
+        }
+    }
+
+    foreach ( const Track& entry, m_addedTracks )
+    {
+        const float score = scoreTrack( entry, artist, track );
+        if ( score > 0.0 )
+            scored << qMakePair( score, entry.id );
+    }
+
+    return best( scored, limit );
+}
+
+
+QMap< int, float >
+TrigramIndex::searchFullText( const QString& text, int limit ) const
+{
+    QList< QPair< float, quint32 > > scored;
+
+    QReadLocker lock( &m_lock );
+    if ( m_header )
+    {
+        const GramRecord* table = reinterpret_cast< const GramRecord* >( m_data + m_header->trackGrams );
+        foreach ( quint32 index, candidates( text, table, m_header->trackGramCount, m_header->trackCount ) )
+        {
+            const Track entry = track( index );
+            if ( m_hiddenTracks.contains( entry.id ) )
+                continue;
+
+            const float score = scoreFullText( entry, text );
+            if ( score > 0.0 )
+                scored << qMakePair( score, entry.id );
+        }
+    }
+
+    foreach ( const Track& entry, m_addedTracks )
+    {
+        const float score = scoreFullText( entry, text );
+        if ( score > 0.0 )
+            scored << qMakePair( score, entry.id );
+    }
+
+    return best( scored, limit );
+}
+
+
+QMap< int, float >
+TrigramIndex::searchAlbums( const QString& album ) const
+{
+    QList< QPair< float, quint32 > > scored;
+
+    QReadLocker lock( &m_lock );
+    if ( m_header )
+    {
+        const GramRecord* table = reinterpret_cast< const GramRecord* >( m_data + m_header->albumGrams );
+        foreach ( quint32 index, candidates( album, table, m_header->albumGramCount, m_header->albumCount ) )
+        {
+            const Album entry = this->album( index );
+            if ( m_hiddenAlbums.contains( entry.id ) )
+                continue;
+
+            const float score = similarity( entry.album, album, MIN_SIMILARITY );
+            if ( score > 0.0 )
+                scored << qMakePair( score, entry.id );
+        }
+    }
+
+    foreach ( const Album& entry, m_addedAlbums )
+    {
+        const float score = similarity( entry.album, album, MIN_SIMILARITY );
+        if ( score > 0.0 )
+            scored << qMakePair( score, entry.id );
+    }
+
+    return best( scored, 0 );
+}
+
+
+int
+TrigramIndex::boundedDistance( const QString& a, const QString& b, int bound )
+{
+    const int la = a.length();
+    const int lb = b.length();
+    if ( qAbs( la - lb ) > bound )
+        return bound + 1;
+
+    QVarLengthArray< int, 128 > rows( 2 * ( lb + 1 ) );
+    int* previous = rows.data();
+    int* current = rows.data() + lb + 1;
+    for ( int j = 0; j <= lb; j++ )
+        previous[ j ] = j;
+
+    for ( int i = 1; i <= la; i++ )
+    {
+        current[ 0 ] = i;
+        int rowMin = i;
+
+        const QChar c = a.at( i - 1 );
+        for ( int j = 1; j <= lb; j++ )
+        {
+            const int substitution = previous[ j - 1 ] + ( c == b.at( j - 1 ) ? 0 : 1 );
+            current[ j ] = qMin( substitution, qMin( previous[ j ], current[ j - 1 ] ) + 1 );
+            rowMin = qMin( rowMin, current[ j ] );
+        }
+
+        // every later row only gets worse
+        if ( rowMin > bound )
+            return bound + 1;
+
+        std::swap( previous, current );
+    }
+
+    return qMin( previous[ lb ], bound + 1 );
+}
+
+
+float
+TrigramIndex::similarity( const QString& a, const QString& b, float minSimilarity )
+{
+    const int shorter = qMin( a.length(), b.length() );
+    if ( !shorter )
+        return 0.0;
+
+    const int bound = int( ( 1.0 - minSimilarity ) * shorter );
+    const int distance = boundedDistance( a, b, bound );
+    if ( distance > bound )
+        return 0.0;
+
+    const float result = 1.0 - float( distance ) / shorter;
+    return result > minSimilarity ? result : 0.0;
+}
@@ -0,0 +1,145 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TRIGRAMINDEX_H
+#define TOMAHAWK_TRIGRAMINDEX_H
+
+#include <QFile>
+#include <QHash>
+#include <QMap>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include "DllMacro.h"
+
+namespace Tomahawk
+{
+
+struct IndexData;
+
+/**
+ * Fuzzy index over already normalized (sortname'd) track, artist and album
+ * names, kept in a single memory-mapped file.
+ *
+ * Every track is indexed by the trigrams of "artist track", every album by the
+ * trigrams of its name. A search collects the entries sharing enough trigrams
+ * with the query from the posting lists and scores them with an edit distance
+ * that gives up as soon as it can't reach the minimum similarity anymore. Ids
+ * come straight out of the mapped records.
+ *
+ * Changes made after the file was written live in memory, on top of it, until
+ * there are enough of them to write a new file. Searches can run from any
+ * thread, changes must not run concurrently with each other.
+ */
+class DLLEXPORT TrigramIndex
+{
+public:
+    explicit TrigramIndex( const QString& path );
+    ~TrigramIndex();
+
+    /// Maps the index file, false if there is none or it can't be read
+    bool load();
+    /// Unmaps and removes the index file
+    void deleteIndex();
+
+    /**
+     * Rebuild the whole index: beginBuild() starts over with an empty one,
+     * add() adds to it and endBuild() writes and maps it.
+     */
+    void beginBuild();
+    void add( const IndexData& data );
+    bool endBuild();
+
+    /// Adds the given entries, replacing any existing ones with the same id
+    void update( const QList< IndexData >& data );
+    void remove( const QList< unsigned int >& trackIds, const QList< unsigned int >& albumIds );
+
+    /// Tracks whose artist and track are both similar enough, best @p limit ones
+    QMap< int, float > searchTracks( const QString& artist, const QString& track, int limit ) const;
+    /// Tracks whose artist, track or "artist track" is similar enough to @p text, best @p limit ones
+    QMap< int, float > searchFullText( const QString& text, int limit ) const;
+    QMap< int, float > searchAlbums( const QString& album ) const;
+
+    /**
+     * Levenshtein distance between @p a and @p b, or @p bound + 1 as soon as it
+     * is clear it will be larger than @p bound.
+     */
+    static int boundedDistance( const QString& a, const QString& b, int bound );
+    /// Similarity the way Lucene's FuzzyQuery sees it: 1 - distance / length of the shorter one
+    static float similarity( const QString& a, const QString& b, float minSimilarity );
+
+private:
+    struct Header;
+    struct ArtistRecord;
+    struct TrackRecord;
+    struct AlbumRecord;
+    struct GramRecord;
+
+    struct Track
+    {
+        quint32 id;
+        quint32 artistId;
+        QString artist;
+        QString track;
+    };
+
+    struct Album
+    {
+        quint32 id;
+        QString album;
+    };
+
+    static QVector< quint64 > grams( const QString& text );
+    static bool write( const QString& path, const QVector< Track >& tracks, const QVector< Album >& albums );
+
+    bool map();
+    void unmap();
+    bool replaceWith( const QString& path );
+    bool compact();
+
+    QString string( quint32 offset, quint32 length ) const;
+    Track track( quint32 index ) const;
+    Album album( quint32 index ) const;
+
+    QVector< quint32 > candidates( const QString& text, const GramRecord* table, quint32 tableCount, quint32 recordCount ) const;
+    static float scoreTrack( const Track& entry, const QString& artist, const QString& track );
+    static float scoreFullText( const Track& entry, const QString& text );
+
+    QString m_path;
+    QFile m_file;
+    const uchar* m_data;
+    const Header* m_header;
+
+    // changes since the file was written
+    QHash< quint32, Track > m_addedTracks;
+    QHash< quint32, Album > m_addedAlbums;
+    QSet< quint32 > m_hiddenTracks;
+    QSet< quint32 > m_hiddenAlbums;
+
+    // only while building
+    QVector< Track > m_buildTracks;
+    QVector< Album > m_buildAlbums;
+
+    mutable QReadWriteLock m_lock;
+};
+
+} // namespace Tomahawk
+
+#endif // TOMAHAWK_TRIGRAMINDEX_H
@@ -35,6 +35,10 @@
 
 #include "config.h"
 
+#include <QtConcurrentRun>
+
+#define DEFAULT_TAG_READERS 2
+
 using namespace Tomahawk;
 
 void
@@ -141,11 +145,14 @@ MusicScanner::MusicScanner( MusicScanner::ScanMode scanMode, const QStringList&
     , m_scanMode( scanMode )
     , m_paths( paths )
     , m_scanned( 0 )
+    , m_skipped( 0 )
     , m_dryRun( false )
     , m_verbose( false )
     , m_cmdQueue( 0 )
     , m_batchsize( bs )
     , m_dirListerThreadController( 0 )
+    , m_tagReaders( 0 )
+    , m_listingFinished( false )
 {
 }
 
@@ -162,6 +169,9 @@ MusicScanner::~MusicScanner()
         delete m_dirListerThreadController;
         m_dirListerThreadController = 0;
     }
+
+    m_pendingChunks.clear();
+    m_tagReaderPool.waitForDone();
 }
 
 
@@ -193,12 +203,41 @@ MusicScanner::verbose()
 }
 
 
+void
+MusicScanner::setTagReaders( unsigned int tagReaders )
+{
+    m_tagReaders = tagReaders;
+}
+
+
+unsigned int
+MusicScanner::tagReaders() const
+{
+    return m_tagReaders;
+}
+
+
+unsigned int
+MusicScanner::scanned() const
+{
+    return m_scanned;
+}
+
+
+unsigned int
+MusicScanner::skipped() const
+{
+    return m_skipped;
+}
+
+
 void
 MusicScanner::startScan()
 {
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Loading mtimes...";
     m_scanned = m_skipped = m_cmdQueue = 0;
     m_skippedFiles.clear();
+    m_listingFinished = false;
 
     emit progress( m_scanned );
 
@@ -232,6 +271,10 @@ MusicScanner::scan()
     connect( this, SIGNAL( batchReady( QVariantList, QVariantList ) ),
                      SLOT( commitBatch( QVariantList, QVariantList ) ), Qt::DirectConnection );
 
+    // more readers mostly make the disk seek between directories, a couple are enough to hide the parsing
+    m_tagReaderPool.setMaxThreadCount( m_tagReaders > 0 ? m_tagReaders : qBound( 1, QThread::idealThreadCount(), DEFAULT_TAG_READERS ) );
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Reading tags with" << m_tagReaderPool.maxThreadCount() << "threads";
+
     if ( m_scanMode == MusicScanner::FileScan )
     {
         scanFilePaths();
@@ -251,7 +294,9 @@ MusicScanner::scanFilePaths()
     foreach( QString path, m_paths )
     {
         QFileInfo fi( path );
-        if ( fi.exists() && fi.isReadable() )
+        if ( fi.isDir() )
+            scanDirectory( QDir( fi.canonicalFilePath() ) );
+        else if ( fi.exists() && fi.isReadable() )
             scanFile( fi );
     }
 
@@ -259,11 +304,68 @@ MusicScanner::scanFilePaths()
 }
 
 
+void
+MusicScanner::scanDirectory( const QDir& dir )
+{
+    // Only the files directly inside dir are scanned, subdirectories are passed in as separate paths
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << dir.canonicalPath();
+    foreach ( const QFileInfo& fi, dir.entryInfoList( QDir::Files | QDir::Readable | QDir::NoDotAndDotDot, QDir::Name ) )
+        scanFile( fi );
+
+    // scanFile() consumed the mtimes of all existing files. What is left below dir
+    // was either deleted or lives in a subdirectory that might have been removed.
+    const QString prefix = "file://" + dir.canonicalPath() + "/";
+    QHash< QString, bool > subDirExists;
+    QMap< QString, QMap< unsigned int, unsigned int > >::iterator it = m_filemtimes.lowerBound( prefix );
+    while ( it != m_filemtimes.end() && it.key().startsWith( prefix ) )
+    {
+        const QString relativePath = it.key().mid( prefix.length() );
+        const int slash = relativePath.indexOf( '/' );
+        if ( slash >= 0 )
+        {
+            const QString subDir = relativePath.left( slash );
+            if ( !subDirExists.contains( subDir ) )
+                subDirExists.insert( subDir, dir.exists( subDir ) );
+
+            if ( subDirExists.value( subDir ) )
+            {
+                ++it;
+                continue;
+            }
+        }
+
+        if ( !it.value().keys().isEmpty() )
+            m_filesToDelete << it.value().keys().first();
+        it = m_filemtimes.erase( it );
+    }
+}
+
+
 void
 MusicScanner::postOps()
 {
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO;
 
+    // the listing is done, but tag readers may still be busy
+    m_listingFinished = true;
+    if ( !m_pendingFiles.isEmpty() )
+    {
+        m_pendingChunks.enqueue( m_pendingFiles );
+        m_pendingFiles.clear();
+    }
+    dispatchFiles();
+
+    if ( m_tagReads.isEmpty() && m_pendingChunks.isEmpty() )
+        finishScan();
+}
+
+
+void
+MusicScanner::finishScan()
+{
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO;
+    m_listingFinished = false;
+
     if ( m_scanMode == MusicScanner::DirScan )
     {
         // any remaining stuff that wasnt emitted as a batch:
@@ -375,10 +477,77 @@ MusicScanner::scanFile( const QFileInfo& fi )
         m_filemtimes.remove( "file://" + fi.canonicalFilePath() );
     }
 
-    QVariant m = readFile( fi );
+    queueFile( fi );
+}
+
+
+void
+MusicScanner::queueFile( const QFileInfo& fi )
+{
+    // DirLister emits all files of a directory in a row, so a new path starts the next chunk
+    if ( !m_pendingFiles.isEmpty() && m_pendingFiles.last().absolutePath() != fi.absolutePath() )
+    {
+        m_pendingChunks.enqueue( m_pendingFiles );
+        m_pendingFiles.clear();
+        dispatchFiles();
+    }
+
+    m_pendingFiles << fi;
+}
+
+
+void
+MusicScanner::dispatchFiles()
+{
+    while ( !m_pendingChunks.isEmpty() && m_tagReads.count() < m_tagReaderPool.maxThreadCount() )
+    {
+        const QFileInfoList files = m_pendingChunks.dequeue();
+
+        QFutureWatcher< QVariantList >* watcher = new QFutureWatcher< QVariantList >( this );
+        connect( watcher, SIGNAL( finished() ), SLOT( onTagsRead() ), Qt::QueuedConnection );
+        m_tagReads.insert( watcher, files );
+
+        watcher->setFuture( QtConcurrent::run( &m_tagReaderPool, [ files ]() { return MusicScanner::readTags( files ); } ) );
+    }
+}
+
+
+void
+MusicScanner::onTagsRead()
+{
+    QFutureWatcher< QVariantList >* watcher = static_cast< QFutureWatcher< QVariantList >* >( sender() );
+    const QFileInfoList files = m_tagReads.take( watcher );
+    const QVariantList tags = watcher->result();
+    watcher->deleteLater();
+
+    for ( int i = 0; i < files.count(); i++ )
+        addScannedFile( files.at( i ), tags.at( i ) );
+
+    dispatchFiles();
+
+    if ( m_listingFinished && m_tagReads.isEmpty() && m_pendingChunks.isEmpty() )
+        finishScan();
+}
+
+
+void
+MusicScanner::addScannedFile( const QFileInfo& fi, const QVariant& m )
+{
+    if ( m_scanned )
+        if ( m_scanned % 3 == 0 )
+            emit progress( m_scanned );
+
+    if ( m_scanned % 100 == 0 || m_verbose )
+        tDebug( LOGINFO ) << Q_FUNC_INFO << "Scanning file:" << m_scanned << fi.canonicalFilePath();
+
     if ( m.toMap().isEmpty() )
+    {
+        m_skippedFiles << fi.canonicalFilePath();
+        m_skipped++;
         return;
+    }
 
+    m_scanned++;
     m_scannedfiles << m;
     if ( m_batchsize != 0 && (quint32)m_scannedfiles.length() >= m_batchsize )
     {
@@ -452,28 +621,14 @@ MusicScanner::readTags( const QFileInfo& fi )
 }
 
 
-QVariant
-MusicScanner::readFile( const QFileInfo& fi )
+QVariantList
+MusicScanner::readTags( const QFileInfoList& files )
 {
-    const QVariant m = readTags( fi );
+    QVariantList tags;
+    tags.reserve( files.count() );
 
-    if ( m_scanned )
-        if ( m_scanned % 3 == 0 )
-            emit progress( m_scanned );
+    foreach ( const QFileInfo& fi, files )
+        tags << readTags( fi );
 
-    if ( m_scanned % 100 == 0 || m_verbose )
-        tDebug( LOGINFO ) << Q_FUNC_INFO << "Scanning file:" << m_scanned << fi.canonicalFilePath();
-
-    if ( m.toMap().isEmpty() )
-    {
-        m_skippedFiles << fi.canonicalFilePath();
-        m_skipped++;
-    }
-    else
-    {
-        m_scanned++;
-    }
-
-    return m;
+    return tags;
 }
-
@@ -31,11 +31,14 @@
 #include <QDateTime>
 #include <QDir>
 #include <QFileInfo>
+#include <QFutureWatcher>
 #include <QMutex>
 #include <QMutexLocker>
 #include <QPointer>
+#include <QQueue>
 #include <QString>
 #include <QThread>
+#include <QThreadPool>
 #include <QTimer>
 #include <QVariantMap>
 
@@ -124,6 +127,27 @@ public:
     void setVerbose( bool _verbose );
     bool verbose();
 
+    /**
+     * Number of threads reading tags in parallel. Files are handed to them
+     * per directory, so reads within a directory stay sequential.
+     *
+     * 0 (the default) uses two threads, or one on a single core machine. Set
+     * this to 1 for collections on a single spinning disk.
+     */
+    void setTagReaders( unsigned int tagReaders );
+    unsigned int tagReaders() const;
+
+    /**
+     * Number of files that were read successfully / skipped during the last scan.
+     */
+    unsigned int scanned() const;
+    unsigned int skipped() const;
+
+    /**
+     * Reads the tags of all @p files, in order. Run on the tag reader threads.
+     */
+    static QVariantList readTags( const QFileInfoList& files );
+
 signals:
     //void fileScanned( QVariantMap );
     void finished();
@@ -131,8 +155,11 @@ signals:
     void progress( unsigned int files );
 
 private:
-    QVariant readFile( const QFileInfo& fi );
     void executeCommand( Tomahawk::dbcmd_ptr cmd );
+    void queueFile( const QFileInfo& fi );
+    void dispatchFiles();
+    void addScannedFile( const QFileInfo& fi, const QVariant& m );
+    void finishScan();
 
 private slots:
     void postOps();
@@ -143,9 +170,11 @@ private slots:
     void cleanup();
     void commitBatch( const QVariantList& tracks, const QVariantList& deletethese );
     void commandFinished();
+    void onTagsRead();
 
 private:
     void scanFilePaths();
+    void scanDirectory( const QDir& dir );
 
     MusicScanner::ScanMode m_scanMode;
     QStringList m_paths;
@@ -165,6 +194,15 @@ private:
     quint32 m_batchsize;
 
     DirListerThreadController* m_dirListerThreadController;
+
+    // files of the directory we are currently collecting
+    QFileInfoList m_pendingFiles;
+    // per-directory chunks waiting for a free tag reader
+    QQueue< QFileInfoList > m_pendingChunks;
+    QThreadPool m_tagReaderPool;
+    QHash< QFutureWatcher< QVariantList >*, QFileInfoList > m_tagReads;
+    unsigned int m_tagReaders;
+    bool m_listingFinished;
 };
 
 #endif
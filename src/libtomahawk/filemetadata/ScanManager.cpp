@@ -32,8 +32,16 @@
 
 #include <QThread>
 #include <QCoreApplication>
+#include <QDirIterator>
+#include <QFileSystemWatcher>
 #include <QTimer>
 #include <QSet>
+#include <QtConcurrentRun>
+
+// how long to wait for more change notifications before rescanning
+#define CHANGED_DIRS_DELAY 5000
+// while change notifications are active the full walk only runs as a consistency sweep
+#define CONSISTENCY_SWEEP_INTERVAL ( 6 * 60 * 60 * 1000 )
 
 using namespace Tomahawk;
 
@@ -56,6 +64,7 @@ MusicScannerThreadController::run()
 {
     m_musicScanner = QPointer< MusicScanner >( new MusicScanner( m_mode, m_paths, m_bs ) );
     m_musicScanner->setVerbose( qApp->arguments().contains( "--verbose" ) );
+    m_musicScanner->setTagReaders( TomahawkSettings::instance()->scannerTagReaders() );
 
     connect( m_musicScanner.data(), SIGNAL( finished() ), parent(), SLOT( scannerFinished() ), Qt::QueuedConnection );
     connect( m_musicScanner.data(), SIGNAL( progress( unsigned int ) ), parent(), SIGNAL( progress( unsigned int ) ), Qt::QueuedConnection );
@@ -83,6 +92,8 @@ ScanManager::ScanManager( QObject* parent )
     , m_musicScannerThreadController( 0 )
     , m_currScannerPaths()
     , m_cachedScannerDirs()
+    , m_fsWatcher( 0 )
+    , m_listDirsWatcher( 0 )
     , m_queuedScanType( MusicScanner::None )
     , m_updateGUI( true )
 {
@@ -91,6 +102,11 @@ ScanManager::ScanManager( QObject* parent )
     m_scanTimer = new QTimer( this );
     m_scanTimer->setSingleShot( false );
     m_scanTimer->setInterval( TomahawkSettings::instance()->scannerTime() * 1000 );
+
+    m_changedDirsTimer = new QTimer( this );
+    m_changedDirsTimer->setSingleShot( true );
+    m_changedDirsTimer->setInterval( CHANGED_DIRS_DELAY );
+    connect( m_changedDirsTimer, SIGNAL( timeout() ), SLOT( runChangedDirsScan() ) );
 }
 
 
@@ -106,6 +122,9 @@ ScanManager::~ScanManager()
         delete m_musicScannerThreadController;
         m_musicScannerThreadController = 0;
     }
+
+    if ( m_listDirsWatcher )
+        m_listDirsWatcher->waitForFinished();
     qDebug() << Q_FUNC_INFO << "scanner thread controller finished, exiting ScanManager";
 }
 
@@ -121,7 +140,10 @@ ScanManager::init()
         m_cachedScannerDirs = TomahawkSettings::instance()->scannerPaths();
         m_scanTimer->start();
         if ( TomahawkSettings::instance()->watchForChanges() )
+        {
             QTimer::singleShot( 1000, this, SLOT( runStartupScan() ) );
+            updateWatchedDirs();
+        }
     }
 }
 
@@ -132,20 +154,175 @@ ScanManager::onSettingsChanged()
     if ( !TomahawkSettings::instance()->watchForChanges() && m_scanTimer->isActive() )
         m_scanTimer->stop();
 
-    m_scanTimer->setInterval( TomahawkSettings::instance()->scannerTime() * 1000 );
-
+    const bool watchedDirsChanged = ( TomahawkSettings::instance()->watchForChanges() != ( m_fsWatcher || m_listDirsWatcher ) );
     if ( TomahawkSettings::instance()->hasScannerPaths() &&
         m_cachedScannerDirs != TomahawkSettings::instance()->scannerPaths() )
     {
         m_cachedScannerDirs = TomahawkSettings::instance()->scannerPaths();
         runNormalScan();
+        updateWatchedDirs();
     }
+    else if ( watchedDirsChanged )
+    {
+        updateWatchedDirs();
+    }
+
+    updateScanTimerInterval();
 
     if ( TomahawkSettings::instance()->watchForChanges() && !m_scanTimer->isActive() )
         m_scanTimer->start();
 }
 
 
+void
+ScanManager::updateScanTimerInterval()
+{
+    if ( m_fsWatcher && m_unwatchedDirs.isEmpty() )
+        m_scanTimer->setInterval( qMax( (uint)CONSISTENCY_SWEEP_INTERVAL, TomahawkSettings::instance()->scannerTime() * 1000 ) );
+    else
+        m_scanTimer->setInterval( TomahawkSettings::instance()->scannerTime() * 1000 );
+}
+
+
+void
+ScanManager::updateWatchedDirs()
+{
+    delete m_fsWatcher;
+    m_fsWatcher = 0;
+    m_unwatchedDirs.clear();
+    m_changedDirs.clear();
+    m_changedDirsTimer->stop();
+
+#ifdef Q_OS_LINUX
+    // QFileSystemWatcher is backed by inotify here. Other backends poll or need a
+    // file descriptor per directory, so they stick to the timer based walk.
+    if ( !TomahawkSettings::instance()->watchForChanges() || !TomahawkSettings::instance()->hasScannerPaths() )
+    {
+        updateScanTimerInterval();
+        return;
+    }
+
+    if ( m_listDirsWatcher )
+    {
+        // still listing the old roots, start over once that is done
+        m_listDirsWatcher->setProperty( "outdated", true );
+        return;
+    }
+
+    m_listDirsWatcher = new QFutureWatcher< QStringList >( this );
+    connect( m_listDirsWatcher, SIGNAL( finished() ), SLOT( onWatchedDirsListed() ) );
+    m_listDirsWatcher->setFuture( QtConcurrent::run( &ScanManager::listDirs, TomahawkSettings::instance()->scannerPaths() ) );
+#else
+    updateScanTimerInterval();
+#endif
+}
+
+
+void
+ScanManager::onWatchedDirsListed()
+{
+    const QStringList dirs = m_listDirsWatcher->result();
+    const bool outdated = m_listDirsWatcher->property( "outdated" ).toBool();
+    m_listDirsWatcher->deleteLater();
+    m_listDirsWatcher = 0;
+
+    if ( outdated )
+    {
+        updateWatchedDirs();
+        return;
+    }
+
+    tDebug() << Q_FUNC_INFO << "Watching" << dirs.count() << "directories for changes";
+    m_fsWatcher = new QFileSystemWatcher( this );
+    connect( m_fsWatcher, SIGNAL( directoryChanged( QString ) ), SLOT( onDirectoryChanged( QString ) ) );
+    if ( !dirs.isEmpty() )
+        watchDirs( dirs );
+
+    updateScanTimerInterval();
+}
+
+
+void
+ScanManager::watchDirs( const QStringList& dirs )
+{
+    const QStringList failed = m_fsWatcher->addPaths( dirs );
+    if ( failed.isEmpty() )
+        return;
+
+    tLog() << Q_FUNC_INFO << "Could not watch" << failed.count() << "directories, rescanning them every"
+           << TomahawkSettings::instance()->scannerTime() << "seconds instead, e.g." << failed.first();
+    m_unwatchedDirs << failed;
+}
+
+
+QStringList
+ScanManager::listDirs( const QStringList& roots )
+{
+    QStringList dirs;
+    foreach ( const QString& root, roots )
+    {
+        QFileInfo fi( root );
+        if ( !fi.isDir() )
+            continue;
+
+        dirs << fi.canonicalFilePath();
+        QDirIterator it( fi.canonicalFilePath(), QDir::Dirs | QDir::Readable | QDir::NoDotAndDotDot, QDirIterator::Subdirectories );
+        while ( it.hasNext() )
+            dirs << QFileInfo( it.next() ).canonicalFilePath();
+    }
+
+    dirs.removeDuplicates();
+    return dirs;
+}
+
+
+void
+ScanManager::onDirectoryChanged( const QString& path )
+{
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << path;
+    m_changedDirs << path;
+    m_changedDirsTimer->start();
+}
+
+
+void
+ScanManager::runChangedDirsScan()
+{
+    if ( !m_fsWatcher || m_changedDirs.isEmpty() )
+        return;
+
+    if ( !Database::instance() || !Database::instance()->isReady() )
+    {
+        m_changedDirsTimer->start();
+        return;
+    }
+
+    const QStringList changedDirs = m_changedDirs.toList();
+    m_changedDirs.clear();
+    QStringList paths = changedDirs;
+
+    // watch and scan directories that were created since we last looked
+    const QSet< QString > watched = m_fsWatcher->directories().toSet();
+    foreach ( const QString& path, changedDirs )
+    {
+        QDir dir( path );
+        foreach ( const QFileInfo& fi, dir.entryInfoList( QDir::Dirs | QDir::Readable | QDir::NoDotAndDotDot ) )
+        {
+            if ( watched.contains( fi.canonicalFilePath() ) )
+                continue;
+
+            const QStringList newDirs = listDirs( QStringList() << fi.canonicalFilePath() );
+            watchDirs( newDirs );
+            paths << newDirs;
+        }
+    }
+    updateScanTimerInterval();
+
+    tDebug() << Q_FUNC_INFO << "Rescanning" << paths.count() << "changed directories";
+    runFileScan( paths );
+}
+
+
 void
 ScanManager::runStartupScan()
 {
@@ -165,8 +342,16 @@ ScanManager::scanTimerTimeout()
          !Database::instance() ||
          ( Database::instance() && !Database::instance()->isReady() ) )
         return;
-    else
-        runNormalScan();
+
+    // only what the watcher couldn't take needs a look until the next consistency sweep
+    if ( m_fsWatcher && !m_unwatchedDirs.isEmpty() &&
+         m_lastNormalScan.isValid() && m_lastNormalScan.elapsed() < CONSISTENCY_SWEEP_INTERVAL )
+    {
+        runFileScan( m_unwatchedDirs );
+        return;
+    }
+
+    runNormalScan();
 }
 
 
@@ -203,6 +388,7 @@ ScanManager::runNormalScan( bool manualFull )
     }
 
     m_scanTimer->stop();
+    m_lastNormalScan.start();
     m_musicScannerThreadController = new MusicScannerThreadController( this );
     m_currScanMode = MusicScanner::DirScan;
 
@@ -322,7 +508,7 @@ ScanManager::scannerFinished()
             QMetaObject::invokeMethod( this, "runNormalScan", Qt::QueuedConnection, Q_ARG( bool, m_queuedScanType == MusicScanner::Full ) );
             break;
         case MusicScanner::File:
-            QMetaObject::invokeMethod( this, "", Qt::QueuedConnection, Q_ARG( QStringList, QStringList() ) );
+            QMetaObject::invokeMethod( this, "runFileScan", Qt::QueuedConnection, Q_ARG( QStringList, QStringList() ) );
             break;
         default:
             break;
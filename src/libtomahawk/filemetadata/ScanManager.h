@@ -25,6 +25,8 @@
 
 #include "MusicScanner.h"
 
+#include <QElapsedTimer>
+#include <QFutureWatcher>
 #include <QHash>
 #include <QMap>
 #include <QObject>
@@ -90,7 +92,16 @@ private slots:
     void fileMtimesCheck( const QMap< QString, QMap< unsigned int, unsigned int > >& mtimes );
     void filesDeleted();
 
+    void updateWatchedDirs();
+    void onWatchedDirsListed();
+    void onDirectoryChanged( const QString& path );
+    void runChangedDirsScan();
+
 private:
+    static QStringList listDirs( const QStringList& roots );
+    void watchDirs( const QStringList& dirs );
+    void updateScanTimerInterval();
+
     static ScanManager* s_instance;
 
     MusicScanner::ScanMode m_currScanMode;
@@ -99,6 +110,18 @@ private:
     QStringList m_cachedScannerDirs;
 
     QTimer* m_scanTimer;
+
+    // change notification: dirs reported by m_fsWatcher are collected until
+    // m_changedDirsTimer fires and then rescanned in FileScan mode
+    QFileSystemWatcher* m_fsWatcher;
+    QFutureWatcher< QStringList >* m_listDirsWatcher;
+    QSet< QString > m_changedDirs;
+    QTimer* m_changedDirsTimer;
+    // dirs m_fsWatcher couldn't take (e.g. out of inotify watches) get
+    // rescanned on m_scanTimer instead, between the consistency sweeps
+    QStringList m_unwatchedDirs;
+    QElapsedTimer m_lastNormalScan;
+
     MusicScanner::ScanType m_queuedScanType;
 
     bool m_updateGUI;
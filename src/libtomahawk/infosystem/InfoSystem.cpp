@@ -340,6 +340,13 @@ InfoSystem::workerThread() const
 }
 
 
+InfoSystemCache*
+InfoSystem::cache() const
+{
+    return m_infoSystemCacheThreadController->cache();
+}
+
+
 InfoSystemCacheThread::InfoSystemCacheThread( QObject* parent )
     : QThread( parent )
 {
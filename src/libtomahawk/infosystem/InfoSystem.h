@@ -201,6 +201,8 @@ public:
     const InfoTypeSet& supportedPushTypes() const { return m_supportedPushTypes; }
 
     QPointer< QThread > workerThread() const;
+    /// Lives in its own thread, only use the thread-safe parts of it
+    InfoSystemCache* cache() const;
 
 public slots:
     void addInfoPlugin( Tomahawk::InfoSystem::InfoPluginPtr plugin );
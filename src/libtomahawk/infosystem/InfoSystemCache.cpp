@@ -21,11 +21,13 @@
 #include <QDesktopServices>
 
 #include "InfoSystemCache.h"
+#include "InfoSystemCacheStore.h"
 #include "TomahawkSettings.h"
 #include "utils/Logger.h"
 #include "Source.h"
 
 #include <QDir>
+#include <QElapsedTimer>
 #include <QSettings>
 #include <QCryptographicHash>
 
@@ -62,124 +64,154 @@ InfoSystemCache::~InfoSystemCache()
 }
 
 
+InfoSystemCache::Statistics
+InfoSystemCache::statistics() const
+{
+    QMutexLocker lock( &m_statisticsMutex );
+    return m_statistics;
+}
+
+
 void
-InfoSystemCache::pruneTimerFired()
+InfoSystemCache::updateStatistics( bool hit, qint64 lookupUs )
 {
-    qDebug() << Q_FUNC_INFO << "Pruning infosystemcache";
-    qlonglong currentMSecsSinceEpoch = QDateTime::currentMSecsSinceEpoch();
+    QMutexLocker lock( &m_statisticsMutex );
+    if ( hit )
+        m_statistics.hits++;
+    else
+        m_statistics.misses++;
 
-    for ( int i = InfoNoInfo; i <= InfoLastInfo; i++ )
+    m_statistics.totalLookupUs += lookupUs;
+    m_statistics.maxLookupUs = qMax( m_statistics.maxLookupUs, lookupUs );
+
+    if ( m_store )
     {
-        InfoType type = (InfoType)(i);
-        QHash< QString, QString > fileLocationHash = m_fileLocationCache[type];
-        const QString cacheDirName = m_cacheBaseDir + QString::number( (int)type );
-        QFileInfoList fileList = QDir( cacheDirName ).entryInfoList( QDir::Files | QDir::NoDotAndDotDot );
-        foreach ( QFileInfo file, fileList )
-        {
-            QString baseName = file.baseName();
-            if ( file.suffix().toLongLong() < currentMSecsSinceEpoch )
-            {
-                if ( !QFile::remove( file.canonicalFilePath() ) )
-                    tLog() << "Failed to remove stale cache file" << file.canonicalFilePath();
-                else
-                    qDebug() << "Removed stale cache file" << file.canonicalFilePath();
-            }
-            if ( fileLocationHash.contains( baseName ) )
-                fileLocationHash.remove( baseName );
-        }
-        m_fileLocationCache[type] = fileLocationHash;
+        m_statistics.entries = m_store->count();
+        m_statistics.storeSize = m_store->size();
+        m_statistics.deadSize = m_store->deadSize();
     }
 }
 
 
-void
-InfoSystemCache::getCachedInfoSlot( Tomahawk::InfoSystem::InfoStringHash criteria, qint64 newMaxAge, Tomahawk::InfoSystem::InfoRequestData requestData )
+InfoSystemCacheStore*
+InfoSystemCache::store()
 {
-    QObject* sendingObj = sender();
-    const QString criteriaHashVal = criteriaMd5( criteria );
-    const QString criteriaHashValWithType = criteriaMd5( criteria, requestData.type );
-    QHash< QString, QString > fileLocationHash = m_fileLocationCache[ requestData.type ];
-    if ( !fileLocationHash.contains( criteriaHashVal ) )
+    if ( !m_store )
     {
-        if ( !fileLocationHash.isEmpty() )
-        {
-            //We already know of some values, so no need to re-read the directory again as it's already happened
-            //qDebug() << Q_FUNC_INFO << "notInCache -- filelocationhash empty";
-            notInCache( sendingObj, criteria, requestData );
-            return;
-        }
+        m_store.reset( new InfoSystemCacheStore( m_cacheBaseDir ) );
+        if ( m_store->isNew() )
+            migrateFileCache();
+    }
+
+    return m_store.data();
+}
 
-        const QString cacheDir = m_cacheBaseDir + QString::number( (int)requestData.type );
-        QDir dir( cacheDir );
+
+void
+InfoSystemCache::migrateFileCache()
+{
+    // Up to version 4 every entry was an INI file named <criteria md5>.<expiry> in a directory per InfoType
+    const qlonglong currentMSecsSinceEpoch = QDateTime::currentMSecsSinceEpoch();
+    int migrated = 0;
+
+    for ( int i = InfoNoInfo; i <= InfoLastInfo; i++ )
+    {
+        const QString cacheDirName = m_cacheBaseDir + QString::number( i );
+        QDir dir( cacheDirName );
         if ( !dir.exists() )
-        {
-            //Dir doesn't exist so clearly not in cache
-            //qDebug() << Q_FUNC_INFO << "notInCache -- dir doesn't exist";
-            notInCache( sendingObj, criteria, requestData );
-            return;
-        }
+            continue;
 
-        QFileInfoList fileList = dir.entryInfoList( QDir::Files | QDir::NoDotAndDotDot );
-        foreach ( QFileInfo file, fileList )
+        foreach ( const QFileInfo& file, dir.entryInfoList( QDir::Files | QDir::NoDotAndDotDot ) )
         {
-            QString baseName = file.baseName();
-            fileLocationHash[ baseName ] = file.canonicalFilePath();
-        }
+            const qlonglong expiry = file.suffix().toLongLong();
+            if ( expiry < currentMSecsSinceEpoch )
+                continue;
 
-        //Store what we've loaded up
-        m_fileLocationCache[ requestData.type ] = fileLocationHash;
-        if ( !fileLocationHash.contains( criteriaHashVal ) )
-        {
-            //Still didn't find it? It's really not in the cache then
-            //qDebug() << Q_FUNC_INFO << "notInCache -- filelocationhash doesn't contain criteria val";
-            notInCache( sendingObj, criteria, requestData );
-            return;
+            const QByteArray key = QByteArray::fromHex( file.baseName().toLatin1() );
+            if ( key.size() != 16 )
+                continue;
+
+            QSettings cachedSettings( file.filePath(), QSettings::IniFormat );
+            m_store->put( i, key, cachedSettings.value( "data" ), expiry );
+            migrated++;
         }
+
+        TomahawkUtils::removeDirectory( cacheDirName );
     }
 
-    QFileInfo file( fileLocationHash[ criteriaHashVal ] );
-    qlonglong currMaxAge = file.suffix().toLongLong();
+    if ( migrated )
+    {
+        tLog() << Q_FUNC_INFO << "Migrated" << migrated << "cache files";
+        m_store->prune( currentMSecsSinceEpoch );
+    }
+}
 
-    if ( currMaxAge < QDateTime::currentMSecsSinceEpoch() )
+
+void
+InfoSystemCache::pruneTimerFired()
+{
+    qDebug() << Q_FUNC_INFO << "Pruning infosystemcache";
+    store()->prune( QDateTime::currentMSecsSinceEpoch() );
+
+    const Statistics stats = statistics();
+    tDebug() << Q_FUNC_INFO << "Cache entries:" << store()->count() << "hits:" << stats.hits << "misses:" << stats.misses
+             << "avg lookup:" << stats.averageLookupUs() << "us max:" << stats.maxLookupUs << "us";
+}
+
+
+void
+InfoSystemCache::getCachedInfoSlot( Tomahawk::InfoSystem::InfoStringHash criteria, qint64 newMaxAge, Tomahawk::InfoSystem::InfoRequestData requestData )
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QObject* sendingObj = sender();
+    const QByteArray key = QByteArray::fromHex( criteriaMd5( criteria ).toLatin1() );
+    const QString criteriaHashValWithType = criteriaMd5( criteria, requestData.type );
+
+    const qint64 currMaxAge = store()->expiry( requestData.type, key );
+    if ( currMaxAge < 0 )
     {
-        if ( !QFile::remove( file.canonicalFilePath() ) )
-            tLog() << "Failed to remove stale cache file" << file.canonicalFilePath();
-        else
-            qDebug() << "Removed stale cache file" << file.canonicalFilePath();
+        //qDebug() << Q_FUNC_INFO << "notInCache -- unknown criteria";
+        updateStatistics( false, timer.nsecsElapsed() / 1000 );
+        notInCache( sendingObj, criteria, requestData );
+        return;
+    }
 
-        fileLocationHash.remove( criteriaHashVal );
-        m_fileLocationCache[ requestData.type ] = fileLocationHash;
+    if ( currMaxAge < QDateTime::currentMSecsSinceEpoch() )
+    {
+        store()->remove( requestData.type, key );
         m_dataCache.remove( criteriaHashValWithType );
 
-        qDebug() << Q_FUNC_INFO << "notInCache -- file was stale";
+        qDebug() << Q_FUNC_INFO << "notInCache -- entry was stale";
+        updateStatistics( false, timer.nsecsElapsed() / 1000 );
         notInCache( sendingObj, criteria, requestData );
         return;
     }
     else if ( newMaxAge > 0 )
     {
-        const QString newFilePath = QString( file.dir().canonicalPath() + '/' + criteriaHashVal + '.' + QString::number( QDateTime::currentMSecsSinceEpoch() + newMaxAge ) );
+        store()->touch( requestData.type, key, QDateTime::currentMSecsSinceEpoch() + newMaxAge );
+    }
 
-        if ( !QFile::rename( file.canonicalFilePath(), newFilePath ) )
+    if ( !m_dataCache.contains( criteriaHashValWithType ) )
+    {
+        QVariant output;
+        if ( !store()->value( requestData.type, key, output ) )
         {
-            qDebug() << Q_FUNC_INFO << "notInCache -- failed to move old cache file to new location";
+            tLog() << Q_FUNC_INFO << "notInCache -- failed to read cached value";
+            updateStatistics( false, timer.nsecsElapsed() / 1000 );
             notInCache( sendingObj, criteria, requestData );
             return;
         }
 
-        fileLocationHash[ criteriaHashVal ] = newFilePath;
-        m_fileLocationCache[ requestData.type ] = fileLocationHash;
-    }
-
-    if ( !m_dataCache.contains( criteriaHashValWithType ) )
-    {
-        QSettings cachedSettings( fileLocationHash[ criteriaHashVal ], QSettings::IniFormat );
-        QVariant output = cachedSettings.value( "data" );
         m_dataCache.insert( criteriaHashValWithType, new QVariant( output ) );
 
+        updateStatistics( true, timer.nsecsElapsed() / 1000 );
         emit info( requestData, output );
     }
     else
     {
+        updateStatistics( true, timer.nsecsElapsed() / 1000 );
         emit info( requestData, QVariant( *( m_dataCache[ criteriaHashValWithType ] ) ) );
     }
 }
@@ -195,51 +227,10 @@ InfoSystemCache::notInCache( QObject *receiver, Tomahawk::InfoSystem::InfoString
 void
 InfoSystemCache::updateCacheSlot( Tomahawk::InfoSystem::InfoStringHash criteria, qint64 maxAge, Tomahawk::InfoSystem::InfoType type, QVariant output )
 {
-    const QString criteriaHashVal = criteriaMd5( criteria );
+    const QByteArray key = QByteArray::fromHex( criteriaMd5( criteria ).toLatin1() );
     const QString criteriaHashValWithType = criteriaMd5( criteria, type );
-    const QString cacheDir = m_cacheBaseDir + QString::number( (int)type );
-    const QString settingsFilePath( cacheDir + '/' + criteriaHashVal + '.' + QString::number( QDateTime::currentMSecsSinceEpoch() + maxAge ) );
-
-    QHash< QString, QString > fileLocationHash = m_fileLocationCache[ type ];
-    if ( fileLocationHash.contains( criteriaHashVal ) )
-    {
-        if ( !QFile::rename( fileLocationHash[ criteriaHashVal ], settingsFilePath ) )
-        {
-            tLog() << "Failed to move old cache file to new location!";
-            return;
-        }
-        fileLocationHash[ criteriaHashVal ] = settingsFilePath;
-        m_fileLocationCache[ type ] = fileLocationHash;
-
-        QSettings cachedSettings( fileLocationHash[ criteriaHashVal ], QSettings::IniFormat );
-        cachedSettings.setValue( "data", output );
-
-        m_dataCache.insert( criteriaHashValWithType, new QVariant( output ) );
-
-        return;
-    }
 
-    QDir dir( cacheDir );
-    if( !dir.exists( cacheDir ) )
-    {
-        qDebug() << "Creating cache directory" << cacheDir;
-        if( !dir.mkpath( cacheDir ) )
-        {
-            tLog() << "Failed to create cache dir! Bailing...";
-            return;
-        }
-    }
-
-    QSettings cachedSettings( settingsFilePath, QSettings::IniFormat );
-    QStringList keys = criteria.keys();
-    cachedSettings.beginGroup( "criteria" );
-    for( int i = 0; i < criteria.size(); i++ )
-        cachedSettings.setValue( keys.at( i ), criteria[keys.at( i )] );
-    cachedSettings.endGroup();
-    cachedSettings.setValue( "data", output );
-
-    fileLocationHash[criteriaHashVal] = settingsFilePath;
-    m_fileLocationCache[type] = fileLocationHash;
+    store()->put( type, key, output, QDateTime::currentMSecsSinceEpoch() + maxAge );
     m_dataCache.insert( criteriaHashValWithType, new QVariant( output ) );
 }
 
@@ -22,7 +22,9 @@
 
 #include <QCache>
 #include <QDateTime>
+#include <QMutex>
 #include <QObject>
+#include <QScopedPointer>
 #include <QtDebug>
 #include <QTimer>
 
@@ -34,15 +36,35 @@ namespace Tomahawk
 namespace InfoSystem
 {
 
+class InfoSystemCacheStore;
+
 class DLLEXPORT InfoSystemCache : public QObject
 {
 Q_OBJECT
 
 public:
+    struct Statistics
+    {
+        Statistics() : hits( 0 ), misses( 0 ), totalLookupUs( 0 ), maxLookupUs( 0 ), entries( 0 ), storeSize( 0 ), deadSize( 0 ) {}
+
+        quint64 hits;
+        quint64 misses;
+        quint64 totalLookupUs;
+        qint64 maxLookupUs;
+        int entries;
+        qint64 storeSize;
+        qint64 deadSize;
+
+        qint64 averageLookupUs() const { return ( hits + misses ) ? totalLookupUs / ( hits + misses ) : 0; }
+    };
+
     InfoSystemCache( QObject *parent = 0 );
 
     virtual ~InfoSystemCache();
 
+    /// Can be called from any thread
+    Statistics statistics() const;
+
 signals:
     void info( Tomahawk::InfoSystem::InfoRequestData requestData, QVariant output );
 
@@ -64,10 +86,18 @@ private:
     void notInCache( QObject *receiver, Tomahawk::InfoSystem::InfoStringHash criteria, Tomahawk::InfoSystem::InfoRequestData requestData );
     const QString criteriaMd5( const Tomahawk::InfoSystem::InfoStringHash &criteria, Tomahawk::InfoSystem::InfoType type = Tomahawk::InfoSystem::InfoNoInfo ) const;
 
+    /// Opens the store on first use and migrates the old file-per-entry cache into it
+    InfoSystemCacheStore* store();
+    void migrateFileCache();
+    void updateStatistics( bool hit, qint64 lookupUs );
+
     QString m_cacheBaseDir;
-    QHash< InfoType, QHash< QString, QString > > m_fileLocationCache;
+    QScopedPointer< InfoSystemCacheStore > m_store;
     QTimer m_pruneTimer;
     QCache< QString, QVariant > m_dataCache;
+
+    mutable QMutex m_statisticsMutex;
+    Statistics m_statistics;
 };
 
 } //namespace InfoSystem
@@ -0,0 +1,529 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "InfoSystemCacheStore.h"
+
+#include "utils/Logger.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QSaveFile>
+
+// don't bother compacting less than this many dead bytes
+#define COMPACT_MIN_DEAD_SIZE ( 4 * 1024 * 1024 )
+
+namespace Tomahawk
+{
+
+namespace InfoSystem
+{
+
+InfoSystemCacheStore::InfoSystemCacheStore( const QString& directory )
+    : m_map( 0 )
+    , m_mapSize( 0 )
+    , m_size( 0 )
+    , m_liveSize( 0 )
+    , m_dirty( false )
+    , m_isNew( false )
+{
+    QDir().mkpath( directory );
+    m_file.setFileName( directory + "/store.dat" );
+    m_indexPath = directory + "/store.idx";
+
+    open();
+}
+
+
+InfoSystemCacheStore::~InfoSystemCacheStore()
+{
+    if ( m_dirty )
+        saveIndex();
+
+    unmap();
+}
+
+
+QByteArray
+InfoSystemCacheStore::storeKey( int type, const QByteArray& key )
+{
+    QByteArray k;
+    k.reserve( 4 + key.size() );
+    QDataStream stream( &k, QIODevice::WriteOnly );
+    stream << (qint32)type;
+    stream.writeRawData( key.constData(), key.size() );
+    return k;
+}
+
+
+void
+InfoSystemCacheStore::open()
+{
+    m_isNew = !m_file.exists();
+    if ( !m_file.open( QIODevice::ReadWrite ) )
+    {
+        tLog() << Q_FUNC_INFO << "Could not open cache store" << m_file.fileName() << m_file.errorString();
+        return;
+    }
+
+    m_size = m_file.size();
+    if ( m_size >= HeaderSize )
+    {
+        QDataStream stream( &m_file );
+        quint32 magic, version;
+        stream >> magic >> version;
+        if ( magic != FileMagic || version != FormatVersion )
+        {
+            tLog() << Q_FUNC_INFO << "Discarding cache store with unknown format" << magic << version;
+            m_size = 0;
+        }
+    }
+
+    if ( m_size < HeaderSize )
+    {
+        m_file.resize( 0 );
+        m_file.seek( 0 );
+        QDataStream stream( &m_file );
+        stream << FileMagic << FormatVersion;
+        m_file.flush();
+        m_size = HeaderSize;
+        QFile::remove( m_indexPath );
+    }
+
+    qint64 replayFrom = HeaderSize;
+    if ( loadIndex() )
+        replayFrom = m_size;
+
+    m_size = m_file.size();
+    const qint64 end = replay( replayFrom );
+    if ( end < m_size )
+    {
+        tLog() << Q_FUNC_INFO << "Dropping" << m_size - end << "bytes of incomplete records from cache store";
+        unmap();
+        m_file.resize( end );
+        m_size = end;
+        m_dirty = true;
+    }
+
+    tDebug() << Q_FUNC_INFO << "Loaded" << m_entries.count() << "cache entries," << m_size << "bytes," << deadSize() << "of them dead";
+}
+
+
+bool
+InfoSystemCacheStore::loadIndex()
+{
+    QFile indexFile( m_indexPath );
+    if ( !indexFile.open( QIODevice::ReadOnly ) )
+        return false;
+
+    // one read for the whole index, parsing happens in memory
+    const QByteArray index = indexFile.readAll();
+    QDataStream stream( index );
+
+    quint32 magic, version, count;
+    qint64 coveredSize;
+    stream >> magic >> version >> coveredSize >> count;
+    if ( stream.status() != QDataStream::Ok || magic != IndexMagic || version != FormatVersion || coveredSize > m_file.size() )
+        return false;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    char key[ KeySize ];
+    for ( quint32 i = 0; i < count; i++ )
+    {
+        qint32 type;
+        Entry entry;
+        stream >> type;
+        stream.readRawData( key, KeySize );
+        stream >> entry.expiry >> entry.offset >> entry.size;
+        if ( stream.status() != QDataStream::Ok )
+        {
+            m_entries.clear();
+            m_expiries.clear();
+            m_liveSize = 0;
+            return false;
+        }
+
+        if ( entry.expiry >= now )
+            setEntry( storeKey( type, QByteArray( key, KeySize ) ), entry );
+    }
+
+    m_size = coveredSize;
+    return true;
+}
+
+
+qint64
+InfoSystemCacheStore::replay( qint64 from )
+{
+    qint64 pos = from;
+    char key[ KeySize ];
+    while ( pos + RecordHeaderSize <= m_size )
+    {
+        const uchar* header = data( pos, RecordHeaderSize );
+        if ( !header )
+            break;
+
+        QDataStream stream( QByteArray::fromRawData( (const char*)header, RecordHeaderSize ) );
+        quint32 magic, size;
+        quint8 op;
+        qint32 type;
+        qint64 expiry;
+        stream >> magic >> op >> type;
+        stream.readRawData( key, KeySize );
+        stream >> expiry >> size;
+
+        if ( magic != RecordMagic || pos + RecordHeaderSize + size > m_size )
+            break;
+
+        const QByteArray k = storeKey( type, QByteArray( key, KeySize ) );
+        switch ( op )
+        {
+            case Put:
+            {
+                Entry entry;
+                entry.expiry = expiry;
+                entry.offset = pos + RecordHeaderSize;
+                entry.size = size;
+                setEntry( k, entry );
+                break;
+            }
+            case Touch:
+                if ( m_entries.contains( k ) )
+                {
+                    Entry entry = m_entries.value( k );
+                    entry.expiry = expiry;
+                    setEntry( k, entry );
+                }
+                break;
+            case Remove:
+                removeEntry( k );
+                break;
+        }
+
+        pos += RecordHeaderSize + size;
+        m_dirty = true;
+    }
+
+    return pos;
+}
+
+
+void
+InfoSystemCacheStore::saveIndex()
+{
+    if ( !m_file.isOpen() )
+        return;
+
+    m_file.flush();
+
+    QByteArray index;
+    index.reserve( 24 + m_entries.count() * ( 4 + KeySize + 20 ) );
+    QDataStream stream( &index, QIODevice::WriteOnly );
+    stream << IndexMagic << FormatVersion << m_size << (quint32)m_entries.count();
+
+    QHash< QByteArray, Entry >::const_iterator it = m_entries.constBegin();
+    for ( ; it != m_entries.constEnd(); ++it )
+    {
+        stream.writeRawData( it.key().constData(), it.key().size() );
+        stream << it.value().expiry << it.value().offset << it.value().size;
+    }
+
+    QSaveFile indexFile( m_indexPath );
+    if ( !indexFile.open( QIODevice::WriteOnly ) || indexFile.write( index ) != index.size() || !indexFile.commit() )
+    {
+        tLog() << Q_FUNC_INFO << "Failed to write cache index" << m_indexPath << indexFile.errorString();
+        return;
+    }
+
+    m_dirty = false;
+}
+
+
+void
+InfoSystemCacheStore::compact()
+{
+    tDebug() << Q_FUNC_INFO << "Compacting cache store," << deadSize() << "of" << m_size << "bytes are dead";
+
+    // only replaces the store once everything got written, until then the old one stays as it is
+    QSaveFile compacted( m_file.fileName() );
+    if ( !compacted.open( QIODevice::WriteOnly ) )
+    {
+        tLog() << Q_FUNC_INFO << "Could not create" << compacted.fileName() << compacted.errorString();
+        return;
+    }
+
+    QByteArray header;
+    QDataStream( &header, QIODevice::WriteOnly ) << FileMagic << FormatVersion;
+    compacted.write( header );
+
+    QHash< QByteArray, Entry > entries;
+    qint64 pos = HeaderSize;
+    QHash< QByteArray, Entry >::const_iterator it = m_entries.constBegin();
+    for ( ; it != m_entries.constEnd(); ++it )
+    {
+        const qint64 recordOffset = it.value().offset - RecordHeaderSize;
+        const qint64 recordSize = RecordHeaderSize + it.value().size;
+        const uchar* record = data( recordOffset, recordSize );
+        if ( !record )
+            continue;
+
+        // the expiry in the copied record might be outdated by touch records,
+        // so write a fresh header and only copy the payload
+        QByteArray recordHeader;
+        QDataStream stream( &recordHeader, QIODevice::WriteOnly );
+        stream << RecordMagic << (quint8)Put;
+        stream.writeRawData( it.key().constData(), it.key().size() );
+        stream << it.value().expiry << it.value().size;
+
+        if ( compacted.write( recordHeader ) != RecordHeaderSize ||
+             compacted.write( (const char*)record + RecordHeaderSize, it.value().size ) != it.value().size )
+        {
+            tLog() << Q_FUNC_INFO << "Failed to write" << compacted.fileName() << compacted.errorString();
+            compacted.cancelWriting();
+            return;
+        }
+
+        Entry entry = it.value();
+        entry.offset = pos + RecordHeaderSize;
+        entries.insert( it.key(), entry );
+        pos += recordSize;
+    }
+
+    // some platforms can't replace a file that is still open
+    unmap();
+    m_file.close();
+    if ( compacted.commit() )
+    {
+        // records that couldn't be copied are gone, so everything else is recounted from what made it
+        m_entries.clear();
+        m_expiries.clear();
+        m_liveSize = 0;
+        QHash< QByteArray, Entry >::const_iterator eit = entries.constBegin();
+        for ( ; eit != entries.constEnd(); ++eit )
+            setEntry( eit.key(), eit.value() );
+
+        m_size = pos;
+        m_dirty = true;
+    }
+    else
+        tLog() << Q_FUNC_INFO << "Failed to replace cache store, keeping the old one" << compacted.errorString();
+
+    if ( !m_file.open( QIODevice::ReadWrite ) )
+    {
+        tLog() << Q_FUNC_INFO << "Could not reopen cache store" << m_file.errorString();
+        m_entries.clear();
+        m_expiries.clear();
+        m_liveSize = 0;
+    }
+}
+
+
+void
+InfoSystemCacheStore::append( Operation op, const QByteArray& storeKey, qint64 expiry, const QByteArray& payload )
+{
+    QByteArray record;
+    record.reserve( RecordHeaderSize + payload.size() );
+    QDataStream stream( &record, QIODevice::WriteOnly );
+    stream << RecordMagic << (quint8)op;
+    stream.writeRawData( storeKey.constData(), storeKey.size() );
+    stream << expiry << (quint32)payload.size();
+    record.append( payload );
+
+    m_file.seek( m_size );
+    if ( m_file.write( record ) != record.size() )
+    {
+        tLog() << Q_FUNC_INFO << "Failed to write to cache store" << m_file.errorString();
+        m_file.resize( m_size );
+        return;
+    }
+
+    m_size += record.size();
+    m_dirty = true;
+}
+
+
+const uchar*
+InfoSystemCacheStore::data( qint64 offset, qint64 size )
+{
+    if ( offset + size > m_mapSize )
+    {
+        // the file grew since we mapped it
+        unmap();
+        m_file.flush();
+        m_map = m_file.map( 0, m_size );
+        if ( !m_map )
+        {
+            tLog() << Q_FUNC_INFO << "Could not map cache store" << m_file.errorString();
+            return 0;
+        }
+        m_mapSize = m_size;
+    }
+
+    if ( offset + size > m_mapSize )
+        return 0;
+
+    return m_map + offset;
+}
+
+
+void
+InfoSystemCacheStore::unmap()
+{
+    if ( m_map )
+        m_file.unmap( m_map );
+
+    m_map = 0;
+    m_mapSize = 0;
+}
+
+
+void
+InfoSystemCacheStore::setEntry( const QByteArray& storeKey, const Entry& entry )
+{
+    removeEntry( storeKey );
+
+    m_entries.insert( storeKey, entry );
+    m_expiries.insert( entry.expiry, storeKey );
+    m_liveSize += RecordHeaderSize + entry.size;
+}
+
+
+void
+InfoSystemCacheStore::removeEntry( const QByteArray& storeKey )
+{
+    QHash< QByteArray, Entry >::iterator it = m_entries.find( storeKey );
+    if ( it == m_entries.end() )
+        return;
+
+    m_expiries.remove( it.value().expiry, storeKey );
+    m_liveSize -= RecordHeaderSize + it.value().size;
+    m_entries.erase( it );
+}
+
+
+qint64
+InfoSystemCacheStore::expiry( int type, const QByteArray& key ) const
+{
+    QHash< QByteArray, Entry >::const_iterator it = m_entries.constFind( storeKey( type, key ) );
+    if ( it == m_entries.constEnd() )
+        return -1;
+
+    return it.value().expiry;
+}
+
+
+bool
+InfoSystemCacheStore::value( int type, const QByteArray& key, QVariant& value )
+{
+    QHash< QByteArray, Entry >::const_iterator it = m_entries.constFind( storeKey( type, key ) );
+    if ( it == m_entries.constEnd() )
+        return false;
+
+    const uchar* payload = data( it.value().offset, it.value().size );
+    if ( !payload )
+        return false;
+
+    QDataStream stream( QByteArray::fromRawData( (const char*)payload, it.value().size ) );
+    stream.setVersion( QDataStream::Qt_5_0 );
+    stream >> value;
+
+    return stream.status() == QDataStream::Ok;
+}
+
+
+void
+InfoSystemCacheStore::put( int type, const QByteArray& key, const QVariant& value, qint64 expiry )
+{
+    QByteArray payload;
+    QDataStream stream( &payload, QIODevice::WriteOnly );
+    stream.setVersion( QDataStream::Qt_5_0 );
+    stream << value;
+
+    const QByteArray k = storeKey( type, key );
+    const qint64 recordOffset = m_size;
+    append( Put, k, expiry, payload );
+    if ( m_size == recordOffset )
+        return;
+
+    Entry entry;
+    entry.expiry = expiry;
+    entry.offset = recordOffset + RecordHeaderSize;
+    entry.size = payload.size();
+    setEntry( k, entry );
+}
+
+
+bool
+InfoSystemCacheStore::touch( int type, const QByteArray& key, qint64 expiry )
+{
+    const QByteArray k = storeKey( type, key );
+    if ( !m_entries.contains( k ) )
+        return false;
+
+    append( Touch, k, expiry );
+
+    Entry entry = m_entries.value( k );
+    entry.expiry = expiry;
+    setEntry( k, entry );
+
+    return true;
+}
+
+
+void
+InfoSystemCacheStore::remove( int type, const QByteArray& key )
+{
+    const QByteArray k = storeKey( type, key );
+    if ( !m_entries.contains( k ) )
+        return;
+
+    append( Remove, k, 0 );
+    removeEntry( k );
+}
+
+
+void
+InfoSystemCacheStore::prune( qint64 now )
+{
+    // expired entries are simply forgotten, loading the index or replaying skips them too
+    int pruned = 0;
+    while ( !m_expiries.isEmpty() && m_expiries.constBegin().key() < now )
+    {
+        // erase the node here, so one without an entry can't keep us looping
+        const QByteArray storeKey = m_expiries.constBegin().value();
+        m_expiries.erase( m_expiries.begin() );
+        removeEntry( storeKey );
+        pruned++;
+    }
+
+    if ( pruned )
+    {
+        tDebug() << Q_FUNC_INFO << "Pruned" << pruned << "stale cache entries";
+        m_dirty = true;
+    }
+
+    if ( deadSize() > COMPACT_MIN_DEAD_SIZE && deadSize() > m_liveSize )
+        compact();
+
+    if ( m_dirty )
+        saveIndex();
+}
+
+} //namespace InfoSystem
+
+} //namespace Tomahawk
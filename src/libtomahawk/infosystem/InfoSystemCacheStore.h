@@ -0,0 +1,128 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_INFOSYSTEMCACHESTORE_H
+#define TOMAHAWK_INFOSYSTEMCACHESTORE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QMultiMap>
+#include <QString>
+#include <QVariant>
+
+#include "DllMacro.h"
+
+namespace Tomahawk
+{
+
+namespace InfoSystem
+{
+
+/**
+ * Key/value store backing the InfoSystemCache.
+ *
+ * All values live in a single append-only data file that is memory-mapped for
+ * reading. Every put, touch or remove appends a record, so the data file is
+ * also its own journal. The location of the live records is kept in memory and
+ * saved to a compact index file on prune() and on destruction; on startup the
+ * index is loaded and only records appended after it was written are replayed.
+ * Values are not decoded before they are asked for.
+ *
+ * Expiry times are kept ordered so prune() only looks at entries that actually
+ * expired. Once more than half of the data file is dead records it is compacted.
+ *
+ * Keys are the raw md5 of the request criteria, scoped by info type. Not thread-safe.
+ */
+class DLLEXPORT InfoSystemCacheStore
+{
+public:
+    explicit InfoSystemCacheStore( const QString& directory );
+    ~InfoSystemCacheStore();
+
+    /// Expiry time of @p key in msecs since epoch, or -1 if it is unknown
+    qint64 expiry( int type, const QByteArray& key ) const;
+    bool value( int type, const QByteArray& key, QVariant& value );
+
+    void put( int type, const QByteArray& key, const QVariant& value, qint64 expiry );
+    bool touch( int type, const QByteArray& key, qint64 expiry );
+    void remove( int type, const QByteArray& key );
+
+    /// Drops everything that expired before @p now, compacts the data file if worthwhile and saves the index
+    void prune( qint64 now );
+
+    int count() const { return m_entries.count(); }
+    qint64 size() const { return m_size; }
+    qint64 deadSize() const { return m_size - HeaderSize - m_liveSize; }
+
+    /// True if the store did not exist before, i.e. there might be something to migrate
+    bool isNew() const { return m_isNew; }
+
+private:
+    enum Operation { Put = 1, Touch = 2, Remove = 3 };
+
+    struct Entry
+    {
+        Entry() : expiry( 0 ), offset( 0 ), size( 0 ) {}
+
+        qint64 expiry;
+        qint64 offset; // of the payload
+        quint32 size;  // of the payload
+    };
+
+    static const quint32 FileMagic = 0x54494353; // "TICS"
+    static const quint32 RecordMagic = 0x54494352; // "TICR"
+    static const quint32 IndexMagic = 0x54494349; // "TICI"
+    static const quint32 FormatVersion = 1;
+    static const qint64 HeaderSize = 8;
+    static const qint64 RecordHeaderSize = 37;
+    static const int KeySize = 16;
+
+    static QByteArray storeKey( int type, const QByteArray& key );
+
+    void open();
+    bool loadIndex();
+    qint64 replay( qint64 from );
+    void saveIndex();
+    void compact();
+
+    void append( Operation op, const QByteArray& storeKey, qint64 expiry, const QByteArray& payload = QByteArray() );
+    const uchar* data( qint64 offset, qint64 size );
+    void unmap();
+
+    void setEntry( const QByteArray& storeKey, const Entry& entry );
+    void removeEntry( const QByteArray& storeKey );
+
+    QString m_indexPath;
+    QFile m_file;
+    uchar* m_map;
+    qint64 m_mapSize;
+    qint64 m_size;
+    qint64 m_liveSize;
+    bool m_dirty;
+    bool m_isNew;
+
+    QHash< QByteArray, Entry > m_entries;
+    QMultiMap< qint64, QByteArray > m_expiries;
+};
+
+} //namespace InfoSystem
+
+} //namespace Tomahawk
+
+#endif //TOMAHAWK_INFOSYSTEMCACHESTORE_H
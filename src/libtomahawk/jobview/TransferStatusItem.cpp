@@ -77,7 +77,11 @@ TransferStatusItem::rightColumnText() const
     if ( m_stream.isNull() )
         return QString();
 
-    return QString( "%1 kB/s" ).arg( m_stream.data()->transferRate() / 1000 );
+    const StreamConnection* sc = m_stream.data();
+    return tr( "%1 kB/s (avg. %2 kB/s, %3 MB)" )
+              .arg( sc->transferRate() / 1000 )
+              .arg( sc->averageRate() / 1000 )
+              .arg( sc->bytesTransferred() / 1000000.0, 0, 'f', 1 );
 }
 
 void
@@ -0,0 +1,216 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BandwidthManager.h"
+
+#include "utils/Logger.h"
+
+#include "BufferIoDevice.h"
+#include "Msg.h"
+#include "StreamConnection.h"
+#include "TomahawkSettings.h"
+
+// the bucket holds at most this much of a second's worth of tokens
+#define BURST_DIVISOR 10
+#define NSECS_PER_SEC 1000000000.0
+
+
+BandwidthManager::BandwidthManager( QObject* parent )
+    : QObject( parent )
+    , m_rateLimit( 0 )
+    , m_tokens( 0 )
+    , m_refilledNs( 0 )
+    , m_scheduling( false )
+{
+    m_refillTimer.setSingleShot( true );
+    connect( &m_refillTimer, SIGNAL( timeout() ), SLOT( schedule() ) );
+
+    connect( TomahawkSettings::instance(), SIGNAL( changed() ), SLOT( onSettingsChanged() ) );
+    onSettingsChanged();
+}
+
+
+BandwidthManager::~BandwidthManager()
+{
+}
+
+
+void
+BandwidthManager::onSettingsChanged()
+{
+    setRateLimit( (qint64)TomahawkSettings::instance()->uploadLimit() * 1024 );
+}
+
+
+void
+BandwidthManager::setRateLimit( qint64 bytesPerSecond )
+{
+    if ( bytesPerSecond == m_rateLimit )
+        return;
+
+    tDebug() << Q_FUNC_INFO << "Upload limit:" << bytesPerSecond << "bytes/sec";
+    m_rateLimit = bytesPerSecond;
+    m_tokens = 0;
+    m_clock.restart();
+    m_refilledNs = 0;
+
+    schedule();
+}
+
+
+void
+BandwidthManager::addStream( StreamConnection* sc )
+{
+    ControlConnection* peer = sc->controlConnection();
+    if ( !m_streams.contains( peer ) )
+        m_peers << peer;
+
+    m_streams[ peer ] << sc;
+}
+
+
+void
+BandwidthManager::removeStream( StreamConnection* sc )
+{
+    m_priority.removeAll( sc );
+
+    QHash< ControlConnection*, QList< StreamConnection* > >::iterator it = m_streams.begin();
+    while ( it != m_streams.end() )
+    {
+        it.value().removeAll( sc );
+        if ( it.value().isEmpty() )
+        {
+            m_peers.removeAll( it.key() );
+            it = m_streams.erase( it );
+        }
+        else
+            ++it;
+    }
+}
+
+
+void
+BandwidthManager::prioritize( StreamConnection* sc )
+{
+    if ( !m_priority.contains( sc ) )
+        m_priority << sc;
+}
+
+
+void
+BandwidthManager::refill()
+{
+    if ( !m_rateLimit )
+        return;
+
+    const qint64 burst = qMax( m_rateLimit / BURST_DIVISOR, (qint64)( BufferIODevice::blockSize() + Msg::headerSize() ) * 4 );
+
+    // only the time that whole tokens were made of is used up, the rest carries over to the
+    // next refill. Otherwise low limits would lose a good part of their rate to rounding.
+    const qint64 elapsed = m_clock.nsecsElapsed() - m_refilledNs;
+    const qint64 tokens = (qint64)( (double)elapsed * m_rateLimit / NSECS_PER_SEC );
+    if ( m_tokens + tokens >= burst )
+    {
+        m_tokens = burst;
+        m_clock.restart();
+        m_refilledNs = 0;
+        return;
+    }
+
+    m_tokens += tokens;
+    m_refilledNs += (qint64)( (double)tokens * NSECS_PER_SEC / m_rateLimit );
+}
+
+
+StreamConnection*
+BandwidthManager::next( const QSet< StreamConnection* >& stalled )
+{
+    // the peer is waiting for exactly this block, so it goes out even if the window is full of
+    // what was sent before the seek. It stays first in line until it actually got sent.
+    QList< StreamConnection* >::iterator it = m_priority.begin();
+    while ( it != m_priority.end() )
+    {
+        StreamConnection* sc = *it;
+        if ( !sc->hasMoreToSend() )
+            it = m_priority.erase( it );
+        else if ( stalled.contains( sc ) )
+            ++it;
+        else
+            return sc;
+    }
+
+    // the peer and stream that get served move to the back of their queue
+    for ( int i = 0; i < m_peers.count(); i++ )
+    {
+        ControlConnection* peer = m_peers.at( i );
+        QList< StreamConnection* >& streams = m_streams[ peer ];
+        for ( int j = 0; j < streams.count(); j++ )
+        {
+            StreamConnection* sc = streams.at( j );
+            if ( !sc->wantsToSend() || stalled.contains( sc ) )
+                continue;
+
+            streams.append( streams.takeAt( j ) );
+            m_peers.append( m_peers.takeAt( i ) );
+            return sc;
+        }
+    }
+
+    return 0;
+}
+
+
+void
+BandwidthManager::schedule()
+{
+    // sending a block can not get us called again, but better be safe
+    if ( m_scheduling )
+        return;
+    m_scheduling = true;
+
+    refill();
+
+    // streams reading from a device that has nothing for us yet are skipped until readyRead()
+    QSet< StreamConnection* > stalled;
+    const qint64 blockCost = BufferIODevice::blockSize() + Msg::headerSize();
+    while ( !m_rateLimit || m_tokens >= blockCost )
+    {
+        StreamConnection* sc = next( stalled );
+        if ( !sc )
+            break;
+
+        const qint64 sent = sc->sendBlock();
+        if ( !sent )
+        {
+            stalled << sc;
+            continue;
+        }
+
+        m_priority.removeOne( sc );
+        if ( m_rateLimit )
+            m_tokens -= sent + Msg::headerSize();
+    }
+
+    if ( m_rateLimit && m_tokens < blockCost && !m_refillTimer.isActive() )
+    {
+        // wake up once there are enough tokens for one block, if anyone is still waiting then
+        m_refillTimer.start( qMax( (qint64)1, ( blockCost - m_tokens ) * 1000 / m_rateLimit ) );
+    }
+
+    m_scheduling = false;
+}
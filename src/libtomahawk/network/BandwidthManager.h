@@ -0,0 +1,86 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BANDWIDTHMANAGER_H
+#define BANDWIDTHMANAGER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QObject>
+#include <QTimer>
+
+#include "DllMacro.h"
+
+class ControlConnection;
+class StreamConnection;
+
+/**
+ * Decides which of the streams we are sending to peers may send its next block.
+ *
+ * Peers take turns block by block, and so do the streams of a single peer, so
+ * one fast peer can not starve the others. A block that answers a seek is sent
+ * before anything else. With an upload limit set, blocks are paid for from a
+ * token bucket refilled at that rate, shared by all streams.
+ *
+ * Lives in the Servent thread, like the StreamConnections.
+ */
+class DLLEXPORT BandwidthManager : public QObject
+{
+Q_OBJECT
+
+public:
+    explicit BandwidthManager( QObject* parent = 0 );
+    virtual ~BandwidthManager();
+
+    void addStream( StreamConnection* sc );
+    void removeStream( StreamConnection* sc );
+
+    /// The next block of @p sc answers a seek and jumps the queue, even past a full window
+    void prioritize( StreamConnection* sc );
+
+    /// Total upload limit in bytes per second, 0 for none
+    qint64 rateLimit() const { return m_rateLimit; }
+    void setRateLimit( qint64 bytesPerSecond );
+
+public slots:
+    /// Sends blocks until every stream is blocked or the bucket is empty
+    void schedule();
+
+private slots:
+    void onSettingsChanged();
+
+private:
+    StreamConnection* next( const QSet< StreamConnection* >& stalled );
+    void refill();
+
+    QList< ControlConnection* > m_peers;
+    QHash< ControlConnection*, QList< StreamConnection* > > m_streams;
+    QList< StreamConnection* > m_priority;
+
+    qint64 m_rateLimit;
+    qint64 m_tokens;
+    QElapsedTimer m_clock;
+    // how much of m_clock's time has been turned into tokens already
+    qint64 m_refilledNs;
+    QTimer m_refillTimer;
+    bool m_scheduling;
+};
+
+#endif // BANDWIDTHMANAGER_H
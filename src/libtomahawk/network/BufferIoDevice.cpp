@@ -34,6 +34,7 @@ BufferIODevice::BufferIODevice( unsigned int size, QObject* parent )
     : QIODevice( parent )
     , d_ptr( new BufferIODevicePrivate( this, size ) )
 {
+    reserve( maxBlocks(), size );
 }
 
 
@@ -117,13 +118,17 @@ void
 BufferIODevice::addData( int block, const QByteArray& ba )
 {
     Q_D( BufferIODevice );
+    bool isNew;
     {
         QMutexLocker lock( &d->mut );
 
-        while ( d->buffer.count() <= block )
-            d->buffer << QByteArray();
+        const unsigned int end = block * BLOCKSIZE + ba.count();
+        reserve( block + 1, end );
 
-        d->buffer.replace( block, ba );
+        memcpy( d->buffer.data() + block * BLOCKSIZE, ba.constData(), ba.count() );
+        isNew = !d->blocks.testBit( block );
+        d->blocks.setBit( block );
+        d->dataEnd = qMax( d->dataEnd, end );
     }
 
     // If this was the last block of the transfer, check if we need to fill up gaps
@@ -135,7 +140,8 @@ BufferIODevice::addData( int block, const QByteArray& ba )
         }
     }
 
-    d->received += ba.count();
+    if ( isNew )
+        d->received += ba.count();
     emit bytesWritten( ba.count() );
     emit readyRead();
 }
@@ -159,14 +165,27 @@ BufferIODevice::readData( char* data, qint64 maxSize )
     if ( atEnd() )
         return 0;
 
-    QByteArray ba;
-    ba.append( getData( d->pos, maxSize ) );
-    d->pos += ba.count();
+    // copy straight out of the buffer, up to the first block we don't have yet
+    QMutexLocker lock( &d->mut );
+    qint64 read = 0;
+    while ( read < maxSize )
+    {
+        const int block = blockForPos( d->pos );
+        if ( block >= d->blocks.size() || !d->blocks.testBit( block ) )
+            break;
 
-//    qDebug() << Q_FUNC_INFO << maxSize << ba.count() << 2;
-    memcpy( data, ba.data(), ba.count() );
+        const qint64 blockEnd = qMin( (qint64)( block + 1 ) * BLOCKSIZE, (qint64)d->dataEnd );
+        const qint64 len = qMin( blockEnd - d->pos, maxSize - read );
+        if ( len <= 0 )
+            break;
+
+        memcpy( data + read, d->buffer.constData() + d->pos, len );
+        d->pos += len;
+        read += len;
+    }
 
-    return ba.count();
+//    qDebug() << Q_FUNC_INFO << maxSize << read << 2;
+    return read;
 }
 
 
@@ -214,7 +233,8 @@ BufferIODevice::clear()
     QMutexLocker lock( &d->mut );
 
     d->pos = 0;
-    d->buffer.clear();
+    d->blocks.fill( false );
+    d->firstEmptyBlock = 0;
 }
 
 
@@ -258,20 +278,16 @@ int
 BufferIODevice::nextEmptyBlock() const
 {
     Q_D( const BufferIODevice );
+    QMutexLocker lock( &d->mut );
 
-    int i = 0;
-    foreach( const QByteArray& ba, d->buffer )
-    {
-        if ( ba.isEmpty() )
-            return i;
-
-        i++;
-    }
+    // blocks are only ever added (until clear()), so never look back
+    while ( d->firstEmptyBlock < d->blocks.size() && d->blocks.testBit( d->firstEmptyBlock ) )
+        d->firstEmptyBlock++;
 
-    if ( i == maxBlocks() )
+    if ( d->firstEmptyBlock >= maxBlocks() )
         return -1;
 
-    return i;
+    return d->firstEmptyBlock;
 }
 
 
@@ -293,34 +309,20 @@ bool
 BufferIODevice::isBlockEmpty( int block ) const
 {
     Q_D( const BufferIODevice );
-    if ( block >= d->buffer.count() )
-        return true;
+    QMutexLocker lock( &d->mut );
 
-    return d->buffer.at( block ).isEmpty();
+    return block >= d->blocks.size() || !d->blocks.testBit( block );
 }
 
 
-QByteArray
-BufferIODevice::getData( qint64 pos, qint64 size )
+void
+BufferIODevice::reserve( int blocks, unsigned int bytes )
 {
     Q_D( BufferIODevice );
-//    qDebug() << Q_FUNC_INFO << pos << size << 1;
-    QByteArray ba;
-    int block = blockForPos( pos );
-    int offset = offsetForPos( pos );
-
-    QMutexLocker lock( &d->mut );
-    while( ba.count() < size )
-    {
-        if ( block > maxBlocks() )
-            break;
-
-        if ( isBlockEmpty( block ) )
-            break;
-
-        ba.append( d->buffer.at( block++ ).mid( offset ) );
-    }
 
-//    qDebug() << Q_FUNC_INFO << pos << size << 2;
-    return ba.left( size );
+    // only grows if the peer sends more than the size we were told about
+    if ( (unsigned int)d->buffer.size() < bytes )
+        d->buffer.resize( bytes );
+    if ( d->blocks.size() < blocks )
+        d->blocks.resize( blocks );
 }
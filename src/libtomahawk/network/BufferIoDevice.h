@@ -68,7 +68,7 @@ protected:
 private:
     int blockForPos( qint64 pos ) const;
     int offsetForPos( qint64 pos ) const;
-    QByteArray getData( qint64 pos, qint64 size );
+    void reserve( int blocks, unsigned int bytes );
 
     Q_DECLARE_PRIVATE( BufferIODevice )
     BufferIODevicePrivate* d_ptr;
@@ -22,6 +22,7 @@
 
 #include "BufferIoDevice.h"
 
+#include <QBitArray>
 #include <QMutex>
 
 class BufferIODevicePrivate
@@ -32,18 +33,26 @@ public:
         , size( size )
         , received( 0 )
         , pos( 0 )
-
+        , dataEnd( 0 )
+        , firstEmptyBlock( 0 )
     {
     }
     BufferIODevice* q_ptr;
     Q_DECLARE_PUBLIC ( BufferIODevice )
 
 private:
-    QList<QByteArray> buffer;
+    // preallocated for the whole file, blocks are copied to their final place
+    QByteArray buffer;
+    // which blocks of buffer have been received
+    QBitArray blocks;
     mutable QMutex mut;
     unsigned int size;
     unsigned int received;
     unsigned int pos;
+    // end of the furthest block we received, the last block may be short
+    unsigned int dataEnd;
+    // all blocks before this one have been received
+    mutable int firstEmptyBlock;
 };
 
 #endif // BUFFERIODEVICE_P_H
@@ -282,6 +282,12 @@ Connection::bytesReceived() const
     return d_func()->rx_bytes;
 }
 
+qint64
+Connection::bytesPending() const
+{
+    return d_func()->tx_bytes_requested - d_func()->tx_bytes;
+}
+
 void
 Connection::setMsgProcessorModeOut(quint32 m)
 {
@@ -681,7 +687,13 @@ Connection::bytesWritten( qint64 i )
     d_func()->tx_bytes += i;
     // if we are waiting to shutdown, and have sent all queued data, do actual shutdown:
     if ( d_func()->do_shutdown && d_func()->tx_bytes == d_func()->tx_bytes_requested )
+    {
         actualShutdown();
+        return;
+    }
+
+    if ( i > 0 )
+        emit messagesWritten();
 }
 
 
@@ -79,6 +79,10 @@ public:
 
     qint64 bytesSent() const;
     qint64 bytesReceived() const;
+    /**
+     * Bytes passed to sendMsg() that have not been written to the socket yet.
+     */
+    qint64 bytesPending() const;
 
     void setMsgProcessorModeOut( quint32 m );
     void setMsgProcessorModeIn( quint32 m );
@@ -110,6 +114,11 @@ signals:
     void finished();
     void statsTick( qint64 tx_bytes_sec, qint64 rx_bytes_sec );
     void socketClosed();
+    /**
+     * Emitted whenever the socket wrote some of our queued data, use
+     * bytesPending() to see how much is left.
+     */
+    void messagesWritten();
     void socketErrored( QAbstractSocket::SocketError );
 
 protected:
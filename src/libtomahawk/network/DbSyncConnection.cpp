@@ -27,6 +27,12 @@
 
     Synced.
 
+    Peers that understand it add "batchops" to their fetchops request. Ops
+    are then sent to them packed into size-bounded frames (a JSON array of
+    ops per msg, compressed as one stream) instead of one msg per op, and
+    every frame is applied in a single transaction. Old peers never ask for
+    it and keep getting one msg per op.
+
 */
 
 #include "DbSyncConnection.h"
@@ -43,6 +49,9 @@
 #include "Source.h"
 #include "SourceList.h"
 
+// Version of the batched op frame format we understand
+#define DBSYNC_BATCH_VERSION 1
+
 using namespace Tomahawk;
 
 
@@ -50,6 +59,7 @@ DBSyncConnection::DBSyncConnection( Servent* s, const source_ptr& src )
     : Connection( s )
     , m_fetchCount( 0 )
     , m_source( src )
+    , m_sendBatchedOps( false )
     , m_state( UNKNOWN )
 {
     qDebug() << Q_FUNC_INFO << src->id() << thread();
@@ -158,6 +168,7 @@ DBSyncConnection::fetchOpsData( const QString& sinceguid )
     QVariantMap msg;
     msg.insert( "method", "fetchops" );
     msg.insert( "lastop", sinceguid );
+    msg.insert( "batchops", DBSYNC_BATCH_VERSION );
     sendMsg( msg );
 }
 
@@ -188,6 +199,13 @@ DBSyncConnection::handleMsg( msg_ptr msg )
 
     Q_ASSERT( msg->is( Msg::JSON ) );
 
+    // a frame of batched db sync ops
+    if ( msg->is( Msg::DBOP ) && msg->json().type() == QVariant::List )
+    {
+        handleOpsFrame( msg );
+        return;
+    }
+
     QVariantMap m = msg->json().toMap();
     if ( m.empty() )
     {
@@ -217,6 +235,7 @@ DBSyncConnection::handleMsg( msg_ptr msg )
     {
         ++m_fetchCount;
         tDebug( LOGVERBOSE ) << "Fetching new dbops:" << m["lastop"].toString() << m_fetchCount;
+        m_sendBatchedOps = m.value( "batchops" ).toInt() >= DBSYNC_BATCH_VERSION;
         m_uscache = m;
         sendOps();
         return;
@@ -234,6 +253,30 @@ DBSyncConnection::handleMsg( msg_ptr msg )
 }
 
 
+void
+DBSyncConnection::handleOpsFrame( msg_ptr msg )
+{
+    const QVariantList ops = msg->json().toList();
+
+    QList< dbcmd_ptr > cmds;
+    foreach ( const QVariant& op, ops )
+    {
+        dbcmd_ptr cmd = Database::instance()->createCommandInstance( op, m_source );
+        if ( !cmd.isNull() )
+            cmds << cmd;
+    }
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Got frame with" << ops.count() << "ops from:" << m_source->id();
+    m_source->addCommands( cmds );
+
+    if ( !msg->is( Msg::FRAGMENT ) ) // last frame in this batch
+    {
+        changeState( SAVING ); // just DB work left to complete
+        m_source->executeCommands();
+    }
+}
+
+
 void
 DBSyncConnection::lastOpApplied()
 {
@@ -275,7 +318,22 @@ DBSyncConnection::sendOpsData( QString sinceguid, QString lastguid, QList< dbop_
         return;
     }
 
-    tLog( LOGVERBOSE ) << Q_FUNC_INFO << sinceguid << lastguid << "Num ops to send:" << ops.length();
+    tLog( LOGVERBOSE ) << Q_FUNC_INFO << sinceguid << lastguid << "Num ops to send:" << ops.length() << "batched:" << m_sendBatchedOps;
+
+    if ( m_sendBatchedOps )
+    {
+        const QList< QByteArray > frames = packOps( ops, MAX_OPS_FRAME_SIZE );
+        for ( int i = 0; i < frames.length(); ++i )
+        {
+            // compressed as a whole by the MsgProcessor, see COMPRESS_IF_LARGE
+            quint8 flags = Msg::JSON | Msg::DBOP;
+            if ( i != frames.length() - 1 )
+                flags |= Msg::FRAGMENT;
+
+            sendMsg( Msg::factory( frames.at( i ), flags ) );
+        }
+        return;
+    }
 
     int i;
     for( i = 0; i < ops.length(); ++i )
@@ -292,6 +350,44 @@ DBSyncConnection::sendOpsData( QString sinceguid, QString lastguid, QList< dbop_
 }
 
 
+QList< QByteArray >
+DBSyncConnection::packOps( const QList< dbop_ptr >& ops, int maxFrameSize )
+{
+    QList< QByteArray > frames;
+    QByteArray frame;
+
+    foreach ( const dbop_ptr& op, ops )
+    {
+        const QByteArray payload = op->compressed ? qUncompress( op->payload ) : op->payload;
+
+        if ( !frame.isEmpty() && frame.length() + payload.length() + 2 > maxFrameSize )
+        {
+            frame.append( ']' );
+            frames << frame;
+            frame.clear();
+        }
+
+        if ( frame.isEmpty() )
+        {
+            frame.reserve( qMax( maxFrameSize, payload.length() + 2 ) );
+            frame.append( '[' );
+        }
+        else
+            frame.append( ',' );
+
+        frame.append( payload );
+    }
+
+    if ( !frame.isEmpty() )
+    {
+        frame.append( ']' );
+        frames << frame;
+    }
+
+    return frames;
+}
+
+
 Connection*
 DBSyncConnection::clone()
 {
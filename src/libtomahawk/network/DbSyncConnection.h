@@ -23,6 +23,7 @@
 #include "network/Connection.h"
 #include "network/DBSyncConnectionState.h"
 #include "database/Op.h"
+#include "DllMacro.h"
 #include "Typedefs.h"
 
 #include <QObject>
@@ -30,11 +31,13 @@
 #include <QSharedPointer>
 #include <QIODevice>
 
+// Upper bound for the uncompressed size of a batched op frame
+#define MAX_OPS_FRAME_SIZE 256 * 1024
 
 
 class DatabaseCommand;
 
-class DBSyncConnection : public Connection
+class DLLEXPORT DBSyncConnection : public Connection
 {
 Q_OBJECT
 
@@ -45,6 +48,13 @@ public:
     void setup() override;
     Connection* clone() override;
 
+    /**
+     * Packs the (uncompressed) JSON payloads of @p ops into JSON array frames
+     * of at most @p maxFrameSize bytes each. A single op larger than that
+     * gets a frame of its own.
+     */
+    static QList< QByteArray > packOps( const QList< dbop_ptr >& ops, int maxFrameSize );
+
 signals:
     void stateChanged( Tomahawk::DBSyncConnectionState newstate, Tomahawk::DBSyncConnectionState oldstate, const QString& info );
 
@@ -68,6 +78,7 @@ private slots:
 private:
     void synced();
     void changeState( Tomahawk::DBSyncConnectionState newstate );
+    void handleOpsFrame( msg_ptr msg );
 
     int m_fetchCount;
     Tomahawk::source_ptr m_source;
@@ -75,6 +86,9 @@ private:
 
     QString m_lastSentOp;
 
+    // peer asked for ops packed into batched frames in its last fetchops
+    bool m_sendBatchedOps;
+
     Tomahawk::DBSyncConnectionState m_state;
 };
 
@@ -35,6 +35,9 @@
 
 #include <QObject>
 
+// Msgs larger than this get compressed in COMPRESS_IF_LARGE mode
+#define COMPRESSION_THRESHOLD 512
+
 class MsgProcessor : public QObject
 {
 Q_OBJECT
@@ -47,7 +50,7 @@ public:
         PARSE_JSON = 4
     };
 
-    explicit MsgProcessor( quint32 mode = NOTHING, quint32 t = 512 );
+    explicit MsgProcessor( quint32 mode = NOTHING, quint32 t = COMPRESSION_THRESHOLD );
 
     void setMode( quint32 m ) { m_mode = m ; }
 
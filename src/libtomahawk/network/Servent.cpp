@@ -84,6 +84,7 @@ Servent::Servent( QObject* parent )
     s_instance = this;
 
     d_func()->noAuth = qApp->arguments().contains( "--noauth" );
+    d_func()->bandwidth = new BandwidthManager( this );
 
     setProxy( QNetworkProxy::NoProxy );
 
@@ -1283,6 +1284,8 @@ Servent::registerStreamConnection( StreamConnection* sc )
 
     QMutexLocker lock( &d_func()->ftsession_mut );
     d_func()->scsessions.append( sc );
+    if ( sc->type() == StreamConnection::SENDING )
+        d_func()->bandwidth->addStream( sc );
 
     printCurrentTransfers();
     emit streamStarted( sc );
@@ -1297,6 +1300,7 @@ Servent::onStreamFinished( StreamConnection* sc )
 
     QMutexLocker lock( &d_func()->ftsession_mut );
     d_func()->scsessions.removeAll( sc );
+    d_func()->bandwidth->removeStream( sc );
 
     printCurrentTransfers();
     emit streamFinished( sc );
@@ -1434,6 +1438,13 @@ Servent::streams() const
 }
 
 
+BandwidthManager*
+Servent::bandwidthManager() const
+{
+    return d_func()->bandwidth;
+}
+
+
 void
 Servent::triggerDBSync()
 {
@@ -47,6 +47,7 @@ class RemoteCollectionConnection;
 class SipInfo;
 class StreamConnection;
 
+class BandwidthManager;
 class ServentPrivate;
 
 class DLLEXPORT Servent : public QTcpServer
@@ -136,6 +137,7 @@ public:
     unsigned int numConnectedPeers() const;
 
     QList< StreamConnection* > streams() const;
+    BandwidthManager* bandwidthManager() const;
 
     bool isReady() const;
 
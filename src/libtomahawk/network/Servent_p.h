@@ -23,6 +23,7 @@
 #define SERVENT_P_H
 
 #include "Servent.h"
+#include "BandwidthManager.h"
 
 #include <QMutex>
 #include <QStringList>
@@ -37,6 +38,7 @@ public:
         , port( 0 )
         , externalPort( 0 )
         , ready( false )
+        , bandwidth( 0 )
     {
     }
     Servent* q_ptr;
@@ -87,6 +89,8 @@ private:
     // currently active file transfers:
     QList< StreamConnection* > scsessions;
     QMutex ftsession_mut;
+    // decides which of the sending streams may send next
+    BandwidthManager* bandwidth;
     // username -> nodeid -> PeerInfos
     QMap<QString, QMap<QString, QSet<Tomahawk::peerinfo_ptr> > > queuedForACLResult;
 
@@ -22,6 +22,7 @@
 
 #include "database/DatabaseCommand_LoadFiles.h"
 #include "database/Database.h"
+#include "network/BandwidthManager.h"
 #include "network/ControlConnection.h"
 #include "network/Servent.h"
 #include "utils/Logger.h"
@@ -31,10 +32,10 @@
 #include "MsgProcessor.h"
 #include "Result.h"
 #include "SourceList.h"
+#include "TomahawkSettings.h"
 #include "UrlHandler.h"
 
 #include <QFile>
-#include <QTimer>
 
 using namespace Tomahawk;
 
@@ -44,6 +45,11 @@ StreamConnection::StreamConnection( Servent* s, ControlConnection* cc, QString f
     , m_cc( cc )
     , m_fid( fid )
     , m_type( RECEIVING )
+    , m_map( 0 )
+    , m_mapSize( 0 )
+    , m_readPos( 0 )
+    , m_window( 0 )
+    , m_sentAll( false )
     , m_curBlock( 0 )
     , m_badded( 0 )
     , m_bsent( 0 )
@@ -78,6 +84,12 @@ StreamConnection::StreamConnection( Servent* s, ControlConnection* cc, QString f
     , m_cc( cc )
     , m_fid( fid )
     , m_type( SENDING )
+    , m_map( 0 )
+    , m_mapSize( 0 )
+    , m_readPos( 0 )
+    , m_window( 0 )
+    , m_sentAll( false )
+    , m_curBlock( 0 )
     , m_badded( 0 )
     , m_bsent( 0 )
     , m_allok( false )
@@ -157,6 +169,7 @@ StreamConnection::setup()
     }
 
     connect( this, SIGNAL( statsTick( qint64, qint64 ) ), SLOT( showStats( qint64, qint64 ) ) );
+    m_started.start();
     if ( m_type == RECEIVING )
     {
         qDebug() << "in RX mode";
@@ -207,6 +220,23 @@ StreamConnection::reallyStartSending( const Tomahawk::result_ptr result, const Q
     }
 
     m_readdev = QSharedPointer<QIODevice>( io );
+    m_window = qMax( (qint64)TomahawkSettings::instance()->streamWindowSize(), (qint64)BufferIODevice::blockSize() );
+
+    QFile* file = qobject_cast< QFile* >( io.data() );
+    if ( file && file->size() > 0 )
+    {
+        m_map = file->map( 0, file->size() );
+        if ( m_map )
+            m_mapSize = file->size();
+        else
+            tDebug() << Q_FUNC_INFO << "Could not map file, reading it instead:" << file->errorString();
+    }
+
+    // refill the window whenever the socket made some room, and when more data arrives for streams
+    connect( this, SIGNAL( messagesWritten() ), SLOT( sendSome() ) );
+    if ( !m_map )
+        connect( m_readdev.data(), SIGNAL( readyRead() ), SLOT( sendSome() ) );
+
     sendSome();
 
     emit updated();
@@ -221,7 +251,11 @@ StreamConnection::handleMsg( msg_ptr msg )
     if ( msg->payload().startsWith( "block" ) )
     {
         int block = QString( msg->payload() ).mid( 5 ).toInt();
-        m_readdev->seek( block * BufferIODevice::blockSize() );
+        if ( m_map )
+            m_readPos = qMin( (qint64)block * BufferIODevice::blockSize(), m_mapSize );
+        else
+            m_readdev->seek( block * BufferIODevice::blockSize() );
+        m_sentAll = false;
 
         qDebug() << "Seeked to block:" << block;
 
@@ -229,7 +263,10 @@ StreamConnection::handleMsg( msg_ptr msg )
         sm.append( QString( "doneblock%1" ).arg( block ) );
 
         sendMsg( Msg::factory( sm, Msg::RAW | Msg::FRAGMENT ) );
-        QTimer::singleShot( 0, this, SLOT( sendSome() ) );
+
+        // the peer is waiting for exactly this block, don't make it queue behind the others
+        Servent::instance()->bandwidthManager()->prioritize( this );
+        sendSome();
     }
     else if ( msg->payload().startsWith( "doneblock" ) )
     {
@@ -274,24 +311,67 @@ StreamConnection::sendSome()
 {
     Q_ASSERT( m_type == StreamConnection::SENDING );
 
-    QByteArray ba = "data";
-    ba.append( m_readdev->read( BufferIODevice::blockSize() ) );
-    m_bsent += ba.length() - 4;
+    // Blocks are sent by the BandwidthManager, which shares the upload between all
+    // streams and applies the upload limit. We get called again from messagesWritten()
+    // once the socket drained some of our window.
+    Servent::instance()->bandwidthManager()->schedule();
+}
+
+
+bool
+StreamConnection::wantsToSend() const
+{
+    return hasMoreToSend() && bytesPending() < m_window;
+}
 
-    if ( m_readdev->atEnd() )
+
+qint64
+StreamConnection::averageRate() const
+{
+    if ( !m_started.isValid() || m_started.elapsed() < 1000 )
+        return m_transferRate;
+
+    return bytesTransferred() * 1000 / m_started.elapsed();
+}
+
+
+qint64
+StreamConnection::sendBlock()
+{
+    if ( m_sentAll || m_readdev.isNull() )
+        return 0;
+
+    const qint64 blockSize = BufferIODevice::blockSize();
+    QByteArray ba;
+    bool atEnd;
+    if ( m_map )
     {
-        sendMsg( Msg::factory( ba, Msg::RAW ) );
-        return;
+        // one copy from the page cache into the message, no read() calls
+        const qint64 len = qMin( blockSize, m_mapSize - m_readPos );
+        ba.reserve( 4 + len );
+        ba.append( "data", 4 );
+        ba.append( (const char*)m_map + m_readPos, len );
+        m_readPos += len;
+        atEnd = ( m_readPos >= m_mapSize );
     }
     else
     {
-        // more to come -> FRAGMENT
-        sendMsg( Msg::factory( ba, Msg::RAW | Msg::FRAGMENT ) );
+        ba = "data";
+        ba.append( m_readdev->read( blockSize ) );
+        atEnd = m_readdev->atEnd();
+
+        // nothing available yet, readyRead() will get us going again
+        if ( ba.length() == 4 && !atEnd )
+            return 0;
     }
 
-    // HINT: change the 0 to 50 to transmit at 640Kbps, for example
-    //       (this is where upload throttling could be implemented)
-    QTimer::singleShot( 0, this, SLOT( sendSome() ) );
+    m_bsent += ba.length() - 4;
+    m_sentAll = atEnd;
+
+    // more to come -> FRAGMENT
+    sendMsg( Msg::factory( ba, atEnd ? Msg::RAW : Msg::RAW | Msg::FRAGMENT ) );
+
+    return ba.length();
 }
 
 
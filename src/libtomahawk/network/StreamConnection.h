@@ -23,6 +23,7 @@
 
 #include <QObject>
 #include <QSharedPointer>
+#include <QElapsedTimer>
 #include <QIODevice>
 
 #include "network/Connection.h"
@@ -61,6 +62,13 @@ public:
     Tomahawk::source_ptr source() const;
     Tomahawk::result_ptr track() const { return m_result; }
     qint64 transferRate() const { return m_transferRate; }
+    /// Payload bytes sent or received so far
+    qint64 bytesTransferred() const { return m_type == SENDING ? m_bsent : m_badded; }
+    /// Average payload bytes per second since the transfer started
+    qint64 averageRate() const;
+
+    /// True if there is room in the window and the next block could be sent
+    bool wantsToSend() const;
 
     Type type() const { return m_type; }
     QString fid() const { return m_fid; }
@@ -80,15 +88,31 @@ private slots:
     void onBlockRequest( int pos );
 
 private:
+    friend class BandwidthManager;
+
+    /// True if not everything got sent yet, no matter how full the window is
+    bool hasMoreToSend() const { return !m_sentAll && !m_readdev.isNull(); }
+    /// Sends the next block, returns its size or 0 if there was nothing to send right now
+    qint64 sendBlock();
+
     QSharedPointer<QIODevice> m_iodev;
     ControlConnection* m_cc;
     QString m_fid;
     Type m_type;
     QSharedPointer<QIODevice> m_readdev;
 
+    // local files are sent straight out of a memory map of the file
+    const uchar* m_map;
+    qint64 m_mapSize;
+    qint64 m_readPos;
+    // sendSome() stops once this many bytes are waiting for the socket
+    qint64 m_window;
+    bool m_sentAll;
+
     int m_curBlock;
 
-    int m_badded, m_bsent;
+    qint64 m_badded, m_bsent;
+    QElapsedTimer m_started;
     bool m_allok; // got last msg ok, transfer complete?
 
     Tomahawk::source_ptr m_source;
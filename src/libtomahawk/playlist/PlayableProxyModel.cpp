@@ -31,6 +31,8 @@
 
 #include <QTreeView>
 
+#include <algorithm>
+
 PlayableProxyModel::PlayableProxyModel( QObject* parent )
     : QSortFilterProxyModel( parent )
     , m_model( 0 )
@@ -125,7 +127,15 @@ PlayableProxyModel::setSourcePlayableModel( PlayableModel* sourceModel )
         disconnect( m_model, SIGNAL( currentIndexChanged( QModelIndex, QModelIndex ) ), this, SLOT( onCurrentIndexChanged( QModelIndex, QModelIndex ) ) );
         disconnect( m_model, SIGNAL( expandRequest( QPersistentModelIndex ) ), this, SLOT( expandRequested( QPersistentModelIndex ) ) );
         disconnect( m_model, SIGNAL( selectRequest( QPersistentModelIndex ) ), this, SLOT( selectRequested( QPersistentModelIndex ) ) );
+
+        disconnect( m_model, SIGNAL( rowsInserted( QModelIndex, int, int ) ), this, SLOT( onSourceRowsChanged( QModelIndex, int ) ) );
+        disconnect( m_model, SIGNAL( rowsRemoved( QModelIndex, int, int ) ), this, SLOT( clearFilterIndex() ) );
+        disconnect( m_model, SIGNAL( rowsMoved( QModelIndex, int, int, QModelIndex, int ) ), this, SLOT( clearFilterIndex() ) );
+        disconnect( m_model, SIGNAL( dataChanged( QModelIndex, QModelIndex ) ), this, SLOT( onSourceDataChanged( QModelIndex, QModelIndex ) ) );
+        disconnect( m_model, SIGNAL( layoutChanged() ), this, SLOT( clearFilterIndex() ) );
+        disconnect( m_model, SIGNAL( modelReset() ), this, SLOT( clearFilterIndex() ) );
     }
+    m_filterIndex.clear();
 
     m_model = sourceModel;
     if ( m_model )
@@ -138,87 +148,210 @@ PlayableProxyModel::setSourcePlayableModel( PlayableModel* sourceModel )
         connect( m_model, SIGNAL( currentIndexChanged( QModelIndex, QModelIndex ) ), SLOT( onCurrentIndexChanged( QModelIndex, QModelIndex ) ) );
         connect( m_model, SIGNAL( expandRequest( QPersistentModelIndex ) ), SLOT( expandRequested( QPersistentModelIndex ) ) );
         connect( m_model, SIGNAL( selectRequest( QPersistentModelIndex ) ), SLOT( selectRequested( QPersistentModelIndex ) ) );
+
+        // connected before the proxy itself refilters on them
+        connect( m_model, SIGNAL( rowsInserted( QModelIndex, int, int ) ), SLOT( onSourceRowsChanged( QModelIndex, int ) ) );
+        // removed items might have been parents, their addresses must not be reused as keys
+        connect( m_model, SIGNAL( rowsRemoved( QModelIndex, int, int ) ), SLOT( clearFilterIndex() ) );
+        connect( m_model, SIGNAL( rowsMoved( QModelIndex, int, int, QModelIndex, int ) ), SLOT( clearFilterIndex() ) );
+        connect( m_model, SIGNAL( dataChanged( QModelIndex, QModelIndex ) ), SLOT( onSourceDataChanged( QModelIndex, QModelIndex ) ) );
+        connect( m_model, SIGNAL( layoutChanged() ), SLOT( clearFilterIndex() ) );
+        connect( m_model, SIGNAL( modelReset() ), SLOT( clearFilterIndex() ) );
     }
 
     QSortFilterProxyModel::setSourceModel( m_model );
 }
 
 
-bool
-PlayableProxyModel::filterAcceptsRow( int sourceRow, const QModelIndex& sourceParent ) const
+void
+PlayableProxyModelFilterIndex::truncate( int row )
 {
-    PlayableProxyModelFilterMemo memo;
+    if ( row >= (int)accepted.size() )
+        return;
 
-    PlayableItem* pi = itemFromIndex( sourceModel()->index( sourceRow, 0, sourceParent ) );
-    if ( !pi )
-        return false;
+    // only the keys of the dropped rows go, accepted rows own theirs
+    for ( int i = accepted.size() - 1; i >= row; i-- )
+    {
+        if ( !accepted[ i ] )
+            continue;
+
+        visible--;
+        const DupeKeys& k = keys[ i ];
+        if ( !k.track.isNull() && tracks.value( k.track ) == i )
+            tracks.remove( k.track );
+        if ( k.album && albums.value( k.album ) == i )
+            albums.remove( k.album );
+        if ( !k.artist.isNull() && artists.value( k.artist ) == i )
+            artists.remove( k.artist );
+    }
 
-    return filterAcceptsRowInternal( sourceRow, pi, sourceParent, memo );
+    accepted.resize( row );
+    keys.resize( row );
+}
+
+
+static QString
+dupeKey( const Tomahawk::query_ptr& query )
+{
+    // the fields compared by Query::equals()
+    const Tomahawk::track_ptr& track = query->queryTrack();
+    return track->artist() + QChar( 0 ) + track->album() + QChar( 0 ) + track->track();
 }
 
 
 bool
-PlayableProxyModel::filterAcceptsRowInternal( int sourceRow, PlayableItem* pi, const QModelIndex& sourceParent, PlayableProxyModelFilterMemo& memo ) const
+PlayableProxyModel::filterAcceptsRow( int sourceRow, const QModelIndex& sourceParent ) const
 {
-    if ( m_maxVisibleItems > 0 && !visibilityFilterAcceptsRow( sourceRow, sourceParent, memo ) )
-        return false;
-    if ( m_hideDupeItems && !dupeFilterAcceptsRow( sourceRow, pi, sourceParent, memo ) )
+    PlayableItem* pi = itemFromIndex( sourceModel()->index( sourceRow, 0, sourceParent ) );
+    if ( !pi )
         return false;
 
-    return nameFilterAcceptsRow( sourceRow, pi, sourceParent );
+    // without these filters a row's visibility does not depend on the rows before it
+    if ( !m_hideDupeItems && m_maxVisibleItems <= 0 )
+        return nameFilterAcceptsRow( sourceRow, pi, sourceParent );
+
+    return filterIndex( sourceRow, sourceParent ).accepted[ sourceRow ];
 }
 
 
-bool
-PlayableProxyModel::dupeFilterAcceptsRow( int sourceRow, PlayableItem* pi, const QModelIndex& sourceParent, PlayableProxyModelFilterMemo& memo ) const
+const PlayableProxyModelFilterIndex&
+PlayableProxyModel::filterIndex( int sourceRow, const QModelIndex& sourceParent ) const
 {
-    if ( !m_hideDupeItems )
-        return true;
+    // setFilterRegExp() is not virtual, so notice a new pattern here
+    if ( m_filterIndexPattern != filterRegExp().pattern() )
+    {
+        m_filterIndex.clear();
+        m_filterIndexPattern = filterRegExp().pattern();
+    }
 
-    for ( int i = 0; i < sourceRow; i++ )
+    PlayableProxyModelFilterIndex& index = m_filterIndex[ itemFromIndex( sourceParent ) ];
+    for ( int i = index.accepted.size(); i <= sourceRow; i++ )
     {
-        PlayableItem* di = itemFromIndex( sourceModel()->index( i, 0, sourceParent ) );
-        if ( !di )
+        PlayableItem* pi = itemFromIndex( sourceModel()->index( i, 0, sourceParent ) );
+        const bool accepted = pi && filterAcceptsRowInternal( i, pi, sourceParent, index );
+        index.accepted.push_back( accepted );
+        index.keys.push_back( PlayableProxyModelFilterIndex::DupeKeys() );
+        if ( !accepted )
             continue;
 
-        bool b = ( pi->query() && pi->query()->equals( di->query() ) ) ||
-                 ( pi->album() && pi->album() == di->album() ) ||
-                 ( pi->artist() && pi->artist()->name() == di->artist()->name() );
+        index.visible++;
+        if ( !m_hideDupeItems )
+            continue;
 
-        if ( b && filterAcceptsRowInternal( i, di, sourceParent, memo ) )
-            return false;
+        // accepted rows are no dupes, so these are all new keys
+        PlayableProxyModelFilterIndex::DupeKeys& keys = index.keys.back();
+        if ( pi->query() )
+        {
+            keys.track = dupeKey( pi->query() );
+            index.tracks.insert( keys.track, i );
+        }
+        if ( pi->album() )
+        {
+            keys.album = pi->album().data();
+            index.albums.insert( keys.album, i );
+        }
+        if ( pi->artist() )
+        {
+            keys.artist = pi->artist()->name();
+            index.artists.insert( keys.artist, i );
+        }
     }
 
-    return true;
+    return index;
 }
 
 
-bool
-PlayableProxyModel::visibilityFilterAcceptsRow( int sourceRow, const QModelIndex& sourceParent, PlayableProxyModelFilterMemo& memo ) const
+void
+PlayableProxyModel::truncateFilterIndex( const QModelIndex& sourceParent, int sourceRow )
 {
-    if ( m_maxVisibleItems <= 0 )
-        return true;
+    QHash< PlayableItem*, PlayableProxyModelFilterIndex >::iterator it = m_filterIndex.find( itemFromIndex( sourceParent ) );
+    if ( it != m_filterIndex.end() )
+        it.value().truncate( sourceRow );
+}
+
+
+void
+PlayableProxyModel::onSourceRowsChanged( const QModelIndex& parent, int first )
+{
+    truncateFilterIndex( parent, first );
+
+    // a parent with or without children might be hidden now
+    if ( parent.isValid() )
+        truncateFilterIndex( parent.parent(), parent.row() );
+}
+
+
+void
+PlayableProxyModel::onSourceDataChanged( const QModelIndex& topLeft, const QModelIndex& bottomRight )
+{
+    const QModelIndex parent = topLeft.parent();
+    QHash< PlayableItem*, PlayableProxyModelFilterIndex >::iterator it = m_filterIndex.find( itemFromIndex( parent ) );
+    if ( it == m_filterIndex.end() )
+        return;
+
+    PlayableProxyModelFilterIndex& index = it.value();
 
-    if ( static_cast<size_t>( sourceRow ) < memo.visibilty.size() )
+    // with a limit on the visible items, every row after a changed one might move in or out of it
+    if ( m_maxVisibleItems > 0 )
     {
-        // We have already memoized the return value.
-        return memo.visibilty[sourceRow] < m_maxVisibleItems;
+        index.truncate( topLeft.row() );
+        return;
     }
-    // else: We do not have memoized the value, so compute it.
 
-    int items = memo.visibilty.back();
-    for ( int i = memo.visibilty.size() - 1; ( i < sourceRow ) && ( items < m_maxVisibleItems ) ; i++ )
+    // the dupe keys come from the item, which stays the same, so later rows only care about changed rows that flipped
+    const int last = qMin( bottomRight.row(), (int)index.accepted.size() - 1 );
+    for ( int i = topLeft.row(); i <= last; i++ )
     {
-        PlayableItem* pi = itemFromIndex( sourceModel()->index( i, 0, sourceParent ) );
-        // We will not change memo in these calls as all values needed in them are already memoized.
-        if ( pi && dupeFilterAcceptsRow( i, pi, sourceParent, memo ) && nameFilterAcceptsRow( i, pi, sourceParent ) )
+        PlayableItem* pi = itemFromIndex( sourceModel()->index( i, 0, parent ) );
+        const bool accepted = pi && dupeFilterAcceptsRow( i, pi, index ) && nameFilterAcceptsRow( i, pi, parent );
+        if ( accepted != index.accepted[ i ] )
         {
-            items++;
-            memo.visibilty.push_back( items ); // Sets memo.visibilty[i + 1] to items
+            index.truncate( i );
+            return;
         }
     }
+}
+
+
+void
+PlayableProxyModel::clearFilterIndex()
+{
+    m_filterIndex.clear();
+}
+
+
+bool
+PlayableProxyModel::filterAcceptsRowInternal( int sourceRow, PlayableItem* pi, const QModelIndex& sourceParent, const PlayableProxyModelFilterIndex& index ) const
+{
+    if ( m_maxVisibleItems > 0 && !visibilityFilterAcceptsRow( index ) )
+        return false;
+    if ( m_hideDupeItems && !dupeFilterAcceptsRow( sourceRow, pi, index ) )
+        return false;
+
+    return nameFilterAcceptsRow( sourceRow, pi, sourceParent );
+}
+
+
+bool
+PlayableProxyModel::dupeFilterAcceptsRow( int sourceRow, PlayableItem* pi, const PlayableProxyModelFilterIndex& index ) const
+{
+    if ( !m_hideDupeItems )
+        return true;
+
+    // a dupe of an accepted row before this one, the index may already know the rows after it
+    return !( ( pi->query() && index.tracks.value( dupeKey( pi->query() ), sourceRow ) < sourceRow ) ||
+              ( pi->album() && index.albums.value( pi->album().data(), sourceRow ) < sourceRow ) ||
+              ( pi->artist() && index.artists.value( pi->artist()->name(), sourceRow ) < sourceRow ) );
+}
+
+
+bool
+PlayableProxyModel::visibilityFilterAcceptsRow( const PlayableProxyModelFilterIndex& index ) const
+{
+    if ( m_maxVisibleItems <= 0 )
+        return true;
 
-    return ( items < m_maxVisibleItems );
+    return index.visible < m_maxVisibleItems;
 }
 
 
@@ -347,6 +480,7 @@ void
 PlayableProxyModel::setShowOfflineResults( bool b )
 {
     m_showOfflineResults = b;
+    m_filterIndex.clear();
     invalidateFilter();
 }
 
@@ -355,6 +489,7 @@ void
 PlayableProxyModel::setHideDupeItems( bool b )
 {
     m_hideDupeItems = b;
+    m_filterIndex.clear();
     invalidateFilter();
 }
 
@@ -366,6 +501,7 @@ PlayableProxyModel::setMaxVisibleItems( int items )
         return;
 
     m_maxVisibleItems = items;
+    m_filterIndex.clear();
     invalidateFilter();
 }
 
@@ -374,13 +510,9 @@ bool
 PlayableProxyModel::lessThan( int column, const Tomahawk::query_ptr& q1, const Tomahawk::query_ptr& q2 ) const
 {
     // Attention: This function may be called very often!
-    // So be aware of its performance.
+    // So be aware of its performance: all strings are compared by their precomputed collation keys.
     const Tomahawk::track_ptr& t1 = q1->track();
     const Tomahawk::track_ptr& t2 = q2->track();
-    const QString& artist1 = t1->artistSortname();
-    const QString& artist2 = t2->artistSortname();
-    const QString& album1 = t1->albumSortname();
-    const QString& album2 = t2->albumSortname();
     const unsigned int albumpos1 = t1->albumpos();
     const unsigned int albumpos2 = t2->albumpos();
     const unsigned int discnumber1 = t1->discnumber();
@@ -388,72 +520,30 @@ PlayableProxyModel::lessThan( int column, const Tomahawk::query_ptr& q1, const T
     const qint64 id1 = (qint64)&q1;
     const qint64 id2 = (qint64)&q2;
 
-    if ( column == PlayableModel::Artist ) // sort by artist
-    {
-        if ( artist1 == artist2 )
-        {
-            if ( album1 == album2 )
-            {
-                if ( discnumber1 == discnumber2 )
-                {
-                    if ( albumpos1 == albumpos2 )
-                        return id1 < id2;
-
-                    return albumpos1 < albumpos2;
-                }
-
-                return discnumber1 < discnumber2;
-            }
-
-            return QString::localeAwareCompare( album1, album2 ) < 0;
-        }
-
-        return QString::localeAwareCompare( artist1, artist2 ) < 0;
-    }
-
-    // Sort by Composer
-    const QString& composer1 = t1->composerSortname();
-    const QString& composer2 = t2->composerSortname();
-    if ( column == PlayableModel::Composer )
+    if ( column == PlayableModel::Artist || column == PlayableModel::Composer || column == PlayableModel::Album )
     {
-        if ( composer1 == composer2 )
-        {
-            if ( album1 == album2 )
-            {
-                if ( discnumber1 == discnumber2 )
-                {
-                    if ( albumpos1 == albumpos2 )
-                        return id1 < id2;
-
-                    return albumpos1 < albumpos2;
-                }
-
-                return discnumber1 < discnumber2;
-            }
-
-            return QString::localeAwareCompare( album1, album2 ) < 0;
-        }
+        int cmp = 0;
+        if ( column == PlayableModel::Artist ) // sort by artist
+            cmp = t1->artistSortKey().compare( t2->artistSortKey() );
+        else if ( column == PlayableModel::Composer ) // sort by composer
+            cmp = t1->composerSortKey().compare( t2->composerSortKey() );
+        if ( cmp != 0 )
+            return cmp < 0;
 
-        return QString::localeAwareCompare( composer1, composer2 ) < 0;
-    }
+        // then by album
+        cmp = t1->albumSortKey().compare( t2->albumSortKey() );
+        if ( cmp != 0 )
+            return cmp < 0;
 
-    // Sort by Album
-    if ( column == PlayableModel::Album ) // sort by album
-    {
-        if ( album1 == album2 )
+        if ( discnumber1 == discnumber2 )
         {
-            if ( discnumber1 == discnumber2 )
-            {
-                if ( albumpos1 == albumpos2 )
-                    return id1 < id2;
+            if ( albumpos1 == albumpos2 )
+                return id1 < id2;
 
-                return albumpos1 < albumpos2;
-            }
-
-            return discnumber1 < discnumber2;
+            return albumpos1 < albumpos2;
         }
 
-        return QString::localeAwareCompare( album1, album2 ) < 0;
+        return discnumber1 < discnumber2;
     }
 
     // Lazy load these variables, they are not used before.
@@ -472,7 +562,8 @@ PlayableProxyModel::lessThan( int column, const Tomahawk::query_ptr& q1, const T
         size1 = r->size();
         year1 = r->track()->year();
         score1 = q1->score();
-        origin1 = r->friendlySource().toLower();
+        if ( column == PlayableModel::Origin )
+            origin1 = r->friendlySource();
     }
     if ( !q2->results().isEmpty() )
     {
@@ -482,7 +573,8 @@ PlayableProxyModel::lessThan( int column, const Tomahawk::query_ptr& q1, const T
         size2 = r->size();
         year2 = r->track()->year();
         score2 = q2->score();
-        origin2 = r->friendlySource().toLower();
+        if ( column == PlayableModel::Origin )
+            origin2 = r->friendlySource();
     }
 
     // Sort by bitrate
@@ -533,10 +625,11 @@ PlayableProxyModel::lessThan( int column, const Tomahawk::query_ptr& q1, const T
     }
     else if ( column == PlayableModel::Origin ) // sort by file origin
     {
-        if ( origin1 == origin2 )
+        const int cmp = origin1.compare( origin2, Qt::CaseInsensitive );
+        if ( cmp == 0 )
             return id1 < id2;
 
-        return origin1 < origin2;
+        return cmp < 0;
     }
     else if ( column == PlayableModel::AlbumPos ) // sort by album pos
     {
@@ -551,12 +644,11 @@ PlayableProxyModel::lessThan( int column, const Tomahawk::query_ptr& q1, const T
         }
     }
 
-    const QString& lefts = t1->track();
-    const QString& rights = t2->track();
-    if ( lefts == rights )
+    const int cmp = t1->trackSortKey().compare( t2->trackSortKey() );
+    if ( cmp == 0 )
         return id1 < id2;
 
-    return QString::localeAwareCompare( lefts, rights ) < 0;
+    return cmp < 0;
 }
 
 
@@ -565,10 +657,10 @@ PlayableProxyModel::lessThan( const Tomahawk::album_ptr& album1, const Tomahawk:
 {
     if ( album1->artist() == album2->artist() )
     {
-        return QString::localeAwareCompare( album1->sortname(), album2->sortname() ) < 0;
+        return album1->sortKey().compare( album2->sortKey() ) < 0;
     }
 
-    return QString::localeAwareCompare( album1->artist()->sortname(), album2->artist()->sortname() ) < 0;
+    return album1->artist()->sortKey().compare( album2->artist()->sortKey() ) < 0;
 }
 
 
@@ -27,18 +27,37 @@
 
 #include "DllMacro.h"
 
-class PlayableProxyModelFilterMemo
+/**
+ * Filter results for the children of one source parent, computed in a single
+ * pass from the first row on. Holds the first accepted row for every duplicate
+ * key, so hiding duplicates and limiting the number of visible items cost O(1)
+ * per row instead of a scan over all previous rows.
+ */
+class PlayableProxyModelFilterIndex
 {
 public:
-    PlayableProxyModelFilterMemo()
+    PlayableProxyModelFilterIndex() : visible( 0 ) {}
+
+    /// What a row is compared by when hiding duplicates, empty unless it was accepted
+    struct DupeKeys
     {
-        // First element always has no predecessors.
-        // TODO C++11: Make this a constexpr using initializer lists.
-        visibilty.push_back( 0 );
-    }
+        DupeKeys() : album( 0 ) {}
+
+        QString track;
+        Tomahawk::Album* album;
+        QString artist;
+    };
+
+    /// Forgets everything from @p row on, it will be filtered again when asked for
+    void truncate( int row );
 
-    virtual ~PlayableProxyModelFilterMemo() {}
-    std::vector<int> visibilty;
+    std::vector<bool> accepted;
+    std::vector<DupeKeys> keys;
+    int visible;
+
+    QHash< QString, int > tracks;
+    QHash< Tomahawk::Album*, int > albums;
+    QHash< QString, int > artists;
 };
 
 class DLLEXPORT PlayableProxyModel : public QSortFilterProxyModel
@@ -132,11 +151,18 @@ private slots:
     void selectRequested( const QPersistentModelIndex& index );
     void onCurrentIndexChanged( const QModelIndex& newIndex, const QModelIndex& oldIndex );
 
+    void onSourceRowsChanged( const QModelIndex& parent, int first );
+    void onSourceDataChanged( const QModelIndex& topLeft, const QModelIndex& bottomRight );
+    void clearFilterIndex();
+
 private:
-    bool filterAcceptsRowInternal( int sourceRow, PlayableItem* pi, const QModelIndex& sourceParent, PlayableProxyModelFilterMemo& memo ) const;
+    const PlayableProxyModelFilterIndex& filterIndex( int sourceRow, const QModelIndex& sourceParent ) const;
+    void truncateFilterIndex( const QModelIndex& sourceParent, int sourceRow );
+
+    bool filterAcceptsRowInternal( int sourceRow, PlayableItem* pi, const QModelIndex& sourceParent, const PlayableProxyModelFilterIndex& index ) const;
     bool nameFilterAcceptsRow( int sourceRow, PlayableItem* pi, const QModelIndex& sourceParent ) const;
-    bool dupeFilterAcceptsRow( int sourceRow, PlayableItem* pi, const QModelIndex& sourceParent, PlayableProxyModelFilterMemo& memo ) const;
-    bool visibilityFilterAcceptsRow( int sourceRow, const QModelIndex& sourceParent, PlayableProxyModelFilterMemo& memo ) const;
+    bool dupeFilterAcceptsRow( int sourceRow, PlayableItem* pi, const PlayableProxyModelFilterIndex& index ) const;
+    bool visibilityFilterAcceptsRow( const PlayableProxyModelFilterIndex& index ) const;
 
     bool lessThan( int column, const Tomahawk::query_ptr& left, const Tomahawk::query_ptr& right ) const;
     bool lessThan( const Tomahawk::album_ptr& album1, const Tomahawk::album_ptr& album2 ) const;
@@ -148,6 +174,10 @@ private:
     bool m_hideDupeItems;
     int m_maxVisibleItems;
 
+    // only used while hiding duplicates or limiting the visible items, keyed by source parent
+    mutable QHash< PlayableItem*, PlayableProxyModelFilterIndex > m_filterIndex;
+    mutable QString m_filterIndexPattern;
+
     QHash< PlayableItemStyle, QList<PlayableModel::Columns> > m_headerStyle;
     PlayableItemStyle m_style;
 };
@@ -24,12 +24,12 @@
 #include "Source.h"
 #include "Query.h"
 #include "database/Database.h"
-#include "database/DatabaseImpl.h"
 #include "collection/AlbumsRequest.h"
 #include "collection/ArtistsRequest.h"
 #include "database/DatabaseCommand_AllAlbums.h"
 #include "PlayableItem.h"
 #include "utils/Logger.h"
+#include "utils/TomahawkUtils.h"
 
 #include <QListView>
 
@@ -342,39 +342,38 @@ TreeProxyModel::lessThan( const QModelIndex& left, const QModelIndex& right ) co
             return albumpos1 < albumpos2;
     }
 
-    const QString& lefts = textForItem( p1 );
-    const QString& rights = textForItem( p2 );
-    if ( lefts == rights )
+    const int cmp = sortKeyForItem( p1 ).compare( sortKeyForItem( p2 ) );
+    if ( cmp == 0 )
         return (qint64)&p1 < (qint64)&p2;
 
-    return QString::localeAwareCompare( lefts, rights ) < 0;
+    return cmp < 0;
 }
 
 
-QString
-TreeProxyModel::textForItem( PlayableItem* item ) const
+QCollatorSortKey
+TreeProxyModel::sortKeyForItem( PlayableItem* item ) const
 {
     if ( !item )
-        return QString();
+        return TomahawkUtils::collationKey( QString() );
 
     if ( !item->artist().isNull() )
     {
-        return item->artist()->sortname();
+        return item->artist()->sortKey();
     }
     else if ( !item->album().isNull() )
     {
-        return Tomahawk::DatabaseImpl::sortname( item->album()->name() );
+        return item->album()->sortKey();
     }
     else if ( !item->result().isNull() )
     {
-        return item->result()->track()->trackSortname();
+        return item->result()->track()->trackSortKey();
     }
     else if ( !item->query().isNull() )
     {
-        return item->query()->track()->track();
+        return item->query()->track()->trackSortKey();
     }
 
-    return QString();
+    return TomahawkUtils::collationKey( QString() );
 }
 
 
@@ -24,6 +24,8 @@
 #include "TreeModel.h"
 #include "PlayableProxyModel.h"
 
+#include <QCollator>
+
 #include "DllMacro.h"
 
 namespace Tomahawk
@@ -69,7 +71,7 @@ private slots:
 
 private:
     void filterFinished();
-    QString textForItem( PlayableItem* item ) const;
+    QCollatorSortKey sortKeyForItem( PlayableItem* item ) const;
 
     mutable QMap< QPersistentModelIndex, Tomahawk::query_ptr > m_cache;
 
@@ -20,6 +20,7 @@
 
 #include "../utils/Json.h"
 #include "../utils/Logger.h"
+#include "JSBridge.h"
 #include "ScriptEngine.h"
 #include "ScriptJob.h"
 #include "ScriptObject.h"
@@ -34,6 +35,7 @@ using namespace Tomahawk;
 JSAccount::JSAccount( const QString& name )
     : ScriptAccount( name )
     , m_engine( new ScriptEngine( this ) )
+    , m_bridge( new JSBridge( this ) )
 {
 }
 
@@ -45,6 +47,13 @@ JSAccount::addToJavaScriptWindowObject( const QString& name, QObject* object )
 }
 
 
+JSBridge*
+JSAccount::bridge() const
+{
+    return m_bridge;
+}
+
+
 void
 JSAccount::setResolver( JSResolver* resolver )
 {
@@ -139,22 +148,8 @@ JSAccount::loadScripts( const QStringList& paths )
 void
 JSAccount::startJob( ScriptJob* scriptJob )
 {
-    QString eval = QString(
-        "Tomahawk.PluginManager.invoke("
-        "'%1'," // requestId
-        "'%2'," // objectId
-        "'%3'," // methodName
-        "%4"    // arguments
-        ");"
-    ).arg( scriptJob->id() )
-    .arg( scriptJob->scriptObject()->id() )
-    .arg( scriptJob->methodName() )
-    .arg( serializeQVariantMap( scriptJob->arguments() ) );
-
-    // Remove when new scripting api turned out to work reliably
-    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << eval;
-
-    evaluateJavaScript( eval );
+    // goes out with the next batch, see JSBridge
+    m_bridge->post( scriptJob );
 }
 
 
@@ -181,36 +176,14 @@ JSAccount::syncInvoke( const scriptobject_ptr& scriptObject, const QString& meth
 void
 JSAccount::reportNativeScriptJobResult( int resultId, const QVariantMap& result )
 {
-    QString eval = QString(
-        "Tomahawk.NativeScriptJobManager.reportNativeScriptJobResult("
-        "%1," // requestId
-        "%2"    // results
-        ");"
-    ).arg( resultId )
-    .arg( serializeQVariantMap( result ) );
-
-    // Remove when new scripting api turned out to work reliably
-    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << eval;
-
-    evaluateJavaScript( eval );
+    m_bridge->postNativeResult( resultId, result );
 }
 
 
 void
 JSAccount::reportNativeScriptJobError( int resultId, const QVariantMap& error )
 {
-    QString eval = QString(
-        "Tomahawk.NativeScriptJobManager.reportNativeScriptJobError("
-        "%1," // requestId
-        "%2"    // results
-        ");"
-    ).arg( resultId )
-    .arg( serializeQVariantMap( error ) );
-
-    // Remove when new scripting api turned out to work reliably
-    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << eval;
-
-    evaluateJavaScript( eval );
+    m_bridge->postNativeError( resultId, error );
 }
 
 
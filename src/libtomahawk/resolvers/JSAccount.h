@@ -33,6 +33,7 @@
 namespace Tomahawk
 {
 //TODO: pimple
+class JSBridge;
 class ScriptEngine;
 class JSResolver;
 
@@ -66,6 +67,11 @@ public:
     void loadScripts( const QStringList& paths );
     void addToJavaScriptWindowObject( const QString& name, QObject* object );
 
+    /**
+    * Queues jobs and native job results to be handed to the script in batches
+    */
+    JSBridge* bridge() const;
+
     void setResolver( JSResolver* resolver );
     void scriptPluginFactory( const QString& type, const scriptobject_ptr& object ) override;
 
@@ -83,6 +89,7 @@ private:
     QVariant evaluateJavaScriptInternal( const QString& scriptSource );
 
     ScriptEngine* m_engine;
+    JSBridge* m_bridge;
     // HACK: the order of initializen is flawed, tbr
     JSResolver* m_resolver;
 };
@@ -0,0 +1,197 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "JSBridge.h"
+
+#include "../utils/Logger.h"
+#include "JSAccount.h"
+#include "ScriptJob.h"
+#include "ScriptObject.h"
+
+#include <QImage>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QThread>
+
+using namespace Tomahawk;
+
+
+JSBridge::JSBridge( JSAccount* account )
+    : QObject( account )
+    , m_account( account )
+    , m_flushScheduled( false )
+{
+    m_clock.start();
+}
+
+
+JSBridge::~JSBridge()
+{
+}
+
+
+QVariantMap
+JSBridge::scriptable( const QVariantMap& map )
+{
+    QVariantMap localMap = map;
+
+    foreach( const QString& key, localMap.keys() )
+    {
+        if ( localMap[ key ].canConvert< QImage >() )
+            localMap.remove( key );
+    }
+
+    // the page would turn e.g. dates into Date objects, scripts expect what they used to get as JSON
+    return QJsonObject::fromVariantMap( localMap ).toVariantMap();
+}
+
+
+void
+JSBridge::post( ScriptJob* job )
+{
+    QVariantMap call;
+    call[ "requestId" ] = job->id();
+    call[ "objectId" ] = job->scriptObject()->id();
+    call[ "methodName" ] = job->methodName();
+    call[ "arguments" ] = scriptable( job->arguments() );
+
+    connect( job, SIGNAL( destroyed( QString ) ), SLOT( onJobDestroyed( QString ) ) );
+
+    QMutexLocker lock( &m_mutex );
+    m_jobs << call;
+    m_postedAt.insert( job->id(), m_clock.elapsed() );
+
+    m_stats.calls++;
+    m_stats.queued = m_jobs.count();
+    m_stats.maxQueued = qMax( m_stats.maxQueued, m_stats.queued );
+    m_stats.inFlight = m_postedAt.count();
+
+    scheduleFlush();
+}
+
+
+void
+JSBridge::postNativeResult( int resultId, const QVariantMap& result )
+{
+    QVariantMap report;
+    report[ "requestId" ] = resultId;
+    report[ "result" ] = scriptable( result );
+
+    QMutexLocker lock( &m_mutex );
+    m_nativeResults << report;
+    scheduleFlush();
+}
+
+
+void
+JSBridge::postNativeError( int resultId, const QVariantMap& error )
+{
+    QVariantMap report;
+    report[ "requestId" ] = resultId;
+    report[ "error" ] = scriptable( error );
+
+    QMutexLocker lock( &m_mutex );
+    m_nativeResults << report;
+    scheduleFlush();
+}
+
+
+void
+JSBridge::scheduleFlush()
+{
+    // m_mutex must be held
+    if ( m_flushScheduled )
+        return;
+
+    m_flushScheduled = true;
+    QMetaObject::invokeMethod( this, "flush", Qt::QueuedConnection );
+}
+
+
+void
+JSBridge::flush()
+{
+    Q_ASSERT( QThread::currentThread() == thread() );
+
+    QVariantList jobs;
+    QVariantList nativeResults;
+    {
+        QMutexLocker lock( &m_mutex );
+        jobs = m_jobs;
+        nativeResults = m_nativeResults;
+        m_jobs.clear();
+        m_nativeResults.clear();
+        m_flushScheduled = false;
+
+        m_stats.queued = 0;
+        if ( !jobs.isEmpty() )
+            m_stats.batches++;
+    }
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << m_account->name() << "Dispatching" << jobs.count() << "jobs and" << nativeResults.count() << "native results";
+
+    if ( !nativeResults.isEmpty() )
+        emit this->nativeResults( nativeResults );
+    if ( !jobs.isEmpty() )
+        emit dispatch( jobs );
+}
+
+
+void
+JSBridge::reportResults( const QVariantList& results )
+{
+    if ( m_account->isStopped() )
+        return;
+
+    foreach ( const QVariant& v, results )
+    {
+        const QVariantMap result = v.toMap();
+        {
+            QMutexLocker lock( &m_mutex );
+            const QString requestId = result[ "requestId" ].toString();
+            if ( m_postedAt.contains( requestId ) )
+            {
+                const qint64 latency = m_clock.elapsed() - m_postedAt.take( requestId );
+                m_stats.answered++;
+                m_stats.totalLatencyMs += latency;
+                m_stats.maxLatencyMs = qMax( m_stats.maxLatencyMs, latency );
+                m_stats.inFlight = m_postedAt.count();
+            }
+        }
+
+        m_account->reportScriptJobResult( result );
+    }
+}
+
+
+void
+JSBridge::onJobDestroyed( const QString& requestId )
+{
+    // the job went away without the script ever answering it
+    QMutexLocker lock( &m_mutex );
+    m_postedAt.remove( requestId );
+    m_stats.inFlight = m_postedAt.count();
+}
+
+
+JSBridge::Statistics
+JSBridge::statistics() const
+{
+    QMutexLocker lock( &m_mutex );
+    return m_stats;
+}
@@ -0,0 +1,112 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_JSBRIDGE_H
+#define TOMAHAWK_JSBRIDGE_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QVariantList>
+
+#include "DllMacro.h"
+
+namespace Tomahawk
+{
+
+class JSAccount;
+class ScriptJob;
+
+/**
+ * Message channel between a JSAccount and its script, exposed to the page as
+ * TomahawkBridge.
+ *
+ * Instead of evaluating a freshly built snippet of JavaScript for every call,
+ * jobs and native job results are queued and handed to the page once per event
+ * loop turn, as a single signal carrying the whole batch. tomahawk.js connects
+ * its dispatch functions to those signals once, so nothing needs to be parsed
+ * or compiled per call. Results come back batched the same way, through
+ * reportResults().
+ */
+class DLLEXPORT JSBridge : public QObject
+{
+Q_OBJECT
+
+public:
+    struct Statistics
+    {
+        Statistics() : calls( 0 ), batches( 0 ), answered( 0 ), queued( 0 ), maxQueued( 0 ), inFlight( 0 ), totalLatencyMs( 0 ), maxLatencyMs( 0 ) {}
+
+        int calls;
+        int batches;
+        int answered;
+        int queued;
+        int maxQueued;
+        int inFlight;
+        qint64 totalLatencyMs;
+        qint64 maxLatencyMs;
+
+        qint64 averageLatencyMs() const { return answered ? totalLatencyMs / answered : 0; }
+    };
+
+    explicit JSBridge( JSAccount* account );
+    virtual ~JSBridge();
+
+    /// Queues @p job for the next batch, can be called from any thread
+    void post( ScriptJob* job );
+    void postNativeResult( int resultId, const QVariantMap& result );
+    void postNativeError( int resultId, const QVariantMap& error );
+
+    Statistics statistics() const;
+
+    /// Reduces @p map to what JSON can express, dropping images
+    static QVariantMap scriptable( const QVariantMap& map );
+
+public slots:
+    /// Called by the script with a batch of { requestId, data } or { requestId, error } maps
+    void reportResults( const QVariantList& results );
+
+signals:
+    /// A batch of { requestId, objectId, methodName, arguments } maps for the script to invoke
+    void dispatch( const QVariantList& jobs );
+    /// A batch of { requestId, result } or { requestId, error } maps for native jobs the script started
+    void nativeResults( const QVariantList& results );
+
+private slots:
+    void flush();
+    void onJobDestroyed( const QString& requestId );
+
+private:
+    void scheduleFlush();
+
+    JSAccount* m_account;
+
+    mutable QMutex m_mutex;
+    QVariantList m_jobs;
+    QVariantList m_nativeResults;
+    bool m_flushScheduled;
+
+    QElapsedTimer m_clock;
+    QHash< QString, qint64 > m_postedAt;
+    Statistics m_stats;
+};
+
+} // ns: Tomahawk
+
+#endif // TOMAHAWK_JSBRIDGE_H
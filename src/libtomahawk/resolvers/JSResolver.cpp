@@ -44,6 +44,7 @@
 #include "Track.h"
 #include "ScriptInfoPlugin.h"
 #include "JSAccount.h"
+#include "JSBridge.h"
 #include "ScriptJob.h"
 
 // lookupUrl stuff
@@ -220,6 +221,7 @@ JSResolver::init()
     {
         // add c++ part of tomahawk javascript library
         d->scriptAccount->addToJavaScriptWindowObject( "Tomahawk", d->resolverHelper );
+        d->scriptAccount->addToJavaScriptWindowObject( "TomahawkBridge", d->scriptAccount->bridge() );
 
         // load es6-promises shim
         d->scriptAccount->loadScript( RESPATH "js/rsvp-latest.min.js" );
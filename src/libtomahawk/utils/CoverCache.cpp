@@ -0,0 +1,337 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CoverCache.h"
+
+#include "utils/Logger.h"
+#include "TomahawkSettings.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QMutexLocker>
+#include <QPixmapCache>
+#include <QSaveFile>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+
+// the thumbnails on disk get pruned to this many bytes, the least recently used ones first
+#define COVER_CACHE_MAX_DISK_SIZE 256 * 1024 * 1024
+
+QAtomicPointer< CoverCache > CoverCache::s_instance;
+
+
+static QImage
+squareCenterImage( const QImage& image )
+{
+    if ( image.width() == image.height() )
+        return image;
+
+    const int sqwidth = qMin( image.width(), image.height() );
+    if ( image.width() > image.height() )
+        return image.copy( ( image.width() - sqwidth ) / 2, 0, sqwidth, sqwidth );
+    else
+        return image.copy( 0, ( image.height() - sqwidth ) / 2, sqwidth, sqwidth );
+}
+
+
+CoverCache*
+CoverCache::instance()
+{
+    // created exactly once, and living in the GUI thread even if a worker asks first:
+    // pixmaps only get made in its slots
+    static CoverCache* instance = []()
+    {
+        CoverCache* cache = new CoverCache();
+        cache->moveToThread( QCoreApplication::instance()->thread() );
+        s_instance.storeRelease( cache );
+        return cache;
+    }();
+
+    return instance;
+}
+
+
+CoverCache::CoverCache()
+    : QObject( 0 )
+    , m_dir( TomahawkSettings::instance()->storageCacheLocation() + "/Covers/" )
+{
+    QDir().mkpath( m_dir );
+
+    QtConcurrent::run( &CoverCache::pruneDirectory, m_dir, (qint64)COVER_CACHE_MAX_DISK_SIZE );
+}
+
+
+static bool
+lessRecentlyUsed( const QFileInfo& left, const QFileInfo& right )
+{
+    return qMax( left.lastRead(), left.lastModified() ) < qMax( right.lastRead(), right.lastModified() );
+}
+
+
+void
+CoverCache::pruneDirectory( const QString& path, qint64 maxSize )
+{
+    QFileInfoList files = QDir( path ).entryInfoList( QDir::Files );
+
+    qint64 size = 0;
+    foreach ( const QFileInfo& file, files )
+        size += file.size();
+
+    if ( size <= maxSize )
+        return;
+
+    std::sort( files.begin(), files.end(), lessRecentlyUsed );
+
+    int removed = 0;
+    for ( int i = 0; i < files.count() && size > maxSize; i++ )
+    {
+        if ( QFile::remove( files.at( i ).absoluteFilePath() ) )
+        {
+            size -= files.at( i ).size();
+            removed++;
+        }
+    }
+
+    tDebug() << Q_FUNC_INFO << "Removed" << removed << "cover thumbnails," << size << "bytes left";
+}
+
+
+QList< int >
+CoverCache::pyramidSizes()
+{
+    return QList< int >() << 32 << 64 << 128 << 256 << 512;
+}
+
+
+QString
+CoverCache::cacheKey( const QString& key, const QSize& size )
+{
+    return QString( "cover_%1_%2_%3" ).arg( key ).arg( size.width() ).arg( size.height() );
+}
+
+
+QString
+CoverCache::thumbnailPath( const QString& path, int size )
+{
+    return QString( "%1_%2.png" ).arg( path ).arg( size );
+}
+
+
+void
+CoverCache::decode( const QString& key, const QByteArray& data, QObject* receiver, const char* slot )
+{
+    const QString hash = QCryptographicHash::hash( data, QCryptographicHash::Md5 ).toHex();
+    {
+        QMutexLocker lock( &m_mutex );
+
+        Entry& entry = m_entries[ key ];
+        entry.receiver = receiver;
+        entry.slot = slot;
+        entry.decoding = true;
+        entry.hash = hash;
+    }
+
+    QFutureWatcher< Decoded >* watcher = new QFutureWatcher< Decoded >( this );
+    connect( watcher, SIGNAL( finished() ), SLOT( onDecoded() ) );
+    watcher->setFuture( QtConcurrent::run( &CoverCache::decodeImage, key, data, m_dir + hash ) );
+}
+
+
+bool
+CoverCache::isDecoding( const QString& key ) const
+{
+    QMutexLocker lock( &m_mutex );
+    return m_entries.value( key ).decoding;
+}
+
+
+CoverCache::Decoded
+CoverCache::decodeImage( const QString& key, const QByteArray& data, const QString& path )
+{
+    Decoded decoded;
+    decoded.key = key;
+
+    QImage image;
+    if ( !image.loadFromData( data ) )
+        return decoded;
+
+    decoded.image = squareCenterImage( image );
+
+    // each level is scaled from the one above, that's a lot cheaper than starting from the full size every time
+    QImage source = decoded.image;
+    QList< int > sizes = pyramidSizes();
+    for ( int i = sizes.count() - 1; i >= 0; i-- )
+    {
+        const int size = sizes.at( i );
+        if ( size > decoded.image.width() )
+            continue;
+
+        QImage level;
+        const QString file = thumbnailPath( path, size );
+        if ( !QFile::exists( file ) || !level.load( file ) || level.width() != size )
+        {
+            level = source.scaled( size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation );
+
+            // another decode of the same cover might be writing it too, nobody gets to see half a file
+            QSaveFile out( file );
+            if ( out.open( QIODevice::WriteOnly ) && level.save( &out, "PNG" ) )
+                out.commit();
+        }
+
+        decoded.pyramid.prepend( level );
+        source = level;
+    }
+
+    return decoded;
+}
+
+
+CoverCache::Scaled
+CoverCache::scaleImage( const QString& key, const QString& cacheKey, const QImage& image, const QSize& size, const QString& path )
+{
+    Scaled scaled;
+    scaled.key = key;
+    scaled.cacheKey = cacheKey;
+
+    // the pyramid got kicked out of the QPixmapCache, but it's still on disk
+    if ( size.width() == size.height() && pyramidSizes().contains( size.width() ) && scaled.image.load( thumbnailPath( path, size.width() ) ) )
+        return scaled;
+
+    scaled.image = image.scaled( size, Qt::KeepAspectRatio, Qt::SmoothTransformation );
+    return scaled;
+}
+
+
+void
+CoverCache::onDecoded()
+{
+    QFutureWatcher< Decoded >* watcher = static_cast< QFutureWatcher< Decoded >* >( sender() );
+    const Decoded decoded = watcher->result();
+    watcher->deleteLater();
+
+    {
+        QMutexLocker lock( &m_mutex );
+        if ( !m_entries.contains( decoded.key ) )
+            return;
+
+        Entry& entry = m_entries[ decoded.key ];
+        entry.decoding = false;
+        entry.image = decoded.image;
+    }
+
+    foreach ( const QImage& level, decoded.pyramid )
+        QPixmapCache::insert( cacheKey( decoded.key, level.size() ), QPixmap::fromImage( level ) );
+
+    notify( decoded.key );
+}
+
+
+void
+CoverCache::onScaled()
+{
+    QFutureWatcher< Scaled >* watcher = static_cast< QFutureWatcher< Scaled >* >( sender() );
+    const Scaled scaled = watcher->result();
+    watcher->deleteLater();
+
+    {
+        QMutexLocker lock( &m_mutex );
+        if ( !m_entries.contains( scaled.key ) )
+            return;
+
+        m_entries[ scaled.key ].scaling.remove( scaled.cacheKey );
+    }
+
+    QPixmapCache::insert( scaled.cacheKey, QPixmap::fromImage( scaled.image ) );
+    notify( scaled.key );
+}
+
+
+void
+CoverCache::notify( const QString& key )
+{
+    QPointer< QObject > receiver;
+    QByteArray slot;
+    {
+        QMutexLocker lock( &m_mutex );
+        receiver = m_entries.value( key ).receiver;
+        slot = m_entries.value( key ).slot;
+    }
+
+    if ( receiver )
+        QMetaObject::invokeMethod( receiver.data(), slot.constData(), Qt::QueuedConnection );
+}
+
+
+QPixmap
+CoverCache::pixmap( const QString& key, const QSize& size )
+{
+    QMutexLocker lock( &m_mutex );
+
+    QHash< QString, Entry >::iterator it = m_entries.find( key );
+    if ( it == m_entries.end() || it->decoding || it->image.isNull() )
+        return QPixmap();
+
+    const QSize target = size.isEmpty() ? it->image.size() : size;
+    const QString ck = cacheKey( key, target );
+
+    QPixmap pixmap;
+    if ( QPixmapCache::find( ck, &pixmap ) )
+        return pixmap;
+
+    if ( size.isEmpty() )
+    {
+        // no scaling involved, just get it into a pixmap again
+        pixmap = QPixmap::fromImage( it->image );
+        QPixmapCache::insert( ck, pixmap );
+        return pixmap;
+    }
+
+    if ( !it->scaling.contains( ck ) )
+    {
+        it->scaling.insert( ck );
+
+        QFutureWatcher< Scaled >* watcher = new QFutureWatcher< Scaled >( this );
+        connect( watcher, SIGNAL( finished() ), SLOT( onScaled() ) );
+        watcher->setFuture( QtConcurrent::run( &CoverCache::scaleImage, key, ck, it->image, size, m_dir + it->hash ) );
+    }
+
+    return QPixmap();
+}
+
+
+void
+CoverCache::remove( const QString& key )
+{
+    // albums and artists go away on any thread, also during shutdown when it's too late to create us
+    CoverCache* cache = s_instance.loadAcquire();
+    if ( cache )
+        cache->removeEntry( key );
+}
+
+
+void
+CoverCache::removeEntry( const QString& key )
+{
+    QMutexLocker lock( &m_mutex );
+    m_entries.remove( key );
+}
@@ -0,0 +1,121 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COVER_CACHE_H
+#define COVER_CACHE_H
+
+#include <QAtomicPointer>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QPixmap>
+#include <QPointer>
+#include <QSet>
+
+#include "DllMacro.h"
+
+/**
+ * Decodes and scales album and artist covers on worker threads, so painting
+ * never has to.
+ *
+ * decode() turns the raw image data into a square QImage and a pyramid of
+ * thumbnails in pyramidSizes(), which also get stored on disk, keyed by a hash
+ * of the data, so we don't have to scale them again the next time. The least
+ * recently used ones get removed on startup once they take up too much space. pixmap()
+ * only ever hands out what is ready: a size that isn't gets scaled in the
+ * background and a null pixmap returned meanwhile, so callers show their
+ * placeholder. Whenever a cover or one of its sizes is ready, the slot given
+ * to decode() gets invoked.
+ *
+ * Scaled pixmaps live in the QPixmapCache, only the full size image is kept
+ * for as long as its key isn't remove()d.
+ */
+class DLLEXPORT CoverCache : public QObject
+{
+Q_OBJECT
+
+public:
+    static CoverCache* instance();
+
+    /// Square sizes we precompute for every cover
+    static QList< int > pyramidSizes();
+
+    /**
+     * Decodes @p data in the background. Invokes @p slot of @p receiver once the
+     * cover for @p key is ready, and again whenever another size of it is.
+     */
+    void decode( const QString& key, const QByteArray& data, QObject* receiver, const char* slot );
+    bool isDecoding( const QString& key ) const;
+
+    /// The cover for @p key, squared and scaled into @p size, or the full one for an empty size
+    QPixmap pixmap( const QString& key, const QSize& size );
+
+    /// Forgets the cover for @p key, doesn't create the cache if there is none yet
+    static void remove( const QString& key );
+
+private slots:
+    void onDecoded();
+    void onScaled();
+
+private:
+    struct Entry
+    {
+        Entry() : decoding( true ) {}
+
+        QPointer< QObject > receiver;
+        QByteArray slot;
+        bool decoding;
+        QString hash;
+        QImage image;
+        QSet< QString > scaling;
+    };
+
+    struct Decoded
+    {
+        QString key;
+        QImage image;
+        QList< QImage > pyramid;
+    };
+
+    struct Scaled
+    {
+        QString key;
+        QString cacheKey;
+        QImage image;
+    };
+
+    explicit CoverCache();
+
+    static Decoded decodeImage( const QString& key, const QByteArray& data, const QString& path );
+    static Scaled scaleImage( const QString& key, const QString& cacheKey, const QImage& image, const QSize& size, const QString& path );
+    static QString cacheKey( const QString& key, const QSize& size );
+    static QString thumbnailPath( const QString& path, int size );
+    static void pruneDirectory( const QString& path, qint64 maxSize );
+
+    void notify( const QString& key );
+    void removeEntry( const QString& key );
+
+    QString m_dir;
+    QHash< QString, Entry > m_entries;
+    mutable QMutex m_mutex;
+
+    static QAtomicPointer< CoverCache > s_instance;
+};
+
+#endif // COVER_CACHE_H
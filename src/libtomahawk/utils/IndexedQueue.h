@@ -0,0 +1,109 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INDEXEDQUEUE_H
+#define INDEXEDQUEUE_H
+
+#include <QHash>
+#include <QPair>
+
+#include <list>
+
+namespace Tomahawk
+{
+
+namespace Utils
+{
+
+/**
+ * FIFO queue of unique keys, each with a value, where looking up, moving to the
+ * front and removing any key is O(1).
+ *
+ * The entries live in a linked list and a hash maps every key to its list node,
+ * so nothing ever gets shifted around. Not thread-safe.
+ */
+template< class Key, class T >
+class IndexedQueue
+{
+    typedef std::list< QPair< Key, T > > List;
+
+public:
+    IndexedQueue() {}
+
+    int count() const { return m_index.count(); }
+    bool isEmpty() const { return m_index.isEmpty(); }
+    bool contains( const Key& key ) const { return m_index.contains( key ); }
+
+    /// Enqueues @p value at the back, unless @p key is queued already
+    bool append( const Key& key, const T& value )
+    {
+        if ( m_index.contains( key ) )
+            return false;
+
+        m_index.insert( key, m_list.insert( m_list.end(), qMakePair( key, value ) ) );
+        return true;
+    }
+
+    /// Puts @p key at the front, enqueueing @p value if it isn't queued yet
+    void prepend( const Key& key, const T& value )
+    {
+        typename QHash< Key, typename List::iterator >::const_iterator it = m_index.constFind( key );
+        if ( it != m_index.constEnd() )
+            m_list.splice( m_list.begin(), m_list, it.value() );
+        else
+            m_index.insert( key, m_list.insert( m_list.begin(), qMakePair( key, value ) ) );
+    }
+
+    const T& first() const { return m_list.front().second; }
+
+    T takeFirst()
+    {
+        const T value = m_list.front().second;
+        m_index.remove( m_list.front().first );
+        m_list.pop_front();
+
+        return value;
+    }
+
+    bool remove( const Key& key )
+    {
+        typename QHash< Key, typename List::iterator >::iterator it = m_index.find( key );
+        if ( it == m_index.end() )
+            return false;
+
+        m_list.erase( it.value() );
+        m_index.erase( it );
+        return true;
+    }
+
+    void clear()
+    {
+        m_list.clear();
+        m_index.clear();
+    }
+
+private:
+    List m_list;
+    QHash< Key, typename List::iterator > m_index;
+};
+
+} // namespace Utils
+
+} // namespace Tomahawk
+
+#endif // INDEXEDQUEUE_H
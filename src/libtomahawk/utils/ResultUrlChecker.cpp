@@ -19,15 +19,13 @@
 
 #include "ResultUrlChecker.h"
 
-#include <QNetworkAccessManager>
-#include <QNetworkRequest>
 #include <QUrl>
 
 #include "Query.h"
 #include "Result.h"
 #include "Source.h"
 #include "utils/Logger.h"
-#include "utils/NetworkAccessManager.h"
+#include "utils/UrlValidator.h"
 
 using namespace Tomahawk;
 
@@ -38,6 +36,7 @@ ResultUrlChecker::ResultUrlChecker( const query_ptr& query, QObject* userData,
     , m_query( query )
     , m_userData( userData )
     , m_results( results )
+    , m_pending( 0 )
 {
     check();
 }
@@ -53,38 +52,42 @@ ResultUrlChecker::check()
 {
     foreach ( const result_ptr& result, m_results )
     {
-        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Checking http url:" << result->url();
-        QUrl url = QUrl::fromUserInput( result->url() );
-        if ( url.isEmpty() || !url.toString().startsWith( "http" ) )
+        const QString url = result->url();
+        QUrl u = QUrl::fromUserInput( url );
+        if ( u.isEmpty() || !u.toString().startsWith( "http" ) || m_urls.contains( url ) )
             continue;
 
-        NetworkReply* reply = new NetworkReply( Tomahawk::Utils::nam()->head( QNetworkRequest( url ) ) );
-        m_replies.insert( reply, result );
-        connect( reply, SIGNAL( finished() ), SLOT( headFinished() ) );
+        m_urls.insert( url, false );
+        m_pending++;
+        Utils::UrlValidator::instance()->check( url, this, "onUrlsChecked" );
     }
+
+    // nothing worth checking, but our owner still expects to hear back
+    if ( !m_pending )
+        QMetaObject::invokeMethod( this, "done", Qt::QueuedConnection );
 }
 
 
 void
-ResultUrlChecker::headFinished()
+ResultUrlChecker::onUrlsChecked( const QVariantMap& outcomes )
 {
-    NetworkReply* r = qobject_cast<NetworkReply*>( sender() );
-    r->deleteLater();
+    foreach ( const QString& url, outcomes.keys() )
+    {
+        if ( !m_urls.contains( url ) )
+            continue;
 
-    if ( !m_replies.contains( r ) )
-        return;
+        m_urls[ url ] = outcomes.value( url ).toBool();
+        m_pending--;
+    }
 
-    result_ptr result = m_replies.value( r );
-    m_replies.remove( r );
+    if ( m_pending > 0 )
+        return;
 
-    if ( r->reply()->error() == QNetworkReply::NoError )
+    foreach ( const result_ptr& result, m_results )
     {
-        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Found valid http url:" << result->url();
-        m_validResults << result;
+        if ( m_urls.value( result->url() ) )
+            m_validResults << result;
     }
-    else
-        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Found invalid http url:" << result->url() << r->reply()->error();
 
-    if ( m_replies.isEmpty() )
-        emit done();
+    emit done();
 }
@@ -21,14 +21,18 @@
 #define WEB_RESULT_HINT_CHECKER_H
 
 #include "Typedefs.h"
-#include "utils/NetworkReply.h"
 
+#include <QHash>
 #include <QObject>
-#include <QSet>
+#include <QVariantMap>
 
 namespace Tomahawk
 {
 
+/**
+ * Finds out which of the given results have a reachable http url. The actual
+ * checking is left to the shared Utils::UrlValidator.
+ */
 class ResultUrlChecker : public QObject
 {
     Q_OBJECT
@@ -46,14 +50,15 @@ signals:
 
 private slots:
     void check();
-    void headFinished();
+    void onUrlsChecked( const QVariantMap& outcomes );
 
 private:
     query_ptr m_query;
     QObject* m_userData;
     QList< result_ptr > m_results;
     QList< result_ptr > m_validResults;
-    QHash< NetworkReply*, Tomahawk::result_ptr > m_replies;
+    QHash< QString, bool > m_urls;
+    int m_pending;
 };
 
 }
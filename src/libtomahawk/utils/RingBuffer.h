@@ -0,0 +1,120 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+
+#include <string.h>
+
+namespace Tomahawk
+{
+
+namespace Utils
+{
+
+/**
+ * Byte ring buffer for exactly one producer and one consumer thread, without locks.
+ *
+ * Read and write positions only ever grow (wrapping around at 2^32), each is
+ * only stored by its own side, and the capacity is a power of two, so the fill
+ * level is simply their difference. The producer may write directly into the
+ * buffer via writePointer() / commitWrite(), e.g. from QIODevice::read().
+ */
+class RingBuffer
+{
+public:
+    /// @p capacity gets rounded up to a power of two
+    explicit RingBuffer( int capacity )
+        : m_readPos( 0 )
+        , m_writePos( 0 )
+    {
+        int size = 1;
+        while ( size < capacity )
+            size <<= 1;
+
+        m_data.resize( size );
+        m_mask = size - 1;
+    }
+
+    int capacity() const { return m_mask + 1; }
+
+    /// Bytes the consumer can read
+    int available() const
+    {
+        return (int)( (quint32)m_writePos.loadAcquire() - (quint32)m_readPos.loadAcquire() );
+    }
+
+    /// Bytes the producer can write
+    int space() const { return capacity() - available(); }
+
+    /**
+     * Producer: where the next bytes go, and in @p len how many of them fit
+     * there without wrapping around.
+     */
+    char* writePointer( int* len )
+    {
+        const quint32 w = m_writePos.loadAcquire();
+        const int offset = w & m_mask;
+        *len = qMin( space(), capacity() - offset );
+        return m_data.data() + offset;
+    }
+
+    /// Producer: publishes @p len bytes written at writePointer()
+    void commitWrite( int len )
+    {
+        m_writePos.storeRelease( (int)( (quint32)m_writePos.loadAcquire() + len ) );
+    }
+
+    /// Consumer: copies up to @p maxLen bytes into @p data, returns how many
+    int read( char* data, int maxLen )
+    {
+        const quint32 r = m_readPos.loadAcquire();
+        const int len = qMin( available(), maxLen );
+        const int offset = r & m_mask;
+        const int first = qMin( len, capacity() - offset );
+
+        memcpy( data, m_data.constData() + offset, first );
+        memcpy( data + first, m_data.constData(), len - first );
+
+        m_readPos.storeRelease( (int)( r + len ) );
+        return len;
+    }
+
+    /// Empties the buffer. Only while the consumer is known not to read.
+    void clear()
+    {
+        m_readPos.storeRelease( m_writePos.loadAcquire() );
+    }
+
+private:
+    QByteArray m_data;
+    int m_mask;
+    QAtomicInt m_readPos;
+    QAtomicInt m_writePos;
+
+    Q_DISABLE_COPY( RingBuffer )
+};
+
+} // namespace Utils
+
+} // namespace Tomahawk
+
+#endif // RINGBUFFER_H
@@ -0,0 +1,205 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TimerWheel.h"
+
+using namespace Tomahawk::Utils;
+
+
+TimerWheel::TimerWheel( int resolution, QObject* parent )
+    : QObject( parent )
+    , m_resolution( qMax( 1, resolution ) )
+    , m_now( 0 )
+    , m_nextId( 1 )
+    , m_wheelCount( 0 )
+{
+    for ( int i = 0; i < Levels; i++ )
+        m_wheels[ i ].resize( Slots );
+
+    m_clock.start();
+
+    m_tickTimer.setInterval( m_resolution );
+    connect( &m_tickTimer, SIGNAL( timeout() ), SLOT( tick() ) );
+
+    m_deferredTimer.setSingleShot( true );
+    m_deferredTimer.setInterval( 0 );
+    connect( &m_deferredTimer, SIGNAL( timeout() ), SLOT( runDeferred() ) );
+}
+
+
+TimerWheel::~TimerWheel()
+{
+}
+
+
+quint64
+TimerWheel::currentTick() const
+{
+    return m_clock.elapsed() / m_resolution;
+}
+
+
+TimerWheel::TimerId
+TimerWheel::schedule( int msecs, const std::function< void() >& callback )
+{
+    Timeout timeout;
+    timeout.id = m_nextId++;
+    timeout.callback = callback;
+
+    if ( msecs <= 0 )
+    {
+        timeout.expires = 0;
+        m_live.insert( timeout.id, false );
+        m_deferred << timeout;
+        if ( !m_deferredTimer.isActive() )
+            m_deferredTimer.start();
+
+        return timeout.id;
+    }
+
+    if ( !m_tickTimer.isActive() )
+    {
+        // nothing in the wheels is live anymore, so they can skip the ticks we spent idling
+        for ( int i = 0; i < Levels; i++ )
+        {
+            for ( int j = 0; j < Slots; j++ )
+                m_wheels[ i ][ j ].clear();
+        }
+        m_now = currentTick();
+        m_tickTimer.start();
+    }
+
+    // round up, so we never run early
+    timeout.expires = ( m_clock.elapsed() + msecs + m_resolution - 1 ) / m_resolution;
+    m_live.insert( timeout.id, true );
+    m_wheelCount++;
+    insert( timeout );
+
+    return timeout.id;
+}
+
+
+bool
+TimerWheel::cancel( TimerId id )
+{
+    // the timeout stays in its slot, but gets dropped instead of run once it comes up
+    return release( id );
+}
+
+
+bool
+TimerWheel::release( TimerId id )
+{
+    QHash< TimerId, bool >::iterator it = m_live.find( id );
+    if ( it == m_live.end() )
+        return false;
+
+    if ( it.value() )
+        m_wheelCount--;
+    m_live.erase( it );
+
+    return true;
+}
+
+
+void
+TimerWheel::insert( const Timeout& timeout )
+{
+    // anything that is due already goes into the very next tick
+    const quint64 expires = qMax( timeout.expires, m_now + 1 );
+    const quint64 delta = expires - m_now;
+
+    int level = 0;
+    while ( level < Levels - 1 && delta >= ( (quint64)1 << ( SlotBits * ( level + 1 ) ) ) )
+        level++;
+
+    // too far out even for the topmost wheel: park it in its last slot, it gets sorted in again from there
+    quint64 slotTime = expires;
+    if ( delta >= ( (quint64)1 << ( SlotBits * Levels ) ) )
+        slotTime = m_now + ( (quint64)1 << ( SlotBits * Levels ) ) - 1;
+
+    const int slot = ( slotTime >> ( SlotBits * level ) ) & ( Slots - 1 );
+    m_wheels[ level ][ slot ] << timeout;
+}
+
+
+void
+TimerWheel::cascade( int level )
+{
+    const int slot = ( m_now >> ( SlotBits * level ) ) & ( Slots - 1 );
+    const QList< Timeout > timeouts = m_wheels[ level ][ slot ];
+    m_wheels[ level ][ slot ].clear();
+
+    foreach ( const Timeout& timeout, timeouts )
+    {
+        if ( m_live.contains( timeout.id ) )
+            insert( timeout );
+    }
+}
+
+
+void
+TimerWheel::run( const Timeout& timeout )
+{
+    if ( !release( timeout.id ) )
+        return;
+
+    timeout.callback();
+}
+
+
+void
+TimerWheel::tick()
+{
+    const quint64 target = currentTick();
+    while ( m_now < target )
+    {
+        m_now++;
+
+        // a wheel came full circle, spread the next slot of the one above over the ones below
+        for ( int level = 1; level < Levels; level++ )
+        {
+            if ( m_now & ( ( (quint64)1 << ( SlotBits * level ) ) - 1 ) )
+                break;
+
+            cascade( level );
+        }
+
+        const int slot = m_now & ( Slots - 1 );
+        const QList< Timeout > due = m_wheels[ 0 ][ slot ];
+        m_wheels[ 0 ][ slot ].clear();
+
+        foreach ( const Timeout& timeout, due )
+            run( timeout );
+    }
+
+    if ( !m_wheelCount )
+        m_tickTimer.stop();
+}
+
+
+void
+TimerWheel::runDeferred()
+{
+    // callbacks scheduled from in here wait for the next round
+    const QList< Timeout > deferred = m_deferred;
+    m_deferred.clear();
+
+    foreach ( const Timeout& timeout, deferred )
+        run( timeout );
+}
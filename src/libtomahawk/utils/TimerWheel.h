@@ -0,0 +1,116 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+#include <functional>
+
+#include "DllMacro.h"
+
+namespace Tomahawk
+{
+
+namespace Utils
+{
+
+/**
+ * Runs callbacks after a timeout, for lots of timeouts that rarely need to be
+ * precise, e.g. one per resolver request.
+ *
+ * Instead of a QTimer per timeout, there is a single one ticking every
+ * resolution() milliseconds while anything is pending. Timeouts are sorted into
+ * a hierarchy of wheels of 64 slots each, the first one with one slot per tick,
+ * every further one with slots 64 times as long as the wheel below. Whenever a
+ * wheel comes full circle, the next slot of the wheel above gets spread over the
+ * ones below, so scheduling and cancelling are O(1) and every tick only looks at
+ * the timeouts that are due.
+ *
+ * Callbacks run up to one tick late, and never earlier than asked for. A
+ * timeout of 0 runs on the next event loop iteration, in the order scheduled.
+ */
+class DLLEXPORT TimerWheel : public QObject
+{
+Q_OBJECT
+
+public:
+    typedef quint64 TimerId;
+
+    explicit TimerWheel( int resolution = 50, QObject* parent = 0 );
+    virtual ~TimerWheel();
+
+    int resolution() const { return m_resolution; }
+
+    /// Runs @p callback in @p msecs milliseconds, unless cancelled before
+    TimerId schedule( int msecs, const std::function< void() >& callback );
+    /// Returns false if the timeout already ran or was cancelled before
+    bool cancel( TimerId id );
+
+    /// How many timeouts are still waiting to run
+    int pending() const { return m_live.count(); }
+
+private slots:
+    void tick();
+    void runDeferred();
+
+private:
+    static const int Levels = 4;
+    static const int SlotBits = 6;
+    static const int Slots = 1 << SlotBits;
+
+    struct Timeout
+    {
+        TimerId id;
+        quint64 expires;
+        std::function< void() > callback;
+    };
+
+    void insert( const Timeout& timeout );
+    void cascade( int level );
+    void run( const Timeout& timeout );
+    /// Forgets about a live timeout, false if it isn't live anymore
+    bool release( TimerId id );
+    quint64 currentTick() const;
+
+    const int m_resolution;
+    QElapsedTimer m_clock;
+    QTimer m_tickTimer;
+    QTimer m_deferredTimer;
+
+    quint64 m_now;
+    TimerId m_nextId;
+    QVector< QList< Timeout > > m_wheels[ Levels ];
+    QList< Timeout > m_deferred;
+    // live timeouts, true for the ones in the wheels rather than in m_deferred
+    QHash< TimerId, bool > m_live;
+    // live timeouts in the wheels, the tick timer stops once there are none
+    int m_wheelCount;
+};
+
+} // namespace Utils
+
+} // namespace Tomahawk
+
+#endif // TIMERWHEEL_H
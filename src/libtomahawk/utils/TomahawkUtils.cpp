@@ -53,13 +53,16 @@
 #include <QNetworkAccessManager>
 #include <QNetworkProxy>
 
+#include <QCollator>
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QDir>
 #include <QMutex>
+#include <QVarLengthArray>
 #include <QCryptographicHash>
 #include <QProcess>
 #include <QStringList>
+#include <QThreadStorage>
 #include <QTranslator>
 
 // Qt version specific includes
@@ -331,30 +334,62 @@ filesizeToString( unsigned int size )
 }
 
 
+static QStringList
+createSupportedExtensions()
+{
+    QStringList extensions;
+    extensions << "mp3"
+               << "ogg" << "oga"
+               << "mpc"
+               << "wma"
+               << "aac" << "m4a" << "mp4"
+               << "flac"
+               << "aiff" << "aif"
+               << "wv";
+
+    #if defined(TAGLIB_MAJOR_VERSION) && defined(TAGLIB_MINOR_VERSION)
+    #if TAGLIB_MAJOR_VERSION >= 1 && TAGLIB_MINOR_VERSION >= 9
+        extensions << "opus";
+    #endif
+    #endif
+
+    return extensions;
+}
+
+
+static QMap<QString, QString>
+createExtensionToMimetype()
+{
+    QMap<QString, QString> ext2mime;
+    ext2mime.insert( "mp3",  "audio/mpeg" );
+    ext2mime.insert( "ogg",  "application/ogg" );
+    ext2mime.insert( "oga",  "application/ogg" );
+#if defined(TAGLIB_MAJOR_VERSION) && defined(TAGLIB_MINOR_VERSION)
+#if TAGLIB_MAJOR_VERSION >= 1 && TAGLIB_MINOR_VERSION >= 9
+    ext2mime.insert( "opus",  "application/opus" );
+#endif
+#endif
+    ext2mime.insert( "mpc",  "audio/x-musepack" );
+    ext2mime.insert( "wma",  "audio/x-ms-wma" );
+    ext2mime.insert( "aac",  "audio/mp4" );
+    ext2mime.insert( "m4a",  "audio/mp4" );
+    ext2mime.insert( "mp4",  "audio/mp4" );
+    ext2mime.insert( "flac", "audio/flac" );
+    ext2mime.insert( "aiff", "audio/aiff" );
+    ext2mime.insert( "aif",  "audio/aiff" );
+    ext2mime.insert( "wv",   "audio/x-wavpack" );
+
+    return ext2mime;
+}
+
+
 QStringList
 supportedExtensions()
 {
     //TODO supportedExtensions() and extensionToMimetype could share a QMap
     //TODO and this method should just return map.keys()
-    static QStringList s_extensions;
-    if ( s_extensions.isEmpty() )
-    {
-        s_extensions << "mp3"
-                     << "ogg" << "oga"
-                     << "mpc"
-                     << "wma"
-                     << "aac" << "m4a" << "mp4"
-                     << "flac"
-                     << "aiff" << "aif"
-                     << "wv";
-
-        #if defined(TAGLIB_MAJOR_VERSION) && defined(TAGLIB_MINOR_VERSION)
-        #if TAGLIB_MAJOR_VERSION >= 1 && TAGLIB_MINOR_VERSION >= 9
-            s_extensions << "opus";
-        #endif
-        #endif
-    }
-
+    // built once by the static initializer, which is thread-safe, the scanner's readers call this concurrently
+    static const QStringList s_extensions = createSupportedExtensions();
     return s_extensions;
 }
 
@@ -362,28 +397,7 @@ supportedExtensions()
 QString
 extensionToMimetype( const QString& extension )
 {
-    static QMap<QString, QString> s_ext2mime;
-    if ( s_ext2mime.isEmpty() )
-    {
-        s_ext2mime.insert( "mp3",  "audio/mpeg" );
-        s_ext2mime.insert( "ogg",  "application/ogg" );
-        s_ext2mime.insert( "oga",  "application/ogg" );
-#if defined(TAGLIB_MAJOR_VERSION) && defined(TAGLIB_MINOR_VERSION)
-#if TAGLIB_MAJOR_VERSION >= 1 && TAGLIB_MINOR_VERSION >= 9
-        s_ext2mime.insert( "opus",  "application/opus" );
-#endif
-#endif
-        s_ext2mime.insert( "mpc",  "audio/x-musepack" );
-        s_ext2mime.insert( "wma",  "audio/x-ms-wma" );
-        s_ext2mime.insert( "aac",  "audio/mp4" );
-        s_ext2mime.insert( "m4a",  "audio/mp4" );
-        s_ext2mime.insert( "mp4",  "audio/mp4" );
-        s_ext2mime.insert( "flac", "audio/flac" );
-        s_ext2mime.insert( "aiff", "audio/aiff" );
-        s_ext2mime.insert( "aif",  "audio/aiff" );
-        s_ext2mime.insert( "wv",   "audio/x-wavpack" );
-    }
-
+    static const QMap<QString, QString> s_ext2mime = createExtensionToMimetype();
     return s_ext2mime.value( extension.toLower(), "unknown" );
 }
 
@@ -399,6 +413,18 @@ msleep( unsigned int ms )
 }
 
 
+QCollatorSortKey
+collationKey( const QString& text )
+{
+    // QCollator is not thread-safe and sort names get updated from any thread
+    static QThreadStorage< QCollator* > collators;
+    if ( !collators.hasLocalData() )
+        collators.setLocalData( new QCollator() );
+
+    return collators.localData()->sortKey( text );
+}
+
+
 int
 levenshtein( const QString& source, const QString& target )
 {
@@ -411,51 +437,47 @@ levenshtein( const QString& source, const QString& target )
     if ( m == 0 )
         return n;
 
-    // Good form to declare a TYPEDEF
-    typedef QVector< QVector<int> > Tmatrix;
-    Tmatrix matrix;
-    matrix.resize( n + 1 );
+    // Only the current row and the two rows above it are ever read, so we
+    // keep three rolling rows instead of the full (n + 1) x (m + 1) matrix.
+    // For typical artist / track names these stay on the stack.
+    typedef QVarLengthArray< int, 128 > Row;
+    Row rowStorage[3];
+    for ( int k = 0; k < 3; k++ )
+        rowStorage[k].resize( m + 1 );
 
-    // Size the vectors in the 2.nd dimension. Unfortunately C++ doesn't
-    // allow for allocation on declaration of 2.nd dimension of vec of vec
-    for ( int i = 0; i <= n; i++ )
-    {
-        QVector<int> tmp;
-        tmp.resize( m + 1 );
-        matrix.insert( i, tmp );
-    }
+    int* twoAbove = rowStorage[0].data();
+    int* above = rowStorage[1].data();
+    int* current = rowStorage[2].data();
+
+    const QChar* s = source.constData();
+    const QChar* t = target.constData();
 
     // Step 2
-    for ( int i = 0; i <= n; i++ )
-        matrix[i][0] = i;
     for ( int j = 0; j <= m; j++ )
-        matrix[0][j] = j;
+        above[j] = j;
 
     // Step 3
     for ( int i = 1; i <= n; i++ )
     {
-        const QChar s_i = source[i - 1];
+        const QChar s_i = s[i - 1];
+        current[0] = i;
 
         // Step 4
         for ( int j = 1; j <= m; j++ )
         {
-            const QChar t_j = target[j - 1];
+            const QChar t_j = t[j - 1];
 
             // Step 5
-            int cost;
-            if ( s_i == t_j )
-                cost = 0;
-            else
-                cost = 1;
+            const int cost = ( s_i == t_j ) ? 0 : 1;
 
             // Step 6
-            const int above = matrix[i - 1][j];
-            const int left = matrix[i][j - 1];
-            const int diag = matrix[i - 1][j - 1];
+            const int up = above[j];
+            const int left = current[j - 1];
+            const int diag = above[j - 1];
 
             int cell = ( ( ( left + 1 ) > ( diag + cost ) ) ? diag + cost : left + 1 );
-            if ( above + 1 < cell )
-                cell = above + 1;
+            if ( up + 1 < cell )
+                cell = up + 1;
 
             // Step 6A: Cover transposition, in addition to deletion,
             // insertion and substitution. This step is taken from:
@@ -464,18 +486,23 @@ levenshtein( const QString& source, const QString& target )
             // (http://www.acm.org/~hlb/publications/asm/asm.html)
             if ( i > 2 && j > 2 )
             {
-                int trans = matrix[i - 2][j - 2] + 1;
+                int trans = twoAbove[j - 2] + 1;
 
-                if ( source[ i - 2 ] != t_j ) trans++;
-                if ( s_i != target[ j - 2 ] ) trans++;
+                if ( s[ i - 2 ] != t_j ) trans++;
+                if ( s_i != t[ j - 2 ] ) trans++;
                 if ( cell > trans ) cell = trans;
             }
-            matrix[i][j] = cell;
+            current[j] = cell;
         }
+
+        int* recycled = twoAbove;
+        twoAbove = above;
+        above = current;
+        current = recycled;
     }
 
     // Step 7
-    return matrix[n][m];
+    return above[m];
 }
 
 
@@ -24,6 +24,7 @@
 
 #include "DllMacro.h"
 
+#include <QtCore/QCollator>
 #include <QtCore/QThread>
 #include <QtNetwork/QNetworkProxy>
 #include <QtCore/QStringList>
@@ -162,6 +163,8 @@ namespace TomahawkUtils
     DLLEXPORT void msleep( unsigned int ms );
     DLLEXPORT bool newerVersion( const QString& oldVersion, const QString& newVersion );
     DLLEXPORT int levenshtein( const QString& source, const QString& target );
+    /// Locale-aware sort key for @p text, comparing two keys is much cheaper than QString::localeAwareCompare()
+    DLLEXPORT QCollatorSortKey collationKey( const QString& text );
 
     DLLEXPORT quint64 infosystemRequestId();
 
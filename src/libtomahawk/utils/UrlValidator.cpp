@@ -0,0 +1,251 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "UrlValidator.h"
+
+#include "utils/Logger.h"
+#include "utils/NetworkAccessManager.h"
+#include "utils/NetworkReply.h"
+
+#include <QCoreApplication>
+#include <QNetworkRequest>
+#include <QThread>
+
+#define VALID_TTL_MS ( 60 * 60 * 1000 )
+#define INVALID_TTL_MS ( 10 * 60 * 1000 )
+#define MAX_CACHED_URLS 20000
+#define MAX_REQUESTS_PER_HOST 4
+
+using namespace Tomahawk::Utils;
+
+UrlValidator*
+UrlValidator::instance()
+{
+    // created exactly once even when several threads ask at the same time,
+    // and the first one to ask might well be a database worker
+    static UrlValidator* instance = []()
+    {
+        UrlValidator* validator = new UrlValidator();
+        validator->moveToThread( QCoreApplication::instance()->thread() );
+        return validator;
+    }();
+
+    return instance;
+}
+
+
+UrlValidator::UrlValidator( QObject* parent )
+    : QObject( parent )
+    , m_maxPerHost( MAX_REQUESTS_PER_HOST )
+    , m_flushScheduled( false )
+    , m_requests( 0 )
+    , m_cacheHits( 0 )
+    , m_deduplicated( 0 )
+{
+    m_clock.start();
+}
+
+
+UrlValidator::~UrlValidator()
+{
+}
+
+
+void
+UrlValidator::setMaxRequestsPerHost( int max )
+{
+    m_maxPerHost = qMax( 1, max );
+}
+
+
+void
+UrlValidator::clear()
+{
+    m_cache.clear();
+}
+
+
+QString
+UrlValidator::hostKey( const QUrl& url )
+{
+    return QString( "%1:%2" ).arg( url.host() ).arg( url.port() );
+}
+
+
+void
+UrlValidator::check( const QString& url, QObject* receiver, const QByteArray& slot )
+{
+    if ( QThread::currentThread() != thread() )
+    {
+        QMetaObject::invokeMethod( this, "check", Qt::QueuedConnection,
+                                   Q_ARG( QString, url ), Q_ARG( QObject*, receiver ), Q_ARG( QByteArray, slot ) );
+        return;
+    }
+
+    Waiter waiter;
+    waiter.receiver = receiver;
+    waiter.slot = slot;
+
+    const QUrl u = QUrl::fromUserInput( url );
+    if ( u.isEmpty() || !u.scheme().startsWith( "http" ) )
+    {
+        complete( waiter, url, false );
+        return;
+    }
+
+    if ( m_cache.contains( url ) )
+    {
+        const Outcome outcome = m_cache.value( url );
+        if ( outcome.expires > m_clock.elapsed() )
+        {
+            m_cacheHits++;
+            complete( waiter, url, outcome.valid );
+            return;
+        }
+
+        m_cache.remove( url );
+    }
+
+    if ( m_waiting.contains( url ) )
+    {
+        // already being checked for someone else
+        m_deduplicated++;
+        m_waiting[ url ] << waiter;
+        return;
+    }
+
+    m_waiting[ url ] << waiter;
+
+    const QString host = hostKey( u );
+    m_queued[ host ].enqueue( url );
+    startNext( host );
+}
+
+
+void
+UrlValidator::startNext( const QString& host )
+{
+    QQueue< QString >& queue = m_queued[ host ];
+    while ( !queue.isEmpty() && m_running.value( host ) < m_maxPerHost )
+    {
+        const QString url = queue.dequeue();
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Checking http url:" << url;
+
+        NetworkReply* reply = new NetworkReply( Tomahawk::Utils::nam()->head( QNetworkRequest( QUrl::fromUserInput( url ) ) ) );
+        connect( reply, SIGNAL( finished() ), SLOT( onHeadFinished() ) );
+
+        m_replies.insert( reply, url );
+        m_running[ host ]++;
+        m_requests++;
+    }
+
+    if ( queue.isEmpty() )
+        m_queued.remove( host );
+}
+
+
+void
+UrlValidator::onHeadFinished()
+{
+    NetworkReply* r = qobject_cast< NetworkReply* >( sender() );
+    r->deleteLater();
+
+    if ( !m_replies.contains( r ) )
+        return;
+
+    const QString url = m_replies.take( r );
+    const bool valid = ( r->reply()->error() == QNetworkReply::NoError );
+    if ( valid )
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Found valid http url:" << url;
+    else
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Found invalid http url:" << url << r->reply()->error();
+
+    Outcome outcome;
+    outcome.valid = valid;
+    outcome.expires = m_clock.elapsed() + ( valid ? VALID_TTL_MS : INVALID_TTL_MS );
+    m_cache.insert( url, outcome );
+    if ( m_cache.count() > MAX_CACHED_URLS )
+        pruneCache();
+
+    foreach ( const Waiter& waiter, m_waiting.take( url ) )
+        complete( waiter, url, valid );
+
+    // counted against the host we asked, wherever we got redirected to
+    const QString host = hostKey( QUrl::fromUserInput( url ) );
+    if ( --m_running[ host ] <= 0 )
+        m_running.remove( host );
+
+    startNext( host );
+}
+
+
+void
+UrlValidator::complete( const Waiter& waiter, const QString& url, bool valid )
+{
+    if ( !waiter.receiver )
+        return;
+
+    m_receivers.insert( waiter.receiver.data(), waiter );
+    m_completed[ waiter.receiver.data() ].insert( url, valid );
+
+    if ( !m_flushScheduled )
+    {
+        m_flushScheduled = true;
+        QMetaObject::invokeMethod( this, "flush", Qt::QueuedConnection );
+    }
+}
+
+
+void
+UrlValidator::flush()
+{
+    const QHash< QObject*, QVariantMap > completed = m_completed;
+    m_completed.clear();
+    m_flushScheduled = false;
+
+    QHash< QObject*, QVariantMap >::const_iterator it = completed.constBegin();
+    for ( ; it != completed.constEnd(); ++it )
+    {
+        const Waiter waiter = m_receivers.take( it.key() );
+        if ( !waiter.receiver )
+            continue;
+
+        QMetaObject::invokeMethod( waiter.receiver.data(), waiter.slot.constData(), Q_ARG( QVariantMap, it.value() ) );
+    }
+}
+
+
+void
+UrlValidator::pruneCache()
+{
+    const qint64 now = m_clock.elapsed();
+
+    QHash< QString, Outcome >::iterator it = m_cache.begin();
+    while ( it != m_cache.end() )
+    {
+        if ( it->expires <= now )
+            it = m_cache.erase( it );
+        else
+            ++it;
+    }
+
+    // still too many that are current, just make room
+    it = m_cache.begin();
+    while ( m_cache.count() > MAX_CACHED_URLS * 3 / 4 && it != m_cache.end() )
+        it = m_cache.erase( it );
+}
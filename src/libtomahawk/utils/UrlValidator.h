@@ -0,0 +1,121 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_URLVALIDATOR_H
+#define TOMAHAWK_URLVALIDATOR_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QQueue>
+#include <QUrl>
+#include <QVariantMap>
+
+#include "DllMacro.h"
+
+class NetworkReply;
+
+namespace Tomahawk
+{
+
+namespace Utils
+{
+
+/**
+ * Checks whether http urls are reachable, with a HEAD request, for everyone
+ * who needs to know, e.g. ResultUrlChecker.
+ *
+ * A url gets requested only once while it is being checked, no matter how many
+ * ask for it, and its outcome is remembered for a while: valid urls for an
+ * hour, invalid ones for ten minutes. No more than maxRequestsPerHost() HEADs
+ * run against the same host at once, the rest wait their turn.
+ *
+ * Outcomes are never reported right away, not even cached ones. Everything that
+ * completed for a receiver during an event loop turn is handed to its slot in
+ * one go, as a QVariantMap from url to bool.
+ */
+class DLLEXPORT UrlValidator : public QObject
+{
+Q_OBJECT
+
+public:
+    static UrlValidator* instance();
+
+    explicit UrlValidator( QObject* parent = 0 );
+    virtual ~UrlValidator();
+
+    /// Checks @p url and invokes @p slot of @p receiver, taking a QVariantMap, with the outcome. Thread-safe.
+    Q_INVOKABLE void check( const QString& url, QObject* receiver, const QByteArray& slot );
+
+    int maxRequestsPerHost() const { return m_maxPerHost; }
+    void setMaxRequestsPerHost( int max );
+
+    /// Forgets all remembered outcomes
+    void clear();
+
+    int requests() const { return m_requests; }
+    int cacheHits() const { return m_cacheHits; }
+    int deduplicated() const { return m_deduplicated; }
+
+private slots:
+    void onHeadFinished();
+    void flush();
+
+private:
+    struct Outcome
+    {
+        bool valid;
+        qint64 expires;
+    };
+
+    struct Waiter
+    {
+        QPointer< QObject > receiver;
+        QByteArray slot;
+    };
+
+    static QString hostKey( const QUrl& url );
+
+    void startNext( const QString& host );
+    void complete( const Waiter& waiter, const QString& url, bool valid );
+    void pruneCache();
+
+    int m_maxPerHost;
+    QElapsedTimer m_clock;
+
+    QHash< QString, Outcome > m_cache;
+    QHash< QString, QList< Waiter > > m_waiting;
+    QHash< QString, QQueue< QString > > m_queued;
+    QHash< QString, int > m_running;
+    QHash< NetworkReply*, QString > m_replies;
+
+    QHash< QObject*, Waiter > m_receivers;
+    QHash< QObject*, QVariantMap > m_completed;
+    bool m_flushScheduled;
+
+    int m_requests;
+    int m_cacheHits;
+    int m_deduplicated;
+};
+
+} // namespace Utils
+
+} // namespace Tomahawk
+
+#endif // TOMAHAWK_URLVALIDATOR_H
@@ -0,0 +1,158 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WEAKREGISTRY_H
+#define WEAKREGISTRY_H
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSharedPointer>
+#include <QWeakPointer>
+
+namespace Tomahawk
+{
+
+namespace Utils
+{
+
+/**
+ * Thread-safe registry of weak references, used to intern the shared objects
+ * handed out by the static get() factories (Result, Track, TrackData).
+ *
+ * Keys are spread over Shards independently locked hashes, so lookups of
+ * different keys rarely contend. Entries only hold weak references; expired
+ * ones are dropped by remove() once their object is gone, and every
+ * SweepInterval inserts a shard is swept for any that were left behind.
+ *
+ * Never let the last strong reference to an object die while calling into the
+ * registry from its deleter: the shard locks are not recursive.
+ */
+template< class Key, class T, int Shards = 16, int SweepInterval = 512 >
+class WeakRegistry
+{
+public:
+    WeakRegistry() {}
+
+    /**
+     * Returns the live object registered for @p key, or a null pointer.
+     */
+    QSharedPointer< T > value( const Key& key ) const
+    {
+        const Shard& s = shard( key );
+        QMutexLocker lock( &s.mutex );
+        return s.hash.value( key ).toStrongRef();
+    }
+
+    /**
+     * Returns the live object registered for @p key. If there is none, @p create
+     * is called with the shard locked and its result is registered and returned,
+     * so concurrent callers always end up with the same object.
+     */
+    template< typename Factory >
+    QSharedPointer< T > valueOrInsert( const Key& key, Factory create )
+    {
+        Shard& s = shard( key );
+        QMutexLocker lock( &s.mutex );
+
+        QSharedPointer< T > v = s.hash.value( key ).toStrongRef();
+        if ( v )
+            return v;
+
+        v = create();
+        insertLocked( s, key, v );
+        return v;
+    }
+
+    /**
+     * Registers @p v for @p key, replacing any previous entry.
+     */
+    void insert( const Key& key, const QSharedPointer< T >& v )
+    {
+        Shard& s = shard( key );
+        QMutexLocker lock( &s.mutex );
+        insertLocked( s, key, v );
+    }
+
+    /**
+     * Removes the entry for @p key if its object is gone. Meant to be called
+     * from the deleter, where a live entry means the key was taken over by a
+     * new object in the meantime.
+     */
+    void remove( const Key& key )
+    {
+        Shard& s = shard( key );
+        QMutexLocker lock( &s.mutex );
+
+        typename QHash< Key, QWeakPointer< T > >::iterator it = s.hash.find( key );
+        if ( it != s.hash.end() && it.value().isNull() )
+            s.hash.erase( it );
+    }
+
+    int count() const
+    {
+        int c = 0;
+        for ( int i = 0; i < Shards; i++ )
+        {
+            QMutexLocker lock( &m_shards[ i ].mutex );
+            c += m_shards[ i ].hash.count();
+        }
+        return c;
+    }
+
+private:
+    struct Shard
+    {
+        Shard() : inserts( 0 ) {}
+
+        mutable QMutex mutex;
+        QHash< Key, QWeakPointer< T > > hash;
+        int inserts;
+    };
+
+    Shard& shard( const Key& key ) { return m_shards[ qHash( key ) % Shards ]; }
+    const Shard& shard( const Key& key ) const { return m_shards[ qHash( key ) % Shards ]; }
+
+    void insertLocked( Shard& s, const Key& key, const QSharedPointer< T >& v )
+    {
+        s.hash.insert( key, v.toWeakRef() );
+
+        if ( ++s.inserts < SweepInterval )
+            return;
+
+        s.inserts = 0;
+        typename QHash< Key, QWeakPointer< T > >::iterator it = s.hash.begin();
+        while ( it != s.hash.end() )
+        {
+            if ( it.value().isNull() )
+                it = s.hash.erase( it );
+            else
+                ++it;
+        }
+    }
+
+    Shard m_shards[ Shards ];
+
+    Q_DISABLE_COPY( WeakRegistry )
+};
+
+} // namespace Utils
+
+} // namespace Tomahawk
+
+#endif // WEAKREGISTRY_H
@@ -22,7 +22,12 @@
 #include <QtTest>
 
 #include "database/Database.h"
+#include "database/DatabaseCommand_AddFiles.h"
+#include "database/DatabaseCommand_DeleteFiles.h"
 #include "database/DatabaseCommand_LogPlayback.h"
+#include "database/DatabaseImpl.h"
+#include "Query.h"
+#include "Source.h"
 
 
 class TestDatabaseCommand : public Tomahawk::DatabaseCommand
@@ -73,6 +78,122 @@ private slots:
         TestDatabaseCommand* tCmd = qobject_cast< TestDatabaseCommand* >( command.data() );
         QVERIFY( tCmd );
     }
+
+    void testPreparedQuery()
+    {
+        Tomahawk::DatabaseImpl* impl = db->impl();
+        const Tomahawk::DatabaseStatementStatistics before = impl->statementStatistics();
+
+        const int id = impl->artistId( "Prepared Query Artist", true );
+        QVERIFY( id > 0 );
+        QCOMPARE( impl->artistId( "prepared  query artist", false ), id );
+
+        // the second lookup got the statement from the cache
+        const Tomahawk::DatabaseStatementStatistics after = impl->statementStatistics();
+        QVERIFY( after.hits > before.hits );
+        QVERIFY( after.cached > 0 );
+
+        // values don't stick between uses
+        TomahawkSqlQuery query = impl->preparedQuery( "SELECT name FROM artist WHERE id = ?" );
+        query.bindValue( 0, id );
+        QVERIFY( query.exec() && query.next() );
+        QCOMPARE( query.value( 0 ).toString(), QString( "Prepared Query Artist" ) );
+
+        query = impl->preparedQuery( "SELECT name FROM artist WHERE id = ?" );
+        query.bindValue( 0, -1 );
+        QVERIFY( query.exec() );
+        QVERIFY( !query.next() );
+
+        impl->finishPreparedQueries();
+        QVERIFY( !query.isActive() );
+    }
+
+    void testWriteAheadLog()
+    {
+        // there are no settings here, so it's on
+        Tomahawk::DatabaseImpl* impl = db->impl();
+        QVERIFY( impl->writeAheadLog() );
+
+        TomahawkSqlQuery query = impl->newquery();
+        QVERIFY( query.exec( "PRAGMA journal_mode" ) && query.next() );
+        QCOMPARE( query.value( 0 ).toString().toLower(), QString( "wal" ) );
+
+        QVERIFY( query.exec( "PRAGMA auto_vacuum" ) && query.next() );
+        QCOMPARE( query.value( 0 ).toInt(), 2 );
+        query.finish();
+
+        // nobody else is writing, so nothing had to wait
+        impl->runIdleMaintenance();
+        QCOMPARE( TomahawkSqlQuery::lockStatistics().busyRetries, quint64( 0 ) );
+    }
+
+    void testReadDuringWrite()
+    {
+        Tomahawk::DatabaseImpl* writer = db->impl();
+        Tomahawk::DatabaseImpl* reader = writer->clone();
+        const quint64 busyRetries = TomahawkSqlQuery::lockStatistics().busyRetries;
+
+        QVERIFY( writer->database().transaction() );
+        TomahawkSqlQuery write = writer->newquery();
+        QVERIFY( write.exec( "INSERT INTO artist(name, sortname) VALUES('Uncommitted Artist', 'uncommitted artist')" ) );
+
+        // the reader gets the last commit right away instead of waiting for the writer
+        QElapsedTimer t;
+        t.start();
+        TomahawkSqlQuery read = reader->newquery();
+        QVERIFY( read.exec( "SELECT count(*) FROM artist WHERE sortname = 'uncommitted artist'" ) && read.next() );
+        QCOMPARE( read.value( 0 ).toInt(), 0 );
+        QVERIFY( t.elapsed() < 1000 );
+        QCOMPARE( TomahawkSqlQuery::lockStatistics().busyRetries, busyRetries );
+        read.finish();
+
+        write.finish();
+        QVERIFY( writer->database().rollback() );
+        delete reader;
+    }
+
+    void testDeleteFilesUpdatesIndex()
+    {
+        Tomahawk::DatabaseImpl* impl = db->impl();
+
+        TomahawkSqlQuery query = impl->newquery();
+        QVERIFY( query.exec( "INSERT OR IGNORE INTO source(id, name, friendlyname) VALUES(4242, 'indextest', 'indextest')" ) );
+        query.finish();
+        Tomahawk::source_ptr source( new Tomahawk::Source( 4242, "indextest" ) );
+
+        QVariantMap file;
+        file[ "url" ] = "1";
+        file[ "artist" ] = "Orphan Artist";
+        file[ "track" ] = "Orphaned Track";
+        file[ "album" ] = "Orphan Album";
+        file[ "mimetype" ] = "audio/mpeg";
+        file[ "size" ] = 1000;
+        file[ "mtime" ] = 1;
+        file[ "duration" ] = 180;
+        file[ "bitrate" ] = 128;
+
+        Tomahawk::DatabaseCommand_AddFiles add( QVariantList() << file, source );
+        add.exec( impl );
+        add.postCommit();
+
+        const int trackId = impl->trackId( impl->artistId( "Orphan Artist", false ), "Orphaned Track", false );
+        QVERIFY( trackId > 0 );
+
+        const Tomahawk::query_ptr q = Tomahawk::Query::get( "Orphan Artist", "Orphaned Track", QString(), QString(), false );
+        bool found = false;
+        typedef QPair< int, float > ScorePair;
+        foreach ( const ScorePair& hit, impl->search( q ) )
+            found = found || hit.first == trackId;
+        QVERIFY( found );
+
+        // the track loses its only file, so searching mustn't find it anymore
+        Tomahawk::DatabaseCommand_DeleteFiles del( QVariantList() << "1", source );
+        del.exec( impl );
+        del.postCommit();
+
+        foreach ( const ScorePair& hit, impl->search( q ) )
+            QVERIFY( hit.first != trackId );
+    }
 };
 
 #endif // TOMAHAWK_TESTDATABASE_H
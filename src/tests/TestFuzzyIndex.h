@@ -0,0 +1,229 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTFUZZYINDEX_H
+#define TOMAHAWK_TESTFUZZYINDEX_H
+
+#include "libtomahawk/database/fuzzyindex/FuzzyIndex.h"
+#include "libtomahawk/database/fuzzyindex/TrigramIndex.h"
+#include "libtomahawk/utils/TomahawkUtils.h"
+#include "libtomahawk/Query.h"
+
+#include <QElapsedTimer>
+#include <QtTest>
+
+class TestFuzzyIndex : public QObject
+{
+    Q_OBJECT
+
+private:
+    /// Made-up but repeatable names, a few hundred tracks per artist and a dozen per album
+    static QList< Tomahawk::IndexData > corpus( int tracks )
+    {
+        static const char* syllables[] = { "ka", "lo", "mi", "ne", "ru", "sa", "to", "vi", "bel", "dor", "fen", "gar", "hul", "mar", "qui", "zen" };
+
+        qsrand( 42 );
+        QList< Tomahawk::IndexData > result;
+        for ( int i = 0; i < tracks; i++ )
+        {
+            QString artist, track;
+            for ( int s = 0; s < 3; s++ )
+                artist += syllables[ ( i / 300 * 7 + s * 5 ) % 16 ];
+            for ( int s = 0; s < 4; s++ )
+                track += QString( syllables[ qrand() % 16 ] ) + ( s == 1 ? " " : "" );
+
+            Tomahawk::IndexData data;
+            data.id = i + 1;
+            data.artistId = i / 300 + 1;
+            data.artist = QString( "%1 %2" ).arg( artist ).arg( i / 300 );
+            data.track = QString( "%1 %2" ).arg( track ).arg( i % 300 );
+            result << data;
+
+            if ( i % 12 == 0 )
+            {
+                Tomahawk::IndexData album;
+                album.id = i / 12 + 1;
+                album.artistId = 0;
+                album.album = QString( "%1 %2" ).arg( track.section( ' ', 0, 0 ) ).arg( i / 12 );
+                result << album;
+            }
+        }
+
+        return result;
+    }
+
+    /// Resident set size in kB, where we can tell
+    static qint64 residentSize()
+    {
+        QFile status( "/proc/self/status" );
+        if ( !status.open( QIODevice::ReadOnly ) )
+            return -1;
+
+        foreach ( const QByteArray& line, status.readAll().split( '\n' ) )
+        {
+            if ( line.startsWith( "VmRSS:" ) )
+                return line.mid( 6 ).trimmed().split( ' ' ).value( 0 ).toLongLong();
+        }
+
+        return -1;
+    }
+
+    static QString indexPath( const QString& name )
+    {
+        return QDir::temp().absoluteFilePath( QString( "tomahawk-test-%1-%2" ).arg( name ).arg( QCoreApplication::applicationPid() ) );
+    }
+
+private slots:
+    void testBoundedDistance()
+    {
+        QCOMPARE( Tomahawk::TrigramIndex::boundedDistance( "yesterday", "yesterday", 2 ), 0 );
+        QCOMPARE( Tomahawk::TrigramIndex::boundedDistance( "yesterday", "yesturday", 2 ), 1 );
+        QCOMPARE( Tomahawk::TrigramIndex::boundedDistance( "kitten", "sitting", 3 ), 3 );
+        QCOMPARE( Tomahawk::TrigramIndex::boundedDistance( "kitten", "sitting", 2 ), 3 );
+        QCOMPARE( Tomahawk::TrigramIndex::boundedDistance( "a", "abcdef", 2 ), 3 );
+
+        QCOMPARE( Tomahawk::TrigramIndex::similarity( "yesterday", "yesturday", 0.5 ), float( 1.0 - 1.0 / 9 ) );
+        QCOMPARE( Tomahawk::TrigramIndex::similarity( "yesterday", "tomorrow", 0.5 ), float( 0.0 ) );
+    }
+
+    void testTrigramIndex()
+    {
+        const QString path = indexPath( "trigrams" );
+        Tomahawk::TrigramIndex index( path );
+        QVERIFY( !index.load() );
+
+        index.beginBuild();
+        foreach ( const Tomahawk::IndexData& data, corpus( 3000 ) )
+            index.add( data );
+        QVERIFY( index.endBuild() );
+
+        // a second instance finds it as well
+        Tomahawk::TrigramIndex reopened( path );
+        QVERIFY( reopened.load() );
+
+        Tomahawk::IndexData beatles;
+        beatles.id = 100000;
+        beatles.artistId = 100000;
+        beatles.artist = "the beatles";
+        beatles.track = "yesterday";
+
+        Tomahawk::IndexData album;
+        album.id = 100000;
+        album.artistId = 0;
+        album.album = "abbey road";
+
+        index.update( QList< Tomahawk::IndexData >() << beatles << album );
+
+        QMap< int, float > hits = index.searchTracks( "the beatles", "yesterday", 20 );
+        QCOMPARE( hits.keys(), QList< int >() << 100000 );
+        QCOMPARE( hits.value( 100000 ), float( 1.0 ) );
+
+        hits = index.searchTracks( "the beatles", "yesturday", 20 );
+        QVERIFY( hits.contains( 100000 ) );
+        QVERIFY( hits.value( 100000 ) < 1.0 );
+
+        QVERIFY( index.searchFullText( "beatles yesterday", 20 ).contains( 100000 ) );
+        QVERIFY( index.searchFullText( "yesterday", 20 ).contains( 100000 ) );
+        QVERIFY( index.searchAlbums( "abey road" ).contains( 100000 ) );
+
+        // what was mapped from the file can be replaced and removed as well
+        const Tomahawk::IndexData first = corpus( 1 ).first();
+        QVERIFY( index.searchTracks( first.artist, first.track, 20 ).contains( first.id ) );
+
+        index.remove( QList< unsigned int >() << first.id << beatles.id, QList< unsigned int >() << album.id );
+        QVERIFY( !index.searchTracks( first.artist, first.track, 20 ).contains( first.id ) );
+        QVERIFY( !index.searchTracks( "the beatles", "yesterday", 20 ).contains( 100000 ) );
+        QVERIFY( index.searchAlbums( "abbey road" ).isEmpty() );
+
+        index.deleteIndex();
+        QVERIFY( !QFile::exists( path ) );
+    }
+
+    void benchmark_data()
+    {
+        QTest::addColumn< int >( "backend" );
+        QTest::newRow( "lucene" ) << int( FuzzyIndex::LuceneBackend );
+        QTest::newRow( "trigram" ) << int( FuzzyIndex::TrigramBackend );
+    }
+
+    /**
+     * Builds an index for TOMAHAWK_FUZZY_BENCH_TRACKS tracks (20000 unless
+     * set, use 1000000 for a realistic big collection) and looks up a mix of
+     * exact, misspelt and full text queries.
+     */
+    void benchmark()
+    {
+        QFETCH( int, backend );
+
+        int tracks = qgetenv( "TOMAHAWK_FUZZY_BENCH_TRACKS" ).toInt();
+        if ( tracks < 1000 )
+            tracks = 20000;
+        const QString path = indexPath( QString( "bench%1" ).arg( backend ) );
+
+        QList< Tomahawk::query_ptr > queries;
+        {
+            const QList< Tomahawk::IndexData > data = corpus( tracks );
+            for ( int i = 0, n = 0; i < data.count(); i += data.count() / 50, n++ )
+            {
+                if ( data.at( i ).track.isEmpty() )
+                    continue;
+
+                // every other one misspelt
+                QString track = data.at( i ).track;
+                if ( n % 2 )
+                    track[ track.length() / 2 ] = 'x';
+
+                queries << Tomahawk::Query::get( data.at( i ).artist, track, QString(), QString(), false );
+                queries << Tomahawk::Query::get( data.at( i ).track, QString() );
+            }
+        }
+
+        const qint64 rssBefore = residentSize();
+        QElapsedTimer timer;
+        timer.start();
+
+        FuzzyIndex index( 0, path, false, FuzzyIndex::Backend( backend ) );
+        index.beginIndexing();
+        foreach ( const Tomahawk::IndexData& data, corpus( tracks ) )
+            index.appendFields( data );
+        index.endIndexing();
+
+        const qint64 buildMs = timer.elapsed();
+        const qint64 rssBuilt = residentSize();
+
+        int found = 0;
+        timer.restart();
+        foreach ( const Tomahawk::query_ptr& query, queries )
+            found += index.search( query ).isEmpty() ? 0 : 1;
+        const qint64 firstMs = timer.elapsed();
+
+        qDebug() << "Indexed" << tracks << "tracks in" << buildMs << "ms," << queries.count() << "searches took" << firstMs << "ms cold,"
+                 << "found" << found << "- RSS" << rssBefore << "->" << rssBuilt << "->" << residentSize() << "kB";
+        QVERIFY( found > queries.count() / 2 );
+
+        QBENCHMARK
+        {
+            foreach ( const Tomahawk::query_ptr& query, queries )
+                index.search( query );
+        }
+
+        index.deleteIndex();
+    }
+};
+
+#endif
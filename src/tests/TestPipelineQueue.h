@@ -0,0 +1,179 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTPIPELINEQUEUE_H
+#define TOMAHAWK_TESTPIPELINEQUEUE_H
+
+#include "libtomahawk/utils/IndexedQueue.h"
+#include "libtomahawk/utils/TimerWheel.h"
+#include "libtomahawk/Pipeline.h"
+#include "libtomahawk/Query.h"
+#include "libtomahawk/TomahawkSettings.h"
+
+#include <QtTest>
+
+class TestPipelineQueue : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QList< Tomahawk::query_ptr > queries( int count )
+    {
+        QList< Tomahawk::query_ptr > ql;
+        for ( int i = 0; i < count; i++ )
+            ql << Tomahawk::Query::get( QString( "Artist %1" ).arg( i % 1000 ), QString( "Track %1" ).arg( i ), QString() );
+
+        return ql;
+    }
+
+private slots:
+    void initTestCase()
+    {
+        // the Pipeline wants settings, keep them away from the real ones
+        QStandardPaths::setTestModeEnabled( true );
+        new TomahawkSettings( this );
+    }
+
+    void testQueueOrder()
+    {
+        const QList< Tomahawk::query_ptr > ql = queries( 5 );
+        Tomahawk::Utils::IndexedQueue< QID, Tomahawk::query_ptr > queue;
+        foreach ( const Tomahawk::query_ptr& q, ql )
+            QVERIFY( queue.append( q->id(), q ) );
+
+        // no duplicates, and moving to the front keeps the others in order
+        QVERIFY( !queue.append( ql.at( 2 )->id(), ql.at( 2 ) ) );
+        queue.prepend( ql.at( 3 )->id(), ql.at( 3 ) );
+        QVERIFY( queue.remove( ql.at( 1 )->id() ) );
+        QVERIFY( !queue.contains( ql.at( 1 )->id() ) );
+        QCOMPARE( queue.count(), 4 );
+
+        QCOMPARE( queue.takeFirst(), ql.at( 3 ) );
+        QCOMPARE( queue.takeFirst(), ql.at( 0 ) );
+        QCOMPARE( queue.takeFirst(), ql.at( 2 ) );
+        QCOMPARE( queue.takeFirst(), ql.at( 4 ) );
+        QVERIFY( queue.isEmpty() );
+    }
+
+    void benchmarkQueue_data()
+    {
+        QTest::addColumn< int >( "count" );
+        QTest::newRow( "10k" ) << 10000;
+        QTest::newRow( "100k" ) << 100000;
+    }
+
+    void benchmarkQueue()
+    {
+        QFETCH( int, count );
+        const QList< Tomahawk::query_ptr > ql = queries( count );
+
+        // what Pipeline::resolve() and shuntNext() do when a huge playlist gets loaded and scrolled through
+        QBENCHMARK
+        {
+            Tomahawk::Utils::IndexedQueue< QID, Tomahawk::query_ptr > queue;
+            foreach ( const Tomahawk::query_ptr& q, ql )
+                queue.append( q->id(), q );
+            for ( int i = count - 1; i >= 0; i -= 7 )
+                queue.prepend( ql.at( i )->id(), ql.at( i ) );
+
+            QCOMPARE( queue.count(), count );
+            while ( !queue.isEmpty() )
+                queue.takeFirst();
+        }
+    }
+
+    void benchmarkResolve_data()
+    {
+        QTest::addColumn< int >( "count" );
+        QTest::newRow( "10k" ) << 10000;
+        QTest::newRow( "100k" ) << 100000;
+    }
+
+    void benchmarkResolve()
+    {
+        QFETCH( int, count );
+        const QList< Tomahawk::query_ptr > ql = queries( count );
+
+        QList< Tomahawk::query_ptr > visible;
+        for ( int i = count - 1; i >= 0; i -= 7 )
+            visible << ql.at( i );
+
+        // a stopped Pipeline only queues, so this is the bookkeeping of loading a huge playlist and scrolling through it
+        QBENCHMARK
+        {
+            Tomahawk::Pipeline pipeline;
+            pipeline.resolve( ql, false );
+            pipeline.resolve( visible, true );
+
+            QCOMPARE( pipeline.pendingQueryCount(), (unsigned int)count );
+        }
+    }
+
+    void testTimerWheel()
+    {
+        Tomahawk::Utils::TimerWheel wheel( 1 );
+        QElapsedTimer clock;
+        clock.start();
+
+        // spread over the first three wheels
+        const QList< int > timeouts = QList< int >() << 0 << 1 << 10 << 63 << 64 << 65 << 200 << 1000 << 4200;
+        QList< int > fired;
+        QList< qint64 > firedAt;
+        foreach ( int timeout, timeouts )
+        {
+            wheel.schedule( timeout, [&fired, &firedAt, &clock, timeout]()
+            {
+                fired << timeout;
+                firedAt << clock.elapsed();
+            } );
+        }
+
+        int cancelled = 0;
+        const Tomahawk::Utils::TimerWheel::TimerId id = wheel.schedule( 100, [&cancelled]() { cancelled++; } );
+        QVERIFY( wheel.cancel( id ) );
+        QVERIFY( !wheel.cancel( id ) );
+
+        QTRY_COMPARE_WITH_TIMEOUT( fired.count(), timeouts.count(), 10000 );
+        QCOMPARE( fired, timeouts );
+        for ( int i = 0; i < fired.count(); i++ )
+            QVERIFY( firedAt.at( i ) >= fired.at( i ) );
+
+        QCOMPARE( cancelled, 0 );
+        QCOMPARE( wheel.pending(), 0 );
+    }
+
+    void testTimerWheelCancelDeferred()
+    {
+        Tomahawk::Utils::TimerWheel wheel( 1 );
+
+        // a timeout cancelled while waiting for the event loop mustn't stop the ones in the wheels
+        bool deferred = false;
+        bool fired = false;
+        wheel.schedule( 5, [&wheel, &deferred]()
+        {
+            QVERIFY( wheel.cancel( wheel.schedule( 0, [&deferred]() { deferred = true; } ) ) );
+        } );
+        wheel.schedule( 50, [&fired]() { fired = true; } );
+
+        QTRY_VERIFY_WITH_TIMEOUT( fired, 5000 );
+        QVERIFY( !deferred );
+        QCOMPARE( wheel.pending(), 0 );
+    }
+};
+
+#endif
@@ -0,0 +1,202 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTPLAYABLEPROXYMODEL_H
+#define TOMAHAWK_TESTPLAYABLEPROXYMODEL_H
+
+#include "libtomahawk/playlist/PlayableModel.h"
+#include "libtomahawk/playlist/PlayableProxyModel.h"
+#include "libtomahawk/Query.h"
+#include "libtomahawk/Track.h"
+
+#include <QtTest>
+
+class TestPlayableProxyModel : public QObject
+{
+    Q_OBJECT
+
+private:
+    /// Every track appears twice in a row, so half of them are dupes
+    static QList< Tomahawk::query_ptr > queries( int count )
+    {
+        QList< Tomahawk::query_ptr > ql;
+        for ( int i = 0; i < count; i++ )
+        {
+            ql << Tomahawk::Query::get( QString( "Artist %1" ).arg( i / 2 % 100 ),
+                                        QString( "Track %1" ).arg( i / 2 ),
+                                        QString( "Album %1" ).arg( i / 20 ) );
+        }
+
+        return ql;
+    }
+
+    static Tomahawk::query_ptr query( const QString& track, const QString& album = QString( "Silent Alarm" ) )
+    {
+        return Tomahawk::Query::get( "Bloc Party", track, album );
+    }
+
+private slots:
+    void testHideDupeItems()
+    {
+        PlayableModel model( 0, false );
+        PlayableProxyModel proxy;
+        proxy.setSourcePlayableModel( &model );
+
+        model.appendQueries( QList< Tomahawk::query_ptr >()
+                             << query( "Banquet" ) << query( "Banquet" ) << query( "Helicopter" )
+                             << query( "Banquet", "Intimacy" ) << query( "Like Eating Glass" ) << query( "Helicopter" ) );
+        QCOMPARE( proxy.rowCount(), 6 );
+
+        proxy.setHideDupeItems( true );
+        QCOMPARE( proxy.rowCount(), 4 );
+        QCOMPARE( proxy.data( proxy.index( 1, proxy.mapSourceColumnToColumn( PlayableModel::Track ) ) ).toString(), QString( "Helicopter" ) );
+
+        // appended rows are checked against the rows that are already visible
+        model.appendQueries( QList< Tomahawk::query_ptr >() << query( "Like Eating Glass" ) << query( "Positive Tension" ) );
+        QCOMPARE( proxy.rowCount(), 5 );
+
+        // inserting in front of a visible row hides that one instead
+        model.insertQueries( QList< Tomahawk::query_ptr >() << query( "Positive Tension" ), 0 );
+        proxy.setHideDupeItems( true );
+        QCOMPARE( proxy.rowCount(), 5 );
+        QCOMPARE( proxy.data( proxy.index( 0, proxy.mapSourceColumnToColumn( PlayableModel::Track ) ) ).toString(), QString( "Positive Tension" ) );
+
+        proxy.setHideDupeItems( false );
+        QCOMPARE( proxy.rowCount(), 9 );
+    }
+
+    void testHideDupeItemsIncremental()
+    {
+        PlayableModel model( 0, false );
+        PlayableProxyModel proxy;
+        proxy.setSourcePlayableModel( &model );
+
+        // hidden before there are any rows, so every insert goes through the filter index one batch at a time
+        proxy.setHideDupeItems( true );
+        const int trackColumn = proxy.mapSourceColumnToColumn( PlayableModel::Track );
+
+        model.appendQueries( QList< Tomahawk::query_ptr >() << query( "Banquet" ) << query( "Banquet" ) << query( "Helicopter" ) );
+        QCOMPARE( proxy.rowCount(), 2 );
+        QCOMPARE( proxy.data( proxy.index( 1, trackColumn ) ).toString(), QString( "Helicopter" ) );
+
+        model.appendQueries( QList< Tomahawk::query_ptr >() << query( "Helicopter" ) << query( "Like Eating Glass" ) << query( "Banquet", "Intimacy" ) );
+        QCOMPARE( proxy.rowCount(), 4 );
+        QCOMPARE( proxy.data( proxy.index( 2, trackColumn ) ).toString(), QString( "Like Eating Glass" ) );
+
+        model.insertQueries( QList< Tomahawk::query_ptr >() << query( "Positive Tension" ), 0 );
+        QCOMPARE( proxy.rowCount(), 5 );
+        QCOMPARE( proxy.data( proxy.index( 0, trackColumn ) ).toString(), QString( "Positive Tension" ) );
+
+        model.appendQueries( QList< Tomahawk::query_ptr >() << query( "Positive Tension" ) << query( "Luno" ) );
+        QCOMPARE( proxy.rowCount(), 6 );
+        QCOMPARE( proxy.data( proxy.index( 5, trackColumn ) ).toString(), QString( "Luno" ) );
+    }
+
+    void testMaxVisibleItems()
+    {
+        PlayableModel model( 0, false );
+        PlayableProxyModel proxy;
+        proxy.setSourcePlayableModel( &model );
+        model.appendQueries( queries( 20 ) );
+
+        proxy.setMaxVisibleItems( 5 );
+        QCOMPARE( proxy.rowCount(), 5 );
+
+        // dupes don't use up any of the visible items
+        proxy.setHideDupeItems( true );
+        QCOMPARE( proxy.rowCount(), 5 );
+        QCOMPARE( proxy.data( proxy.index( 4, proxy.mapSourceColumnToColumn( PlayableModel::Track ) ) ).toString(), QString( "Track 4" ) );
+
+        proxy.setMaxVisibleItems( -1 );
+        QCOMPARE( proxy.rowCount(), 10 );
+    }
+
+    void benchmarkHideDupeItems_data()
+    {
+        QTest::addColumn< int >( "rows" );
+        QTest::newRow( "1k" ) << 1000;
+        QTest::newRow( "10k" ) << 10000;
+        QTest::newRow( "100k" ) << 100000;
+    }
+
+    void benchmarkHideDupeItems()
+    {
+        QFETCH( int, rows );
+
+        PlayableModel model( 0, false );
+        PlayableProxyModel proxy;
+        proxy.setSourcePlayableModel( &model );
+        model.appendQueries( queries( rows ) );
+
+        QBENCHMARK
+        {
+            proxy.setHideDupeItems( true );
+            proxy.setHideDupeItems( false );
+        }
+
+        proxy.setHideDupeItems( true );
+        QCOMPARE( proxy.rowCount(), rows / 2 );
+    }
+
+    void testSortByArtist()
+    {
+        PlayableModel model( 0, false );
+        PlayableProxyModel proxy;
+        proxy.setSourcePlayableModel( &model );
+        model.appendQueries( QList< Tomahawk::query_ptr >()
+                             << Tomahawk::Query::get( "The Zutons", "Valerie", "Tired of Hanging Around" )
+                             << Tomahawk::Query::get( "Bloc Party", "Helicopter", "Silent Alarm" )
+                             << Tomahawk::Query::get( "bloc party", "Banquet", "Silent Alarm" )
+                             << Tomahawk::Query::get( "Arcade Fire", "Wake Up", "Funeral" ) );
+
+        const int artistColumn = proxy.mapSourceColumnToColumn( PlayableModel::Artist );
+        proxy.sort( artistColumn );
+
+        QStringList artists;
+        for ( int i = 0; i < proxy.rowCount(); i++ )
+            artists << proxy.data( proxy.index( i, artistColumn ) ).toString().toLower();
+
+        QCOMPARE( artists, QStringList() << "arcade fire" << "bloc party" << "bloc party" << "the zutons" );
+    }
+
+    void benchmarkSortByArtist_data()
+    {
+        QTest::addColumn< int >( "rows" );
+        QTest::newRow( "10k" ) << 10000;
+        QTest::newRow( "100k" ) << 100000;
+    }
+
+    void benchmarkSortByArtist()
+    {
+        QFETCH( int, rows );
+
+        PlayableModel model( 0, false );
+        PlayableProxyModel proxy;
+        proxy.setSourcePlayableModel( &model );
+        model.appendQueries( queries( rows ) );
+
+        const int artistColumn = proxy.mapSourceColumnToColumn( PlayableModel::Artist );
+        QBENCHMARK
+        {
+            proxy.sort( artistColumn, Qt::AscendingOrder );
+            proxy.sort( artistColumn, Qt::DescendingOrder );
+        }
+    }
+};
+
+#endif
@@ -19,19 +19,179 @@
 #ifndef TOMAHAWK_TESTQUERY_H
 #define TOMAHAWK_TESTQUERY_H
 
+#include "libtomahawk/database/DatabaseImpl.h"
+#include "libtomahawk/utils/TomahawkUtils.h"
 #include "libtomahawk/Query.h"
+#include "libtomahawk/Result.h"
 #include "libtomahawk/Source.h"
+#include "libtomahawk/Track.h"
+
+#include <QtTest>
 
 class TestQuery : public QObject
 {
     Q_OBJECT
 
+private:
+    Tomahawk::query_ptr m_query;
+    QList< Tomahawk::result_ptr > m_results;
+
+    /// Full-matrix edit distance as used by the scorer before it was memoized
+    static int legacyLevenshtein( const QString& source, const QString& target )
+    {
+        const int n = source.length();
+        const int m = target.length();
+        if ( n == 0 )
+            return m;
+        if ( m == 0 )
+            return n;
+
+        QVector< QVector<int> > matrix( n + 1, QVector<int>( m + 1 ) );
+        for ( int i = 0; i <= n; i++ )
+            matrix[i][0] = i;
+        for ( int j = 0; j <= m; j++ )
+            matrix[0][j] = j;
+
+        for ( int i = 1; i <= n; i++ )
+        {
+            for ( int j = 1; j <= m; j++ )
+            {
+                const int cost = source[i - 1] == target[j - 1] ? 0 : 1;
+                int cell = qMin( matrix[i][j - 1] + 1, matrix[i - 1][j - 1] + cost );
+                cell = qMin( cell, matrix[i - 1][j] + 1 );
+                if ( i > 2 && j > 2 )
+                {
+                    int trans = matrix[i - 2][j - 2] + 1;
+                    if ( source[i - 2] != target[j - 1] ) trans++;
+                    if ( source[i - 1] != target[j - 2] ) trans++;
+                    cell = qMin( cell, trans );
+                }
+                matrix[i][j] = cell;
+            }
+        }
+
+        return matrix[n][m];
+    }
+
+    /// Uncached scoring path: normalizes the query for every single result
+    static float legacyHowSimilar( const Tomahawk::query_ptr& q, const Tomahawk::result_ptr& r )
+    {
+        const QRegExp symbols( QString::fromUtf8( "[-`~!@#$%^&*()_—+=|:;<>«»,.?/{}\'\"\\[\\]\\\\]" ) );
+
+        QString qArtistname = q->queryTrack()->artistSortname();
+        QString qAlbumname = q->queryTrack()->albumSortname();
+        QString qTrackname = q->queryTrack()->trackSortname();
+        qArtistname.remove( symbols );
+        qAlbumname.remove( symbols );
+        qTrackname.remove( symbols );
+
+        const QString& rArtistname = r->track()->artistSortname();
+        const QString& rAlbumname = r->track()->albumSortname();
+        const QString& rTrackname = r->track()->trackSortname();
+
+        const int mlart = qMax( qArtistname.length(), rArtistname.length() );
+        const int mltrk = qMax( qTrackname.length(), rTrackname.length() );
+        const float dcart = (float)( mlart - legacyLevenshtein( qArtistname, rArtistname ) ) / mlart;
+        const float dctrk = (float)( mltrk - legacyLevenshtein( qTrackname, rTrackname ) ) / mltrk;
+
+        float dcalb = 1.0;
+        if ( !qAlbumname.isEmpty() )
+        {
+            const int mlalb = qMax( qAlbumname.length(), rAlbumname.length() );
+            dcalb = (float)( mlalb - legacyLevenshtein( qAlbumname, rAlbumname ) ) / mlalb;
+        }
+
+        return ( dcart * 4 + dcalb + dctrk * 5 ) / 10;
+    }
+
+    /// Number of howSimilar() calls a stable sort of the result list performs
+    int sortComparisons() const
+    {
+        const int n = m_results.count();
+        int log2n = 1;
+        while ( ( 1 << log2n ) < n )
+            log2n++;
+
+        return 2 * n * log2n;
+    }
+
 private slots:
+    void initTestCase()
+    {
+        m_query = Tomahawk::Query::get( Tomahawk::Track::get( "Bloc Party", "Banquet", "Silent Alarm" ) );
+
+        const QStringList artists = QStringList() << "Bloc Party" << "Bloc-Party" << "The Bloc Party" << "Block Party" << "Blok Partie";
+        const QStringList tracks = QStringList() << "Banquet" << "Banquet (Remix)" << "Banquet - Live" << "Banquets" << "Bankwet";
+        const QStringList albums = QStringList() << "Silent Alarm" << "Silent Alarm Remixed" << "" << "Intimacy";
+
+        for ( int i = 0; i < 60; i++ )
+        {
+            Tomahawk::track_ptr t = Tomahawk::Track::get( artists.at( i % artists.count() ),
+                                                          tracks.at( ( i / artists.count() ) % tracks.count() ),
+                                                          albums.at( i % albums.count() ) );
+            m_results << Tomahawk::Result::get( QString( "/tmp/similarity-%1.mp3" ).arg( i ), t );
+        }
+    }
+
+    void cleanupTestCase()
+    {
+        m_results.clear();
+        m_query.clear();
+    }
+
+
     void testGet()
     {
         Tomahawk::query_ptr q = Tomahawk::Query::get( "", "", "" );
         QVERIFY( !q );
     }
+
+    void testLevenshtein()
+    {
+        QCOMPARE( TomahawkUtils::levenshtein( "", "" ), 0 );
+        QCOMPARE( TomahawkUtils::levenshtein( "bloc party", "" ), 10 );
+        QCOMPARE( TomahawkUtils::levenshtein( "", "banquet" ), 7 );
+
+        foreach ( const Tomahawk::result_ptr& r, m_results )
+        {
+            const QString& a = m_query->queryTrack()->trackSortname();
+            const QString& b = r->track()->trackSortname();
+            QCOMPARE( TomahawkUtils::levenshtein( a, b ), legacyLevenshtein( a, b ) );
+        }
+    }
+
+    void testHowSimilar()
+    {
+        foreach ( const Tomahawk::result_ptr& r, m_results )
+        {
+            const float expected = legacyHowSimilar( m_query, r );
+            QCOMPARE( m_query->howSimilar( r ), expected );
+            // second call is answered from the per-result cache
+            QCOMPARE( m_query->howSimilar( r ), expected );
+        }
+
+        QVERIFY( m_query->howSimilar( m_results.first() ) > 0.99 );
+    }
+
+    void benchmarkLegacyHowSimilar()
+    {
+        const int comparisons = sortComparisons();
+        QBENCHMARK
+        {
+            for ( int i = 0; i < comparisons; i++ )
+                legacyHowSimilar( m_query, m_results.at( i % m_results.count() ) );
+        }
+    }
+
+    void benchmarkHowSimilar()
+    {
+        const int comparisons = sortComparisons();
+        QBENCHMARK
+        {
+            for ( int i = 0; i < comparisons; i++ )
+                m_query->howSimilar( m_results.at( i % m_results.count() ) );
+        }
+    }
 };
 
 #endif
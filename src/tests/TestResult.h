@@ -22,11 +22,54 @@
 #include "libtomahawk/Result.h"
 #include "libtomahawk/Track.h"
 #include "libtomahawk/Source.h"
+#include "libtomahawk/TrackData.h"
+
+#include <QThreadPool>
+#include <QtConcurrentRun>
 
 class TestResult : public QObject
 {
     Q_OBJECT
 
+private:
+    /**
+     * One thread of the contention benchmark: looks up a small working set of
+     * tracks, track data and results over and over, like resolvers and models do.
+     */
+    static void hammerRegistries( int worker, int iterations )
+    {
+        QList< Tomahawk::result_ptr > keep;
+        for ( int i = 0; i < iterations; i++ )
+        {
+            const unsigned int n = ( i * 7 + worker ) % 256;
+            const QString artist = QString( "Artist %1" ).arg( n % 32 );
+            const QString track = QString( "Track %1" ).arg( n );
+
+            Tomahawk::track_ptr t = Tomahawk::Track::get( n + 1, artist, track, QString(), QString(), 0, QString(), 0, 0 );
+            Tomahawk::TrackData::get( n + 1, artist, track );
+            Tomahawk::result_ptr r = Tomahawk::Result::get( QString( "file:///tmp/%1.mp3" ).arg( n ), t );
+            Tomahawk::Result::getCached( r->url() );
+
+            // drop some of the objects again so the registries also see removals
+            if ( i % 4 == 0 )
+                keep << r;
+            if ( keep.count() > 64 )
+                keep.removeFirst();
+        }
+    }
+
+    static void hammer( int threads )
+    {
+        QThreadPool pool;
+        pool.setMaxThreadCount( threads );
+
+        QList< QFuture< void > > futures;
+        for ( int i = 0; i < threads; i++ )
+            futures << QtConcurrent::run( &pool, &TestResult::hammerRegistries, i, 2000 );
+        foreach ( QFuture< void > future, futures )
+            future.waitForFinished();
+    }
+
 private slots:
     void testGet()
     {
@@ -46,6 +89,34 @@ private slots:
         r = Tomahawk::Result::get( "/tmp/test.mp3", t );
         QVERIFY( r );
     }
+
+    void testGetShared()
+    {
+        Tomahawk::track_ptr t = Tomahawk::Track::get( "Artist", "Track" );
+        QCOMPARE( Tomahawk::Track::get( "Artist", "Track" ), t );
+
+        Tomahawk::result_ptr r = Tomahawk::Result::get( "/tmp/shared.mp3", t );
+        QCOMPARE( Tomahawk::Result::get( "/tmp/shared.mp3", t ), r );
+        QCOMPARE( Tomahawk::Result::getCached( "/tmp/shared.mp3" ), r );
+        QVERIFY( !Tomahawk::Result::getCached( "/tmp/unknown.mp3" ) );
+    }
+
+    void benchmarkConcurrentGet_data()
+    {
+        QTest::addColumn< int >( "threads" );
+        QTest::newRow( "1 thread" ) << 1;
+        QTest::newRow( "4 threads" ) << 4;
+        QTest::newRow( "16 threads" ) << 16;
+    }
+
+    void benchmarkConcurrentGet()
+    {
+        QFETCH( int, threads );
+        QBENCHMARK
+        {
+            hammer( threads );
+        }
+    }
 };
 
 #endif
@@ -0,0 +1,166 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTURLVALIDATOR_H
+#define TOMAHAWK_TESTURLVALIDATOR_H
+
+#include "libtomahawk/utils/UrlValidator.h"
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QtTest>
+
+/**
+ * Just enough of a web server: answers every request with 200 for paths
+ * starting with /ok and 404 otherwise, after a short delay.
+ */
+class HttpStandIn : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    HttpStandIn() : open( 0 ), maxOpen( 0 )
+    {
+        connect( this, SIGNAL( newConnection() ), SLOT( onNewConnection() ) );
+        listen( QHostAddress::LocalHost );
+    }
+
+    QString url( const QString& path ) const
+    {
+        return QString( "http://127.0.0.1:%1%2" ).arg( serverPort() ).arg( path );
+    }
+
+    QHash< QString, int > hits;
+    int open;
+    int maxOpen;
+
+private slots:
+    void onNewConnection()
+    {
+        while ( hasPendingConnections() )
+        {
+            QTcpSocket* socket = nextPendingConnection();
+            connect( socket, SIGNAL( readyRead() ), SLOT( onReadyRead() ) );
+            connect( socket, SIGNAL( disconnected() ), socket, SLOT( deleteLater() ) );
+        }
+    }
+
+    void onReadyRead()
+    {
+        QTcpSocket* socket = qobject_cast< QTcpSocket* >( sender() );
+        if ( !socket->canReadLine() )
+            return;
+
+        const QList< QByteArray > request = socket->readLine().split( ' ' );
+        socket->readAll();
+        const QString path = request.value( 1 );
+        hits[ path ]++;
+        maxOpen = qMax( maxOpen, ++open );
+
+        QTimer::singleShot( 50, socket, [this, socket, path]()
+        {
+            open--;
+            const QByteArray status = path.startsWith( "/ok" ) ? "200 OK" : "404 Not Found";
+            socket->write( "HTTP/1.1 " + status + "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n" );
+            socket->disconnectFromHost();
+        } );
+    }
+};
+
+
+class UrlValidatorReceiver : public QObject
+{
+    Q_OBJECT
+
+public:
+    UrlValidatorReceiver() : batches( 0 ) {}
+
+    QVariantMap outcomes;
+    int batches;
+
+public slots:
+    void onUrlsChecked( const QVariantMap& batch )
+    {
+        batches++;
+        foreach ( const QString& url, batch.keys() )
+            outcomes.insert( url, batch.value( url ) );
+    }
+};
+
+
+class TestUrlValidator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testDeduplicationAndCache()
+    {
+        HttpStandIn server;
+        QVERIFY( server.isListening() );
+
+        Tomahawk::Utils::UrlValidator validator;
+        UrlValidatorReceiver a, b;
+
+        validator.check( server.url( "/ok" ), &a, "onUrlsChecked" );
+        validator.check( server.url( "/missing" ), &a, "onUrlsChecked" );
+        validator.check( server.url( "/ok" ), &b, "onUrlsChecked" );
+
+        QTRY_COMPARE( a.outcomes.count(), 2 );
+        QTRY_COMPARE( b.outcomes.count(), 1 );
+        QCOMPARE( a.outcomes.value( server.url( "/ok" ) ).toBool(), true );
+        QCOMPARE( a.outcomes.value( server.url( "/missing" ) ).toBool(), false );
+        QCOMPARE( b.outcomes.value( server.url( "/ok" ) ).toBool(), true );
+
+        // one HEAD per url, however many asked
+        QCOMPARE( server.hits.value( "/ok" ), 1 );
+        QCOMPARE( server.hits.value( "/missing" ), 1 );
+        QCOMPARE( validator.requests(), 2 );
+        QCOMPARE( validator.deduplicated(), 1 );
+
+        // both outcomes are remembered, and still arrive asynchronously
+        UrlValidatorReceiver c;
+        validator.check( server.url( "/ok" ), &c, "onUrlsChecked" );
+        validator.check( server.url( "/missing" ), &c, "onUrlsChecked" );
+        QCOMPARE( c.batches, 0 );
+        QTRY_COMPARE( c.batches, 1 );
+        QCOMPARE( c.outcomes.count(), 2 );
+        QCOMPARE( validator.cacheHits(), 2 );
+        QCOMPARE( server.hits.value( "/ok" ), 1 );
+
+        validator.clear();
+        validator.check( server.url( "/ok" ), &c, "onUrlsChecked" );
+        QTRY_COMPARE( server.hits.value( "/ok" ), 2 );
+    }
+
+    void testHostLimit()
+    {
+        HttpStandIn server;
+        Tomahawk::Utils::UrlValidator validator;
+        validator.setMaxRequestsPerHost( 2 );
+
+        UrlValidatorReceiver receiver;
+        for ( int i = 0; i < 8; i++ )
+            validator.check( server.url( QString( "/ok/%1" ).arg( i ) ), &receiver, "onUrlsChecked" );
+
+        QTRY_COMPARE( receiver.outcomes.count(), 8 );
+        QVERIFY( server.maxOpen <= 2 );
+        QCOMPARE( validator.requests(), 8 );
+    }
+};
+
+#endif
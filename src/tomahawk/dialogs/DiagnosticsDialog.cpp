@@ -29,9 +29,14 @@
 #include "accounts/AccountManager.h"
 #include "database/Database.h"
 #include "database/DatabaseImpl.h"
+#include "database/DatabaseScheduler.h"
 #include "infosystem/InfoSystem.h"
+#include "infosystem/InfoSystemCache.h"
 #include "infosystem/InfoSystemWorker.h"
 #include "network/Servent.h"
+#include "resolvers/JSAccount.h"
+#include "resolvers/JSBridge.h"
+#include "resolvers/JSResolver.h"
 #include "sip/PeerInfo.h"
 #include "sip/SipInfo.h"
 #include "sip/SipPlugin.h"
@@ -94,6 +99,59 @@ DiagnosticsDialog::updateLogView()
         log.append( "      not listening to any interface, outgoing connections only\n" );
     }
 
+    log.append( "\n\nDATABASE READ WORKERS:\n" );
+    Tomahawk::DatabaseScheduler* scheduler = Tomahawk::Database::instance()->scheduler();
+    log.append( QString( "      idle workers: %1\n" ).arg( scheduler->idleWorkers() ) );
+    const QStringList priorityNames = QStringList() << "interactive" << "model" << "background";
+    for ( int i = 0; i < priorityNames.count(); i++ )
+    {
+        const Tomahawk::DatabaseScheduler::Statistics stats = scheduler->statistics( (Tomahawk::DatabaseCommand::Priority)i );
+        log.append( QString( "      %1: queued %2 (max %3), ran %4, wait avg %5 ms / max %6 ms\n" )
+                       .arg( priorityNames.at( i ) )
+                       .arg( stats.queued )
+                       .arg( stats.maxQueued )
+                       .arg( stats.dispatched )
+                       .arg( stats.averageWaitMs() )
+                       .arg( stats.maxWaitMs ) );
+    }
+
+    log.append( "\n\nDATABASE STATEMENTS:\n" );
+    {
+        const Tomahawk::DatabaseStatementStatistics stats = Tomahawk::Database::instance()->statementStatistics();
+        log.append( QString( "      cached %1, hits %2, prepared %3, prepare avg %4 us / max %5 us\n" )
+                       .arg( stats.cached )
+                       .arg( stats.hits )
+                       .arg( stats.misses )
+                       .arg( stats.averagePrepareUs() )
+                       .arg( stats.maxPrepareUs ) );
+    }
+
+    log.append( "\n\nDATABASE LOCKS:\n" );
+    {
+        const TomahawkSqlQuery::LockStatistics stats = TomahawkSqlQuery::lockStatistics();
+        log.append( QString( "      journal: %1\n" ).arg( Tomahawk::Database::instance()->impl()->writeAheadLog() ? "write-ahead log" : "rollback" ) );
+        log.append( QString( "      waited %1 times, busy retries %2, wait avg %3 ms / max %4 ms\n" )
+                       .arg( stats.waits )
+                       .arg( stats.busyRetries )
+                       .arg( stats.averageWaitMs() )
+                       .arg( stats.maxWaitMs ) );
+    }
+
+    log.append( "\n\nINFOSYSTEM CACHE:\n" );
+    if ( Tomahawk::InfoSystem::InfoSystemCache* cache = Tomahawk::InfoSystem::InfoSystem::instance()->cache() )
+    {
+        const Tomahawk::InfoSystem::InfoSystemCache::Statistics stats = cache->statistics();
+        log.append( QString( "      entries: %1, store %2 KiB (%3 KiB dead)\n" )
+                       .arg( stats.entries )
+                       .arg( stats.storeSize / 1024 )
+                       .arg( stats.deadSize / 1024 ) );
+        log.append( QString( "      hits %1, misses %2, lookup avg %3 us / max %4 us\n" )
+                       .arg( stats.hits )
+                       .arg( stats.misses )
+                       .arg( stats.averageLookupUs() )
+                       .arg( stats.maxLookupUs ) );
+    }
+
     log.append( "\n\nINFOPLUGINS:\n" );
     QThread* infoSystemWorkerThreadSuperClass = Tomahawk::InfoSystem::InfoSystem::instance()->workerThread();
     Tomahawk::InfoSystem::InfoSystemWorkerThread* infoSystemWorkerThread = qobject_cast< Tomahawk::InfoSystem::InfoSystemWorkerThread* >(infoSystemWorkerThreadSuperClass);
@@ -131,11 +189,47 @@ DiagnosticsDialog::updateLogView()
     connect( Tomahawk::Pipeline::instance(), SIGNAL( resolverAdded( Tomahawk::Resolver* ) ), SLOT( updateLogView() ), Qt::UniqueConnection );
     connect( Tomahawk::Pipeline::instance(), SIGNAL( resolverRemoved( Tomahawk::Resolver* ) ), SLOT( updateLogView() ), Qt::UniqueConnection );
 
+    const QList< int > buckets = Tomahawk::Pipeline::latencyBuckets();
     const QList< Tomahawk::Resolver* > resolvers = Tomahawk::Pipeline::instance()->resolvers();
     foreach ( Tomahawk::Resolver* resolver, resolvers )
     {
+        const Tomahawk::Pipeline::ResolverStatistics stats = Tomahawk::Pipeline::instance()->resolverStatistics( resolver );
+        log.append( QString( "  %1 (weight %2): asked %3, answered %4 (avg %5 ms), in flight %6, timeouts %7, skipped %8\n" )
+                       .arg( resolver->name() )
+                       .arg( resolver->weight() )
+                       .arg( stats.dispatched )
+                       .arg( stats.answered )
+                       .arg( stats.averageAnswerMs() )
+                       .arg( stats.inFlight )
+                       .arg( stats.timeouts )
+                       .arg( stats.skipped ) );
+
+        Tomahawk::JSResolver* jsResolver = qobject_cast< Tomahawk::JSResolver* >( resolver );
+        Tomahawk::JSAccount* jsAccount = jsResolver ? qobject_cast< Tomahawk::JSAccount* >( jsResolver->scriptAccount() ) : 0;
+        if ( jsAccount )
+        {
+            const Tomahawk::JSBridge::Statistics scriptStats = jsAccount->bridge()->statistics();
+            log.append( QString( "      script calls %1 in %2 batches, answered %3 (avg %4 ms, max %5 ms), in flight %6, queued %7 (max %8)\n" )
+                           .arg( scriptStats.calls )
+                           .arg( scriptStats.batches )
+                           .arg( scriptStats.answered )
+                           .arg( scriptStats.averageLatencyMs() )
+                           .arg( scriptStats.maxLatencyMs )
+                           .arg( scriptStats.inFlight )
+                           .arg( scriptStats.queued )
+                           .arg( scriptStats.maxQueued ) );
+        }
 
-        log.append( resolver->name() + "\n" );
+        if ( stats.histogram.isEmpty() )
+            continue;
+
+        QStringList histogram;
+        for ( int i = 0; i < stats.histogram.count(); i++ )
+        {
+            const QString bound = i < buckets.count() ? QString( "<%1" ).arg( buckets.at( i ) ) : QString( ">%1" ).arg( buckets.last() );
+            histogram << QString( "%1 ms: %2" ).arg( bound ).arg( stats.histogram.at( i ) );
+        }
+        log.append( "      " + histogram.join( ", " ) + "\n" );
     }
 
     ui->text->setText( log );
@@ -0,0 +1,164 @@
+#include "database/Database.h"
+#include "database/DatabaseCommand_AddFiles.h"
+#include "database/DatabaseImpl.h"
+#include "database/TomahawkSqlQuery.h"
+#include "Source.h"
+#include "TomahawkVersion.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include <iostream>
+
+
+void
+usage()
+{
+    std::cout << "Usage:" << std::endl;
+    std::cout << "\ttomahawk-db-addfiles-benchmark [files] [--per-file]" << std::endl;
+    std::cout << std::endl;
+    std::cout << "\tfiles\t\tNumber of synthetic files to add (default: 100000)" << std::endl;
+    std::cout << "\t--per-file\tLook up ids and insert rows one file at a time, the way it used to be done" << std::endl;
+}
+
+
+// A remote collection: ~10 tracks per album, ~10 albums per artist
+QVariantList
+createFiles( int count, const QString& urlPrefix )
+{
+    QVariantList files;
+    for ( int i = 0; i < count; ++i )
+    {
+        QVariantMap file;
+        file[ "url" ] = QString( "%1/%2" ).arg( urlPrefix ).arg( i );
+        file[ "artist" ] = QString( "Artist %1" ).arg( i / 100 );
+        file[ "album" ] = QString( "Album %1" ).arg( i / 10 );
+        file[ "track" ] = QString( "Track %1" ).arg( i );
+        file[ "composer" ] = QString( "Composer %1" ).arg( i / 1000 );
+        file[ "mimetype" ] = "audio/mpeg";
+        file[ "size" ] = 4000000 + i;
+        file[ "duration" ] = 180 + i % 120;
+        file[ "bitrate" ] = 320;
+        file[ "mtime" ] = 1400000000 + i;
+        file[ "albumpos" ] = i % 10 + 1;
+        file[ "discnumber" ] = 1;
+        file[ "year" ] = 1990 + i % 25;
+        files << file;
+    }
+
+    return files;
+}
+
+
+// What DatabaseCommand_AddFiles::exec() did before it resolved ids in batches. Neither updates
+// the search index, the command only does that in postCommitHook().
+void
+addPerFile( Tomahawk::DatabaseImpl* dbi, const QVariantList& files, int source )
+{
+    TomahawkSqlQuery query_file = dbi->newquery();
+    TomahawkSqlQuery query_filejoin = dbi->newquery();
+    TomahawkSqlQuery query_trackattr = dbi->newquery();
+
+    query_file.prepare( "INSERT INTO file(source, url, size, mtime, md5, mimetype, duration, bitrate) VALUES (?, ?, ?, ?, ?, ?, ?, ?)" );
+    query_filejoin.prepare( "INSERT INTO file_join(file, artist, album, track, albumpos, composer, discnumber) VALUES (?, ?, ?, ?, ?, ?, ?)" );
+    query_trackattr.prepare( "INSERT INTO track_attributes(id, k, v) VALUES (?, ?, ?)" );
+
+    foreach ( const QVariant& v, files )
+    {
+        const QVariantMap m = v.toMap();
+
+        query_file.bindValue( 0, source );
+        query_file.bindValue( 1, m.value( "url" ) );
+        query_file.bindValue( 2, m.value( "size" ) );
+        query_file.bindValue( 3, m.value( "mtime" ) );
+        query_file.bindValue( 4, QString() );
+        query_file.bindValue( 5, m.value( "mimetype" ) );
+        query_file.bindValue( 6, m.value( "duration" ) );
+        query_file.bindValue( 7, m.value( "bitrate" ) );
+        query_file.exec();
+        const int fileid = query_file.lastInsertId().toInt();
+
+        const int artistid = dbi->artistId( m.value( "artist" ).toString(), true );
+        const int trackid = dbi->trackId( artistid, m.value( "track" ).toString(), true );
+        const int albumid = dbi->albumId( artistid, m.value( "album" ).toString(), true );
+        const int composerid = dbi->artistId( m.value( "composer" ).toString(), true );
+
+        query_filejoin.bindValue( 0, fileid );
+        query_filejoin.bindValue( 1, artistid );
+        query_filejoin.bindValue( 2, albumid );
+        query_filejoin.bindValue( 3, trackid );
+        query_filejoin.bindValue( 4, m.value( "albumpos" ) );
+        query_filejoin.bindValue( 5, composerid );
+        query_filejoin.bindValue( 6, m.value( "discnumber" ) );
+        query_filejoin.exec();
+
+        query_trackattr.bindValue( 0, trackid );
+        query_trackattr.bindValue( 1, "releaseyear" );
+        query_trackattr.bindValue( 2, m.value( "year" ) );
+        query_trackattr.exec();
+    }
+}
+
+
+int
+main( int argc, char* argv[] )
+{
+    QCoreApplication app( argc, argv );
+    app.setOrganizationName( TOMAHAWK_ORGANIZATION_NAME );
+
+    QStringList args = app.arguments().mid( 1 );
+    const bool perFile = args.removeAll( "--per-file" ) > 0;
+
+    int count = 100000;
+    if ( !args.isEmpty() )
+    {
+        bool ok = false;
+        count = args.first().toInt( &ok );
+        if ( !ok || count <= 0 )
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    const QString dbpath = QDir::temp().absoluteFilePath( QString( "tomahawk-addfiles-benchmark-%1.db" ).arg( app.applicationPid() ) );
+    QElapsedTimer timer;
+
+    {
+        Tomahawk::Database database( dbpath );
+        Tomahawk::DatabaseImpl* dbi = database.impl();
+
+        // files of remote sources reference them, the local one would want accounts and a servent
+        const int sourceId = 1;
+        dbi->newquery().exec( "INSERT INTO source(id, name, friendlyname) VALUES (1, 'benchmark', 'benchmark')" );
+        Tomahawk::source_ptr source( new Tomahawk::Source( sourceId, "benchmark" ) );
+
+        // first everything is new, then the same catalogue once more under other urls, so all ids exist already
+        const QStringList passes = QStringList() << "new" << "known";
+        foreach ( const QString& pass, passes )
+        {
+            const QVariantList files = createFiles( count, QString( "benchmark://%1" ).arg( pass ) );
+
+            // set up and torn down outside of the timed part, so both only measure the inserts and the commit
+            Tomahawk::DatabaseCommand_AddFiles cmd( files, source );
+
+            timer.start();
+            dbi->database().transaction();
+            if ( perFile )
+                addPerFile( dbi, files, sourceId );
+            else
+                cmd.exec( dbi );
+            dbi->database().commit();
+
+            const qint64 elapsed = qMax( qint64( 1 ), timer.elapsed() );
+            std::cout << ( perFile ? "per-file" : "batched" ) << ", " << pass.toStdString() << " artists/albums/tracks: "
+                      << count << " files in " << elapsed << " ms ("
+                      << qint64( count ) * 1000 / elapsed << " files/s)" << std::endl;
+        }
+    }
+
+    QFile::remove( dbpath );
+    return 0;
+}
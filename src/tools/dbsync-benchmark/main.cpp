@@ -0,0 +1,219 @@
+#include "database/Database.h"
+#include "database/DatabaseCollection.h"
+#include "database/DatabaseImpl.h"
+#include "database/Op.h"
+#include "database/TomahawkSqlQuery.h"
+#include "network/DbSyncConnection.h"
+#include "network/MsgProcessor.h"
+#include "utils/Json.h"
+#include "utils/TomahawkUtils.h"
+#include "Source.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QUuid>
+#include <QVariantMap>
+
+#include <iostream>
+
+void
+usage()
+{
+    std::cout << "Usage:" << std::endl;
+    std::cout << "\ttomahawk-dbsync-benchmark [ops]" << std::endl;
+    std::cout << std::endl;
+    std::cout << "\tops\tNumber of synthetic sync ops to transfer and apply (default: 100000)" << std::endl;
+}
+
+
+// Every pass gets its own catalogue, so neither finds the artists and tracks of the other in the database
+QList< dbop_ptr >
+createOps( int count, const QString& catalogue )
+{
+    QList< dbop_ptr > ops;
+    for ( int i = 0; i < count; ++i )
+    {
+        QVariantMap file;
+        file[ "url" ] = QString( "/music/Artist %1%2/Album %3/%4 - Track %4.mp3" ).arg( catalogue ).arg( i / 100 ).arg( i / 10 ).arg( i % 10 );
+        file[ "artist" ] = QString( "Artist %1%2" ).arg( catalogue ).arg( i / 100 );
+        file[ "album" ] = QString( "Album %1" ).arg( i / 10 );
+        file[ "track" ] = QString( "Track %1" ).arg( i % 10 );
+        file[ "mimetype" ] = "audio/mpeg";
+        file[ "size" ] = 4000000 + i;
+        file[ "duration" ] = 180 + i % 120;
+        file[ "bitrate" ] = 320;
+        file[ "mtime" ] = 1400000000 + i;
+        file[ "albumpos" ] = i % 10 + 1;
+
+        QVariantMap op;
+        op[ "command" ] = "addfiles";
+        op[ "guid" ] = QUuid::createUuid().toString();
+        op[ "files" ] = QVariantList() << file;
+
+        dbop_ptr dbop( new DBOp() );
+        dbop->guid = op[ "guid" ].toString();
+        dbop->command = "addfiles";
+        dbop->payload = TomahawkUtils::toJson( op );
+        dbop->compressed = false;
+        dbop->singleton = false;
+        ops << dbop;
+    }
+
+    return ops;
+}
+
+
+QByteArray
+compressIfLarge( const QByteArray& payload, bool* compressed )
+{
+    *compressed = payload.length() > COMPRESSION_THRESHOLD;
+    return *compressed ? qCompress( payload, 9 ) : payload;
+}
+
+
+// What the Source does with the ops a DBSyncConnection received: a transaction per op, or one per frame
+qint64
+applyOps( Tomahawk::Database* database, int sourceId, const QList< QVariantList >& frames, bool asFrames )
+{
+    database->impl()->newquery().exec( QString( "INSERT INTO source(id, name, friendlyname) VALUES (%1, 'benchmark%1', 'benchmark')" ).arg( sourceId ) );
+    Tomahawk::source_ptr source( new Tomahawk::Source( sourceId, QString( "benchmark%1" ).arg( sourceId ) ) );
+    Tomahawk::collection_ptr collection( new Tomahawk::DatabaseCollection( source ) );
+    collection->setWeakRef( collection.toWeakRef() );
+    source->addCollection( collection );
+
+    QList< QList< Tomahawk::dbcmd_ptr > > batches;
+    foreach ( const QVariantList& frame, frames )
+    {
+        QList< Tomahawk::dbcmd_ptr > cmds;
+        foreach ( const QVariant& op, frame )
+        {
+            const Tomahawk::dbcmd_ptr cmd = database->createCommandInstance( op, source );
+            if ( !cmd.isNull() )
+                cmds << cmd;
+        }
+
+        if ( !cmds.isEmpty() )
+            batches << cmds;
+    }
+
+    if ( batches.isEmpty() )
+        return 0;
+
+    QEventLoop loop;
+    QObject::connect( batches.last().last().data(), SIGNAL( finished() ), &loop, SLOT( quit() ) );
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // everything is queued up front, the Source would wait for each batch to finish before it sends the next one
+    foreach ( const QList< Tomahawk::dbcmd_ptr >& cmds, batches )
+    {
+        if ( asFrames )
+        {
+            database->enqueue( cmds, true );
+        }
+        else
+        {
+            foreach ( const Tomahawk::dbcmd_ptr& cmd, cmds )
+                database->enqueue( cmd );
+        }
+    }
+
+    loop.exec();
+    return timer.elapsed();
+}
+
+
+int
+main( int argc, char* argv[] )
+{
+    QCoreApplication a( argc, argv );
+
+    int count = 100000;
+    if ( argc > 1 )
+    {
+        bool ok = false;
+        count = QString( argv[1] ).toInt( &ok );
+        if ( !ok || count <= 0 )
+        {
+            usage();
+            exit( EXIT_FAILURE );
+        }
+    }
+
+    // keep the search index and everything else the database writes away from a real installation
+    QCoreApplication::setOrganizationName( QString( "tomahawk-dbsync-benchmark-%1" ).arg( a.applicationPid() ) );
+
+    const QList< dbop_ptr > legacyOps = createOps( count, "A" );
+    const QList< dbop_ptr > batchedOps = createOps( count, "B" );
+    QElapsedTimer timer;
+
+    // One msg per op: compress, transfer, uncompress and parse every op on its own
+    timer.start();
+    qint64 legacyBytes = 0;
+    QVariantList legacyParsed;
+    foreach ( const dbop_ptr& op, legacyOps )
+    {
+        bool compressed;
+        const QByteArray wire = compressIfLarge( op->payload, &compressed );
+        legacyBytes += wire.length();
+
+        const QVariant json = TomahawkUtils::parseJson( compressed ? qUncompress( wire ) : wire );
+        if ( json.type() == QVariant::Map )
+            legacyParsed << json;
+    }
+    const qint64 legacyMs = timer.elapsed();
+
+    // Batched frames: pack, compress, uncompress and parse each frame as a whole
+    timer.restart();
+    qint64 batchedBytes = 0;
+    int batchedCount = 0;
+    QList< QVariantList > batchedParsed;
+    const QList< QByteArray > frames = DBSyncConnection::packOps( batchedOps, MAX_OPS_FRAME_SIZE );
+    foreach ( const QByteArray& frame, frames )
+    {
+        bool compressed;
+        const QByteArray wire = compressIfLarge( frame, &compressed );
+        batchedBytes += wire.length();
+
+        const QVariant json = TomahawkUtils::parseJson( compressed ? qUncompress( wire ) : wire );
+        batchedParsed << json.toList();
+        batchedCount += batchedParsed.last().count();
+    }
+    const qint64 batchedMs = timer.elapsed();
+
+    if ( legacyParsed.count() != count || batchedCount != count )
+    {
+        std::cerr << "Not all ops survived the round trip" << std::endl;
+        exit( EXIT_FAILURE );
+    }
+
+    // Apply what arrived through the database commands, like a peer's initial sync does
+    const QString dbpath = QDir::temp().absoluteFilePath( QString( "tomahawk-dbsync-benchmark-%1.db" ).arg( a.applicationPid() ) );
+    qint64 legacyApplyMs = 0;
+    qint64 batchedApplyMs = 0;
+    {
+        Tomahawk::Database database( dbpath );
+        QEventLoop loop;
+        QObject::connect( &database, SIGNAL( ready() ), &loop, SLOT( quit() ) );
+        database.loadIndex();
+        if ( !database.isReady() )
+            loop.exec();
+
+        legacyApplyMs = applyOps( &database, 1, QList< QVariantList >() << legacyParsed, false );
+        batchedApplyMs = applyOps( &database, 2, batchedParsed, true );
+    }
+    QFile::remove( dbpath );
+    TomahawkUtils::removeDirectory( TomahawkUtils::appDataDir().absolutePath() );
+
+    std::cout << "Ops: " << count << std::endl;
+    std::cout << "Per-op msgs:    " << legacyParsed.count() << " ops in " << legacyOps.count() << " msgs, "
+              << legacyBytes << " bytes, " << legacyMs << " ms transfer, "
+              << legacyApplyMs << " ms applying, " << legacyMs + legacyApplyMs << " ms total" << std::endl;
+    std::cout << "Batched frames: " << batchedCount << " ops in " << frames.count() << " msgs, "
+              << batchedBytes << " bytes, " << batchedMs << " ms transfer, "
+              << batchedApplyMs << " ms applying, " << batchedMs + batchedApplyMs << " ms total" << std::endl;
+}
@@ -1,6 +1,7 @@
 #include"filemetadata/MusicScanner.h"
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QFileInfo>
 
 #include <iostream>
@@ -9,17 +10,19 @@ void
 usage()
 {
     std::cout << "Usage:" << std::endl;
-    std::cout << "\ttomahawk-test-musicscan <path>" << std::endl;
+    std::cout << "\ttomahawk-test-musicscan <path> [tagreaders]" << std::endl;
     std::cout << std::endl;
-    std::cout << "\tpath\tEither an audio file or a directory" << std::endl;
+    std::cout << "\tpath\t\tEither an audio file or a directory" << std::endl;
+    std::cout << "\ttagreaders\tNumber of threads reading tags, 0 (default) for one per core" << std::endl;
 }
 
 int
 main( int argc, char* argv[] )
 {
-    if ( argc != 2 )
+    if ( argc != 2 && argc != 3 )
     {
         usage();
+        exit(EXIT_FAILURE);
     }
 
     QCoreApplication a( argc, argv );
@@ -49,6 +52,8 @@ main( int argc, char* argv[] )
         // We want a dry-run of the scanner and not update any internal data.
         scanner.setDryRun( true );
         scanner.setVerbose( true );
+        if ( argc == 3 )
+            scanner.setTagReaders( QString( argv[2] ).toUInt() );
 
         // Start the MusicScanner in its own thread
         QThread scannerThread( 0 );
@@ -57,10 +62,17 @@ main( int argc, char* argv[] )
         scannerThread.moveToThread( &scannerThread );
         scanner.moveToThread( &scannerThread );
         QObject::connect( &scanner, SIGNAL( finished() ), &scannerThread, SLOT( quit() ) );
+        QElapsedTimer timer;
+        timer.start();
         QMetaObject::invokeMethod( &scanner, "scan", Qt::QueuedConnection );
 
         // Wait until the scanner has done its work.
         scannerThread.wait();
+
+        const qint64 elapsed = qMax( timer.elapsed(), (qint64)1 );
+        const unsigned int files = scanner.scanned() + scanner.skipped();
+        std::cout << "Scanned " << scanner.scanned() << " files, skipped " << scanner.skipped()
+                  << " in " << elapsed << " ms (" << ( files * 1000.0 / elapsed ) << " files/sec)" << std::endl;
     }
     else
     {